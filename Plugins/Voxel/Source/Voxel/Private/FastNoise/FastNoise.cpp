@@ -32,6 +32,7 @@
 //
 
 #include "FastNoise.h"
+#include "HAL/IConsoleManager.h"
 
 #include <math.h>
 #include <assert.h>
@@ -3075,13 +3076,94 @@ FN_DECIMAL FastNoise::GetCellular_3D(FN_DECIMAL x, FN_DECIMAL y, FN_DECIMAL z, f
 	case CellValue:
 	//case NoiseLookup:
 	case Distance:
-		return SingleCellular_3D(x, y, z);
+		return SingleCellular_3D<false>(nullptr, x, y, z);
 	default:
-		return SingleCellular2Edge_3D(x, y, z);
+		return SingleCellular2Edge_3D<false>(nullptr, x, y, z);
 	}
 }
 
-FN_DECIMAL FastNoise::SingleCellular_3D(FN_DECIMAL x, FN_DECIMAL y, FN_DECIMAL z) const
+FN_DECIMAL FastNoise::GetCellular_3D(const CellularCache& cache, FN_DECIMAL x, FN_DECIMAL y, FN_DECIMAL z, float frequency) const
+{
+	x *= frequency;
+	y *= frequency;
+	z *= frequency;
+
+	const bool useCache = cache.Contains_3D(FastRound(x), FastRound(y), FastRound(z));
+
+	switch (m_cellularReturnType)
+	{
+	case CellValue:
+	//case NoiseLookup:
+	case Distance:
+		return useCache ? SingleCellular_3D<true>(&cache, x, y, z) : SingleCellular_3D<false>(nullptr, x, y, z);
+	default:
+		return useCache ? SingleCellular2Edge_3D<true>(&cache, x, y, z) : SingleCellular2Edge_3D<false>(nullptr, x, y, z);
+	}
+}
+
+void FastNoise::BuildCellularCache_3D(CellularCache& cache, FN_DECIMAL minX, FN_DECIMAL minY, FN_DECIMAL minZ, FN_DECIMAL maxX, FN_DECIMAL maxY, FN_DECIMAL maxZ, float frequency) const
+{
+	// Same rounding as SingleCellular_3D, plus the neighbors
+	const int x0 = FMath::Min(FastRound(minX * frequency), FastRound(maxX * frequency)) - 1;
+	const int y0 = FMath::Min(FastRound(minY * frequency), FastRound(maxY * frequency)) - 1;
+	const int z0 = FMath::Min(FastRound(minZ * frequency), FastRound(maxZ * frequency)) - 1;
+	const int x1 = FMath::Max(FastRound(minX * frequency), FastRound(maxX * frequency)) + 1;
+	const int y1 = FMath::Max(FastRound(minY * frequency), FastRound(maxY * frequency)) + 1;
+	const int z1 = FMath::Max(FastRound(minZ * frequency), FastRound(maxZ * frequency)) + 1;
+	const int64 numCells = int64(x1 - x0 + 1) * int64(y1 - y0 + 1) * int64(z1 - z0 + 1);
+
+	cache.cellVectors.Reset();
+	if (numCells > FN_CELLULAR_CACHE_MAX_CELLS)
+	{
+		// Samples will use the lookup tables
+		cache.sizeX = cache.sizeY = cache.sizeZ = 0;
+		return;
+	}
+
+	cache.minX = x0;
+	cache.minY = y0;
+	cache.minZ = z0;
+	cache.sizeX = x1 - x0 + 1;
+	cache.sizeY = y1 - y0 + 1;
+	cache.sizeZ = z1 - z0 + 1;
+	cache.cellVectors.SetNumUninitialized(3 * numCells);
+
+	FN_DECIMAL* cellVectors = cache.cellVectors.GetData();
+	for (int zi = z0; zi <= z1; zi++)
+	{
+		for (int yi = y0; yi <= y1; yi++)
+		{
+			for (int xi = x0; xi <= x1; xi++)
+			{
+				GetCellVector_3D<false>(nullptr, xi, yi, zi, cellVectors[0], cellVectors[1], cellVectors[2]);
+				cellVectors += 3;
+			}
+		}
+	}
+}
+
+template<bool bCached>
+FORCEINLINE void FastNoise::GetCellVector_3D(const CellularCache* cache, int x, int y, int z, FN_DECIMAL& outX, FN_DECIMAL& outY, FN_DECIMAL& outZ) const
+{
+	if (bCached)
+	{
+		const int index = (x - cache->minX) + cache->sizeX * ((y - cache->minY) + cache->sizeY * (z - cache->minZ));
+		const FN_DECIMAL* cellVectors = cache->cellVectors.GetData() + 3 * index;
+		outX = cellVectors[0];
+		outY = cellVectors[1];
+		outZ = cellVectors[2];
+	}
+	else
+	{
+		unsigned char lutPos = Index3D_256(0, x, y, z);
+		outX = CELL_3D_X[lutPos];
+		outY = CELL_3D_Y[lutPos];
+		outZ = CELL_3D_Z[lutPos];
+	}
+}
+
+template<bool bCached>
+FN_DECIMAL FastNoise::SingleCellular_3D(const CellularCache* cache, FN_DECIMAL x, FN_DECIMAL y, FN_DECIMAL z) const
 {
 	int xr = FastRound(x);
 	int yr = FastRound(y);
@@ -3099,11 +3181,12 @@ FN_DECIMAL FastNoise::SingleCellular_3D(FN_DECIMAL x, FN_DECIMAL y, FN_DECIMAL z
 			{
 				for (int zi = zr - 1; zi <= zr + 1; zi++)
 				{
-					unsigned char lutPos = Index3D_256(0, xi, yi, zi);
+					FN_DECIMAL cellX, cellY, cellZ;
+					GetCellVector_3D<bCached>(cache, xi, yi, zi, cellX, cellY, cellZ);
 
-					FN_DECIMAL vecX = xi - x + CELL_3D_X[lutPos] * m_cellularJitter;
-					FN_DECIMAL vecY = yi - y + CELL_3D_Y[lutPos] * m_cellularJitter;
-					FN_DECIMAL vecZ = zi - z + CELL_3D_Z[lutPos] * m_cellularJitter;
+					FN_DECIMAL vecX = xi - x + cellX * m_cellularJitter;
+					FN_DECIMAL vecY = yi - y + cellY * m_cellularJitter;
+					FN_DECIMAL vecZ = zi - z + cellZ * m_cellularJitter;
 
 					FN_DECIMAL newDistance = vecX * vecX + vecY * vecY + vecZ * vecZ;
 
@@ -3125,11 +3208,12 @@ FN_DECIMAL FastNoise::SingleCellular_3D(FN_DECIMAL x, FN_DECIMAL y, FN_DECIMAL z
 			{
 				for (int zi = zr - 1; zi <= zr + 1; zi++)
 				{
-					unsigned char lutPos = Index3D_256(0, xi, yi, zi);
+					FN_DECIMAL cellX, cellY, cellZ;
+					GetCellVector_3D<bCached>(cache, xi, yi, zi, cellX, cellY, cellZ);
 
-					FN_DECIMAL vecX = xi - x + CELL_3D_X[lutPos] * m_cellularJitter;
-					FN_DECIMAL vecY = yi - y + CELL_3D_Y[lutPos] * m_cellularJitter;
-					FN_DECIMAL vecZ = zi - z + CELL_3D_Z[lutPos] * m_cellularJitter;
+					FN_DECIMAL vecX = xi - x + cellX * m_cellularJitter;
+					FN_DECIMAL vecY = yi - y + cellY * m_cellularJitter;
+					FN_DECIMAL vecZ = zi - z + cellZ * m_cellularJitter;
 
 					FN_DECIMAL newDistance = FastAbs(vecX) + FastAbs(vecY) + FastAbs(vecZ);
 
@@ -3151,11 +3235,12 @@ FN_DECIMAL FastNoise::SingleCellular_3D(FN_DECIMAL x, FN_DECIMAL y, FN_DECIMAL z
 			{
 				for (int zi = zr - 1; zi <= zr + 1; zi++)
 				{
-					unsigned char lutPos = Index3D_256(0, xi, yi, zi);
+					FN_DECIMAL cellX, cellY, cellZ;
+					GetCellVector_3D<bCached>(cache, xi, yi, zi, cellX, cellY, cellZ);
 
-					FN_DECIMAL vecX = xi - x + CELL_3D_X[lutPos] * m_cellularJitter;
-					FN_DECIMAL vecY = yi - y + CELL_3D_Y[lutPos] * m_cellularJitter;
-					FN_DECIMAL vecZ = zi - z + CELL_3D_Z[lutPos] * m_cellularJitter;
+					FN_DECIMAL vecX = xi - x + cellX * m_cellularJitter;
+					FN_DECIMAL vecY = yi - y + cellY * m_cellularJitter;
+					FN_DECIMAL vecZ = zi - z + cellZ * m_cellularJitter;
 
 					FN_DECIMAL newDistance = (FastAbs(vecX) + FastAbs(vecY) + FastAbs(vecZ)) + (vecX * vecX + vecY * vecY + vecZ * vecZ);
 
@@ -3193,7 +3278,8 @@ FN_DECIMAL FastNoise::SingleCellular_3D(FN_DECIMAL x, FN_DECIMAL y, FN_DECIMAL z
 	}
 }
 
-FN_DECIMAL FastNoise::SingleCellular2Edge_3D(FN_DECIMAL x, FN_DECIMAL y, FN_DECIMAL z) const
+template<bool bCached>
+FN_DECIMAL FastNoise::SingleCellular2Edge_3D(const CellularCache* cache, FN_DECIMAL x, FN_DECIMAL y, FN_DECIMAL z) const
 {
 	int xr = FastRound(x);
 	int yr = FastRound(y);
@@ -3210,11 +3296,12 @@ FN_DECIMAL FastNoise::SingleCellular2Edge_3D(FN_DECIMAL x, FN_DECIMAL y, FN_DECI
 			{
 				for (int zi = zr - 1; zi <= zr + 1; zi++)
 				{
-					unsigned char lutPos = Index3D_256(0, xi, yi, zi);
+					FN_DECIMAL cellX, cellY, cellZ;
+					GetCellVector_3D<bCached>(cache, xi, yi, zi, cellX, cellY, cellZ);
 
-					FN_DECIMAL vecX = xi - x + CELL_3D_X[lutPos] * m_cellularJitter;
-					FN_DECIMAL vecY = yi - y + CELL_3D_Y[lutPos] * m_cellularJitter;
-					FN_DECIMAL vecZ = zi - z + CELL_3D_Z[lutPos] * m_cellularJitter;
+					FN_DECIMAL vecX = xi - x + cellX * m_cellularJitter;
+					FN_DECIMAL vecY = yi - y + cellY * m_cellularJitter;
+					FN_DECIMAL vecZ = zi - z + cellZ * m_cellularJitter;
 
 					FN_DECIMAL newDistance = vecX * vecX + vecY * vecY + vecZ * vecZ;
 
@@ -3232,11 +3319,12 @@ FN_DECIMAL FastNoise::SingleCellular2Edge_3D(FN_DECIMAL x, FN_DECIMAL y, FN_DECI
 			{
 				for (int zi = zr - 1; zi <= zr + 1; zi++)
 				{
-					unsigned char lutPos = Index3D_256(0, xi, yi, zi);
+					FN_DECIMAL cellX, cellY, cellZ;
+					GetCellVector_3D<bCached>(cache, xi, yi, zi, cellX, cellY, cellZ);
 
-					FN_DECIMAL vecX = xi - x + CELL_3D_X[lutPos] * m_cellularJitter;
-					FN_DECIMAL vecY = yi - y + CELL_3D_Y[lutPos] * m_cellularJitter;
-					FN_DECIMAL vecZ = zi - z + CELL_3D_Z[lutPos] * m_cellularJitter;
+					FN_DECIMAL vecX = xi - x + cellX * m_cellularJitter;
+					FN_DECIMAL vecY = yi - y + cellY * m_cellularJitter;
+					FN_DECIMAL vecZ = zi - z + cellZ * m_cellularJitter;
 
 					FN_DECIMAL newDistance = FastAbs(vecX) + FastAbs(vecY) + FastAbs(vecZ);
 
@@ -3254,11 +3342,12 @@ FN_DECIMAL FastNoise::SingleCellular2Edge_3D(FN_DECIMAL x, FN_DECIMAL y, FN_DECI
 			{
 				for (int zi = zr - 1; zi <= zr + 1; zi++)
 				{
-					unsigned char lutPos = Index3D_256(0, xi, yi, zi);
+					FN_DECIMAL cellX, cellY, cellZ;
+					GetCellVector_3D<bCached>(cache, xi, yi, zi, cellX, cellY, cellZ);
 
-					FN_DECIMAL vecX = xi - x + CELL_3D_X[lutPos] * m_cellularJitter;
-					FN_DECIMAL vecY = yi - y + CELL_3D_Y[lutPos] * m_cellularJitter;
-					FN_DECIMAL vecZ = zi - z + CELL_3D_Z[lutPos] * m_cellularJitter;
+					FN_DECIMAL vecX = xi - x + cellX * m_cellularJitter;
+					FN_DECIMAL vecY = yi - y + cellY * m_cellularJitter;
+					FN_DECIMAL vecZ = zi - z + cellZ * m_cellularJitter;
 
 					FN_DECIMAL newDistance = (FastAbs(vecX) + FastAbs(vecY) + FastAbs(vecZ)) + (vecX * vecX + vecY * vecY + vecZ * vecZ);
 
@@ -3300,9 +3389,9 @@ FN_DECIMAL FastNoise::GetCellular_2D(FN_DECIMAL x, FN_DECIMAL y, float frequency
 	case CellValue:
 	//case NoiseLookup:
 	case Distance:
-		return SingleCellular_2D(x, y);
+		return SingleCellular_2D<false>(nullptr, x, y);
 	default:
-		return SingleCellular2Edge_2D(x, y);
+		return SingleCellular2Edge_2D<false>(nullptr, x, y);
 	}
 }
 
@@ -3472,7 +3561,80 @@ void FastNoise::GetVoronoiNeighbors_2D(
 	out_distance3 = distance[3];
 }
 
-FN_DECIMAL FastNoise::SingleCellular_2D(FN_DECIMAL x, FN_DECIMAL y) const
+FN_DECIMAL FastNoise::GetCellular_2D(const CellularCache& cache, FN_DECIMAL x, FN_DECIMAL y, float frequency) const
+{
+	x *= frequency;
+	y *= frequency;
+
+	const bool useCache = cache.Contains_2D(FastRound(x), FastRound(y));
+
+	switch (m_cellularReturnType)
+	{
+	case CellValue:
+	//case NoiseLookup:
+	case Distance:
+		return useCache ? SingleCellular_2D<true>(&cache, x, y) : SingleCellular_2D<false>(nullptr, x, y);
+	default:
+		return useCache ? SingleCellular2Edge_2D<true>(&cache, x, y) : SingleCellular2Edge_2D<false>(nullptr, x, y);
+	}
+}
+
+void FastNoise::BuildCellularCache_2D(CellularCache& cache, FN_DECIMAL minX, FN_DECIMAL minY, FN_DECIMAL maxX, FN_DECIMAL maxY, float frequency) const
+{
+	// Same rounding as SingleCellular_2D, plus the neighbors
+	const int x0 = FMath::Min(FastRound(minX * frequency), FastRound(maxX * frequency)) - 1;
+	const int y0 = FMath::Min(FastRound(minY * frequency), FastRound(maxY * frequency)) - 1;
+	const int x1 = FMath::Max(FastRound(minX * frequency), FastRound(maxX * frequency)) + 1;
+	const int y1 = FMath::Max(FastRound(minY * frequency), FastRound(maxY * frequency)) + 1;
+	const int64 numCells = int64(x1 - x0 + 1) * int64(y1 - y0 + 1);
+
+	cache.cellVectors.Reset();
+	if (numCells > FN_CELLULAR_CACHE_MAX_CELLS)
+	{
+		// Samples will use the lookup tables
+		cache.sizeX = cache.sizeY = cache.sizeZ = 0;
+		return;
+	}
+
+	cache.minX = x0;
+	cache.minY = y0;
+	cache.minZ = 0;
+	cache.sizeX = x1 - x0 + 1;
+	cache.sizeY = y1 - y0 + 1;
+	cache.sizeZ = 1;
+	cache.cellVectors.SetNumUninitialized(2 * numCells);
+
+	FN_DECIMAL* cellVectors = cache.cellVectors.GetData();
+	for (int yi = y0; yi <= y1; yi++)
+	{
+		for (int xi = x0; xi <= x1; xi++)
+		{
+			GetCellVector_2D<false>(nullptr, xi, yi, cellVectors[0], cellVectors[1]);
+			cellVectors += 2;
+		}
+	}
+}
+
+template<bool bCached>
+FORCEINLINE void FastNoise::GetCellVector_2D(const CellularCache* cache, int x, int y, FN_DECIMAL& outX, FN_DECIMAL& outY) const
+{
+	if (bCached)
+	{
+		const int index = (x - cache->minX) + cache->sizeX * (y - cache->minY);
+		const FN_DECIMAL* cellVectors = cache->cellVectors.GetData() + 2 * index;
+		outX = cellVectors[0];
+		outY = cellVectors[1];
+	}
+	else
+	{
+		unsigned char lutPos = Index2D_256(0, x, y);
+		outX = CELL_2D_X[lutPos];
+		outY = CELL_2D_Y[lutPos];
+	}
+}
+
+template<bool bCached>
+FN_DECIMAL FastNoise::SingleCellular_2D(const CellularCache* cache, FN_DECIMAL x, FN_DECIMAL y) const
 {
 	int xr = FastRound(x);
 	int yr = FastRound(y);
@@ -3488,10 +3650,11 @@ FN_DECIMAL FastNoise::SingleCellular_2D(FN_DECIMAL x, FN_DECIMAL y) const
 		{
 			for (int yi = yr - 1; yi <= yr + 1; yi++)
 			{
-				unsigned char lutPos = Index2D_256(0, xi, yi);
+				FN_DECIMAL cellX, cellY;
+				GetCellVector_2D<bCached>(cache, xi, yi, cellX, cellY);
 
-				FN_DECIMAL vecX = xi - x + CELL_2D_X[lutPos] * m_cellularJitter;
-				FN_DECIMAL vecY = yi - y + CELL_2D_Y[lutPos] * m_cellularJitter;
+				FN_DECIMAL vecX = xi - x + cellX * m_cellularJitter;
+				FN_DECIMAL vecY = yi - y + cellY * m_cellularJitter;
 
 				FN_DECIMAL newDistance = vecX * vecX + vecY * vecY;
 
@@ -3509,10 +3672,11 @@ FN_DECIMAL FastNoise::SingleCellular_2D(FN_DECIMAL x, FN_DECIMAL y) const
 		{
 			for (int yi = yr - 1; yi <= yr + 1; yi++)
 			{
-				unsigned char lutPos = Index2D_256(0, xi, yi);
+				FN_DECIMAL cellX, cellY;
+				GetCellVector_2D<bCached>(cache, xi, yi, cellX, cellY);
 
-				FN_DECIMAL vecX = xi - x + CELL_2D_X[lutPos] * m_cellularJitter;
-				FN_DECIMAL vecY = yi - y + CELL_2D_Y[lutPos] * m_cellularJitter;
+				FN_DECIMAL vecX = xi - x + cellX * m_cellularJitter;
+				FN_DECIMAL vecY = yi - y + cellY * m_cellularJitter;
 
 				FN_DECIMAL newDistance = (FastAbs(vecX) + FastAbs(vecY));
 
@@ -3530,10 +3694,11 @@ FN_DECIMAL FastNoise::SingleCellular_2D(FN_DECIMAL x, FN_DECIMAL y) const
 		{
 			for (int yi = yr - 1; yi <= yr + 1; yi++)
 			{
-				unsigned char lutPos = Index2D_256(0, xi, yi);
+				FN_DECIMAL cellX, cellY;
+				GetCellVector_2D<bCached>(cache, xi, yi, cellX, cellY);
 
-				FN_DECIMAL vecX = xi - x + CELL_2D_X[lutPos] * m_cellularJitter;
-				FN_DECIMAL vecY = yi - y + CELL_2D_Y[lutPos] * m_cellularJitter;
+				FN_DECIMAL vecX = xi - x + cellX * m_cellularJitter;
+				FN_DECIMAL vecY = yi - y + cellY * m_cellularJitter;
 
 				FN_DECIMAL newDistance = (FastAbs(vecX) + FastAbs(vecY)) + (vecX * vecX + vecY * vecY);
 
@@ -3567,7 +3732,8 @@ FN_DECIMAL FastNoise::SingleCellular_2D(FN_DECIMAL x, FN_DECIMAL y) const
 	}
 }
 
-FN_DECIMAL FastNoise::SingleCellular2Edge_2D(FN_DECIMAL x, FN_DECIMAL y) const
+template<bool bCached>
+FN_DECIMAL FastNoise::SingleCellular2Edge_2D(const CellularCache* cache, FN_DECIMAL x, FN_DECIMAL y) const
 {
 	int xr = FastRound(x);
 	int yr = FastRound(y);
@@ -3582,10 +3748,11 @@ FN_DECIMAL FastNoise::SingleCellular2Edge_2D(FN_DECIMAL x, FN_DECIMAL y) const
 		{
 			for (int yi = yr - 1; yi <= yr + 1; yi++)
 			{
-				unsigned char lutPos = Index2D_256(0, xi, yi);
+				FN_DECIMAL cellX, cellY;
+				GetCellVector_2D<bCached>(cache, xi, yi, cellX, cellY);
 
-				FN_DECIMAL vecX = xi - x + CELL_2D_X[lutPos] * m_cellularJitter;
-				FN_DECIMAL vecY = yi - y + CELL_2D_Y[lutPos] * m_cellularJitter;
+				FN_DECIMAL vecX = xi - x + cellX * m_cellularJitter;
+				FN_DECIMAL vecY = yi - y + cellY * m_cellularJitter;
 
 				FN_DECIMAL newDistance = vecX * vecX + vecY * vecY;
 
@@ -3600,10 +3767,11 @@ FN_DECIMAL FastNoise::SingleCellular2Edge_2D(FN_DECIMAL x, FN_DECIMAL y) const
 		{
 			for (int yi = yr - 1; yi <= yr + 1; yi++)
 			{
-				unsigned char lutPos = Index2D_256(0, xi, yi);
+				FN_DECIMAL cellX, cellY;
+				GetCellVector_2D<bCached>(cache, xi, yi, cellX, cellY);
 
-				FN_DECIMAL vecX = xi - x + CELL_2D_X[lutPos] * m_cellularJitter;
-				FN_DECIMAL vecY = yi - y + CELL_2D_Y[lutPos] * m_cellularJitter;
+				FN_DECIMAL vecX = xi - x + cellX * m_cellularJitter;
+				FN_DECIMAL vecY = yi - y + cellY * m_cellularJitter;
 
 				FN_DECIMAL newDistance = FastAbs(vecX) + FastAbs(vecY);
 
@@ -3618,10 +3786,11 @@ FN_DECIMAL FastNoise::SingleCellular2Edge_2D(FN_DECIMAL x, FN_DECIMAL y) const
 		{
 			for (int yi = yr - 1; yi <= yr + 1; yi++)
 			{
-				unsigned char lutPos = Index2D_256(0, xi, yi);
+				FN_DECIMAL cellX, cellY;
+				GetCellVector_2D<bCached>(cache, xi, yi, cellX, cellY);
 
-				FN_DECIMAL vecX = xi - x + CELL_2D_X[lutPos] * m_cellularJitter;
-				FN_DECIMAL vecY = yi - y + CELL_2D_Y[lutPos] * m_cellularJitter;
+				FN_DECIMAL vecX = xi - x + cellX * m_cellularJitter;
+				FN_DECIMAL vecY = yi - y + cellY * m_cellularJitter;
 
 				FN_DECIMAL newDistance = (FastAbs(vecX) + FastAbs(vecY)) + (vecX * vecX + vecY * vecY);
 
@@ -3805,4 +3974,127 @@ void FastNoise::SingleGradientPerturb_2D(unsigned char offset, FN_DECIMAL warpAm
 
 	x += Lerp(lx0x, lx1x, ys) * warpAmp;
 	y += Lerp(ly0x, ly1x, ys) * warpAmp;
-}
\ No newline at end of file
+}
+
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+
+static void TestCellularCache(const TArray<FString>& Args)
+{
+	const int32 NumZones = Args.Num() > 0 ? FMath::Max(1, FCString::Atoi(*Args[0])) : 16;
+	constexpr int32 ZoneSize = 16;
+
+	const TArray<FastNoise::CellularDistanceFunction> DistanceFunctions = { FastNoise::Euclidean, FastNoise::Manhattan, FastNoise::Natural };
+	const TArray<FastNoise::CellularReturnType> ReturnTypes = { FastNoise::CellValue, FastNoise::Distance, FastNoise::Distance2, FastNoise::Distance2Add, FastNoise::Distance2Sub, FastNoise::Distance2Mul, FastNoise::Distance2Div };
+
+	const auto IsIdentical = [](FN_DECIMAL A, FN_DECIMAL B)
+	{
+		return FMemory::Memcmp(&A, &B, sizeof(FN_DECIMAL)) == 0;
+	};
+
+	FRandomStream Stream(NumZones);
+	int64 NumSamples = 0;
+	int64 NumDifferences = 0;
+	double UncachedTime = 0;
+	double CachedTime = 0;
+	// Avoid optimizing the samples away
+	FN_DECIMAL Sum = 0;
+
+	TArray<FN_DECIMAL> Uncached;
+	TArray<FN_DECIMAL> Cached;
+	for (int32 Zone = 0; Zone < NumZones; Zone++)
+	{
+		FastNoise Noise;
+		Noise.SetSeed(Stream.RandHelper(MAX_int32));
+		Noise.SetCellularJitter(Stream.FRandRange(0, 0.5f));
+		Noise.SetCellularDistanceFunction(DistanceFunctions[Stream.RandHelper(DistanceFunctions.Num())]);
+		Noise.SetCellularReturnType(ReturnTypes[Stream.RandHelper(ReturnTypes.Num())]);
+
+		// Small enough for most of the zones to be below FN_CELLULAR_CACHE_MAX_CELLS
+		const float Frequency = Stream.FRandRange(0.01f, 0.2f);
+		const int32 Step = 1 << Stream.RandHelper(4);
+		const FIntVector Min(Stream.RandRange(-10000, 10000), Stream.RandRange(-10000, 10000), Stream.RandRange(-10000, 10000));
+		const FIntVector Max = Min + Step * (ZoneSize - 1);
+		// Also sample one voxel outside of the cached zone, to check the lookup tables fallback
+		const FIntVector SampleMin = Min - Step;
+		const FIntVector SampleMax = Max + Step;
+		const int32 NumZoneSamples = FMath::Cube(ZoneSize + 2);
+
+		for (int32 Dimension = 2; Dimension <= 3; Dimension++)
+		{
+			Uncached.Reset(NumZoneSamples);
+			Cached.Reset(NumZoneSamples);
+			
+			{
+				const double StartTime = FPlatformTime::Seconds();
+				for (int32 Z = SampleMin.Z; Z <= SampleMax.Z; Z += Step)
+				{
+					for (int32 Y = SampleMin.Y; Y <= SampleMax.Y; Y += Step)
+					{
+						for (int32 X = SampleMin.X; X <= SampleMax.X; X += Step)
+						{
+							Uncached.Add(Dimension == 2
+								? Noise.GetCellular_2D(X, Y, Frequency)
+								: Noise.GetCellular_3D(X, Y, Z, Frequency));
+						}
+					}
+				}
+				UncachedTime += FPlatformTime::Seconds() - StartTime;
+			}
+			{
+				const double StartTime = FPlatformTime::Seconds();
+				FastNoise::CellularCache Cache;
+				if (Dimension == 2)
+				{
+					Noise.BuildCellularCache_2D(Cache, Min.X, Min.Y, Max.X, Max.Y, Frequency);
+				}
+				else
+				{
+					Noise.BuildCellularCache_3D(Cache, Min.X, Min.Y, Min.Z, Max.X, Max.Y, Max.Z, Frequency);
+				}
+				for (int32 Z = SampleMin.Z; Z <= SampleMax.Z; Z += Step)
+				{
+					for (int32 Y = SampleMin.Y; Y <= SampleMax.Y; Y += Step)
+					{
+						for (int32 X = SampleMin.X; X <= SampleMax.X; X += Step)
+						{
+							Cached.Add(Dimension == 2
+								? Noise.GetCellular_2D(Cache, X, Y, Frequency)
+								: Noise.GetCellular_3D(Cache, X, Y, Z, Frequency));
+						}
+					}
+				}
+				CachedTime += FPlatformTime::Seconds() - StartTime;
+			}
+
+			check(Uncached.Num() == Cached.Num());
+			for (int32 Index = 0; Index < Uncached.Num(); Index++)
+			{
+				if (!IsIdentical(Uncached[Index], Cached[Index]))
+				{
+					if (NumDifferences == 0)
+					{
+						UE_LOG(LogVoxel, Error, TEXT("Cellular cache mismatch: %dD zone %d index %d: %f, expected %f"), Dimension, Zone, Index, Cached[Index], Uncached[Index]);
+					}
+					NumDifferences++;
+				}
+				Sum += Cached[Index];
+			}
+			NumSamples += Uncached.Num();
+		}
+	}
+
+	UE_LOG(LogVoxel, Log, TEXT("Cellular cache: %lld samples, %lld differences; uncached: %.2fns per sample; cached: %.2fns per sample (including the cache build) (%f)"),
+		NumSamples,
+		NumDifferences,
+		UncachedTime / NumSamples * 1e9,
+		CachedTime / NumSamples * 1e9,
+		Sum);
+	ensureMsgf(NumDifferences == 0, TEXT("Cellular cache results are not bit identical to the uncached ones"));
+}
+
+static FAutoConsoleCommand TestCellularCacheCmd(
+	TEXT("voxel.noise.TestCellularCache"),
+	TEXT("Check that cellular noise sampled with a CellularCache is bit identical to the uncached noise, for random zones, seeds & settings. Args: NumZones (default 16)"),
+	FConsoleCommandWithArgsDelegate::CreateStatic(&TestCellularCache));
\ No newline at end of file
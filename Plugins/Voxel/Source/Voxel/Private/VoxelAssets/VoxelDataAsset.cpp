@@ -10,6 +10,8 @@
 
 #include "Engine/Texture2D.h"
 #include "Misc/ScopedSlowTask.h"
+#include "HAL/IConsoleManager.h"
+#include "Math/RandomStream.h"
 #include "Serialization/BufferArchive.h"
 #include "Serialization/MemoryReader.h"
 
@@ -106,7 +108,27 @@ public:
 
 		if (WorldBounds.Intersect(bCustomTransform ? GetLocalBounds().ApplyTransform(LocalToWorld) : GetLocalBounds()))
 		{
-			return { -1, 1 };
+			const FIntBox AssetBounds = (bCustomTransform ? WorldBounds.ApplyTransform<EInverseTransform::True>(LocalToWorld) : WorldBounds).Translate(-PositionOffset);
+			const TVoxelRange<v_flt> Range = Data->GetValueRange(AssetBounds, bSubtractiveAsset ? FVoxelValue::Full() : FVoxelValue::Empty());
+			
+			const v_flt BestValue = bSubtractiveAsset ? 1 : -1;
+			if (Items.IsEmpty() || (Range.Min == BestValue && Range.Max == BestValue))
+			{
+				// No need to merge as we are the best value possible
+				return Range;
+			}
+
+			const auto NextStack = Items.GetNextStack(WorldBounds);
+			if (!NextStack.IsValid())
+			{
+				return TVoxelRange<v_flt>::Infinite();
+			}
+			
+			const TVoxelRange<v_flt> NextRange = NextStack.GetValueRange(WorldBounds, LOD);
+			return
+				bSubtractiveAsset
+				? TVoxelRange<v_flt>(FMath::Max(Range.Min, NextRange.Min), FMath::Max(Range.Max, NextRange.Max))
+				: TVoxelRange<v_flt>(FMath::Min(Range.Min, NextRange.Min), FMath::Min(Range.Max, NextRange.Max));
 		}
 		else if (Items.IsEmpty())
 		{
@@ -161,6 +183,159 @@ private:
 
 ///////////////////////////////////////////////////////////////////////////////
 
+TVoxelRange<v_flt> FVoxelDataAssetData::GetValueRange(const FIntBox& Bounds, FVoxelValue DefaultValue) const
+{
+	const FIntVector Min = FVoxelUtilities::ComponentMax(Bounds.Min, FIntVector(0));
+	const FIntVector Max = FVoxelUtilities::ComponentMin(Bounds.Max, Size - FIntVector(1));
+
+	const bool bIsInside =
+		Bounds.Min.X >= 0 && Bounds.Min.Y >= 0 && Bounds.Min.Z >= 0 &&
+		Bounds.Max.X < Size.X && Bounds.Max.Y < Size.Y && Bounds.Max.Z < Size.Z;
+	
+	if (Min.X > Max.X || Min.Y > Max.Y || Min.Z > Max.Z)
+	{
+		return DefaultValue.ToFloat();
+	}
+	
+	FVoxelValue MinValue = bIsInside ? FVoxelValue::Empty() : DefaultValue;
+	FVoxelValue MaxValue = bIsInside ? FVoxelValue::Full() : DefaultValue;
+
+	if (bMipsDirty)
+	{
+		MinValue = FVoxelValue::Full();
+		MaxValue = FVoxelValue::Empty();
+	}
+	else
+	{
+		constexpr int32 BrickSizeLog2 = TVoxelDataAssetBricks<FVoxelValue>::BrickSizeLog2;
+		const FIntVector BrickMin(Min.X >> BrickSizeLog2, Min.Y >> BrickSizeLog2, Min.Z >> BrickSizeLog2);
+		const FIntVector BrickMax(Max.X >> BrickSizeLog2, Max.Y >> BrickSizeLog2, Max.Z >> BrickSizeLog2);
+
+		// Find the finest level where the bounds are at most 4 cells wide
+		const int32 NumBricks = (BrickMax - BrickMin).GetMax() + 1;
+		int32 Level = 0;
+		while (Level + 1 < Mips.Num() && (NumBricks >> Level) > 2)
+		{
+			Level++;
+		}
+
+		const FMinMaxMip& Mip = Mips[Level];
+		for (int32 Z = BrickMin.Z >> Level; Z <= BrickMax.Z >> Level; Z++)
+		{
+			for (int32 Y = BrickMin.Y >> Level; Y <= BrickMax.Y >> Level; Y++)
+			{
+				for (int32 X = BrickMin.X >> Level; X <= BrickMax.X >> Level; X++)
+				{
+					const int32 Index = X + Mip.Size.X * Y + Mip.Size.X * Mip.Size.Y * Z;
+					MinValue = FMath::Min(MinValue, Mip.Min[Index]);
+					MaxValue = FMath::Max(MaxValue, Mip.Max[Index]);
+				}
+			}
+		}
+	}
+
+	return { MinValue.ToFloat(), MaxValue.ToFloat() };
+}
+
+void FVoxelDataAssetData::Compact()
+{
+	VOXEL_FUNCTION_COUNTER();
+
+	DEC_DWORD_STAT_BY(STAT_VoxelDataAssetMemory, GetAllocatedSize());
+
+	Values.Compact(Size);
+	Materials.Compact(Size);
+
+	Mips.Empty();
+
+	// Mip 0: one cell per brick
+	{
+		const FIntVector NumBricks = Values.GetNumBricks();
+		
+		FMinMaxMip Mip;
+		Mip.Size = NumBricks;
+		Mip.Min.SetNumUninitialized(NumBricks.X * NumBricks.Y * NumBricks.Z);
+		Mip.Max.SetNumUninitialized(NumBricks.X * NumBricks.Y * NumBricks.Z);
+
+		constexpr int32 BrickSize = TVoxelDataAssetBricks<FVoxelValue>::BrickSize;
+		for (int32 BrickZ = 0; BrickZ < NumBricks.Z; BrickZ++)
+		{
+			for (int32 BrickY = 0; BrickY < NumBricks.Y; BrickY++)
+			{
+				for (int32 BrickX = 0; BrickX < NumBricks.X; BrickX++)
+				{
+					const auto& Brick = Values.GetBrick(BrickX, BrickY, BrickZ);
+					FVoxelValue BrickMin = Brick.UniformValue;
+					FVoxelValue BrickMax = Brick.UniformValue;
+					if (Brick.Offset >= 0)
+					{
+						BrickMin = FVoxelValue::Empty();
+						BrickMax = FVoxelValue::Full();
+						
+						const FIntVector VoxelMin = FIntVector(BrickX, BrickY, BrickZ) * BrickSize;
+						const FIntVector VoxelMax = FVoxelUtilities::ComponentMin(VoxelMin + FIntVector(BrickSize), Size);
+						for (int32 Z = VoxelMin.Z; Z < VoxelMax.Z; Z++)
+						{
+							for (int32 Y = VoxelMin.Y; Y < VoxelMax.Y; Y++)
+							{
+								for (int32 X = VoxelMin.X; X < VoxelMax.X; X++)
+								{
+									const FVoxelValue Value = Values.GetInBrick(Brick, X, Y, Z);
+									BrickMin = FMath::Min(BrickMin, Value);
+									BrickMax = FMath::Max(BrickMax, Value);
+								}
+							}
+						}
+					}
+					const int32 Index = BrickX + NumBricks.X * BrickY + NumBricks.X * NumBricks.Y * BrickZ;
+					Mip.Min[Index] = BrickMin;
+					Mip.Max[Index] = BrickMax;
+				}
+			}
+		}
+		Mips.Add(MoveTemp(Mip));
+	}
+
+	while (Mips.Last().Size.GetMax() > 1)
+	{
+		const FMinMaxMip& PreviousMip = Mips.Last();
+		
+		FMinMaxMip Mip;
+		Mip.Size = FVoxelUtilities::DivideCeil(PreviousMip.Size, 2);
+		Mip.Min.SetNumUninitialized(Mip.Size.X * Mip.Size.Y * Mip.Size.Z);
+		Mip.Max.SetNumUninitialized(Mip.Size.X * Mip.Size.Y * Mip.Size.Z);
+
+		for (int32 Z = 0; Z < Mip.Size.Z; Z++)
+		{
+			for (int32 Y = 0; Y < Mip.Size.Y; Y++)
+			{
+				for (int32 X = 0; X < Mip.Size.X; X++)
+				{
+					FVoxelValue CellMin = FVoxelValue::Empty();
+					FVoxelValue CellMax = FVoxelValue::Full();
+					for (int32 Child = 0; Child < 8; Child++)
+					{
+						const int32 PreviousX = FMath::Min(2 * X + bool(Child & 0x1), PreviousMip.Size.X - 1);
+						const int32 PreviousY = FMath::Min(2 * Y + bool(Child & 0x2), PreviousMip.Size.Y - 1);
+						const int32 PreviousZ = FMath::Min(2 * Z + bool(Child & 0x4), PreviousMip.Size.Z - 1);
+						const int32 PreviousIndex = PreviousX + PreviousMip.Size.X * PreviousY + PreviousMip.Size.X * PreviousMip.Size.Y * PreviousZ;
+						CellMin = FMath::Min(CellMin, PreviousMip.Min[PreviousIndex]);
+						CellMax = FMath::Max(CellMax, PreviousMip.Max[PreviousIndex]);
+					}
+					const int32 Index = X + Mip.Size.X * Y + Mip.Size.X * Mip.Size.Y * Z;
+					Mip.Min[Index] = CellMin;
+					Mip.Max[Index] = CellMax;
+				}
+			}
+		}
+		Mips.Add(MoveTemp(Mip));
+	}
+
+	bMipsDirty = false;
+	
+	INC_DWORD_STAT_BY(STAT_VoxelDataAssetMemory, GetAllocatedSize());
+}
+
 void FVoxelDataAssetData::Serialize(FArchive& Ar, uint32 ValueConfigFlag, uint32 MaterialConfigFlag, int32 VoxelCustomVersion)
 {
 	FScopedSlowTask Serializing(2.f);
@@ -168,22 +343,191 @@ void FVoxelDataAssetData::Serialize(FArchive& Ar, uint32 ValueConfigFlag, uint32
 	Ar.UsingCustomVersion(FVoxelCustomVersion::GUID);
 	Ar << Size;
 
+	// The serialized format is still flat arrays
+	TArray<FVoxelValue> FlatValues;
+	TArray<FVoxelMaterial> FlatMaterials;
+	if (Ar.IsSaving())
+	{
+		const int32 Num = Size.X * Size.Y * Size.Z;
+		FlatValues.SetNumUninitialized(Num);
+		FlatMaterials.SetNumUninitialized(HasMaterials() ? Num : 0);
+		for (int32 Z = 0; Z < Size.Z; Z++)
+		{
+			for (int32 Y = 0; Y < Size.Y; Y++)
+			{
+				for (int32 X = 0; X < Size.X; X++)
+				{
+					FlatValues[GetIndex(X, Y, Z)] = Values.Get(X, Y, Z);
+					if (HasMaterials())
+					{
+						FlatMaterials[GetIndex(X, Y, Z)] = Materials.Get(X, Y, Z);
+					}
+				}
+			}
+		}
+	}
+
 	Serializing.EnterProgressFrame(1.f, LOCTEXT("SerializingValues", "Serializing values"));
-	FVoxelSerializationUtilities::SerializeValues(Ar, Values, ValueConfigFlag, VoxelCustomVersion);
+	FVoxelSerializationUtilities::SerializeValues(Ar, FlatValues, ValueConfigFlag, VoxelCustomVersion);
 
 	Serializing.EnterProgressFrame(1.f, LOCTEXT("SerializingMaterials", "Serializing materials"));
-	FVoxelSerializationUtilities::SerializeMaterials(Ar, Materials, MaterialConfigFlag, VoxelCustomVersion);
+	FVoxelSerializationUtilities::SerializeMaterials(Ar, FlatMaterials, MaterialConfigFlag, VoxelCustomVersion);
 
-	if (Size.X * Size.Y * Size.Z != Values.Num() || (Materials.Num() > 0 && Size.X * Size.Y * Size.Z != Materials.Num()))
+	if (Size.X * Size.Y * Size.Z != FlatValues.Num() || (FlatMaterials.Num() > 0 && Size.X * Size.Y * Size.Z != FlatMaterials.Num()))
 	{
 		Ar.SetError();
+		return;
 	}
+
+	if (Ar.IsLoading())
+	{
+		DEC_DWORD_STAT_BY(STAT_VoxelDataAssetMemory, GetAllocatedSize());
+		
+		Values.Init(Size, FVoxelValue::Empty());
+		if (FlatMaterials.Num() > 0)
+		{
+			Materials.Init(Size, FVoxelMaterial::Default());
+		}
+		else
+		{
+			Materials.Empty();
+		}
+		
+		for (int32 Z = 0; Z < Size.Z; Z++)
+		{
+			for (int32 Y = 0; Y < Size.Y; Y++)
+			{
+				for (int32 X = 0; X < Size.X; X++)
+				{
+					Values.Set(X, Y, Z, FlatValues[GetIndex(X, Y, Z)]);
+					if (FlatMaterials.Num() > 0)
+					{
+						Materials.Set(X, Y, Z, FlatMaterials[GetIndex(X, Y, Z)]);
+					}
+				}
+			}
+		}
+		
+		INC_DWORD_STAT_BY(STAT_VoxelDataAssetMemory, GetAllocatedSize());
+	}
+
+	Compact();
 }
 
 ///////////////////////////////////////////////////////////////////////////////
 ///////////////////////////////////////////////////////////////////////////////
 ///////////////////////////////////////////////////////////////////////////////
 
+static void BenchmarkDataAssetBricks(const TArray<FString>& Args)
+{
+	const int32 Size = Args.Num() > 0 ? FMath::Max(2, FCString::Atoi(*Args[0])) : 256;
+	const int32 NumQueries = Args.Num() > 1 ? FMath::Max(1, FCString::Atoi(*Args[1])) : 1000;
+
+	UE_LOG(LogVoxel, Log, TEXT("Benchmarking data asset bricks: %dx%dx%d, %d queries"), Size, Size, Size, NumQueries);
+
+	// A sphere with tunnels, similar to a stamped cave network
+	FVoxelDataAssetData Data(nullptr);
+	Data.SetSize(FIntVector(Size), true);
+	{
+		const FVector Center = FVector(Size) / 2;
+		const float Radius = Size * 0.4f;
+		for (int32 Z = 0; Z < Size; Z++)
+		{
+			for (int32 Y = 0; Y < Size; Y++)
+			{
+				for (int32 X = 0; X < Size; X++)
+				{
+					const FVector P(X, Y, Z);
+					const float Sphere = FVector::Distance(P, Center) - Radius;
+					const float Tunnels = 4.f - FMath::Abs(FMath::Sin(X * 0.05f) * 16.f + FMath::Cos(Z * 0.04f) * 16.f - (Y - Center.Y) * 0.5f);
+					const float Distance = FMath::Max(Sphere, Tunnels);
+					Data.SetValue(X, Y, Z, FVoxelValue(Distance));
+					if (Distance < 2)
+					{
+						FVoxelMaterial Material = FVoxelMaterial::Default();
+						Material.SetR(Z > Center.Z ? 255 : 0);
+						Data.SetMaterial(X, Y, Z, Material);
+					}
+				}
+			}
+		}
+	}
+
+	const double CompactStartTime = FPlatformTime::Seconds();
+	Data.Compact();
+	const double CompactTime = FPlatformTime::Seconds() - CompactStartTime;
+
+	const auto& ValueBricks = Data.GetValueBricks();
+	const int32 NumBricks = ValueBricks.GetNumBricks().X * ValueBricks.GetNumBricks().Y * ValueBricks.GetNumBricks().Z;
+	const double FlatSize = double(Size) * Size * Size * (sizeof(FVoxelValue) + sizeof(FVoxelMaterial));
+
+	// Same sizes as render chunks from LOD 0 to LOD 4
+	FRandomStream Stream(1337);
+	TArray<FIntBox> Boxes;
+	for (int32 Index = 0; Index < NumQueries; Index++)
+	{
+		const int32 BoxSize = FMath::Min(Size, 32 << Stream.RandRange(0, 4));
+		const FIntVector Min(Stream.RandRange(0, Size - BoxSize), Stream.RandRange(0, Size - BoxSize), Stream.RandRange(0, Size - BoxSize));
+		Boxes.Add(FIntBox(Min, Min + FIntVector(BoxSize - 1)));
+	}
+
+	int32 NumCulled = 0;
+	const double PyramidStartTime = FPlatformTime::Seconds();
+	for (auto& Box : Boxes)
+	{
+		const TVoxelRange<v_flt> Range = Data.GetValueRange(Box, FVoxelValue::Empty());
+		if (Range.Min > 0 || Range.Max < 0)
+		{
+			NumCulled++;
+		}
+	}
+	const double PyramidTime = FPlatformTime::Seconds() - PyramidStartTime;
+
+	int32 NumCullable = 0;
+	const double ScanStartTime = FPlatformTime::Seconds();
+	for (auto& Box : Boxes)
+	{
+		FVoxelValue Min = FVoxelValue::Empty();
+		FVoxelValue Max = FVoxelValue::Full();
+		for (int32 Z = Box.Min.Z; Z <= Box.Max.Z; Z++)
+		{
+			for (int32 Y = Box.Min.Y; Y <= Box.Max.Y; Y++)
+			{
+				for (int32 X = Box.Min.X; X <= Box.Max.X; X++)
+				{
+					const FVoxelValue Value = Data.GetValueUnsafe(X, Y, Z);
+					Min = FMath::Min(Min, Value);
+					Max = FMath::Max(Max, Value);
+				}
+			}
+		}
+		if (Min.ToFloat() > 0 || Max.ToFloat() < 0)
+		{
+			NumCullable++;
+		}
+	}
+	const double ScanTime = FPlatformTime::Seconds() - ScanStartTime;
+
+	UE_LOG(LogVoxel, Log, TEXT("Compact: %fs; %d/%d uniform value bricks; %d/%d uniform material bricks"),
+		CompactTime,
+		ValueBricks.GetNumUniformBricks(),
+		NumBricks,
+		Data.GetMaterialBricks().GetNumUniformBricks(),
+		NumBricks);
+	UE_LOG(LogVoxel, Log, TEXT("Memory: flat %fMB; bricks %fMB"), FlatSize / double(1 << 20), Data.GetAllocatedSize() / double(1 << 20));
+	UE_LOG(LogVoxel, Log, TEXT("Range queries: %fus per query; scan: %fus per query"), PyramidTime / NumQueries * 1e6, ScanTime / NumQueries * 1e6);
+	UE_LOG(LogVoxel, Log, TEXT("Culled: %d/%d (%d could be culled with exact ranges)"), NumCulled, NumQueries, NumCullable);
+}
+
+static FAutoConsoleCommand BenchmarkDataAssetBricksCmd(
+	TEXT("voxel.dataasset.BenchmarkBricks"),
+	TEXT("Benchmark the data asset bricks memory usage and range queries on a generated asset. Args: Size (default 256), NumQueries (default 1000)"),
+	FConsoleCommandWithArgsDelegate::CreateStatic(&BenchmarkDataAssetBricks));
+
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+
 TVoxelSharedRef<FVoxelTransformableWorldGeneratorInstance> UVoxelDataAsset::GetTransformableInstance()
 {
 	TryLoad();
@@ -315,9 +659,7 @@ void UVoxelDataAsset::SyncProperties()
 {
 	// To access those properties without loading the asset
 	Size = Data->GetSize();
-	UncompressedSizeInMB =
-		Data->GetRawValues().Num() * sizeof(FVoxelValue) / double(1 << 20) +
-		Data->GetRawMaterials().Num() * sizeof(FVoxelMaterial) / double(1 << 20);
+	UncompressedSizeInMB = Data->GetAllocatedSize() / double(1 << 20);
 	CompressedSizeInMB = CompressedData.Num() / double(1 << 20);
 }
 
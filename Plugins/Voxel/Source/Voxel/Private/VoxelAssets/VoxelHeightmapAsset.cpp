@@ -12,6 +12,8 @@
 
 #include "Engine/Texture2D.h"
 #include "Misc/ScopedSlowTask.h"
+#include "HAL/IConsoleManager.h"
+#include "Math/RandomStream.h"
 
 #define LOCTEXT_NAMESPACE "Voxel"
 
@@ -91,8 +93,21 @@ public:
 		if (Bounds.Intersect(WorldBounds))
 		{
 			const auto ZRange = TVoxelRange<v_flt>(Bounds.Min.Z, Bounds.Max.Z);
-			const auto HeightRange = TVoxelRange<v_flt>(Wrapper.GetMinHeight(), Wrapper.GetMaxHeight());
-			return (ZRange - HeightRange) / Precision;
+			const auto HeightRange = Wrapper.GetHeightRange(
+				Bounds.Min.X + GetCenter().X,
+				Bounds.Min.Y + GetCenter().Y,
+				Bounds.Max.X + GetCenter().X,
+				Bounds.Max.Y + GetCenter().Y);
+			const auto Range = (ZRange - HeightRange) / Precision;
+			if (WorldBounds.Contains(Bounds))
+			{
+				return Range;
+			}
+			else
+			{
+				// Partially outside asset bounds
+				return TVoxelRange<v_flt>::Union(Range, 1);
+			}
 		}
 		else
 		{
@@ -124,10 +139,82 @@ public:
 			}
 		}
 	}
+	virtual void GetValues(TArrayView<const FVector> Positions, int32 LOD, const FVoxelItemStack& Items, TArrayView<v_flt> OutValues) const override final
+	{
+		check(Positions.Num() == OutValues.Num());
+
+		const FIntPoint Center = GetCenter();
+		
+		// Positions are often queried along columns: reuse the last height if X and Y did not change
+		v_flt LastX = TNumericLimits<v_flt>::Max();
+		v_flt LastY = TNumericLimits<v_flt>::Max();
+		float Height = 0;
+		
+		for (int32 Index = 0; Index < Positions.Num(); Index++)
+		{
+			const FVector& Position = Positions[Index];
+			if (!WorldBounds.ContainsFloat(Position.X, Position.Y, Position.Z))
+			{
+				// Outside asset bounds
+				OutValues[Index] = 1;
+				continue;
+			}
+			if (Position.X != LastX || Position.Y != LastY)
+			{
+				LastX = Position.X;
+				LastY = Position.Y;
+				Height = Wrapper.GetHeight(Position.X + Center.X, Position.Y + Center.Y, EVoxelSamplerMode::Clamp);
+			}
+			OutValues[Index] = (Position.Z - Height) / Precision;
+		}
+	}
 	virtual FVector GetUpVector(v_flt X, v_flt Y, v_flt Z) const override final
 	{
 		return FVector::UpVector;
 	}
+	virtual bool IsHeightfield() const override final
+	{
+		return true;
+	}
+	virtual bool GetHeightfieldColumns(const FIntBox& Bounds, int32 LOD, FVoxelHeightfieldColumns& OutColumns) const override final
+	{
+		if (Bounds.Min.Z < WorldBounds.Min.Z)
+		{
+			// Below the asset bottom, values are empty: not a heightfield
+			// Above WorldBounds.Max.Z, (Z - Height) / Precision is > 1 which is empty too
+			return false;
+		}
+
+		OutColumns.Min = FIntPoint(Bounds.Min.X, Bounds.Min.Y);
+		OutColumns.Step = 1 << LOD;
+		OutColumns.Size = FIntPoint(Bounds.Size().X / OutColumns.Step, Bounds.Size().Y / OutColumns.Step);
+		OutColumns.Precision = Precision;
+		OutColumns.Heights.SetNumUninitialized(OutColumns.Size.X * OutColumns.Size.Y);
+		OutColumns.Materials.SetNumUninitialized(OutColumns.Size.X * OutColumns.Size.Y);
+
+		for (int32 LocalY = 0; LocalY < OutColumns.Size.Y; LocalY++)
+		{
+			for (int32 LocalX = 0; LocalX < OutColumns.Size.X; LocalX++)
+			{
+				const int32 X = OutColumns.Min.X + LocalX * OutColumns.Step;
+				const int32 Y = OutColumns.Min.Y + LocalY * OutColumns.Step;
+				const int32 Index = OutColumns.GetIndex(LocalX, LocalY);
+
+				if (WorldBounds.Min.X <= X && X < WorldBounds.Max.X &&
+					WorldBounds.Min.Y <= Y && Y < WorldBounds.Max.Y)
+				{
+					OutColumns.Heights[Index] = Wrapper.GetHeight(X + GetCenter().X, Y + GetCenter().Y, EVoxelSamplerMode::Clamp);
+				}
+				else
+				{
+					// Outside asset bounds
+					OutColumns.Heights[Index] = TNumericLimits<float>::Lowest();
+				}
+				OutColumns.Materials[Index] = Wrapper.GetMaterial(X + GetCenter().X, Y + GetCenter().Y, EVoxelSamplerMode::Clamp);
+			}
+		}
+		return true;
+	}
 	//~ End FVoxelWorldGeneratorInstance Interface
 };
 
@@ -135,6 +222,60 @@ public:
 ///////////////////////////////////////////////////////////////////////////////
 ///////////////////////////////////////////////////////////////////////////////
 
+template<typename T>
+void TVoxelHeightmapAssetData<T>::BuildMinMaxPyramid()
+{
+	VOXEL_FUNCTION_COUNTER();
+
+	DEC_DWORD_STAT_BY(STAT_VoxelHeightmapAssetMemory, GetAllocatedSize());
+
+	Mips.Empty();
+	bMipsDirty = Heights.Num() == 0 || Heights.Num() != Width * Height;
+
+	if (!bMipsDirty)
+	{
+		int32 PreviousSizeX = Width;
+		int32 PreviousSizeY = Height;
+		while (PreviousSizeX > 1 || PreviousSizeY > 1)
+		{
+			FMinMaxMip Mip;
+			Mip.SizeX = FVoxelUtilities::DivideCeil(PreviousSizeX, 2);
+			Mip.SizeY = FVoxelUtilities::DivideCeil(PreviousSizeY, 2);
+			Mip.Min.SetNumUninitialized(Mip.SizeX * Mip.SizeY);
+			Mip.Max.SetNumUninitialized(Mip.SizeX * Mip.SizeY);
+
+			const FMinMaxMip* const PreviousMip = Mips.Num() > 0 ? &Mips.Last() : nullptr;
+			for (int32 Y = 0; Y < Mip.SizeY; Y++)
+			{
+				for (int32 X = 0; X < Mip.SizeX; X++)
+				{
+					T Min = TNumericLimits<T>::Max();
+					T Max = TNumericLimits<T>::Lowest();
+					for (int32 DY = 0; DY < 2; DY++)
+					{
+						for (int32 DX = 0; DX < 2; DX++)
+						{
+							const int32 PreviousX = FMath::Min(2 * X + DX, PreviousSizeX - 1);
+							const int32 PreviousY = FMath::Min(2 * Y + DY, PreviousSizeY - 1);
+							const int32 PreviousIndex = PreviousX + PreviousSizeX * PreviousY;
+							Min = FMath::Min(Min, PreviousMip ? PreviousMip->Min[PreviousIndex] : Heights[PreviousIndex]);
+							Max = FMath::Max(Max, PreviousMip ? PreviousMip->Max[PreviousIndex] : Heights[PreviousIndex]);
+						}
+					}
+					Mip.Min[X + Mip.SizeX * Y] = Min;
+					Mip.Max[X + Mip.SizeX * Y] = Max;
+				}
+			}
+
+			PreviousSizeX = Mip.SizeX;
+			PreviousSizeY = Mip.SizeY;
+			Mips.Add(MoveTemp(Mip));
+		}
+	}
+
+	INC_DWORD_STAT_BY(STAT_VoxelHeightmapAssetMemory, GetAllocatedSize());
+}
+
 template<typename T>
 void TVoxelHeightmapAssetData<T>::SerializeAsset(FArchive& Ar, uint32 MaterialConfigFlag, int32 VoxelCustomVersion)
 {
@@ -161,9 +302,95 @@ void TVoxelHeightmapAssetData<T>::SerializeAsset(FArchive& Ar, uint32 MaterialCo
 	if (Width * Height != Heights.Num() || (Materials.Num() > 0 && Width * Height != Materials.Num()))
 	{
 		Ar.SetError();
+		return;
+	}
+
+	// Not serialized: it's fast enough to build, and that way the asset format doesn't change
+	BuildMinMaxPyramid();
+}
+
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+
+static void BenchmarkHeightmapMinMaxPyramid(const TArray<FString>& Args)
+{
+	const int32 Size = Args.Num() > 0 ? FMath::Max(2, FCString::Atoi(*Args[0])) : 8192;
+	const int32 NumQueries = Args.Num() > 1 ? FMath::Max(1, FCString::Atoi(*Args[1])) : 1000;
+	
+	UE_LOG(LogVoxel, Log, TEXT("Benchmarking heightmap min/max pyramid: %dx%d, %d queries"), Size, Size, NumQueries);
+
+	TVoxelHeightmapAssetData<uint16> Data(nullptr);
+	Data.SetSize(Size, Size, false);
+	FRandomStream Stream(1337);
+	for (int32 Y = 0; Y < Size; Y++)
+	{
+		for (int32 X = 0; X < Size; X++)
+		{
+			// Smooth hills with some noise so that ranges aren't trivial
+			const float Hills = FMath::Sin(X * 0.003f) * FMath::Cos(Y * 0.002f);
+			Data.SetHeight(X, Y, uint16(FMath::Clamp(32768.f + 20000.f * Hills + Stream.FRandRange(-500.f, 500.f), 0.f, 65535.f)));
+		}
+	}
+
+	const double BuildStartTime = FPlatformTime::Seconds();
+	Data.BuildMinMaxPyramid();
+	const double BuildTime = FPlatformTime::Seconds() - BuildStartTime;
+
+	// Same sizes as render chunks from LOD 0 to LOD 8
+	TArray<FIntRect> Rects;
+	for (int32 Index = 0; Index < NumQueries; Index++)
+	{
+		const int32 RectSize = FMath::Min(Size, 32 << Stream.RandRange(0, 8));
+		const int32 MinX = Stream.RandRange(0, Size - RectSize);
+		const int32 MinY = Stream.RandRange(0, Size - RectSize);
+		Rects.Add(FIntRect(MinX, MinY, MinX + RectSize - 1, MinY + RectSize - 1));
+	}
+
+	uint64 ScanError = 0;
+
+	const double PyramidStartTime = FPlatformTime::Seconds();
+	TArray<TPair<uint16, uint16>> PyramidRanges;
+	for (auto& Rect : Rects)
+	{
+		uint16 Min;
+		uint16 Max;
+		Data.GetHeightRange(Rect.Min.X, Rect.Min.Y, Rect.Max.X, Rect.Max.Y, Min, Max);
+		PyramidRanges.Emplace(Min, Max);
+	}
+	const double PyramidTime = FPlatformTime::Seconds() - PyramidStartTime;
+
+	const double ScanStartTime = FPlatformTime::Seconds();
+	for (int32 Index = 0; Index < Rects.Num(); Index++)
+	{
+		const FIntRect& Rect = Rects[Index];
+		uint16 Min = MAX_uint16;
+		uint16 Max = 0;
+		for (int32 Y = Rect.Min.Y; Y <= Rect.Max.Y; Y++)
+		{
+			for (int32 X = Rect.Min.X; X <= Rect.Max.X; X++)
+			{
+				const uint16 Value = Data.GetHeightUnsafe(X, Y);
+				Min = FMath::Min(Min, Value);
+				Max = FMath::Max(Max, Value);
+			}
+		}
+		ensure(PyramidRanges[Index].Key <= Min && Max <= PyramidRanges[Index].Value);
+		ScanError += (Min - PyramidRanges[Index].Key) + (PyramidRanges[Index].Value - Max);
 	}
+	const double ScanTime = FPlatformTime::Seconds() - ScanStartTime;
+
+	UE_LOG(LogVoxel, Log, TEXT("Pyramid build: %fs; memory overhead: %fMB"), BuildTime, (Data.GetAllocatedSize() - Size * Size * sizeof(uint16)) / double(1 << 20));
+	UE_LOG(LogVoxel, Log, TEXT("Pyramid queries: %fs; %fus per query"), PyramidTime, PyramidTime / NumQueries * 1e6);
+	UE_LOG(LogVoxel, Log, TEXT("Scan queries: %fs; %fus per query"), ScanTime, ScanTime / NumQueries * 1e6);
+	UE_LOG(LogVoxel, Log, TEXT("Speedup: %fx; average pyramid range error: %f"), ScanTime / FMath::Max(PyramidTime, SMALL_NUMBER), double(ScanError) / NumQueries);
 }
 
+static FAutoConsoleCommand BenchmarkHeightmapMinMaxPyramidCmd(
+	TEXT("voxel.heightmap.BenchmarkMinMaxPyramid"),
+	TEXT("Benchmark the heightmap min/max pyramid against a full scan. Args: Size (default 8192), NumQueries (default 1000)"),
+	FConsoleCommandWithArgsDelegate::CreateStatic(&BenchmarkHeightmapMinMaxPyramid));
+
 ///////////////////////////////////////////////////////////////////////////////
 ///////////////////////////////////////////////////////////////////////////////
 ///////////////////////////////////////////////////////////////////////////////
@@ -4,11 +4,13 @@
 #include "VoxelData/VoxelSaveUtilities.h"
 #include "VoxelData/VoxelDataUtilities.h"
 #include "VoxelWorldGeneratorHelpers.h"
+#include "VoxelWorldGeneratorBakeCache.h"
 #include "VoxelWorld.h"
 #include "StackArray.h"
 
 #include "Misc/ScopeLock.h"
 #include "Async/Async.h"
+#include "HAL/ThreadSingleton.h"
 
 TAutoConsoleVariable<int32> CVarMaxPlaceableItemsPerOctree(
 		TEXT("voxel.data.MaxPlaceableItemsPerOctree"),
@@ -27,12 +29,27 @@ inline auto CreateWorldGenerator(const AVoxelWorld* World)
 	return WorldGeneratorInstance;
 }
 
+inline TVoxelSharedPtr<const FVoxelWorldGeneratorBakeCache> CreateBakeCache(const AVoxelWorld* World)
+{
+	if (!World->bEnableWorldGeneratorBakeCache)
+	{
+		return nullptr;
+	}
+	auto* WorldGeneratorObject = World->WorldGenerator.GetWorldGenerator();
+	if (!WorldGeneratorObject)
+	{
+		return nullptr;
+	}
+	return FVoxelWorldGeneratorBakeCache::Create(*WorldGeneratorObject, World->GetInitStruct());
+}
+
 FVoxelDataSettings::FVoxelDataSettings(const AVoxelWorld* World, EVoxelPlayType PlayType)
 	: Depth(FVoxelUtilities::ClampDataDepth(FVoxelUtilities::GetDataDepthFromChunkDepth(World->OctreeDepth)))
 	, WorldBounds(World->GetWorldBounds())
 	, WorldGenerator(CreateWorldGenerator(World))
 	, bEnableMultiplayer(false)
 	, bEnableUndoRedo(PlayType == EVoxelPlayType::Game ? World->bEnableUndoRedo : true)
+	, BakeCache(CreateBakeCache(World))
 {
 }
 
@@ -74,6 +91,7 @@ FVoxelData::FVoxelData(const FVoxelDataSettings& Settings)
 	, bEnableMultiplayer(Settings.bEnableMultiplayer)
 	, bEnableUndoRedo(Settings.bEnableUndoRedo)
 	, WorldGenerator(Settings.WorldGenerator)
+	, BakeCache(Settings.BakeCache)
 	, Octree(MakeUnique<FVoxelDataOctreeParent>(Depth))
 {
 	check(Depth > 0);
@@ -394,11 +412,126 @@ void FVoxelData::CheckIsSingle(const FIntBox& Bounds)
 template VOXEL_API void FVoxelData::CheckIsSingle<FVoxelValue   >(const FIntBox&);
 template VOXEL_API void FVoxelData::CheckIsSingle<FVoxelMaterial>(const FIntBox&);
 
+// Values read by PrefetchBakedValues, used by the next Get of the same thread
+struct FVoxelBakedValuesPrefetch : TThreadSingleton<FVoxelBakedValuesPrefetch>
+{
+	TVoxelWeakPtr<const FVoxelWorldGeneratorBakeCache> BakeCache;
+	FIntBox Bounds;
+	int32 LOD = 0;
+	bool bLoaded = false;
+	TArray<FVoxelValue> Values;
+};
+
+void FVoxelData::PrefetchBakedValues(const FIntBox& Bounds, int32 LOD) const
+{
+	if (!BakeCache.IsValid())
+	{
+		return;
+	}
+
+	VOXEL_FUNCTION_COUNTER();
+	
+	const FIntVector Size = Bounds.Size() / (1 << LOD);
+	
+	auto& Prefetch = FVoxelBakedValuesPrefetch::Get();
+	Prefetch.BakeCache = BakeCache;
+	Prefetch.Bounds = Bounds;
+	Prefetch.LOD = LOD;
+	Prefetch.Values.SetNumUninitialized(Size.X * Size.Y * Size.Z, false);
+	Prefetch.bLoaded = BakeCache->LoadValues(Bounds, LOD, Prefetch.Values);
+}
+
+// Only the values are baked
+inline bool GetBakedValues(const FVoxelData& Data, TVoxelQueryZone<FVoxelMaterial>& QueryZone, int32 LOD, bool& bOutNeedsToBake)
+{
+	bOutNeedsToBake = false;
+	return false;
+}
+inline void BakeValues(const FVoxelData& Data, const TVoxelQueryZone<FVoxelMaterial>& QueryZone, int32 LOD)
+{
+	checkVoxelSlow(false);
+}
+
+inline bool GetBakedValues(const FVoxelData& Data, TVoxelQueryZone<FVoxelValue>& QueryZone, int32 LOD, bool& bOutNeedsToBake)
+{
+	bOutNeedsToBake = false;
+	
+	if (!Data.BakeCache.IsValid())
+	{
+		return false;
+	}
+	
+	auto& Prefetch = FVoxelBakedValuesPrefetch::Get();
+	// The prefetched values are spaced by 1 << LOD: the zone step must match for the copy below to follow their layout
+	if (!Prefetch.BakeCache.HasSameObject(Data.BakeCache.Get()) ||
+		Prefetch.Bounds != QueryZone.Bounds ||
+		Prefetch.LOD != LOD ||
+		QueryZone.Step != uint32(1 << LOD))
+	{
+		return false;
+	}
+	Prefetch.BakeCache.Reset();
+	
+	// Edits or items might have been added since the values were baked
+	if (!Data.IsGeneratorOnly(QueryZone.Bounds))
+	{
+		return false;
+	}
+
+	if (!Prefetch.bLoaded)
+	{
+		bOutNeedsToBake = true;
+		return false;
+	}
+	
+	VOXEL_SLOW_SCOPE_COUNTER("Copy Baked Values");
+	int32 Index = 0;
+	for (VOXEL_QUERY_ZONE_ITERATE(QueryZone, Z))
+	{
+		for (VOXEL_QUERY_ZONE_ITERATE(QueryZone, Y))
+		{
+			for (VOXEL_QUERY_ZONE_ITERATE(QueryZone, X))
+			{
+				checkVoxelSlow(Prefetch.Values.IsValidIndex(Index));
+				QueryZone.Set(X, Y, Z, Prefetch.Values.GetData()[Index++]);
+			}
+		}
+	}
+	checkVoxelSlow(Index == Prefetch.Values.Num());
+	return true;
+}
+inline void BakeValues(const FVoxelData& Data, const TVoxelQueryZone<FVoxelValue>& QueryZone, int32 LOD)
+{
+	VOXEL_FUNCTION_COUNTER();
+
+	const FIntVector Size = QueryZone.Bounds.Size() / QueryZone.Step;
+	
+	TArray<FVoxelValue> Values;
+	Values.Reserve(Size.X * Size.Y * Size.Z);
+	for (VOXEL_QUERY_ZONE_ITERATE(QueryZone, Z))
+	{
+		for (VOXEL_QUERY_ZONE_ITERATE(QueryZone, Y))
+		{
+			for (VOXEL_QUERY_ZONE_ITERATE(QueryZone, X))
+			{
+				Values.Add(QueryZone.Get(X, Y, Z));
+			}
+		}
+	}
+	Data.BakeCache->SaveValuesAsync(QueryZone.Bounds, LOD, MoveTemp(Values));
+}
+
 template<typename T>
 void FVoxelData::Get(TVoxelQueryZone<T>& GlobalQueryZone, int32 LOD) const
 {
 	VOXEL_FUNCTION_COUNTER();
 
+	bool bNeedsToBake;
+	if (GetBakedValues(*this, GlobalQueryZone, LOD, bNeedsToBake))
+	{
+		return;
+	}
+
 	FVoxelOctreeUtilities::IterateTreeInBounds(GetOctree(), GlobalQueryZone.Bounds, [&](FVoxelDataOctreeBase& InOctree)
 	{
 		if (!InOctree.IsLeafOrHasNoChildren()) return;
@@ -461,6 +594,11 @@ void FVoxelData::Get(TVoxelQueryZone<T>& GlobalQueryZone, int32 LOD) const
 			WorldGenerator->Get(LocalQueryZone, LOD, FVoxelItemStack::Empty);
 		}
 	}
+
+	if (bNeedsToBake)
+	{
+		BakeValues(*this, GlobalQueryZone, LOD);
+	}
 }
 
 template VOXEL_API void FVoxelData::Get<FVoxelValue   >(TVoxelQueryZone<FVoxelValue   >&, int32) const;
@@ -556,6 +694,40 @@ TVoxelRange<FVoxelValue> FVoxelData::GetValueRange(const FIntBox& Bounds, int32
 	return Result.Get(FVoxelValue::Empty());
 }
 
+bool FVoxelData::IsGeneratorOnly(const FIntBox& Bounds) const
+{
+	VOXEL_FUNCTION_COUNTER();
+
+	return FVoxelOctreeUtilities::IterateTreeInBoundsEarlyExit(GetOctree(), Bounds, [&](FVoxelDataOctreeBase& Tree)
+	{
+		if (!Tree.IsLeafOrHasNoChildren()) return true;
+		ensureThreadSafe(Tree.IsLockedForRead());
+
+		if (Tree.IsLeaf())
+		{
+			auto& Leaf = Tree.AsLeaf();
+			// Non dirty data is a cache of the generator
+			if (Leaf.Values.IsDirty() || Leaf.Materials.IsDirty())
+			{
+				return false;
+			}
+		}
+
+		for (auto& Items : Tree.GetItemHolder().GetAllItems())
+		{
+			for (auto* Item : Items)
+			{
+				if (Item->Bounds.Intersect(Bounds))
+				{
+					return false;
+				}
+			}
+		}
+
+		return true;
+	});
+}
+
 TVoxelRange<v_flt> FVoxelData::GetCustomOutputRange(TVoxelRange<v_flt> DefaultValue, FName Name, const FIntBox& Bounds, int32 LOD) const
 {
 	VOXEL_FUNCTION_COUNTER();
@@ -10,6 +10,7 @@
 #include "VoxelTools/VoxelDataTools.h"
 #include "VoxelMessages.h"
 #include "VoxelWorld.h"
+#include "VoxelWorldGeneratorInstance.inl"
 #include "IVoxelPool.h"
 
 #include "Engine/Engine.h"
@@ -197,6 +198,61 @@ static FAutoConsoleCommandWithWorldAndArgs CheckForSingleMaterialsCmd(
 			World.GetData().CheckIsSingle<FVoxelMaterial>(FIntBox::Infinite);
 		}));
 
+static void BenchmarkCustomOutputs(AVoxelWorld& World)
+{
+	const FVoxelWorldGeneratorInstance& WorldGenerator = *World.GetData().WorldGenerator;
+	const FVoxelItemStack& Items = FVoxelItemStack::Empty;
+	constexpr int32 NumSamples = 1000000;
+
+	TArray<FVector> Positions;
+	Positions.SetNumUninitialized(NumSamples);
+	FRandomStream Stream(1337);
+	for (auto& Position : Positions)
+	{
+		Position = FVector(Stream.FRandRange(-1000, 1000), Stream.FRandRange(-1000, 1000), Stream.FRandRange(-1000, 1000));
+	}
+	TArray<v_flt> Values;
+	Values.SetNumUninitialized(NumSamples);
+
+	UE_LOG(LogVoxel, Log, TEXT("Benchmarking %s custom outputs: %d samples"), *World.GetName(), NumSamples);
+	for (auto& It : WorldGenerator.FloatOutputsPtr)
+	{
+		const FName Name = It.Key;
+		
+		const double ByNameStartTime = FPlatformTime::Seconds();
+		for (int32 Index = 0; Index < NumSamples; Index++)
+		{
+			const FVector& Position = Positions[Index];
+			Values[Index] = WorldGenerator.GetCustomOutput<v_flt>(0, Name, Position.X, Position.Y, Position.Z, 0, Items);
+		}
+		const double ByNameTime = FPlatformTime::Seconds() - ByNameStartTime;
+
+		const double ByHandleStartTime = FPlatformTime::Seconds();
+		const auto Handle = WorldGenerator.GetCustomOutputHandle<v_flt>(Name);
+		for (int32 Index = 0; Index < NumSamples; Index++)
+		{
+			const FVector& Position = Positions[Index];
+			Values[Index] = WorldGenerator.GetCustomOutput<v_flt>(Handle, 0, Position.X, Position.Y, Position.Z, 0, Items);
+		}
+		const double ByHandleTime = FPlatformTime::Seconds() - ByHandleStartTime;
+
+		const double BatchedStartTime = FPlatformTime::Seconds();
+		WorldGenerator.GetCustomOutputs<v_flt>(WorldGenerator.GetCustomOutputHandle<v_flt>(Name), 0, Positions, 0, Items, Values);
+		const double BatchedTime = FPlatformTime::Seconds() - BatchedStartTime;
+
+		UE_LOG(LogVoxel, Log, TEXT("%s: by name: %.4fus/call; by handle: %.4fus/call; batched: %.4fus/call"),
+			*Name.ToString(),
+			ByNameTime * 1e6 / NumSamples,
+			ByHandleTime * 1e6 / NumSamples,
+			BatchedTime * 1e6 / NumSamples);
+	}
+}
+
+static FAutoConsoleCommandWithWorldAndArgs BenchmarkCustomOutputsCmd(
+	TEXT("voxel.generator.BenchmarkCustomOutputs"),
+	TEXT("Compare the cost of querying the world generator float custom outputs by name, by handle and batched"),
+	CreateCommandWithVoxelWorldDelegate(&BenchmarkCustomOutputs));
+
 static void LogSecondsPerCycles()
 {
     UE_LOG(LogVoxel, Log, TEXT("SECONDS PER CYCLES: %e"), FPlatformTime::GetSecondsPerCycle());
@@ -3,8 +3,16 @@
 #include "VoxelPlaceableItems/VoxelPlaceableItem.h"
 #include "VoxelMessages.h"
 
+#include "HAL/ThreadSafeCounter64.h"
+
 const FVoxelPlaceableItemHolder FVoxelPlaceableItemHolder::Empty;
 
+uint64 FVoxelPlaceableItem::NewSerialNumber()
+{
+	static FThreadSafeCounter64 Counter;
+	return Counter.Increment();
+}
+
 FVoxelPlaceableItemLoader* FVoxelPlaceableItemLoader::GetLoader(uint8 ItemId)
 {
 	auto& Loaders = GetStaticLoaders();
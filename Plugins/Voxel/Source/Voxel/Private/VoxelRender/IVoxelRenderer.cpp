@@ -79,6 +79,7 @@ FVoxelRendererSettingsBase::FVoxelRendererSettingsBase(
 	, bCleanCollisionMeshes(InWorld->bCleanCollisionMeshes)
 
 	, RenderType(InWorld->RenderType)
+	, bGreedyCubicMeshing(InWorld->RenderType == EVoxelRenderType::Cubic && InWorld->bGreedyCubicMeshing)
 	, bCreateMaterialInstances(InPlayType == EVoxelPlayType::Game
 		? InWorld->bCreateMaterialInstances && !InWorld->bMergeChunks
 		: false /* we don't want to created dynamic material instances in editor */)
@@ -86,6 +87,9 @@ FVoxelRendererSettingsBase::FVoxelRendererSettingsBase(
 	, ChunksDitheringDuration(InWorld->ChunksDitheringDuration)
 
 	, bOptimizeIndices(InWorld->bOptimizeIndices)
+	, bPackVertices(InWorld->bPackVertices)
+	, MinSimplificationLOD(InWorld->bSimplifyFarChunks && InWorld->RenderType == EVoxelRenderType::MarchingCubes ? FMath::Max(0, InWorld->MinSimplificationLOD) : MAX_int32)
+	, SimplificationMaxError(FMath::Max(0.f, InWorld->SimplificationMaxError))
 	, MaxDistanceFieldLOD(InWorld->bGenerateDistanceFields ? InWorld->MaxDistanceFieldLOD : -1)
 	, bOneMaterialPerCubeSide(InWorld->MaterialConfig == EVoxelMaterialConfig::SingleIndex && InWorld->bOneMaterialPerCubeSide)
 	, bHalfPrecisionCoordinates(InWorld->bHalfPrecisionCoordinates)
@@ -3,6 +3,8 @@
 #include "VoxelRender/Meshers/VoxelCubicMesher.h"
 #include "VoxelRender/Meshers/VoxelMesherUtilities.h"
 #include "VoxelRender/IVoxelRenderer.h"
+#include "HAL/IConsoleManager.h"
+#include "HAL/ThreadSingleton.h"
 
 struct FVoxelCubicFullVertex : FVoxelMesherVertex
 {
@@ -64,11 +66,13 @@ struct FVoxelCubicGeometryVertex : FVector
 };
 static_assert(sizeof(FVoxelCubicGeometryVertex) == sizeof(FVector), "");
 
+// Size: size of the quad in voxels, used by greedy meshing. Must be 1 along the face normal
 template<EVoxelDirection::Type Direction, typename TVertex, typename TMesher>
 FORCEINLINE void AddFace(
 	TMesher& Mesher, int32 Step, FVoxelMaterial Material, 
 	int32 X, int32 Y, int32 Z, 
-	TArray<uint32>& Indices, TArray<TVertex>& Vertices)
+	TArray<uint32>& Indices, TArray<TVertex>& Vertices,
+	const FIntVector& Size = FIntVector(1))
 {
 	if (TVertex::bComputeMaterial && Mesher.Settings.bOneMaterialPerCubeSide)
 	{
@@ -162,7 +166,8 @@ FORCEINLINE void AddFace(
 	for (int32 Index = 0; Index < 4; Index++)
 	{
 		const FVector VertexPositionInCube = Positions[Index];
-		const FVector VertexPosition = (VertexPositionInCube + FVector(X, Y, Z)) * Step;
+		const FVector VertexPositionInQuad = VertexPositionInCube * FVector(Size);
+		const FVector VertexPosition = (VertexPositionInQuad + FVector(X, Y, Z)) * Step;
 		
 		TVertex Vertex;
 		Vertex.SetPosition(VertexPosition);
@@ -203,12 +208,14 @@ FORCEINLINE void AddFace(
 			}
 			else if (Mesher.Settings.UVConfig == EVoxelUVConfig::PackWorldUpInUVs)
 			{
-				TextureCoordinate = FVoxelMesherUtilities::GetUVs(Mesher, FVector(X, Y, Z));
+				// Use the voxel at this corner of the quad
+				TextureCoordinate = FVoxelMesherUtilities::GetUVs(Mesher, FVector(X, Y, Z) + VertexPositionInCube * FVector(Size - FIntVector(1)));
 			}
 			else
 			{
 				check(Mesher.Settings.UVConfig == EVoxelUVConfig::PerVoxelUVs);
-				const auto& V = VertexPositionInCube;
+				// Tiled across greedy quads
+				const auto& V = VertexPositionInQuad;
 				switch (Direction)
 				{
 				case EVoxelDirection::XMin:
@@ -253,6 +260,450 @@ FORCEINLINE void AddFace(
 ///////////////////////////////////////////////////////////////////////////////
 ///////////////////////////////////////////////////////////////////////////////
 
+// Merges the cells of a Size x Size grid into maximal rectangles, growing them along X first and then along Y
+// Cells[X + Size * Y] is the value of the cell, or -1 if it has no face. Merged cells are set to -1
+// CanMerge(CellA, CellB) must be transitive, eg by comparing materials
+template<typename TCanMerge, typename TAddRectangle>
+FORCEINLINE void GreedyMerge2D(int32 Size, int32* RESTRICT Cells, TCanMerge CanMerge, TAddRectangle AddRectangle)
+{
+	for (int32 Y = 0; Y < Size; Y++)
+	{
+		for (int32 X = 0; X < Size;)
+		{
+			const int32 Cell = Cells[X + Size * Y];
+			if (Cell < 0)
+			{
+				X++;
+				continue;
+			}
+
+			const auto CanMergeWith = [&](int32 OtherX, int32 OtherY)
+			{
+				const int32 OtherCell = Cells[OtherX + Size * OtherY];
+				return OtherCell >= 0 && CanMerge(Cell, OtherCell);
+			};
+
+			int32 Width = 1;
+			while (X + Width < Size && CanMergeWith(X + Width, Y))
+			{
+				Width++;
+			}
+
+			int32 Height = 1;
+			for (; Y + Height < Size; Height++)
+			{
+				bool bCanMergeRow = true;
+				for (int32 DX = 0; DX < Width && bCanMergeRow; DX++)
+				{
+					bCanMergeRow = CanMergeWith(X + DX, Y + Height);
+				}
+				if (!bCanMergeRow) break;
+			}
+
+			for (int32 DY = 0; DY < Height; DY++)
+			{
+				for (int32 DX = 0; DX < Width; DX++)
+				{
+					Cells[(X + DX) + Size * (Y + DY)] = -1;
+				}
+			}
+
+			AddRectangle(X, Y, Width, Height, Cell);
+			X += Width;
+		}
+	}
+}
+
+// Values: CUBIC_CHUNK_SIZE_WITH_NEIGHBORS^3 values, with a 1 voxel border
+// OutFlags: RENDER_CHUNK_SIZE^3 flags, EVoxelDirection bits set for every visible face
+inline void ComputeCubicFaceFlags(const FVoxelValue* RESTRICT Values, uint8* RESTRICT OutFlags)
+{
+	constexpr int32 SX = 1;
+	constexpr int32 SY = CUBIC_CHUNK_SIZE_WITH_NEIGHBORS;
+	constexpr int32 SZ = CUBIC_CHUNK_SIZE_WITH_NEIGHBORS * CUBIC_CHUNK_SIZE_WITH_NEIGHBORS;
+	
+	for (int32 Z = 0; Z < RENDER_CHUNK_SIZE; Z++)
+	{
+		for (int32 Y = 0; Y < RENDER_CHUNK_SIZE; Y++)
+		{
+			for (int32 X = 0; X < RENDER_CHUNK_SIZE; X++)
+			{
+				const int32 Index = (X + 1) * SX + (Y + 1) * SY + (Z + 1) * SZ;
+				uint8& Flag = OutFlags[X + Y * RENDER_CHUNK_SIZE + Z * RENDER_CHUNK_SIZE * RENDER_CHUNK_SIZE];
+				if (Values[Index].IsEmpty())
+				{
+					Flag = 0;
+					continue;
+				}
+				Flag =
+					(Values[Index - SX].IsEmpty() << 0) |
+					(Values[Index + SX].IsEmpty() << 1) |
+					(Values[Index - SY].IsEmpty() << 2) |
+					(Values[Index + SY].IsEmpty() << 3) |
+					(Values[Index - SZ].IsEmpty() << 4) |
+					(Values[Index + SZ].IsEmpty() << 5);
+			}
+		}
+	}
+}
+
+// Merges the faces facing Direction slice by slice
+// CanMerge(IndexA, IndexB) is called with voxel indices in Flags
+// AddQuad(Position, Size, Index) is called with the quad voxel position & size, and the index of its first voxel
+template<EVoxelDirection::Type Direction, typename TCanMerge, typename TAddQuad>
+FORCEINLINE void GreedyMergeCubicFaces(const uint8* RESTRICT Flags, TCanMerge CanMerge, TAddQuad AddQuad)
+{
+	constexpr int32 NormalAxis =
+		(Direction == EVoxelDirection::XMin || Direction == EVoxelDirection::XMax)
+		? 0
+		: (Direction == EVoxelDirection::YMin || Direction == EVoxelDirection::YMax)
+		? 1
+		: 2;
+	constexpr int32 UAxis = (NormalAxis + 1) % 3;
+	constexpr int32 VAxis = (NormalAxis + 2) % 3;
+
+	TStackArray<int32, RENDER_CHUNK_SIZE * RENDER_CHUNK_SIZE> Cells;
+	for (int32 W = 0; W < RENDER_CHUNK_SIZE; W++)
+	{
+		bool bHasFaces = false;
+		for (int32 V = 0; V < RENDER_CHUNK_SIZE; V++)
+		{
+			for (int32 U = 0; U < RENDER_CHUNK_SIZE; U++)
+			{
+				FIntVector Position;
+				Position[NormalAxis] = W;
+				Position[UAxis] = U;
+				Position[VAxis] = V;
+				
+				const int32 Index = Position.X + Position.Y * RENDER_CHUNK_SIZE + Position.Z * RENDER_CHUNK_SIZE * RENDER_CHUNK_SIZE;
+				const bool bHasFace = Flags[Index] & Direction;
+				Cells[U + V * RENDER_CHUNK_SIZE] = bHasFace ? Index : -1;
+				bHasFaces |= bHasFace;
+			}
+		}
+		if (!bHasFaces) continue;
+
+		GreedyMerge2D(RENDER_CHUNK_SIZE, Cells.GetData(), CanMerge, [&](int32 U, int32 V, int32 Width, int32 Height, int32 Index)
+		{
+			FIntVector Position;
+			Position[NormalAxis] = W;
+			Position[UAxis] = U;
+			Position[VAxis] = V;
+
+			FIntVector Size(1);
+			Size[UAxis] = Width;
+			Size[VAxis] = Height;
+
+			AddQuad(Position, Size, Index);
+		});
+	}
+}
+
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+
+static void BenchmarkGreedyCubicMeshing(const TArray<FString>& Args)
+{
+	const int32 NumRuns = Args.Num() > 0 ? FMath::Max(1, FCString::Atoi(*Args[0])) : 1000;
+	constexpr int32 DataSize = CUBIC_CHUNK_SIZE_WITH_NEIGHBORS;
+	constexpr int32 ChunkSize = RENDER_CHUNK_SIZE;
+
+	const auto CountFaces = [](uint8 Flag)
+	{
+		int32 Count = 0;
+		for (int32 Bit = 0; Bit < 6; Bit++)
+		{
+			Count += (Flag >> Bit) & 0x1;
+		}
+		return Count;
+	};
+
+	bool bAllValid = true;
+	const auto Benchmark = [&](const TCHAR* Name, TFunctionRef<float(int32, int32, int32)> GetValue, TFunctionRef<uint8(int32, int32, int32)> GetMaterial)
+	{
+		TArray<FVoxelValue> Values;
+		Values.SetNumUninitialized(DataSize * DataSize * DataSize);
+		for (int32 Z = 0; Z < DataSize; Z++)
+		{
+			for (int32 Y = 0; Y < DataSize; Y++)
+			{
+				for (int32 X = 0; X < DataSize; X++)
+				{
+					Values[X + DataSize * Y + DataSize * DataSize * Z] = FVoxelValue(GetValue(X - 1, Y - 1, Z - 1));
+				}
+			}
+		}
+		
+		TArray<uint8> Materials;
+		Materials.SetNumUninitialized(ChunkSize * ChunkSize * ChunkSize);
+		for (int32 Z = 0; Z < ChunkSize; Z++)
+		{
+			for (int32 Y = 0; Y < ChunkSize; Y++)
+			{
+				for (int32 X = 0; X < ChunkSize; X++)
+				{
+					Materials[X + ChunkSize * Y + ChunkSize * ChunkSize * Z] = GetMaterial(X, Y, Z);
+				}
+			}
+		}
+		const auto CanMerge = [&](int32 IndexA, int32 IndexB) { return Materials[IndexA] == Materials[IndexB]; };
+
+		TStackArray<uint8, ChunkSize * ChunkSize * ChunkSize> Flags;
+
+		int32 NumFaces = 0;
+		const double FacesStartTime = FPlatformTime::Seconds();
+		for (int32 Run = 0; Run < NumRuns; Run++)
+		{
+			ComputeCubicFaceFlags(Values.GetData(), Flags.GetData());
+			for (uint8 Flag : Flags)
+			{
+				NumFaces += CountFaces(Flag);
+			}
+		}
+		const double FacesTime = FPlatformTime::Seconds() - FacesStartTime;
+
+		int32 NumQuads = 0;
+		const double GreedyStartTime = FPlatformTime::Seconds();
+		for (int32 Run = 0; Run < NumRuns; Run++)
+		{
+			ComputeCubicFaceFlags(Values.GetData(), Flags.GetData());
+			const auto AddQuad = [&](const FIntVector&, const FIntVector&, int32) { NumQuads++; };
+			GreedyMergeCubicFaces<EVoxelDirection::XMin>(Flags.GetData(), CanMerge, AddQuad);
+			GreedyMergeCubicFaces<EVoxelDirection::XMax>(Flags.GetData(), CanMerge, AddQuad);
+			GreedyMergeCubicFaces<EVoxelDirection::YMin>(Flags.GetData(), CanMerge, AddQuad);
+			GreedyMergeCubicFaces<EVoxelDirection::YMax>(Flags.GetData(), CanMerge, AddQuad);
+			GreedyMergeCubicFaces<EVoxelDirection::ZMin>(Flags.GetData(), CanMerge, AddQuad);
+			GreedyMergeCubicFaces<EVoxelDirection::ZMax>(Flags.GetData(), CanMerge, AddQuad);
+		}
+		const double GreedyTime = FPlatformTime::Seconds() - GreedyStartTime;
+
+		// Watertightness: the quads must cover exactly the per voxel faces, without overlaps and without mixing materials
+		// The quads boundaries are then checked to be closed below
+		TStackArray<uint8, ChunkSize * ChunkSize * ChunkSize> CoveredFlags;
+		CoveredFlags.Memzero();
+		int32 NumOverlaps = 0;
+		int32 NumInvalidFaces = 0;
+		int32 NumMaterialErrors = 0;
+		const auto CheckQuad = [&](EVoxelDirection::Type Direction, const FIntVector& Position, const FIntVector& Size, int32 Index)
+		{
+			for (int32 Z = Position.Z; Z < Position.Z + Size.Z; Z++)
+			{
+				for (int32 Y = Position.Y; Y < Position.Y + Size.Y; Y++)
+				{
+					for (int32 X = Position.X; X < Position.X + Size.X; X++)
+					{
+						const int32 VoxelIndex = X + ChunkSize * Y + ChunkSize * ChunkSize * Z;
+						NumOverlaps += bool(CoveredFlags[VoxelIndex] & Direction);
+						NumInvalidFaces += !(Flags[VoxelIndex] & Direction);
+						NumMaterialErrors += Materials[VoxelIndex] != Materials[Index];
+						CoveredFlags[VoxelIndex] |= Direction;
+					}
+				}
+			}
+		};
+#define CHECK_QUADS(Direction) \
+		GreedyMergeCubicFaces<Direction>(Flags.GetData(), CanMerge, [&](const FIntVector& Position, const FIntVector& Size, int32 Index) \
+		{ \
+			CheckQuad(Direction, Position, Size, Index); \
+		})
+		CHECK_QUADS(EVoxelDirection::XMin);
+		CHECK_QUADS(EVoxelDirection::XMax);
+		CHECK_QUADS(EVoxelDirection::YMin);
+		CHECK_QUADS(EVoxelDirection::YMax);
+		CHECK_QUADS(EVoxelDirection::ZMin);
+		CHECK_QUADS(EVoxelDirection::ZMax);
+#undef CHECK_QUADS
+		
+		int32 NumMissingFaces = 0;
+		for (int32 Index = 0; Index < Flags.Num(); Index++)
+		{
+			NumMissingFaces += CountFaces(Flags[Index] & ~CoveredFlags[Index]);
+		}
+
+		// Edge manifoldness: the quads boundaries are split in unit edges. Inside the chunk, every unit edge must be used as many times in both directions,
+		// and the greedy quads must not add edges shared by more than 2 quads: per voxel faces already have some, between diagonal voxels
+		// Edges on the chunk faces are skipped, as the surface is cut there
+		// Limitation: the quads are not split at T-junctions, ie a quad corner can lie in the middle of a neighbor quad edge
+		// The mesh is closed as the positions are exact, but the rasterizer can show single pixel cracks along such edges
+		constexpr int32 NumPoints = ChunkSize + 1;
+		struct FEdges
+		{
+			// Uses of the unit edge from Point along Axis, minus the uses in the opposite direction
+			TArray<int32> Balances;
+			TArray<int32> Uses;
+		};
+		const auto AddQuadEdges = [&](FEdges& Edges, EVoxelDirection::Type Direction, const FIntVector& Position, const FIntVector& Size)
+		{
+			const int32 NormalAxis =
+				(Direction == EVoxelDirection::XMin || Direction == EVoxelDirection::XMax)
+				? 0
+				: (Direction == EVoxelDirection::YMin || Direction == EVoxelDirection::YMax)
+				? 1
+				: 2;
+			const bool bIsMax = Direction == EVoxelDirection::XMax || Direction == EVoxelDirection::YMax || Direction == EVoxelDirection::ZMax;
+			const int32 UAxis = (NormalAxis + 1) % 3;
+			const int32 VAxis = (NormalAxis + 2) % 3;
+
+			// Counterclockwise around the face normal: C0 -> C1 -> C2 -> C3
+			FIntVector C0 = Position;
+			C0[NormalAxis] += bIsMax ? 1 : 0;
+			FIntVector C1 = C0;
+			C1[UAxis] += Size[UAxis];
+			FIntVector C3 = C0;
+			C3[VAxis] += Size[VAxis];
+			const int32 Sign = bIsMax ? 1 : -1;
+
+			const auto AddEdges = [&](const FIntVector& Start, int32 Axis, int32 EdgeSign)
+			{
+				for (int32 Offset = 0; Offset < Size[Axis]; Offset++)
+				{
+					FIntVector Point = Start;
+					Point[Axis] += Offset;
+					const int32 EdgeIndex = Axis + 3 * (Point.X + NumPoints * Point.Y + NumPoints * NumPoints * Point.Z);
+					Edges.Balances[EdgeIndex] += EdgeSign;
+					Edges.Uses[EdgeIndex]++;
+				}
+			};
+			AddEdges(C0, UAxis, Sign);
+			AddEdges(C1, VAxis, Sign);
+			AddEdges(C3, UAxis, -Sign);
+			AddEdges(C0, VAxis, -Sign);
+		};
+		const auto CountEdges = [&](const FEdges& Edges, int32& OutNumOpenEdges, int32& OutNumNonManifoldEdges)
+		{
+			OutNumOpenEdges = 0;
+			OutNumNonManifoldEdges = 0;
+			for (int32 Z = 0; Z < NumPoints; Z++)
+			{
+				for (int32 Y = 0; Y < NumPoints; Y++)
+				{
+					for (int32 X = 0; X < NumPoints; X++)
+					{
+						const FIntVector Point(X, Y, Z);
+						for (int32 Axis = 0; Axis < 3; Axis++)
+						{
+							const int32 AxisA = (Axis + 1) % 3;
+							const int32 AxisB = (Axis + 2) % 3;
+							if (Point[Axis] == ChunkSize ||
+								Point[AxisA] == 0 || Point[AxisA] == ChunkSize ||
+								Point[AxisB] == 0 || Point[AxisB] == ChunkSize)
+							{
+								continue;
+							}
+							const int32 EdgeIndex = Axis + 3 * (X + NumPoints * Y + NumPoints * NumPoints * Z);
+							OutNumOpenEdges += Edges.Balances[EdgeIndex] != 0;
+							OutNumNonManifoldEdges += Edges.Uses[EdgeIndex] > 2;
+						}
+					}
+				}
+			}
+		};
+
+		FEdges VoxelEdges;
+		VoxelEdges.Balances.SetNumZeroed(3 * NumPoints * NumPoints * NumPoints);
+		VoxelEdges.Uses.SetNumZeroed(3 * NumPoints * NumPoints * NumPoints);
+		FEdges GreedyEdges = VoxelEdges;
+		for (int32 Z = 0; Z < ChunkSize; Z++)
+		{
+			for (int32 Y = 0; Y < ChunkSize; Y++)
+			{
+				for (int32 X = 0; X < ChunkSize; X++)
+				{
+					const uint8 Flag = Flags[X + ChunkSize * Y + ChunkSize * ChunkSize * Z];
+					for (int32 Bit = 0; Bit < 6; Bit++)
+					{
+						const auto Direction = EVoxelDirection::Type(1 << Bit);
+						if (Flag & Direction)
+						{
+							AddQuadEdges(VoxelEdges, Direction, FIntVector(X, Y, Z), FIntVector(1));
+						}
+					}
+				}
+			}
+		}
+#define ADD_QUADS_EDGES(Direction) \
+		GreedyMergeCubicFaces<Direction>(Flags.GetData(), CanMerge, [&](const FIntVector& Position, const FIntVector& Size, int32 Index) \
+		{ \
+			AddQuadEdges(GreedyEdges, Direction, Position, Size); \
+		})
+		ADD_QUADS_EDGES(EVoxelDirection::XMin);
+		ADD_QUADS_EDGES(EVoxelDirection::XMax);
+		ADD_QUADS_EDGES(EVoxelDirection::YMin);
+		ADD_QUADS_EDGES(EVoxelDirection::YMax);
+		ADD_QUADS_EDGES(EVoxelDirection::ZMin);
+		ADD_QUADS_EDGES(EVoxelDirection::ZMax);
+#undef ADD_QUADS_EDGES
+
+		int32 NumVoxelOpenEdges;
+		int32 NumVoxelNonManifoldEdges;
+		CountEdges(VoxelEdges, NumVoxelOpenEdges, NumVoxelNonManifoldEdges);
+		ensure(NumVoxelOpenEdges == 0);
+		
+		int32 NumOpenEdges;
+		int32 NumNonManifoldEdges;
+		CountEdges(GreedyEdges, NumOpenEdges, NumNonManifoldEdges);
+
+		const bool bValid =
+			NumOverlaps == 0 &&
+			NumInvalidFaces == 0 &&
+			NumMaterialErrors == 0 &&
+			NumMissingFaces == 0 &&
+			NumOpenEdges == 0 &&
+			NumNonManifoldEdges <= NumVoxelNonManifoldEdges;
+		ensure(bValid);
+		bAllValid &= bValid;
+		
+		NumFaces /= NumRuns;
+		NumQuads /= NumRuns;
+		UE_LOG(LogVoxel, Log, TEXT("%s: %d triangles per voxel faces; %d triangles greedy (%5.2f%% less); faces: %.2fus; greedy: %.2fus; %s"),
+			Name,
+			2 * NumFaces,
+			2 * NumQuads,
+			NumFaces > 0 ? (1 - NumQuads / double(NumFaces)) * 100 : 0,
+			FacesTime / NumRuns * 1e6,
+			GreedyTime / NumRuns * 1e6,
+			bValid ? TEXT("watertight") : TEXT("NOT WATERTIGHT"));
+		if (!bValid)
+		{
+			UE_LOG(LogVoxel, Error, TEXT("%s: %d overlaps, %d invalid faces, %d material errors, %d missing faces, %d open edges, %d non manifold edges (%d with per voxel faces)"),
+				Name,
+				NumOverlaps,
+				NumInvalidFaces,
+				NumMaterialErrors,
+				NumMissingFaces,
+				NumOpenEdges,
+				NumNonManifoldEdges,
+				NumVoxelNonManifoldEdges);
+		}
+	};
+
+	UE_LOG(LogVoxel, Log, TEXT("Benchmarking greedy cubic meshing: %d runs"), NumRuns);
+
+	const auto SingleMaterial = [](int32 X, int32 Y, int32 Z) { return uint8(0); };
+	const auto Layers = [](int32 X, int32 Y, int32 Z) { return uint8(Z / 4); };
+	const auto Noise = [](int32 X, int32 Y, int32 Z) { return uint8((X * 7 + Y * 13 + Z * 17) % 3 == 0); };
+	
+	Benchmark(TEXT("Flat"), [](int32 X, int32 Y, int32 Z) { return Z - 16.3f; }, SingleMaterial);
+	Benchmark(TEXT("Hills"), [](int32 X, int32 Y, int32 Z) { return Z - 16.f - 8.f * FMath::Sin(X * 0.2f) * FMath::Cos(Y * 0.15f); }, SingleMaterial);
+	Benchmark(TEXT("Hills Layers"), [](int32 X, int32 Y, int32 Z) { return Z - 16.f - 8.f * FMath::Sin(X * 0.2f) * FMath::Cos(Y * 0.15f); }, Layers);
+	Benchmark(TEXT("Sphere"), [](int32 X, int32 Y, int32 Z) { return FVector(X - 16, Y - 16, Z - 16).Size() - 14.5f; }, SingleMaterial);
+	Benchmark(TEXT("Caves"), [](int32 X, int32 Y, int32 Z) { return FMath::Sin(X * 0.5f) + FMath::Sin(Y * 0.6f) + FMath::Sin(Z * 0.7f); }, SingleMaterial);
+	Benchmark(TEXT("Caves Noise"), [](int32 X, int32 Y, int32 Z) { return FMath::Sin(X * 0.5f) + FMath::Sin(Y * 0.6f) + FMath::Sin(Z * 0.7f); }, Noise);
+
+	UE_LOG(LogVoxel, Log, TEXT("Greedy cubic meshing %s"), bAllValid ? TEXT("passed") : TEXT("FAILED"));
+	UE_LOG(LogVoxel, Log, TEXT("Note: greedy quads are not split at T-junctions, which can show single pixel cracks when rendered"));
+}
+
+static FAutoConsoleCommand BenchmarkGreedyCubicMeshingCmd(
+	TEXT("voxel.mesher.BenchmarkGreedyCubic"),
+	TEXT("Compare the triangle count & meshing time of greedy cubic meshing against per voxel faces on reference chunks, and check that the greedy quads exactly cover the faces with manifold edges. Args: NumRuns (default 1000)"),
+	FConsoleCommandWithArgsDelegate::CreateStatic(&BenchmarkGreedyCubicMeshing));
+
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+
 FIntBox FVoxelCubicMesher::GetBoundsToCheckIsEmptyOn() const
 {
 	return FIntBox(ChunkPosition - FIntVector(Step), ChunkPosition - FIntVector(Step) + CUBIC_CHUNK_SIZE_WITH_NEIGHBORS * Step);
@@ -263,6 +714,11 @@ FIntBox FVoxelCubicMesher::GetBoundsToLock() const
 	return GetBoundsToCheckIsEmptyOn();
 }
 
+FIntBox FVoxelCubicMesher::GetBoundsToPrefetch() const
+{
+	return GetBoundsToCheckIsEmptyOn();
+}
+
 TVoxelSharedPtr<FVoxelChunkMesh> FVoxelCubicMesher::CreateFullChunkImpl(FVoxelMesherTimes& Times)
 {
 	TArray<FVoxelCubicFullVertex> Vertices;
@@ -299,6 +755,12 @@ void FVoxelCubicMesher::CreateGeometryTemplate(FVoxelMesherTimes& Times, TArray<
 
 	TVoxelQueryZone<FVoxelValue> QueryZone(GetBoundsToCheckIsEmptyOn(), FIntVector(CUBIC_CHUNK_SIZE_WITH_NEIGHBORS), LOD, CachedValues);
 	MESHER_TIME_VALUES(CUBIC_CHUNK_SIZE_WITH_NEIGHBORS * CUBIC_CHUNK_SIZE_WITH_NEIGHBORS * CUBIC_CHUNK_SIZE_WITH_NEIGHBORS, Data.Get<FVoxelValue>(QueryZone, LOD));
+
+	if (Settings.bGreedyCubicMeshing)
+	{
+		CreateGreedyGeometryTemplate(Times, Indices, Vertices);
+		return;
+	}
 	
 	{
 		VOXEL_SCOPE_COUNTER("Iteration");
@@ -345,6 +807,63 @@ void FVoxelCubicMesher::CreateGeometryTemplate(FVoxelMesherTimes& Times, TArray<
 	}
 }
 
+// Face flags of the greedy cubic meshers, reused by all the meshers of a thread instead of being stored in every mesher
+struct FVoxelCubicMesherScratch : TThreadSingleton<FVoxelCubicMesherScratch>
+{
+	TStackArray<uint8, RENDER_CHUNK_SIZE * RENDER_CHUNK_SIZE * RENDER_CHUNK_SIZE> FaceFlags;
+};
+
+template<typename T>
+void FVoxelCubicMesher::CreateGreedyGeometryTemplate(FVoxelMesherTimes& Times, TArray<uint32>& Indices, TArray<T>& Vertices)
+{
+	VOXEL_SCOPE_COUNTER("Greedy Iteration");
+
+	auto& FaceFlags = FVoxelCubicMesherScratch::Get().FaceFlags;
+	ComputeCubicFaceFlags(CachedValues.GetData(), FaceFlags.GetData());
+
+	TArray<FVoxelMaterial> Materials;
+	if (T::bComputeMaterial)
+	{
+		Materials.SetNumUninitialized(FaceFlags.Num());
+		for (int32 Z = 0; Z < RENDER_CHUNK_SIZE; Z++)
+		{
+			for (int32 Y = 0; Y < RENDER_CHUNK_SIZE; Y++)
+			{
+				for (int32 X = 0; X < RENDER_CHUNK_SIZE; X++)
+				{
+					const int32 Index = X + Y * RENDER_CHUNK_SIZE + Z * RENDER_CHUNK_SIZE * RENDER_CHUNK_SIZE;
+					if (!FaceFlags[Index]) continue;
+					
+					Materials[Index] = MESHER_TIME_RETURN_MATERIALS(1, Accelerator->GetMaterial(
+						X + ChunkPosition.X,
+						Y + ChunkPosition.Y,
+						Z + ChunkPosition.Z,
+						LOD));
+				}
+			}
+		}
+	}
+
+	const auto CanMerge = [&](int32 IndexA, int32 IndexB)
+	{
+		return !T::bComputeMaterial || Materials[IndexA] == Materials[IndexB];
+	};
+
+#define ADD_GREEDY_FACES(Direction) \
+	GreedyMergeCubicFaces<Direction>(FaceFlags.GetData(), CanMerge, [&](const FIntVector& Position, const FIntVector& Size, int32 Index) \
+	{ \
+		const FVoxelMaterial Material = T::bComputeMaterial ? Materials[Index] : FVoxelMaterial(); \
+		AddFace<Direction>(*this, Step, Material, Position.X, Position.Y, Position.Z, Indices, Vertices, Size); \
+	})
+	ADD_GREEDY_FACES(EVoxelDirection::XMin);
+	ADD_GREEDY_FACES(EVoxelDirection::XMax);
+	ADD_GREEDY_FACES(EVoxelDirection::YMin);
+	ADD_GREEDY_FACES(EVoxelDirection::YMax);
+	ADD_GREEDY_FACES(EVoxelDirection::ZMin);
+	ADD_GREEDY_FACES(EVoxelDirection::ZMax);
+#undef ADD_GREEDY_FACES
+}
+
 FORCEINLINE FVoxelValue FVoxelCubicMesher::GetValue(int32 X, int32 Y, int32 Z) const
 {
 	checkVoxelSlow(
@@ -427,6 +946,18 @@ void FVoxelCubicTransitionsMesher::CreateTransitionsForDirection(FVoxelMesherTim
 {
 	if (!(TransitionsMask & Direction)) return;
 
+	// When greedy meshing, the faces are first stored here and merged at the end
+	// Cells are indices in CellMaterials, or -1
+	const bool bGreedy = Settings.bGreedyCubicMeshing;
+	TArray<FVoxelMaterial> CellMaterials;
+	TArray<int32> BigCells;
+	TArray<int32> SmallCells;
+	if (bGreedy)
+	{
+		BigCells.Init(-1, RENDER_CHUNK_SIZE * RENDER_CHUNK_SIZE);
+		SmallCells.Init(-1, 4 * RENDER_CHUNK_SIZE * RENDER_CHUNK_SIZE);
+	}
+
 	for (int32 LX = 0; LX < RENDER_CHUNK_SIZE; LX++)
 	{
 		for (int32 LY = 0; LY < RENDER_CHUNK_SIZE; LY++)
@@ -475,7 +1006,14 @@ void FVoxelCubicTransitionsMesher::CreateTransitionsForDirection(FVoxelMesherTim
 				constexpr EVoxelDirection::Type FaceDirection = Direction;
 				
 				const auto Material = MESHER_TIME_RETURN_MATERIALS(1, GetMaterial<Direction>(Step, LX * Step, LY * Step, 0));
-				Add2DFace<Direction, FaceDirection>(Step, Material, LX, LY, Vertices, Indices);
+				if (bGreedy)
+				{
+					BigCells[LX + LY * RENDER_CHUNK_SIZE] = CellMaterials.Add(Material);
+				}
+				else
+				{
+					Add2DFace<Direction, FaceDirection>(Step, Material, LX, LY, Vertices, Indices);
+				}
 			}
 			else
 			{
@@ -523,25 +1061,55 @@ void FVoxelCubicTransitionsMesher::CreateTransitionsForDirection(FVoxelMesherTim
 				constexpr EVoxelDirection::Type FaceDirection = InverseVoxelDirection<Direction>();
 				
 				const auto Material = MESHER_TIME_RETURN_MATERIALS(1, GetMaterial<Direction>(Step, LX * Step, LY * Step, -HalfStep));
+				const int32 MaterialIndex = bGreedy ? CellMaterials.Add(Material) : -1;
+				const auto AddSmallFace = [&](int32 SX, int32 SY)
+				{
+					if (bGreedy)
+					{
+						SmallCells[SX + SY * 2 * RENDER_CHUNK_SIZE] = MaterialIndex;
+					}
+					else
+					{
+						Add2DFace<Direction, FaceDirection>(HalfStep, Material, SX, SY, Vertices, Indices);
+					}
+				};
 				if (AreBothFull & 0x1)
 				{
-					Add2DFace<Direction, FaceDirection>(HalfStep, Material, 2 * LX + 0, 2 * LY + 0, Vertices, Indices);
+					AddSmallFace(2 * LX + 0, 2 * LY + 0);
 				}
 				if (AreBothFull & 0x2)
 				{
-					Add2DFace<Direction, FaceDirection>(HalfStep, Material, 2 * LX + 1, 2 * LY + 0, Vertices, Indices);
+					AddSmallFace(2 * LX + 1, 2 * LY + 0);
 				}
 				if (AreBothFull & 0x4)
 				{
-					Add2DFace<Direction, FaceDirection>(HalfStep, Material, 2 * LX + 0, 2 * LY + 1, Vertices, Indices);
+					AddSmallFace(2 * LX + 0, 2 * LY + 1);
 				}
 				if (AreBothFull & 0x8)
 				{
-					Add2DFace<Direction, FaceDirection>(HalfStep, Material, 2 * LX + 1, 2 * LY + 1, Vertices, Indices);
+					AddSmallFace(2 * LX + 1, 2 * LY + 1);
 				}
 			}
 		}
 	}
+
+	if (bGreedy && CellMaterials.Num() > 0)
+	{
+		VOXEL_SCOPE_COUNTER("Greedy Merge");
+		
+		const auto CanMerge = [&](int32 CellA, int32 CellB)
+		{
+			return CellMaterials[CellA] == CellMaterials[CellB];
+		};
+		GreedyMerge2D(RENDER_CHUNK_SIZE, BigCells.GetData(), CanMerge, [&](int32 LX, int32 LY, int32 Width, int32 Height, int32 Cell)
+		{
+			Add2DFace<Direction, Direction>(Step, CellMaterials[Cell], LX, LY, Vertices, Indices, Width, Height);
+		});
+		GreedyMerge2D(2 * RENDER_CHUNK_SIZE, SmallCells.GetData(), CanMerge, [&](int32 LX, int32 LY, int32 Width, int32 Height, int32 Cell)
+		{
+			Add2DFace<Direction, InverseVoxelDirection<Direction>()>(HalfStep, CellMaterials[Cell], LX, LY, Vertices, Indices, Width, Height);
+		});
+	}
 }
 
 template<EVoxelDirection::Type Direction>
@@ -569,14 +1137,19 @@ void FVoxelCubicTransitionsMesher::Add2DFace(
 	int32 InStep, 
 	const FVoxelMaterial& Material, 
 	int32 LX, int32 LY, 
-	TArray<TVertex>& Vertices, TArray<uint32>& Indices)
+	TArray<TVertex>& Vertices, TArray<uint32>& Indices,
+	int32 Width, int32 Height)
 {
 	const int32 LZ = IsDirectionMax<FaceDirection>()
 		? IsDirectionMax<Direction>() ? 1 : -1
 		: 0;
 
-	const FIntVector P = Local2DToGlobal<Direction>(Step / InStep * RENDER_CHUNK_SIZE, LX, LY, LZ);
-	AddFace<FaceDirection>(*this, InStep, Material, P.X, P.Y, P.Z, Indices, Vertices);
+	const int32 Size = Step / InStep * RENDER_CHUNK_SIZE;
+	const FIntVector P = Local2DToGlobal<Direction>(Size, LX, LY, LZ);
+	// Local2DToGlobal only permutes LX & LY: the delta is positive, and 0 along the face normal
+	const FIntVector Delta = Local2DToGlobal<Direction>(Size, LX + Width, LY + Height, LZ) - P;
+	const FIntVector FaceSize(FMath::Max(Delta.X, 1), FMath::Max(Delta.Y, 1), FMath::Max(Delta.Z, 1));
+	AddFace<FaceDirection>(*this, InStep, Material, P.X, P.Y, P.Z, Indices, Vertices, FaceSize);
 }
 
 template<EVoxelDirection::Type Direction>
@@ -18,6 +18,7 @@ public:
 protected:
 	virtual FIntBox GetBoundsToCheckIsEmptyOn() const override final;
 	virtual FIntBox GetBoundsToLock() const override final;
+	virtual FIntBox GetBoundsToPrefetch() const override final;
 	virtual TVoxelSharedPtr<FVoxelChunkMesh> CreateFullChunkImpl(FVoxelMesherTimes& Times) override final;
 	virtual void CreateGeometryImpl(FVoxelMesherTimes& Times, TArray<uint32>& Indices, TArray<FVector>& Vertices) override final;
 	
@@ -28,6 +29,8 @@ private:
 private:
 	template<typename T>
 	void CreateGeometryTemplate(FVoxelMesherTimes& Times, TArray<uint32>& Indices, TArray<T>& Vertices);
+	template<typename T>
+	void CreateGreedyGeometryTemplate(FVoxelMesherTimes& Times, TArray<uint32>& Indices, TArray<T>& Vertices);
 
 private:
 	FVoxelValue GetValue(int32 X, int32 Y, int32 Z) const;
@@ -57,12 +60,14 @@ private:
 	FVoxelMaterial GetMaterial(int32 InStep, int32 X, int32 Y, int32 Z) const;
 
 	// LX * HalfStep = GX
+	// Width, Height: size of the face in InStep units, used by greedy meshing
 	template<EVoxelDirection::Type Direction, EVoxelDirection::Type FaceDirection, typename TVertex>
 	void Add2DFace(
 		int32 InStep, 
 		const FVoxelMaterial& Material, 
 		int32 LX, int32 LY, 
-		TArray<TVertex>& Vertices, TArray<uint32>& Indices);
+		TArray<TVertex>& Vertices, TArray<uint32>& Indices,
+		int32 Width = 1, int32 Height = 1);
 	
 	template<EVoxelDirection::Type Direction>
 	static FIntVector Local2DToGlobal(int32 InSize, int32 LX, int32 LY, int32 LZ);
@@ -0,0 +1,148 @@
+// Copyright 2020 Phyronnaz
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "VoxelValue.h"
+
+#if PLATFORM_ENABLE_VECTORINTRINSICS_NEON
+#include <arm_neon.h>
+#define VOXEL_EMPTY_MASK_NEON 1
+#define VOXEL_EMPTY_MASK_SSE2 0
+#elif PLATFORM_ENABLE_VECTORINTRINSICS
+#include <emmintrin.h>
+#define VOXEL_EMPTY_MASK_NEON 0
+#define VOXEL_EMPTY_MASK_SSE2 1
+#else
+#define VOXEL_EMPTY_MASK_NEON 0
+#define VOXEL_EMPTY_MASK_SSE2 0
+#endif
+
+static_assert(RENDER_CHUNK_SIZE + 1 <= 64, "Row masks are stored in uint64");
+
+// First pass of the marching cubes: find the cells that have a nontrivial triangulation without looking at them one by one
+// Builds a bitmask of the empty corners for each row along X, and combines the 4 row masks around each cell row
+namespace FVoxelMarchingCubeActiveCells
+{
+	using FStorage = decltype(FVoxelValue().GetStorage());
+	static_assert(sizeof(FVoxelValue) == sizeof(FStorage), "");
+	
+#if VOXEL_EMPTY_MASK_NEON
+	// Mask bytes must be 0 or 0xFF
+	FORCEINLINE uint32 MoveMask8(uint8x8_t Mask)
+	{
+		static const uint8 Weights[8] = { 1, 2, 4, 8, 16, 32, 64, 128 };
+		uint8x8_t Sum = vand_u8(Mask, vld1_u8(Weights));
+		Sum = vpadd_u8(Sum, Sum);
+		Sum = vpadd_u8(Sum, Sum);
+		Sum = vpadd_u8(Sum, Sum);
+		return vget_lane_u8(Sum, 0);
+	}
+#endif
+	
+	// Bit N is set if Values[N] > 0, for N < 8
+	FORCEINLINE uint32 GetPositiveMask8(const int8* RESTRICT Values)
+	{
+#if VOXEL_EMPTY_MASK_SSE2
+		const __m128i Vector = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(Values));
+		return _mm_movemask_epi8(_mm_cmpgt_epi8(Vector, _mm_setzero_si128())) & 0xFF;
+#elif VOXEL_EMPTY_MASK_NEON
+		return MoveMask8(vcgt_s8(vld1_s8(Values), vdup_n_s8(0)));
+#else
+		uint32 Mask = 0;
+		for (int32 Index = 0; Index < 8; Index++)
+		{
+			Mask |= uint32(Values[Index] > 0) << Index;
+		}
+		return Mask;
+#endif
+	}
+	FORCEINLINE uint32 GetPositiveMask8(const int16* RESTRICT Values)
+	{
+#if VOXEL_EMPTY_MASK_SSE2
+		const __m128i Vector = _mm_loadu_si128(reinterpret_cast<const __m128i*>(Values));
+		const __m128i Compare = _mm_cmpgt_epi16(Vector, _mm_setzero_si128());
+		return _mm_movemask_epi8(_mm_packs_epi16(Compare, _mm_setzero_si128())) & 0xFF;
+#elif VOXEL_EMPTY_MASK_NEON
+		return MoveMask8(vmovn_u16(vcgtq_s16(vld1q_s16(Values), vdupq_n_s16(0))));
+#else
+		uint32 Mask = 0;
+		for (int32 Index = 0; Index < 8; Index++)
+		{
+			Mask |= uint32(Values[Index] > 0) << Index;
+		}
+		return Mask;
+#endif
+	}
+	
+	// Bit N is set if Values[N].IsEmpty(), for N < Num <= 64
+	FORCEINLINE uint64 GetEmptyMask(const FVoxelValue* RESTRICT Values, int32 Num)
+	{
+		checkVoxelSlow(Num <= 64);
+		const FStorage* RESTRICT const Storage = reinterpret_cast<const FStorage*>(Values);
+		
+		uint64 Mask = 0;
+		int32 Index = 0;
+		for (; Index + 8 <= Num; Index += 8)
+		{
+			Mask |= uint64(GetPositiveMask8(Storage + Index)) << Index;
+		}
+		for (; Index < Num; Index++)
+		{
+			Mask |= uint64(Values[Index].IsEmpty()) << Index;
+		}
+		return Mask;
+	}
+	
+	// Cells of the slice LZ, with a nontrivial triangulation. Encoded as LX | (LY << 16), sorted by LY then LX
+	// Values: X + DataSize * Y + DataSize * DataSize * Z, first corner at (Offset, Offset, Offset)
+	// SliceMasks: empty masks of the corners rows at Z = LZ, filled by the previous call if LZ != 0. Updated to the rows at Z = LZ + 1
+	template<typename TArrayType>
+	FORCEINLINE void FindActiveCells(
+		const FVoxelValue* RESTRICT Values,
+		int32 DataSize,
+		int32 Offset,
+		int32 LZ,
+		uint64* RESTRICT SliceMasks,
+		uint64* RESTRICT NextSliceMasks,
+		TArrayType& OutCells)
+	{
+		constexpr int32 NumCorners = RENDER_CHUNK_SIZE + 1;
+		
+		const auto GetRow = [&](int32 Y, int32 Z)
+		{
+			return Values + Offset + DataSize * (Y + Offset) + DataSize * DataSize * (Z + Offset);
+		};
+		
+		if (LZ == 0)
+		{
+			for (int32 Y = 0; Y < NumCorners; Y++)
+			{
+				SliceMasks[Y] = GetEmptyMask(GetRow(Y, 0), NumCorners);
+			}
+		}
+		for (int32 Y = 0; Y < NumCorners; Y++)
+		{
+			NextSliceMasks[Y] = GetEmptyMask(GetRow(Y, LZ + 1), NumCorners);
+		}
+
+		constexpr uint64 CellsMask = (uint64(1) << RENDER_CHUNK_SIZE) - 1;
+		for (int32 LY = 0; LY < RENDER_CHUNK_SIZE; LY++)
+		{
+			const uint64 AllEmpty = SliceMasks[LY] & SliceMasks[LY + 1] & NextSliceMasks[LY] & NextSliceMasks[LY + 1];
+			const uint64 AnyEmpty = SliceMasks[LY] | SliceMasks[LY + 1] | NextSliceMasks[LY] | NextSliceMasks[LY + 1];
+
+			// Cell LX uses the corners LX and LX + 1
+			const uint64 AllEmptyCells = AllEmpty & (AllEmpty >> 1);
+			const uint64 AnyEmptyCells = AnyEmpty | (AnyEmpty >> 1);
+			
+			uint64 ActiveCells = AnyEmptyCells & ~AllEmptyCells & CellsMask;
+			while (ActiveCells)
+			{
+				const uint32 LX = FMath::CountTrailingZeros64(ActiveCells);
+				OutCells.Add(LX | (LY << 16));
+				ActiveCells &= ActiveCells - 1;
+			}
+		}
+	}
+}
\ No newline at end of file
@@ -5,11 +5,189 @@
 #include "VoxelRender/IVoxelRenderer.h"
 #include "VoxelData/VoxelData.h"
 #include "VoxelData/VoxelDataUtilities.h"
+#include "VoxelRender/Meshers/VoxelMarchingCubeActiveCells.h"
 #include "Transvoxel.h"
 #include "HAL/IConsoleManager.h"
+#include "HAL/ThreadSingleton.h"
+#include "HAL/ThreadSafeCounter64.h"
 
 #define checkError(x) if(!(x)) { return false; }
 
+static TAutoConsoleVariable<int32> CVarGridNormals(
+	TEXT("voxel.mesher.GridNormals"),
+	1,
+	TEXT("If true, marching cubes normals will be interpolated from the gradient of the cached values when possible, instead of querying the data for each vertex"),
+	ECVF_Default);
+
+static TAutoConsoleVariable<int32> CVarBatchMaterials(
+	TEXT("voxel.mesher.BatchMaterials"),
+	1,
+	TEXT("If true, LOD 0 marching cubes chunks will query the materials of their unique voxels at once instead of querying them for each vertex"),
+	ECVF_Default);
+
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+
+// Materials of the LOD 0 grid points used by the vertices of a chunk
+// Vertices share a lot of voxels: the unique ones are queried once, block by block.
+// Dense blocks are queried with a single query zone, the others through the accelerator
+class FVoxelMarchingCubeMaterialsBatch
+{
+public:
+	// Indices: CHUNK_SIZE_WITH_END_EDGE^3 indices, all -1. Reset to -1 when the batch is destroyed
+	FVoxelMarchingCubeMaterialsBatch(const FVoxelData& Data, const FVoxelConstDataAccelerator& Accelerator, const FIntVector& ChunkPosition, int32* RESTRICT Indices)
+		: Data(Data)
+		, Accelerator(Accelerator)
+		, ChunkPosition(ChunkPosition)
+		, Indices(Indices)
+	{
+	}
+	~FVoxelMarchingCubeMaterialsBatch()
+	{
+		for (const int32 Index : Positions)
+		{
+			Indices[Index] = -1;
+		}
+	}
+
+	// P: local position
+	FORCEINLINE void Add(const FIntVector& P)
+	{
+		int32& MaterialIndex = Indices[GetIndex(P)];
+		if (MaterialIndex == -1)
+		{
+			// Set by Fetch
+			MaterialIndex = -2;
+			Positions.Add(GetIndex(P));
+		}
+	}
+	void Fetch()
+	{
+		VOXEL_FUNCTION_COUNTER();
+		
+		// Sort the positions by block
+		TStackArray<int32, NumBlocks * NumBlocks * NumBlocks + 1> BlockStarts;
+		TStackArray<FIntVector, NumBlocks * NumBlocks * NumBlocks> BlockMins;
+		TStackArray<FIntVector, NumBlocks * NumBlocks * NumBlocks> BlockMaxs;
+		BlockStarts.Memzero();
+		for (int32 Block = 0; Block < NumBlocks * NumBlocks * NumBlocks; Block++)
+		{
+			BlockMins[Block] = FIntVector(MAX_int32);
+			BlockMaxs[Block] = FIntVector(MIN_int32);
+		}
+		for (const int32 Index : Positions)
+		{
+			const FIntVector P = GetPosition(Index);
+			const int32 Block = GetBlock(P);
+			BlockStarts[Block + 1]++;
+			BlockMins[Block] = FVoxelUtilities::ComponentMin(BlockMins[Block], P);
+			BlockMaxs[Block] = FVoxelUtilities::ComponentMax(BlockMaxs[Block], P);
+		}
+		for (int32 Block = 0; Block < NumBlocks * NumBlocks * NumBlocks; Block++)
+		{
+			BlockStarts[Block + 1] += BlockStarts[Block];
+		}
+		
+		TArray<int32> SortedPositions;
+		SortedPositions.SetNumUninitialized(Positions.Num());
+		{
+			TStackArray<int32, NumBlocks * NumBlocks * NumBlocks> BlockEnds;
+			FMemory::Memcpy(BlockEnds.GetData(), BlockStarts.GetData(), BlockEnds.Num() * sizeof(int32));
+			for (const int32 Index : Positions)
+			{
+				SortedPositions[BlockEnds[GetBlock(GetPosition(Index))]++] = Index;
+			}
+		}
+
+		Materials.Reset(Positions.Num());
+		for (int32 Block = 0; Block < NumBlocks * NumBlocks * NumBlocks; Block++)
+		{
+			const int32 Start = BlockStarts[Block];
+			const int32 End = BlockStarts[Block + 1];
+			if (Start == End)
+			{
+				continue;
+			}
+
+			const FIntVector Min = BlockMins[Block];
+			const FIntVector Size = BlockMaxs[Block] - Min + FIntVector(1);
+			const int32 Volume = Size.X * Size.Y * Size.Z;
+			// Querying a voxel of the block costs about as much as querying it through the accelerator,
+			// so only query the whole block if most of its voxels are used
+			if (2 * (End - Start) >= Volume)
+			{
+				const int32 MaterialsStart = Materials.AddUninitialized(Volume);
+				TVoxelQueryZone<FVoxelMaterial> QueryZone(
+					FIntBox(ChunkPosition + Min, ChunkPosition + Min + Size),
+					Size,
+					0,
+					Materials.GetData() + MaterialsStart);
+				Data.Get<FVoxelMaterial>(QueryZone, 0);
+
+				for (int32 SortedIndex = Start; SortedIndex < End; SortedIndex++)
+				{
+					const int32 Index = SortedPositions[SortedIndex];
+					const FIntVector P = GetPosition(Index) - Min;
+					Indices[Index] = MaterialsStart + P.X + Size.X * P.Y + Size.X * Size.Y * P.Z;
+				}
+			}
+			else
+			{
+				for (int32 SortedIndex = Start; SortedIndex < End; SortedIndex++)
+				{
+					const int32 Index = SortedPositions[SortedIndex];
+					Indices[Index] = Materials.Add(Accelerator.GetMaterial(GetPosition(Index) + ChunkPosition, 0));
+				}
+			}
+		}
+	}
+
+	// P: local position, must have been added before Fetch
+	FORCEINLINE const FVoxelMaterial& Get(const FIntVector& P) const
+	{
+		const int32 MaterialIndex = Indices[GetIndex(P)];
+		checkVoxelSlow(Materials.IsValidIndex(MaterialIndex));
+		return Materials.GetData()[MaterialIndex];
+	}
+
+private:
+	static constexpr int32 BlockSize = 8;
+	static constexpr int32 NumBlocks = (CHUNK_SIZE_WITH_END_EDGE + BlockSize - 1) / BlockSize;
+	
+	const FVoxelData& Data;
+	const FVoxelConstDataAccelerator& Accelerator;
+	const FIntVector ChunkPosition;
+	int32* RESTRICT const Indices;
+	
+	// Indices of the unique positions
+	TArray<int32> Positions;
+	TArray<FVoxelMaterial> Materials;
+
+	FORCEINLINE static int32 GetIndex(const FIntVector& P)
+	{
+		checkVoxelSlow(0 <= P.X && P.X < CHUNK_SIZE_WITH_END_EDGE);
+		checkVoxelSlow(0 <= P.Y && P.Y < CHUNK_SIZE_WITH_END_EDGE);
+		checkVoxelSlow(0 <= P.Z && P.Z < CHUNK_SIZE_WITH_END_EDGE);
+		return P.X + P.Y * CHUNK_SIZE_WITH_END_EDGE + P.Z * CHUNK_SIZE_WITH_END_EDGE * CHUNK_SIZE_WITH_END_EDGE;
+	}
+	FORCEINLINE static FIntVector GetPosition(int32 Index)
+	{
+		return FIntVector(
+			Index % CHUNK_SIZE_WITH_END_EDGE,
+			(Index / CHUNK_SIZE_WITH_END_EDGE) % CHUNK_SIZE_WITH_END_EDGE,
+			Index / (CHUNK_SIZE_WITH_END_EDGE * CHUNK_SIZE_WITH_END_EDGE));
+	}
+	FORCEINLINE static int32 GetBlock(const FIntVector& P)
+	{
+		return (P.X / BlockSize) + (P.Y / BlockSize) * NumBlocks + (P.Z / BlockSize) * NumBlocks * NumBlocks;
+	}
+};
+
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+
 class FMarchingCubeHelpers
 {
 public:
@@ -29,19 +207,75 @@ public:
 		return MesherVertices;
 	}
 	
+	static const FVoxelHeightfieldColumns* GetHeightfieldColumns(const FVoxelMarchingCubeMesher& Mesher)
+	{
+		return Mesher.HeightfieldColumns.Get();
+	}
+	static const FVoxelHeightfieldColumns* GetHeightfieldColumns(const FVoxelMarchingCubeTransitionsMesher& Mesher)
+	{
+		return nullptr;
+	}
+	
+	static int32* GetMaterialsBatchIndices(const FVoxelMarchingCubeMesher& Mesher)
+	{
+		// Only LOD 0 material positions are on the grid. The heightfield columns already have the materials of the chunk
+		if (Mesher.LOD != 0 || Mesher.HeightfieldColumns.IsValid() || CVarBatchMaterials.GetValueOnAnyThread() == 0)
+		{
+			return nullptr;
+		}
+		return Mesher.MaterialsBatchIndices;
+	}
+	static int32* GetMaterialsBatchIndices(const FVoxelMarchingCubeTransitionsMesher& Mesher)
+	{
+		return nullptr;
+	}
+	
 	template<typename T, typename TMesher>
 	static void ComputeMaterials(TMesher& Mesher, TArray<FVoxelMesherVertex>& MesherVertices, TArray<T>& Vertices)
 	{
 		VOXEL_FUNCTION_COUNTER();
 	
-		const auto GetMaterial = [&](const FIntVector& P)
+		const bool bInterpolate = Mesher.Settings.bInterpolateColors || Mesher.Settings.bInterpolateUVs;
+		
+		if (int32* const MaterialsBatchIndices = GetMaterialsBatchIndices(Mesher))
 		{
+			FVoxelMarchingCubeMaterialsBatch Batch(Mesher.Data, *Mesher.Accelerator, Mesher.ChunkPosition, MaterialsBatchIndices);
+			for (int32 Index = 0; Index < Vertices.Num(); Index++)
+			{
+				if (bInterpolate)
+				{
+					Batch.Add(FVoxelUtilities::FloorToInt(MesherVertices[Index].Position));
+					Batch.Add(FVoxelUtilities::CeilToInt(MesherVertices[Index].Position));
+				}
+				else
+				{
+					Batch.Add(Vertices[Index].MaterialPosition);
+				}
+			}
+			Batch.Fetch();
+			
+			ComputeMaterialsImpl(Mesher, MesherVertices, Vertices, [&](const FIntVector& P) { return Batch.Get(P); });
+			return;
+		}
+		
+		const FVoxelHeightfieldColumns* const HeightfieldColumns = GetHeightfieldColumns(Mesher);
+		ComputeMaterialsImpl(Mesher, MesherVertices, Vertices, [&](const FIntVector& P)
+		{
+			FVoxelMaterial Material;
+			if (HeightfieldColumns && HeightfieldColumns->GetMaterial(P.X + Mesher.ChunkPosition.X, P.Y + Mesher.ChunkPosition.Y, Material))
+			{
+				return Material;
+			}
 			return Mesher.Accelerator->GetMaterial(
 				P.X + Mesher.ChunkPosition.X,
 				P.Y + Mesher.ChunkPosition.Y, 
 				P.Z + Mesher.ChunkPosition.Z, 
 				Mesher.LOD);
-		};
+		});
+	}
+	template<typename T, typename TMesher, typename TGetMaterial>
+	static void ComputeMaterialsImpl(TMesher& Mesher, TArray<FVoxelMesherVertex>& MesherVertices, TArray<T>& Vertices, TGetMaterial GetMaterial)
+	{
 		if (Mesher.Settings.bInterpolateColors || Mesher.Settings.bInterpolateUVs)
 		{
 			for (int32 Index = 0; Index < Vertices.Num(); Index++)
@@ -106,12 +340,49 @@ public:
 		}
 	}
 	
-	static void ComputeNormals(FVoxelMarchingCubeMesher& Mesher, TArray<FVoxelMesherVertex>& MesherVertices, TArray<uint32>& Indices)
+	// Gradient of the cached values at a vertex: vertices are on the edges of the grid, so lerp the gradients of the edge ends
+	// 12 reads instead of 48 for the interpolated LOD 0 gradient, and no data queries above LOD 0
+	static bool GetGradientFromCachedValues(const FVoxelMarchingCubeMesher& Mesher, const FVector& Position, FVector& OutGradient)
+	{
+		const FVector GridPosition = Position / Mesher.Step;
+		const FIntVector Min = FVoxelUtilities::FloorToInt(GridPosition);
+		const FVector Alpha = GridPosition - FVector(Min);
+		const FIntVector EdgeDirection(Alpha.X > 0, Alpha.Y > 0, Alpha.Z > 0);
+		if (EdgeDirection.X + EdgeDirection.Y + EdgeDirection.Z > 1)
+		{
+			// Not on a grid edge, shouldn't happen
+			return false;
+		}
+
+		const FIntVector Max = Min + EdgeDirection;
+		FVector GradientA;
+		FVector GradientB;
+		if (!Mesher.GetCachedGradient(Min.X, Min.Y, Min.Z, GradientA) ||
+			!Mesher.GetCachedGradient(Max.X, Max.Y, Max.Z, GradientB))
+		{
+			return false;
+		}
+
+		OutGradient = FMath::Lerp(GradientA, GradientB, Alpha.X + Alpha.Y + Alpha.Z).GetSafeNormal();
+		return true;
+	}
+	
+	static void ComputeNormals(FVoxelMarchingCubeMesher& Mesher, FVoxelMesherTimes& Times, TArray<FVoxelMesherVertex>& MesherVertices, TArray<uint32>& Indices)
 	{
 		VOXEL_FUNCTION_COUNTER();
 
+		const bool bUseCachedValues = Mesher.bCachedValuesHaveBorder && CVarGridNormals.GetValueOnAnyThread() != 0;
+		uint64 NumFromData = 0;
+		
 		const auto GetGradient = [&](const FVector& Position)
 		{
+			FVector Gradient;
+			if (bUseCachedValues && GetGradientFromCachedValues(Mesher, Position, Gradient))
+			{
+				return Gradient;
+			}
+			
+			NumFromData++;
 			if (Mesher.LOD == 0)
 			{
 				// For LOD 0, we used the cached data
@@ -191,13 +462,16 @@ public:
 				Vertex.Tangent = FVoxelProcMeshTangent();
 			}
 		}
+
+		Times._NormalsFromData += NumFromData;
 	}
-	static void ComputeNormals(FVoxelMarchingCubeTransitionsMesher& Mesher, TArray<FVoxelMesherVertex>& MesherVertices)
+	static void ComputeNormals(FVoxelMarchingCubeTransitionsMesher& Mesher, FVoxelMesherTimes& Times, TArray<FVoxelMesherVertex>& MesherVertices)
 	{
 		VOXEL_FUNCTION_COUNTER();
 
 		if (Mesher.Settings.NormalConfig == EVoxelNormalConfig::GradientNormal || Mesher.Settings.NormalConfig == EVoxelNormalConfig::MeshNormal)
 		{
+			Times._NormalsFromData += MesherVertices.Num();
 			for (auto& Vertex : MesherVertices)
 			{
 				Vertex.Normal = FVoxelDataUtilities::GetGradientFromGetFloatValue<v_flt>(
@@ -206,7 +480,7 @@ public:
 					v_flt(Vertex.Position.Y) + Mesher.ChunkPosition.Y,
 					v_flt(Vertex.Position.Z) + Mesher.ChunkPosition.Z,
 					Mesher.LOD,
-					Mesher.Step);;
+					Mesher.Step);
 				Vertex.Tangent = FVoxelProcMeshTangent();
 			}
 		}
@@ -233,6 +507,138 @@ public:
 	}
 };
 
+// Buffers of the marching cubes meshers, reused by all the meshers of a thread instead of being allocated for every chunk
+struct FVoxelMarchingCubeMesherScratch : TThreadSingleton<FVoxelMarchingCubeMesherScratch>
+{
+	// Use LOD0 size as it's bigger
+	TStackArray<FVoxelValue, CHUNK_SIZE_WITH_NORMALS * CHUNK_SIZE_WITH_NORMALS * CHUNK_SIZE_WITH_NORMALS> CachedValues;
+	TStackArray<int32, RENDER_CHUNK_SIZE * RENDER_CHUNK_SIZE * EDGE_INDEX_COUNT> CacheA;
+	TStackArray<int32, RENDER_CHUNK_SIZE * RENDER_CHUNK_SIZE * EDGE_INDEX_COUNT> CacheB;
+	// Used by FVoxelMarchingCubeMaterialsBatch, always all -1 between two chunks
+	TStackArray<int32, CHUNK_SIZE_WITH_END_EDGE * CHUNK_SIZE_WITH_END_EDGE * CHUNK_SIZE_WITH_END_EDGE> MaterialsBatchIndices;
+
+	// Decaying maximum of the outputs sizes of the previous chunks
+	int32 NumIndicesHint = 0;
+	int32 NumVerticesHint = 0;
+
+	bool bInUse = false;
+
+	FVoxelMarchingCubeMesherScratch()
+	{
+		for (int32& Index : MaterialsBatchIndices)
+		{
+			Index = -1;
+		}
+	}
+
+	static void UpdateHint(int32& Hint, int32 Num)
+	{
+		Hint = FMath::Max(Num, Hint - Hint / 8);
+	}
+};
+
+struct FVoxelMarchingCubeMesherScratchStats
+{
+	static FThreadSafeCounter64 Meshers;
+	static FThreadSafeCounter64 ScratchAllocations;
+	static FThreadSafeCounter64 OutputsGrowths;
+
+	static void Clear()
+	{
+		Meshers.Reset();
+		ScratchAllocations.Reset();
+		OutputsGrowths.Reset();
+	}
+	static void PrintStats()
+	{
+		const int64 NumMeshers = Meshers.GetValue();
+		const int64 NumScratchAllocations = ScratchAllocations.GetValue();
+		const int64 NumOutputsGrowths = OutputsGrowths.GetValue();
+		
+		UE_LOG(LogVoxel, Log, TEXT("############################ Voxel Marching Cubes Scratch ############################"));
+		UE_LOG(LogVoxel, Log, TEXT("Meshers: %lld"), NumMeshers);
+		UE_LOG(LogVoxel, Log, TEXT("Scratch allocations: %lld (%5.2f%%)"), NumScratchAllocations, NumMeshers > 0 ? NumScratchAllocations / double(NumMeshers) * 100 : 0);
+		UE_LOG(LogVoxel, Log, TEXT("Outputs growths: %lld (%5.2f per chunk)"), NumOutputsGrowths, NumMeshers > 0 ? NumOutputsGrowths / double(NumMeshers) : 0);
+		UE_LOG(LogVoxel, Log, TEXT("######################################################################################"));
+	}
+};
+
+FThreadSafeCounter64 FVoxelMarchingCubeMesherScratchStats::Meshers;
+FThreadSafeCounter64 FVoxelMarchingCubeMesherScratchStats::ScratchAllocations;
+FThreadSafeCounter64 FVoxelMarchingCubeMesherScratchStats::OutputsGrowths;
+
+static FAutoConsoleCommand ClearMarchingCubeScratchStatsCmd(
+	TEXT("voxel.mesher.ClearScratchStats"),
+	TEXT("Clear the marching cubes meshers scratch stats"),
+	FConsoleCommandDelegate::CreateStatic(&FVoxelMarchingCubeMesherScratchStats::Clear));
+
+static FAutoConsoleCommand PrintMarchingCubeScratchStatsCmd(
+	TEXT("voxel.mesher.PrintScratchStats"),
+	TEXT("Print the number of allocations done by the marching cubes meshers since the last clear"),
+	FConsoleCommandDelegate::CreateStatic(&FVoxelMarchingCubeMesherScratchStats::PrintStats));
+
+static FVoxelMarchingCubeMesherScratch& AcquireMarchingCubeMesherScratch(TUniquePtr<FVoxelMarchingCubeMesherScratch>& OwnedScratch)
+{
+	FVoxelMarchingCubeMesherScratchStats::Meshers.Increment();
+	
+	FVoxelMarchingCubeMesherScratch& ThreadScratch = FVoxelMarchingCubeMesherScratch::Get();
+	if (!ThreadScratch.bInUse)
+	{
+		ThreadScratch.bInUse = true;
+		return ThreadScratch;
+	}
+	
+	// Another mesher is alive on this thread
+	FVoxelMarchingCubeMesherScratchStats::ScratchAllocations.Increment();
+	OwnedScratch = MakeUnique<FVoxelMarchingCubeMesherScratch>();
+	return *OwnedScratch;
+}
+
+FVoxelMarchingCubeMesher::FVoxelMarchingCubeMesher(
+	int32 LOD,
+	const FIntVector& ChunkPosition,
+	const FVoxelRendererSettings& Settings)
+	: FVoxelMesher(LOD, ChunkPosition, Settings)
+	, Scratch(AcquireMarchingCubeMesherScratch(OwnedScratch))
+	, CachedValues(Scratch.CachedValues.GetData())
+	, CurrentCache(Scratch.CacheA.GetData())
+	, OldCache(Scratch.CacheB.GetData())
+	, MaterialsBatchIndices(Scratch.MaterialsBatchIndices.GetData())
+{
+}
+
+FVoxelMarchingCubeMesher::~FVoxelMarchingCubeMesher()
+{
+	if (!OwnedScratch.IsValid())
+	{
+		ensure(&Scratch == &FVoxelMarchingCubeMesherScratch::Get());
+		ensure(Scratch.bInUse);
+		Scratch.bInUse = false;
+	}
+}
+
+template<typename T>
+void FVoxelMarchingCubeMesher::ReserveOutputs(TArray<uint32>& Indices, TArray<T>& Vertices) const
+{
+	Indices.Reserve(Scratch.NumIndicesHint);
+	Vertices.Reserve(Scratch.NumVerticesHint);
+}
+
+template<typename T>
+void FVoxelMarchingCubeMesher::UpdateOutputsHints(const TArray<uint32>& Indices, const TArray<T>& Vertices) const
+{
+	FVoxelMarchingCubeMesherScratchStats::OutputsGrowths.Add(
+		(Indices.Num() > Scratch.NumIndicesHint) +
+		(Vertices.Num() > Scratch.NumVerticesHint));
+	
+	FVoxelMarchingCubeMesherScratch::UpdateHint(Scratch.NumIndicesHint, Indices.Num());
+	FVoxelMarchingCubeMesherScratch::UpdateHint(Scratch.NumVerticesHint, Vertices.Num());
+}
+
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+
 FIntBox FVoxelMarchingCubeMesher::GetBoundsToCheckIsEmptyOn() const
 {
 	return FIntBox(ChunkPosition, ChunkPosition + CHUNK_SIZE_WITH_END_EDGE * Step);
@@ -244,10 +650,39 @@ FIntBox FVoxelMarchingCubeMesher::GetBoundsToLock() const
 	return FIntBox(ChunkPosition - FIntVector(Step), ChunkPosition + FIntVector(Step) + CHUNK_SIZE_WITH_END_EDGE * Step);
 }
 
+FIntBox FVoxelMarchingCubeMesher::GetBoundsToPrefetch() const
+{
+	// Heightfields are fast enough to not need it
+	if (Data.WorldGenerator->IsHeightfield())
+	{
+		return FIntBox();
+	}
+	// CreateGeometry never shares its values with the distance field: above LOD 0, its query won't use this prefetch
+	return GetBoundsToQuery(LOD == 0 || NeedsDistanceField());
+}
+
+FIntBox FVoxelMarchingCubeMesher::GetBoundsToQuery(bool bHasBorder) const
+{
+	const FIntBox Bounds(ChunkPosition, ChunkPosition + CHUNK_SIZE_WITH_END_EDGE * Step);
+	return bHasBorder ? Bounds.Extend(Step) : Bounds;
+}
+
 ///////////////////////////////////////////////////////////////////////////////
 ///////////////////////////////////////////////////////////////////////////////
 ///////////////////////////////////////////////////////////////////////////////
 
+static TAutoConsoleVariable<int32> CVarHeightfieldFastPath(
+	TEXT("voxel.mesher.HeightfieldFastPath"),
+	1,
+	TEXT("If true, heightfield world generators will be queried once per column instead of once per voxel on unedited chunks"),
+	ECVF_Default);
+
+static TAutoConsoleVariable<int32> CVarSubBlockSize(
+	TEXT("voxel.mesher.SubBlockSize"),
+	8,
+	TEXT("Size in cells of the blocks whose value range is checked before querying their values. Blocks entirely inside or outside the surface are skipped. 0 to disable"),
+	ECVF_Default);
+
 static TAutoConsoleVariable<int32> CVarEnableUniqueUVs(
 	TEXT("voxel.mesher.UniqueUVs"),
 	0,
@@ -273,14 +708,18 @@ TVoxelSharedPtr<FVoxelChunkMesh> FVoxelMarchingCubeMesher::CreateFullChunkImpl(F
 	
 	TArray<uint32> Indices;
 	TArray<FLocalVertex> Vertices;
+	ReserveOutputs(Indices, Vertices);
+	// Read the values once for both the mesh and the distance field
+	bShareValuesWithDistanceField = NeedsDistanceField();
 	CreateGeometryTemplate(Times, Indices, Vertices);
+	UpdateOutputsHints(Indices, Vertices);
 
 	FVoxelMesherUtilities::SanitizeMesh(Indices, Vertices);
 
 	TArray<FVoxelMesherVertex> MesherVertices = FMarchingCubeHelpers::CreateMesherVertices(Vertices);
 
 	MESHER_TIME_MATERIALS(MesherVertices.Num(), FMarchingCubeHelpers::ComputeMaterials(*this, MesherVertices, Vertices));
-	MESHER_TIME(Normals, FMarchingCubeHelpers::ComputeNormals(*this, MesherVertices, Indices));
+	MESHER_TIME_NORMALS(MesherVertices.Num(), FMarchingCubeHelpers::ComputeNormals(*this, Times, MesherVertices, Indices));
 
 	UnlockData();
 
@@ -369,10 +808,21 @@ void FVoxelMarchingCubeMesher::CreateGeometryImpl(FVoxelMesherTimes& Times, TArr
 		{
 		}
 	};
+	ReserveOutputs(Indices, Vertices);
 	CreateGeometryTemplate(Times, Indices, reinterpret_cast<TArray<FVectorVertex>&>(Vertices));
+	UpdateOutputsHints(Indices, Vertices);
 	UnlockData();
 }
 
+TArrayView<const FVoxelValue> FVoxelMarchingCubeMesher::GetDistanceFieldValues() const
+{
+	if (!bHasDistanceFieldValues)
+	{
+		return {};
+	}
+	return TArrayView<const FVoxelValue>(CachedValues, CHUNK_SIZE_WITH_NORMALS * CHUNK_SIZE_WITH_NORMALS * CHUNK_SIZE_WITH_NORMALS);
+}
+
 ///////////////////////////////////////////////////////////////////////////////
 ///////////////////////////////////////////////////////////////////////////////
 ///////////////////////////////////////////////////////////////////////////////
@@ -382,289 +832,301 @@ bool FVoxelMarchingCubeMesher::CreateGeometryTemplate(FVoxelMesherTimes& Times,
 {
 	VOXEL_FUNCTION_COUNTER();
 
-	const int32 DataSize = LOD == 0 ? CHUNK_SIZE_WITH_NORMALS : CHUNK_SIZE_WITH_END_EDGE;
+	// LOD 0 normals are computed from the values. The distance field also needs them
+	const bool bHasBorder = LOD == 0 || bShareValuesWithDistanceField;
+	const int32 DataSize = bHasBorder ? CHUNK_SIZE_WITH_NORMALS : CHUNK_SIZE_WITH_END_EDGE;
+	bCachedValuesHaveBorder = bHasBorder;
 
-	FIntBox BoundsToQuery(ChunkPosition, ChunkPosition + CHUNK_SIZE_WITH_END_EDGE * Step);
-	if (LOD == 0)
+	const FIntBox BoundsToQuery = GetBoundsToQuery(bHasBorder);
+	bHasDistanceFieldValues = false;
+	const bool bUseHeightfield = MESHER_TIME_RETURN_VALUES(DataSize * DataSize * DataSize, TryGetValuesFromHeightfield(BoundsToQuery, DataSize));
+	if (!bUseHeightfield)
 	{
-		// Account for normals
-		BoundsToQuery = BoundsToQuery.Extend(1);
+		const bool bSkippedBlocks = GetValuesPerBlock(Times, BoundsToQuery, DataSize);
+		checkVoxelSlow(!bSkippedBlocks || !bShareValuesWithDistanceField);
 	}
-	TVoxelQueryZone<FVoxelValue> QueryZone(BoundsToQuery, FIntVector(DataSize), LOD, CachedValues);
-	MESHER_TIME_VALUES(DataSize * DataSize * DataSize, Data.Get<FVoxelValue>(QueryZone, LOD));
+	
+	bHasDistanceFieldValues = bShareValuesWithDistanceField;
 	
 	Accelerator = MakeUnique<FVoxelConstDataAccelerator>(Data, GetBoundsToLock());
 
-	uint32 VoxelIndex = 0;
-	if (LOD == 0) VoxelIndex += DataSize * DataSize; // Additional voxel for normals
+	const int32 Offset = bHasBorder ? 1 : 0; // Additional voxel for normals
+
+	// Empty masks of the corner rows of the current & next Z slices
+	TStackArray<uint64, CHUNK_SIZE_WITH_END_EDGE> SliceMasksA;
+	TStackArray<uint64, CHUNK_SIZE_WITH_END_EDGE> SliceMasksB;
+	uint64* RESTRICT SliceMasks = SliceMasksA.GetData();
+	uint64* RESTRICT NextSliceMasks = SliceMasksB.GetData();
+	
+	TArray<uint32, TFixedAllocator<RENDER_CHUNK_SIZE * RENDER_CHUNK_SIZE>> ActiveCells;
+	
 	for (int32 LZ = 0; LZ < RENDER_CHUNK_SIZE; LZ++)
 	{
-		if (LOD == 0) VoxelIndex += DataSize; // Additional voxel for normals
-		for (int32 LY = 0; LY < RENDER_CHUNK_SIZE; LY++)
+		// Set EdgeIndex 0 to -1 for all the cells, as the cells that aren't voxelized (eg all corners = 0) are skipped
+		for (int32 Index = 0; Index < RENDER_CHUNK_SIZE * RENDER_CHUNK_SIZE; Index++)
+		{
+			CurrentCache[Index * EDGE_INDEX_COUNT] = -1;
+		}
+
+		ActiveCells.Reset();
+		FVoxelMarchingCubeActiveCells::FindActiveCells(CachedValues, DataSize, Offset, LZ, SliceMasks, NextSliceMasks, ActiveCells);
+		
+		for (const uint32 Cell : ActiveCells)
 		{
-			if (LOD == 0) VoxelIndex += 1; // Additional voxel for normals
-			for (int32 LX = 0; LX < RENDER_CHUNK_SIZE; LX++)
+			const int32 LX = Cell & 0xFFFF;
+			const int32 LY = Cell >> 16;
+			const uint32 VoxelIndex = (LX + Offset) + DataSize * (LY + Offset) + DataSize * DataSize * (LZ + Offset);
+			
+			uint32 CubeIndices[8];
+			CubeIndices[0] = VoxelIndex;
+			CubeIndices[1] = VoxelIndex + 1;
+			CubeIndices[2] = VoxelIndex     + DataSize;
+			CubeIndices[3] = VoxelIndex + 1 + DataSize;
+			CubeIndices[4] = VoxelIndex                + DataSize * DataSize;
+			CubeIndices[5] = VoxelIndex + 1            + DataSize * DataSize;
+			CubeIndices[6] = VoxelIndex     + DataSize + DataSize * DataSize;
+			CubeIndices[7] = VoxelIndex + 1 + DataSize + DataSize * DataSize;
+
+			checkVoxelSlow(CubeIndices[0] < uint32(DataSize * DataSize * DataSize));
+			checkVoxelSlow(CubeIndices[1] < uint32(DataSize * DataSize * DataSize));
+			checkVoxelSlow(CubeIndices[2] < uint32(DataSize * DataSize * DataSize));
+			checkVoxelSlow(CubeIndices[3] < uint32(DataSize * DataSize * DataSize));
+			checkVoxelSlow(CubeIndices[4] < uint32(DataSize * DataSize * DataSize));
+			checkVoxelSlow(CubeIndices[5] < uint32(DataSize * DataSize * DataSize));
+			checkVoxelSlow(CubeIndices[6] < uint32(DataSize * DataSize * DataSize));
+			checkVoxelSlow(CubeIndices[7] < uint32(DataSize * DataSize * DataSize));
+
+			const uint32 CaseCode =
+				(CachedValues[CubeIndices[0]].IsEmpty() << 0) |
+				(CachedValues[CubeIndices[1]].IsEmpty() << 1) |
+				(CachedValues[CubeIndices[2]].IsEmpty() << 2) |
+				(CachedValues[CubeIndices[3]].IsEmpty() << 3) |
+				(CachedValues[CubeIndices[4]].IsEmpty() << 4) |
+				(CachedValues[CubeIndices[5]].IsEmpty() << 5) |
+				(CachedValues[CubeIndices[6]].IsEmpty() << 6) |
+				(CachedValues[CubeIndices[7]].IsEmpty() << 7);
+			// Cell has a nontrivial triangulation
+			checkVoxelSlow(CaseCode != 0 && CaseCode != 255);
+
+			const uint8 ValidityMask = (LX != 0) + 2 * (LY != 0) + 4 * (LZ != 0);
+
+			checkVoxelSlow(0 <= CaseCode && CaseCode < 256);
+			const uint8 CellClass = Transvoxel::regularCellClass[CaseCode];
+			const uint16* RESTRICT VertexData = Transvoxel::regularVertexData[CaseCode];
+			checkVoxelSlow(0 <= CellClass && CellClass < 16);
+			Transvoxel::RegularCellData CellData = Transvoxel::regularCellData[CellClass];
+
+			// Indices of the vertices used in this cube
+			TStackArray<int32, 16> VertexIndices;
+			for (int32 I = 0; I < CellData.GetVertexCount(); I++)
 			{
-				{
-					CurrentCache[GetCacheIndex(0, LX, LY)] = -1; // Set EdgeIndex 0 to -1 if the cell isn't voxelized, eg all corners = 0
-
-					uint32 CubeIndices[8];
-					CubeIndices[0] = VoxelIndex;
-					CubeIndices[1] = VoxelIndex + 1;
-					CubeIndices[2] = VoxelIndex     + DataSize;
-					CubeIndices[3] = VoxelIndex + 1 + DataSize;
-					CubeIndices[4] = VoxelIndex                + DataSize * DataSize;
-					CubeIndices[5] = VoxelIndex + 1            + DataSize * DataSize;
-					CubeIndices[6] = VoxelIndex     + DataSize + DataSize * DataSize;
-					CubeIndices[7] = VoxelIndex + 1 + DataSize + DataSize * DataSize;
-
-					checkVoxelSlow(CubeIndices[0] < uint32(DataSize * DataSize * DataSize));
-					checkVoxelSlow(CubeIndices[1] < uint32(DataSize * DataSize * DataSize));
-					checkVoxelSlow(CubeIndices[2] < uint32(DataSize * DataSize * DataSize));
-					checkVoxelSlow(CubeIndices[3] < uint32(DataSize * DataSize * DataSize));
-					checkVoxelSlow(CubeIndices[4] < uint32(DataSize * DataSize * DataSize));
-					checkVoxelSlow(CubeIndices[5] < uint32(DataSize * DataSize * DataSize));
-					checkVoxelSlow(CubeIndices[6] < uint32(DataSize * DataSize * DataSize));
-					checkVoxelSlow(CubeIndices[7] < uint32(DataSize * DataSize * DataSize));
-
-					const uint32 CaseCode =
-						(CachedValues[CubeIndices[0]].IsEmpty() << 0) |
-						(CachedValues[CubeIndices[1]].IsEmpty() << 1) |
-						(CachedValues[CubeIndices[2]].IsEmpty() << 2) |
-						(CachedValues[CubeIndices[3]].IsEmpty() << 3) |
-						(CachedValues[CubeIndices[4]].IsEmpty() << 4) |
-						(CachedValues[CubeIndices[5]].IsEmpty() << 5) |
-						(CachedValues[CubeIndices[6]].IsEmpty() << 6) |
-						(CachedValues[CubeIndices[7]].IsEmpty() << 7);
-
-					if (CaseCode != 0 && CaseCode != 255)
-					{
-						// Cell has a nontrivial triangulation
+				int32 VertexIndex = -2;
+				const uint16 EdgeCode = VertexData[I];
 
-						const uint8 ValidityMask = (LX != 0) + 2 * (LY != 0) + 4 * (LZ != 0);
+				// A: low point / B: high point
+				const uint8 LocalIndexA = (EdgeCode >> 4) & 0x0F;
+				const uint8 LocalIndexB = EdgeCode & 0x0F;
 
-						checkVoxelSlow(0 <= CaseCode && CaseCode < 256);
-						const uint8 CellClass = Transvoxel::regularCellClass[CaseCode];
-						const uint16* RESTRICT VertexData = Transvoxel::regularVertexData[CaseCode];
-						checkVoxelSlow(0 <= CellClass && CellClass < 16);
-						Transvoxel::RegularCellData CellData = Transvoxel::regularCellData[CellClass];
+				checkVoxelSlow(0 <= LocalIndexA && LocalIndexA < 8);
+				checkVoxelSlow(0 <= LocalIndexB && LocalIndexB < 8);
 
-						// Indices of the vertices used in this cube
-						TStackArray<int32, 16> VertexIndices;
-						for (int32 I = 0; I < CellData.GetVertexCount(); I++)
-						{
-							int32 VertexIndex = -2;
-							const uint16 EdgeCode = VertexData[I];
+				const uint32 IndexA = CubeIndices[LocalIndexA];
+				const uint32 IndexB = CubeIndices[LocalIndexB];
 
-							// A: low point / B: high point
-							const uint8 LocalIndexA = (EdgeCode >> 4) & 0x0F;
-							const uint8 LocalIndexB = EdgeCode & 0x0F;
+				const FVoxelValue& ValueAtA = CachedValues[IndexA];
+				const FVoxelValue& ValueAtB = CachedValues[IndexB];
 
-							checkVoxelSlow(0 <= LocalIndexA && LocalIndexA < 8);
-							checkVoxelSlow(0 <= LocalIndexB && LocalIndexB < 8);
+				checkVoxelSlow(ValueAtA.IsEmpty() != ValueAtB.IsEmpty());
 
-							const uint32 IndexA = CubeIndices[LocalIndexA];
-							const uint32 IndexB = CubeIndices[LocalIndexB];
+				uint8 EdgeIndex = ((EdgeCode >> 8) & 0x0F);
+				checkVoxelSlow(1 <= EdgeIndex && EdgeIndex < 4);
 
-							const FVoxelValue& ValueAtA = CachedValues[IndexA];
-							const FVoxelValue& ValueAtB = CachedValues[IndexB];
+				// Direction to go to use an already created vertex: 
+				// first bit:  x is different
+				// second bit: y is different
+				// third bit:  z is different
+				// fourth bit: vertex isn't cached
+				uint8 CacheDirection = EdgeCode >> 12;
 
-							checkVoxelSlow(ValueAtA.IsEmpty() != ValueAtB.IsEmpty());
+				if (ValueAtA.IsNull())
+				{
+					EdgeIndex = 0;
+					CacheDirection = LocalIndexA ^ 7;
+				}
+				if (ValueAtB.IsNull())
+				{
+					checkVoxelSlow(!ValueAtA.IsNull());
+					EdgeIndex = 0;
+					CacheDirection = LocalIndexB ^ 7;
+				}
 
-							uint8 EdgeIndex = ((EdgeCode >> 8) & 0x0F);
-							checkVoxelSlow(1 <= EdgeIndex && EdgeIndex < 4);
+				const bool bIsVertexCached = ((ValidityMask & CacheDirection) == CacheDirection) && CacheDirection; // CacheDirection == 0 => LocalIndexB = 0 (as only B can be = 7) and ValueAtB = 0
 
-							// Direction to go to use an already created vertex: 
-							// first bit:  x is different
-							// second bit: y is different
-							// third bit:  z is different
-							// fourth bit: vertex isn't cached
-							uint8 CacheDirection = EdgeCode >> 12;
+				if (bIsVertexCached)
+				{
+					checkVoxelSlow(!(CacheDirection & 0x08));
+
+					bool XIsDifferent = !!(CacheDirection & 0x01);
+					bool YIsDifferent = !!(CacheDirection & 0x02);
+					bool ZIsDifferent = !!(CacheDirection & 0x04);
+					
+					VertexIndex = (ZIsDifferent ? OldCache : CurrentCache)[GetCacheIndex(EdgeIndex, LX - XIsDifferent, LY - YIsDifferent)];
+					ensureVoxelSlow(-1 <= VertexIndex && VertexIndex < Vertices.Num()); // Can happen if the generator is returning different values
+				}
 
-							if (ValueAtA.IsNull())
-							{
-								EdgeIndex = 0;
-								CacheDirection = LocalIndexA ^ 7;
-							}
-							if (ValueAtB.IsNull())
-							{
-								checkVoxelSlow(!ValueAtA.IsNull());
-								EdgeIndex = 0;
-								CacheDirection = LocalIndexB ^ 7;
-							}
+				if (!bIsVertexCached || VertexIndex == -1)
+				{
+					// We are on one the lower edges of the chunk. Compute vertex
+				
+					const FIntVector PositionA((LX + (LocalIndexA & 0x01)) * Step, (LY + ((LocalIndexA & 0x02) >> 1)) * Step, (LZ + ((LocalIndexA & 0x04) >> 2)) * Step);
+					const FIntVector PositionB((LX + (LocalIndexB & 0x01)) * Step, (LY + ((LocalIndexB & 0x02) >> 1)) * Step, (LZ + ((LocalIndexB & 0x04) >> 2)) * Step);
 
-							const bool bIsVertexCached = ((ValidityMask & CacheDirection) == CacheDirection) && CacheDirection; // CacheDirection == 0 => LocalIndexB = 0 (as only B can be = 7) and ValueAtB = 0
+					FVector IntersectionPoint;
+					FIntVector MaterialPosition;
 
-							if (bIsVertexCached)
-							{
-								checkVoxelSlow(!(CacheDirection & 0x08));
-
-								bool XIsDifferent = !!(CacheDirection & 0x01);
-								bool YIsDifferent = !!(CacheDirection & 0x02);
-								bool ZIsDifferent = !!(CacheDirection & 0x04);
-								
-								VertexIndex = (ZIsDifferent ? OldCache : CurrentCache)[GetCacheIndex(EdgeIndex, LX - XIsDifferent, LY - YIsDifferent)];
-								ensureVoxelSlow(-1 <= VertexIndex && VertexIndex < Vertices.Num()); // Can happen if the generator is returning different values
-							}
+					if (EdgeIndex == 0)
+					{
+						if (ValueAtA.IsNull())
+						{
+							IntersectionPoint = FVector(PositionA);
+							MaterialPosition = PositionA;
+						}
+						else 
+						{
+							checkVoxelSlow(ValueAtB.IsNull());
+							IntersectionPoint = FVector(PositionB);
+							MaterialPosition = PositionB;
+						}
+					}
+					else if (LOD == 0)
+					{
+						// Full resolution
 
-							if (!bIsVertexCached || VertexIndex == -1)
-							{
-								// We are on one the lower edges of the chunk. Compute vertex
-							
-								const FIntVector PositionA((LX + (LocalIndexA & 0x01)) * Step, (LY + ((LocalIndexA & 0x02) >> 1)) * Step, (LZ + ((LocalIndexA & 0x04) >> 2)) * Step);
-								const FIntVector PositionB((LX + (LocalIndexB & 0x01)) * Step, (LY + ((LocalIndexB & 0x02) >> 1)) * Step, (LZ + ((LocalIndexB & 0x04) >> 2)) * Step);
+						const float Alpha = ValueAtA.ToFloat() / (ValueAtA.ToFloat() - ValueAtB.ToFloat());
+						checkError(!FMath::IsNaN(Alpha) && FMath::IsFinite(Alpha));
+						
+						switch (EdgeIndex)
+						{
+						case 2: // X
+							IntersectionPoint = FVector(FMath::Lerp<float>(PositionA.X, PositionB.X, Alpha), PositionA.Y, PositionA.Z);
+							break;
+						case 1: // Y
+							IntersectionPoint = FVector(PositionA.X, FMath::Lerp<float>(PositionA.Y, PositionB.Y, Alpha), PositionA.Z);
+							break;
+						case 3: // Z
+							IntersectionPoint = FVector(PositionA.X, PositionA.Y, FMath::Lerp<float>(PositionA.Z, PositionB.Z, Alpha));
+							break;
+						default:
+							checkVoxelSlow(false);
+						}
 
-								FVector IntersectionPoint;
-								FIntVector MaterialPosition;
+						// Use the material of the point inside
+						MaterialPosition = !ValueAtA.IsEmpty() ? PositionA : PositionB;
+					}
+					else
+					{
+						// Interpolate
 
-								if (EdgeIndex == 0)
-								{
-									if (ValueAtA.IsNull())
-									{
-										IntersectionPoint = FVector(PositionA);
-										MaterialPosition = PositionA;
-									}
-									else 
-									{
-										checkVoxelSlow(ValueAtB.IsNull());
-										IntersectionPoint = FVector(PositionB);
-										MaterialPosition = PositionB;
-									}
-								}
-								else if (LOD == 0)
-								{
-									// Full resolution
-
-									const float Alpha = ValueAtA.ToFloat() / (ValueAtA.ToFloat() - ValueAtB.ToFloat());
-									checkError(!FMath::IsNaN(Alpha) && FMath::IsFinite(Alpha));
-									
-									switch (EdgeIndex)
-									{
-									case 2: // X
-										IntersectionPoint = FVector(FMath::Lerp<float>(PositionA.X, PositionB.X, Alpha), PositionA.Y, PositionA.Z);
-										break;
-									case 1: // Y
-										IntersectionPoint = FVector(PositionA.X, FMath::Lerp<float>(PositionA.Y, PositionB.Y, Alpha), PositionA.Z);
-										break;
-									case 3: // Z
-										IntersectionPoint = FVector(PositionA.X, PositionA.Y, FMath::Lerp<float>(PositionA.Z, PositionB.Z, Alpha));
-										break;
-									default:
-										checkVoxelSlow(false);
-									}
-
-									// Use the material of the point inside
-									MaterialPosition = !ValueAtA.IsEmpty() ? PositionA : PositionB;
-								}
-								else
-								{
-									// Interpolate
-
-									const bool bIsAlongX = (EdgeIndex == 2);
-									const bool bIsAlongY = (EdgeIndex == 1);
-									const bool bIsAlongZ = (EdgeIndex == 3);
-
-									checkVoxelSlow(!bIsAlongX || (PositionA.Y == PositionB.Y && PositionA.Z == PositionB.Z));
-									checkVoxelSlow(!bIsAlongY || (PositionA.X == PositionB.X && PositionA.Z == PositionB.Z));
-									checkVoxelSlow(!bIsAlongZ || (PositionA.X == PositionB.X && PositionA.Y == PositionB.Y));
-
-									int32 Min = bIsAlongX ? PositionA.X : bIsAlongY ? PositionA.Y : PositionA.Z;
-									int32 Max = bIsAlongX ? PositionB.X : bIsAlongY ? PositionB.Y : PositionB.Z;
-
-									FVoxelValue ValueAtACopy = ValueAtA;
-									FVoxelValue ValueAtBCopy = ValueAtB;
-
-									while (Max - Min != 1)
-									{
-										checkError((Max + Min) % 2 == 0);
-										const int32 Middle = (Max + Min) / 2;
-
-										FVoxelValue ValueAtMiddle = MESHER_TIME_RETURN_VALUES(1, Accelerator->Get<FVoxelValue>(
-											(bIsAlongX ? Middle : PositionA.X) + ChunkPosition.X,
-											(bIsAlongY ? Middle : PositionA.Y) + ChunkPosition.Y,
-											(bIsAlongZ ? Middle : PositionA.Z) + ChunkPosition.Z, LOD));
-
-										if (ValueAtACopy.IsEmpty() == ValueAtMiddle.IsEmpty())
-										{
-											// If min and middle have same sign
-											Min = Middle;
-											ValueAtACopy = ValueAtMiddle;
-										}
-										else
-										{
-											// If max and middle have same sign
-											Max = Middle;
-											ValueAtBCopy = ValueAtMiddle;
-										}
-
-										checkError(Min <= Max);
-									}
-
-									const float Alpha = ValueAtACopy.ToFloat() / (ValueAtACopy.ToFloat() - ValueAtBCopy.ToFloat());
-									checkError(!FMath::IsNaN(Alpha) && FMath::IsFinite(Alpha));
-
-									const float R = FMath::Lerp<float>(Min, Max, Alpha);
-									IntersectionPoint = FVector(
-										bIsAlongX ? R : PositionA.X,
-										bIsAlongY ? R : PositionA.Y,
-										bIsAlongZ ? R : PositionA.Z);
-
-									// Get intersection material
-									if (!ValueAtACopy.IsEmpty())
-									{
-										checkVoxelSlow(ValueAtBCopy.IsEmpty());
-										MaterialPosition = FIntVector(
-											bIsAlongX ? Min : PositionA.X,
-											bIsAlongY ? Min : PositionA.Y,
-											bIsAlongZ ? Min : PositionA.Z);
-									}
-									else
-									{
-										checkVoxelSlow(!ValueAtBCopy.IsEmpty());
-										MaterialPosition = FIntVector(
-											bIsAlongX ? Max : PositionA.X,
-											bIsAlongY ? Max : PositionA.Y,
-											bIsAlongZ ? Max : PositionA.Z);
-									}
-								}
+						const bool bIsAlongX = (EdgeIndex == 2);
+						const bool bIsAlongY = (EdgeIndex == 1);
+						const bool bIsAlongZ = (EdgeIndex == 3);
 
-								VertexIndex = Vertices.Num();
+						checkVoxelSlow(!bIsAlongX || (PositionA.Y == PositionB.Y && PositionA.Z == PositionB.Z));
+						checkVoxelSlow(!bIsAlongY || (PositionA.X == PositionB.X && PositionA.Z == PositionB.Z));
+						checkVoxelSlow(!bIsAlongZ || (PositionA.X == PositionB.X && PositionA.Y == PositionB.Y));
 
-								Vertices.Add(T(IntersectionPoint, MaterialPosition));
+						int32 Min = bIsAlongX ? PositionA.X : bIsAlongY ? PositionA.Y : PositionA.Z;
+						int32 Max = bIsAlongX ? PositionB.X : bIsAlongY ? PositionB.Y : PositionB.Z;
 
-								checkVoxelSlow((ValueAtB.IsNull() && LocalIndexB == 7) == !CacheDirection);
-								checkVoxelSlow(CacheDirection || EdgeIndex == 0);
+						FVoxelValue ValueAtACopy = ValueAtA;
+						FVoxelValue ValueAtBCopy = ValueAtB;
 
-								// Save vertex if not on edge
-								if (CacheDirection & 0x08 || !CacheDirection) // ValueAtB.IsNull() && LocalIndexB == 7 => !CacheDirection
-								{
-									CurrentCache[GetCacheIndex(EdgeIndex, LX, LY)] = VertexIndex;
-								}
+						while (Max - Min != 1)
+						{
+							checkError((Max + Min) % 2 == 0);
+							const int32 Middle = (Max + Min) / 2;
+
+							FVoxelValue ValueAtMiddle = MESHER_TIME_RETURN_VALUES(1, bIsAlongZ && bUseHeightfield
+								// Z is the only axis along which we have the data. The columns start at the border if there is one
+								? HeightfieldColumns->GetValue(PositionA.X / Step + Offset, PositionA.Y / Step + Offset, Middle + ChunkPosition.Z)
+								: Accelerator->Get<FVoxelValue>(
+									(bIsAlongX ? Middle : PositionA.X) + ChunkPosition.X,
+									(bIsAlongY ? Middle : PositionA.Y) + ChunkPosition.Y,
+									(bIsAlongZ ? Middle : PositionA.Z) + ChunkPosition.Z, LOD));
+
+							if (ValueAtACopy.IsEmpty() == ValueAtMiddle.IsEmpty())
+							{
+								// If min and middle have same sign
+								Min = Middle;
+								ValueAtACopy = ValueAtMiddle;
+							}
+							else
+							{
+								// If max and middle have same sign
+								Max = Middle;
+								ValueAtBCopy = ValueAtMiddle;
 							}
 
-							VertexIndices[I] = VertexIndex;
-							checkVoxelSlow(0 <= VertexIndex && VertexIndex < Vertices.Num());
+							checkError(Min <= Max);
 						}
 
-						// Add triangles
-						// 3 vertex per triangle
-						for (int32 Index = 0; Index < 3 * CellData.GetTriangleCount(); Index += 3)
+						const float Alpha = ValueAtACopy.ToFloat() / (ValueAtACopy.ToFloat() - ValueAtBCopy.ToFloat());
+						checkError(!FMath::IsNaN(Alpha) && FMath::IsFinite(Alpha));
+
+						const float R = FMath::Lerp<float>(Min, Max, Alpha);
+						IntersectionPoint = FVector(
+							bIsAlongX ? R : PositionA.X,
+							bIsAlongY ? R : PositionA.Y,
+							bIsAlongZ ? R : PositionA.Z);
+
+						// Get intersection material
+						if (!ValueAtACopy.IsEmpty())
+						{
+							checkVoxelSlow(ValueAtBCopy.IsEmpty());
+							MaterialPosition = FIntVector(
+								bIsAlongX ? Min : PositionA.X,
+								bIsAlongY ? Min : PositionA.Y,
+								bIsAlongZ ? Min : PositionA.Z);
+						}
+						else
 						{
-							Indices.Add(VertexIndices[CellData.vertexIndex[Index + 0]]);
-							Indices.Add(VertexIndices[CellData.vertexIndex[Index + 1]]);
-							Indices.Add(VertexIndices[CellData.vertexIndex[Index + 2]]);
+							checkVoxelSlow(!ValueAtBCopy.IsEmpty());
+							MaterialPosition = FIntVector(
+								bIsAlongX ? Max : PositionA.X,
+								bIsAlongY ? Max : PositionA.Y,
+								bIsAlongZ ? Max : PositionA.Z);
 						}
 					}
+
+					VertexIndex = Vertices.Num();
+
+					Vertices.Add(T(IntersectionPoint, MaterialPosition));
+
+					checkVoxelSlow((ValueAtB.IsNull() && LocalIndexB == 7) == !CacheDirection);
+					checkVoxelSlow(CacheDirection || EdgeIndex == 0);
+
+					// Save vertex if not on edge
+					if (CacheDirection & 0x08 || !CacheDirection) // ValueAtB.IsNull() && LocalIndexB == 7 => !CacheDirection
+					{
+						CurrentCache[GetCacheIndex(EdgeIndex, LX, LY)] = VertexIndex;
+					}
 				}
 
-				VoxelIndex++;
+				VertexIndices[I] = VertexIndex;
+				checkVoxelSlow(0 <= VertexIndex && VertexIndex < Vertices.Num());
+			}
+
+			// Add triangles
+			// 3 vertex per triangle
+			for (int32 Index = 0; Index < 3 * CellData.GetTriangleCount(); Index += 3)
+			{
+				Indices.Add(VertexIndices[CellData.vertexIndex[Index + 0]]);
+				Indices.Add(VertexIndices[CellData.vertexIndex[Index + 1]]);
+				Indices.Add(VertexIndices[CellData.vertexIndex[Index + 2]]);
 			}
-			VoxelIndex += 1; // End edge voxel
-			if (LOD == 0) VoxelIndex += 1; // Additional voxel for normals
 		}
-		VoxelIndex += DataSize; // End edge voxel
-		if (LOD == 0) VoxelIndex += DataSize; // Additional voxel for normals
 
+		std::swap(SliceMasks, NextSliceMasks);
 		// Can't use Unreal Swap on restrict ptrs with clang
 		std::swap(CurrentCache, OldCache);
 	}
@@ -676,6 +1138,232 @@ bool FVoxelMarchingCubeMesher::CreateGeometryTemplate(FVoxelMesherTimes& Times,
 ///////////////////////////////////////////////////////////////////////////////
 ///////////////////////////////////////////////////////////////////////////////
 
+bool FVoxelMarchingCubeMesher::GetValuesPerBlock(FVoxelMesherTimes& Times, const FIntBox& BoundsToQuery, int32 DataSize)
+{
+	VOXEL_FUNCTION_COUNTER();
+	
+	TVoxelQueryZone<FVoxelValue> QueryZone(BoundsToQuery, FIntVector(DataSize), LOD, CachedValues);
+
+	const int32 BlockSize = CVarSubBlockSize.GetValueOnAnyThread();
+	// The distance field needs the actual values. Baked values are read & written for the whole chunk
+	if (BlockSize <= 0 || BlockSize >= RENDER_CHUNK_SIZE || bShareValuesWithDistanceField || Data.BakeCache.IsValid())
+	{
+		MESHER_TIME_VALUES(DataSize * DataSize * DataSize, Data.Get<FVoxelValue>(QueryZone, LOD));
+		return false;
+	}
+
+	const int32 Offset = DataSize == CHUNK_SIZE_WITH_NORMALS ? 1 : 0; // Additional voxel for normals
+	const int32 NumBlocks = FVoxelUtilities::DivideCeil(RENDER_CHUNK_SIZE, BlockSize);
+
+	bool bSkippedBlocks = false;
+	TArray<FIntBox, TInlineAllocator<64>> BlocksToQuery;
+	for (int32 BlockZ = 0; BlockZ < NumBlocks; BlockZ++)
+	{
+		for (int32 BlockY = 0; BlockY < NumBlocks; BlockY++)
+		{
+			for (int32 BlockX = 0; BlockX < NumBlocks; BlockX++)
+			{
+				// In cells
+				const FIntVector BlockMin = FIntVector(BlockX, BlockY, BlockZ) * BlockSize;
+				const FIntVector BlockMax(
+					FMath::Min(BlockMin.X + BlockSize, RENDER_CHUNK_SIZE),
+					FMath::Min(BlockMin.Y + BlockSize, RENDER_CHUNK_SIZE),
+					FMath::Min(BlockMin.Z + BlockSize, RENDER_CHUNK_SIZE));
+
+				// Corners of the cells of the block
+				const FIntBox CornersBounds(ChunkPosition + BlockMin * Step, ChunkPosition + (BlockMax + FIntVector(1)) * Step);
+				
+				const TVoxelRange<FVoxelValue> Range = Data.GetValueRange(CornersBounds, LOD);
+				if (Range.Min.IsEmpty() != Range.Max.IsEmpty())
+				{
+					// LOD 0 normals are computed from the cached values: also query the voxels around the block
+					BlocksToQuery.Add(Offset == 1 ? CornersBounds.Extend(Step) : CornersBounds);
+					continue;
+				}
+
+				// No cell of the block is voxelized: only the sign of its corners is used by the active cells pass
+				// Corners shared with blocks that are queried are overwritten below, with values of the same sign
+				bSkippedBlocks = true;
+				
+				const FVoxelValue Value = Range.Min.IsEmpty() ? FVoxelValue::Empty() : FVoxelValue::Full();
+				for (int32 Z = BlockMin.Z; Z <= BlockMax.Z; Z++)
+				{
+					for (int32 Y = BlockMin.Y; Y <= BlockMax.Y; Y++)
+					{
+						FVoxelValue* RESTRICT const Row = CachedValues + Offset + DataSize * (Y + Offset) + DataSize * DataSize * (Z + Offset);
+						for (int32 X = BlockMin.X; X <= BlockMax.X; X++)
+						{
+							Row[X] = Value;
+						}
+					}
+				}
+			}
+		}
+	}
+
+	for (const FIntBox& Block : BlocksToQuery)
+	{
+		auto BlockZone = QueryZone.ShrinkTo(Block);
+		const FIntVector Size = BlockZone.Bounds.Size() / Step;
+		MESHER_TIME_VALUES(Size.X * Size.Y * Size.Z, Data.Get<FVoxelValue>(BlockZone, LOD));
+	}
+
+	return bSkippedBlocks;
+}
+
+bool FVoxelMarchingCubeMesher::TryGetValuesFromHeightfield(const FIntBox& BoundsToQuery, int32 DataSize)
+{
+	VOXEL_FUNCTION_COUNTER();
+	
+	HeightfieldColumns.Reset();
+
+	if (CVarHeightfieldFastPath.GetValueOnAnyThread() == 0 ||
+		!Data.WorldGenerator->IsHeightfield() ||
+		!Data.IsGeneratorOnly(BoundsToQuery))
+	{
+		return false;
+	}
+
+	auto Columns = MakeUnique<FVoxelHeightfieldColumns>();
+	if (!Data.WorldGenerator->GetHeightfieldColumns(BoundsToQuery, LOD, *Columns) ||
+		!ensure(Columns->Size == FIntPoint(DataSize, DataSize)) ||
+		!ensure(Columns->Heights.Num() == DataSize * DataSize) ||
+		!ensure(Columns->Precision > 0))
+	{
+		return false;
+	}
+
+	const int32 MinZ = BoundsToQuery.Min.Z;
+	const int32 MaxZ = BoundsToQuery.Min.Z + (DataSize - 1) * Step;
+	
+	for (int32 LY = 0; LY < DataSize; LY++)
+	{
+		for (int32 LX = 0; LX < DataSize; LX++)
+		{
+			FVoxelValue* RESTRICT const ColumnValues = CachedValues + LX + DataSize * LY;
+			
+			// Values are increasing along Z: resolve fully above/below columns without evaluating them
+			const FVoxelValue BottomValue = Columns->GetValue(LX, LY, MinZ);
+			const FVoxelValue TopValue = Columns->GetValue(LX, LY, MaxZ);
+			if (BottomValue == FVoxelValue::Empty() || TopValue == FVoxelValue::Full())
+			{
+				for (int32 LZ = 0; LZ < DataSize; LZ++)
+				{
+					ColumnValues[DataSize * DataSize * LZ] = BottomValue;
+				}
+				continue;
+			}
+
+			for (int32 LZ = 0; LZ < DataSize; LZ++)
+			{
+				ColumnValues[DataSize * DataSize * LZ] = Columns->GetValue(LX, LY, MinZ + LZ * Step);
+			}
+		}
+	}
+
+	HeightfieldColumns = MoveTemp(Columns);
+	return true;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+
+static void BenchmarkMarchingCubeActiveCells(const TArray<FString>& Args)
+{
+	const int32 NumRuns = Args.Num() > 0 ? FMath::Max(1, FCString::Atoi(*Args[0])) : 1000;
+	constexpr int32 DataSize = CHUNK_SIZE_WITH_NORMALS;
+	constexpr int32 Offset = 1;
+
+	const auto Benchmark = [&](const TCHAR* Name, TFunctionRef<float(int32, int32, int32)> GetValue)
+	{
+		TArray<FVoxelValue> Values;
+		Values.SetNumUninitialized(DataSize * DataSize * DataSize);
+		for (int32 Z = 0; Z < DataSize; Z++)
+		{
+			for (int32 Y = 0; Y < DataSize; Y++)
+			{
+				for (int32 X = 0; X < DataSize; X++)
+				{
+					Values[X + DataSize * Y + DataSize * DataSize * Z] = FVoxelValue(GetValue(X - Offset, Y - Offset, Z - Offset));
+				}
+			}
+		}
+
+		// Same classification as the mesher did before the active cells pass
+		int32 NumScalarCells = 0;
+		const double ScalarStartTime = FPlatformTime::Seconds();
+		for (int32 Run = 0; Run < NumRuns; Run++)
+		{
+			for (int32 LZ = 0; LZ < RENDER_CHUNK_SIZE; LZ++)
+			{
+				for (int32 LY = 0; LY < RENDER_CHUNK_SIZE; LY++)
+				{
+					for (int32 LX = 0; LX < RENDER_CHUNK_SIZE; LX++)
+					{
+						const FVoxelValue* RESTRICT const Cube = Values.GetData() + (LX + Offset) + DataSize * (LY + Offset) + DataSize * DataSize * (LZ + Offset);
+						const uint32 CaseCode =
+							(Cube[0].IsEmpty() << 0) |
+							(Cube[1].IsEmpty() << 1) |
+							(Cube[DataSize].IsEmpty() << 2) |
+							(Cube[DataSize + 1].IsEmpty() << 3) |
+							(Cube[DataSize * DataSize].IsEmpty() << 4) |
+							(Cube[DataSize * DataSize + 1].IsEmpty() << 5) |
+							(Cube[DataSize * DataSize + DataSize].IsEmpty() << 6) |
+							(Cube[DataSize * DataSize + DataSize + 1].IsEmpty() << 7);
+						NumScalarCells += CaseCode != 0 && CaseCode != 255;
+					}
+				}
+			}
+		}
+		const double ScalarTime = FPlatformTime::Seconds() - ScalarStartTime;
+
+		int32 NumActiveCells = 0;
+		const double ActiveCellsStartTime = FPlatformTime::Seconds();
+		for (int32 Run = 0; Run < NumRuns; Run++)
+		{
+			TStackArray<uint64, CHUNK_SIZE_WITH_END_EDGE> SliceMasksA;
+			TStackArray<uint64, CHUNK_SIZE_WITH_END_EDGE> SliceMasksB;
+			uint64* RESTRICT SliceMasks = SliceMasksA.GetData();
+			uint64* RESTRICT NextSliceMasks = SliceMasksB.GetData();
+			TArray<uint32, TFixedAllocator<RENDER_CHUNK_SIZE * RENDER_CHUNK_SIZE>> ActiveCells;
+			for (int32 LZ = 0; LZ < RENDER_CHUNK_SIZE; LZ++)
+			{
+				ActiveCells.Reset();
+				FVoxelMarchingCubeActiveCells::FindActiveCells(Values.GetData(), DataSize, Offset, LZ, SliceMasks, NextSliceMasks, ActiveCells);
+				NumActiveCells += ActiveCells.Num();
+				std::swap(SliceMasks, NextSliceMasks);
+			}
+		}
+		const double ActiveCellsTime = FPlatformTime::Seconds() - ActiveCellsStartTime;
+
+		ensure(NumScalarCells == NumActiveCells);
+		UE_LOG(LogVoxel, Log, TEXT("%s: %d active cells per chunk; scalar: %.2fus; active cells pass: %.2fus; speedup: %.2fx"),
+			Name,
+			NumActiveCells / NumRuns,
+			ScalarTime / NumRuns * 1e6,
+			ActiveCellsTime / NumRuns * 1e6,
+			ScalarTime / FMath::Max(ActiveCellsTime, SMALL_NUMBER));
+	};
+
+	UE_LOG(LogVoxel, Log, TEXT("Benchmarking marching cubes active cells pass: %d runs, %s"), NumRuns,
+		VOXEL_EMPTY_MASK_SSE2 ? TEXT("SSE2") : VOXEL_EMPTY_MASK_NEON ? TEXT("NEON") : TEXT("no SIMD"));
+
+	Benchmark(TEXT("Flat"), [](int32 X, int32 Y, int32 Z) { return Z - 16.3f; });
+	Benchmark(TEXT("Hills"), [](int32 X, int32 Y, int32 Z) { return Z - 16.f - 8.f * FMath::Sin(X * 0.2f) * FMath::Cos(Y * 0.15f); });
+	Benchmark(TEXT("Sphere"), [](int32 X, int32 Y, int32 Z) { return FVector(X - 16, Y - 16, Z - 16).Size() - 14.5f; });
+	Benchmark(TEXT("Caves"), [](int32 X, int32 Y, int32 Z) { return FMath::Sin(X * 0.5f) + FMath::Sin(Y * 0.6f) + FMath::Sin(Z * 0.7f); });
+}
+
+static FAutoConsoleCommand BenchmarkMarchingCubeActiveCellsCmd(
+	TEXT("voxel.mesher.BenchmarkActiveCells"),
+	TEXT("Benchmark the marching cubes active cells pass against per cell classification on reference chunks. Args: NumRuns (default 1000)"),
+	FConsoleCommandWithArgsDelegate::CreateStatic(&BenchmarkMarchingCubeActiveCells));
+
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+
 FORCEINLINE int32 FVoxelMarchingCubeMesher::GetCacheIndex(int32 EdgeIndex, int32 LX, int32 LY)
 {
 	checkVoxelSlow(0 <= LX && LX < RENDER_CHUNK_SIZE);
@@ -731,6 +1419,10 @@ bool FVoxelMarchingCubeTransitionsMesher::CreateGeometryForDirection(FVoxelMeshe
 	}
 #endif
 
+	// The cells corners are shared by up to 4 cells: read them all at once instead of 13 accelerator queries per cell
+	GetFaceValues<Direction>(Times, HalfLOD, HalfLODFaceValues.GetData());
+	GetFaceValues<Direction>(Times, LOD, LODFaceValues.GetData());
+
 	for (int32 LX = 0; LX < RENDER_CHUNK_SIZE; LX++)
 	{
 		for (int32 LY = 0; LY < RENDER_CHUNK_SIZE; LY++)
@@ -744,22 +1436,23 @@ bool FVoxelMarchingCubeTransitionsMesher::CreateGeometryForDirection(FVoxelMeshe
 			FVoxelValue CornerValues[13];
 
 			{
-				MESHER_TIME_SCOPE_VALUES(13);
+				const auto GetHalfLODValue = [&](int32 X, int32 Y) { return HalfLODFaceValues[X + TRANSITION_HALF_LOD_FACE_SIZE * Y]; };
+				const auto GetLODValue = [&](int32 X, int32 Y) { return LODFaceValues[X + CHUNK_SIZE_WITH_END_EDGE * Y]; };
 				
-				CornerValues[0] = GetValue<Direction>((2 * LX + 0) * HalfStep, (2 * LY + 0) * HalfStep, HalfLOD);
-				CornerValues[1] = GetValue<Direction>((2 * LX + 1) * HalfStep, (2 * LY + 0) * HalfStep, HalfLOD);
-				CornerValues[2] = GetValue<Direction>((2 * LX + 2) * HalfStep, (2 * LY + 0) * HalfStep, HalfLOD);
-				CornerValues[3] = GetValue<Direction>((2 * LX + 0) * HalfStep, (2 * LY + 1) * HalfStep, HalfLOD);
-				CornerValues[4] = GetValue<Direction>((2 * LX + 1) * HalfStep, (2 * LY + 1) * HalfStep, HalfLOD);
-				CornerValues[5] = GetValue<Direction>((2 * LX + 2) * HalfStep, (2 * LY + 1) * HalfStep, HalfLOD);
-				CornerValues[6] = GetValue<Direction>((2 * LX + 0) * HalfStep, (2 * LY + 2) * HalfStep, HalfLOD);
-				CornerValues[7] = GetValue<Direction>((2 * LX + 1) * HalfStep, (2 * LY + 2) * HalfStep, HalfLOD);
-				CornerValues[8] = GetValue<Direction>((2 * LX + 2) * HalfStep, (2 * LY + 2) * HalfStep, HalfLOD);
-
-				CornerValues[9] = GetValue<Direction>((LX + 0) * Step, (LY + 0) * Step, LOD);
-				CornerValues[10] = GetValue<Direction>((LX + 1) * Step, (LY + 0) * Step, LOD);
-				CornerValues[11] = GetValue<Direction>((LX + 0) * Step, (LY + 1) * Step, LOD);
-				CornerValues[12] = GetValue<Direction>((LX + 1) * Step, (LY + 1) * Step, LOD);
+				CornerValues[0] = GetHalfLODValue(2 * LX + 0, 2 * LY + 0);
+				CornerValues[1] = GetHalfLODValue(2 * LX + 1, 2 * LY + 0);
+				CornerValues[2] = GetHalfLODValue(2 * LX + 2, 2 * LY + 0);
+				CornerValues[3] = GetHalfLODValue(2 * LX + 0, 2 * LY + 1);
+				CornerValues[4] = GetHalfLODValue(2 * LX + 1, 2 * LY + 1);
+				CornerValues[5] = GetHalfLODValue(2 * LX + 2, 2 * LY + 1);
+				CornerValues[6] = GetHalfLODValue(2 * LX + 0, 2 * LY + 2);
+				CornerValues[7] = GetHalfLODValue(2 * LX + 1, 2 * LY + 2);
+				CornerValues[8] = GetHalfLODValue(2 * LX + 2, 2 * LY + 2);
+
+				CornerValues[9] = GetLODValue(LX + 0, LY + 0);
+				CornerValues[10] = GetLODValue(LX + 1, LY + 0);
+				CornerValues[11] = GetLODValue(LX + 0, LY + 1);
+				CornerValues[12] = GetLODValue(LX + 1, LY + 1);
 			}
 
 			if (CornerValues[9].IsEmpty() != CornerValues[0].IsEmpty())
@@ -1038,7 +1731,7 @@ TVoxelSharedPtr<FVoxelChunkMesh> FVoxelMarchingCubeTransitionsMesher::CreateFull
 	TArray<FVoxelMesherVertex> MesherVertices = FMarchingCubeHelpers::CreateMesherVertices(Vertices);
 
 	MESHER_TIME_MATERIALS(MesherVertices.Num(), FMarchingCubeHelpers::ComputeMaterials(*this, MesherVertices, Vertices));
-	MESHER_TIME(Normals, FMarchingCubeHelpers::ComputeNormals(*this, MesherVertices));
+	MESHER_TIME_NORMALS(MesherVertices.Num(), FMarchingCubeHelpers::ComputeNormals(*this, Times, MesherVertices));
 
 	UnlockData();
 
@@ -1062,6 +1755,40 @@ TVoxelSharedPtr<FVoxelChunkMesh> FVoxelMarchingCubeTransitionsMesher::CreateFull
 	return MESHER_TIME_RETURN(CreateChunk, FVoxelMesherUtilities::CreateChunkFromVertices(Settings, MoveTemp(Indices), MoveTemp(MesherVertices)));
 }
 
+template<uint8 Direction>
+void FVoxelMarchingCubeTransitionsMesher::GetFaceValues(FVoxelMesherTimes& Times, int32 InLOD, FVoxelValue* RESTRICT OutValues) const
+{
+	VOXEL_FUNCTION_COUNTER();
+	
+	const int32 InStep = 1 << InLOD;
+	const int32 FaceSize = (Size >> InLOD) + 1;
+	check(FaceSize <= TRANSITION_HALF_LOD_FACE_SIZE);
+
+	const FIntVector CornerA = Local2DToGlobal<Direction>(0, 0, 0);
+	const FIntVector CornerB = Local2DToGlobal<Direction>(Size, Size, 0);
+	const FIntVector Min = FVoxelUtilities::ComponentMin(CornerA, CornerB);
+	const FIntVector Max = FVoxelUtilities::ComponentMax(CornerA, CornerB);
+
+	// One voxel thick
+	const FIntBox Bounds(ChunkPosition + Min, ChunkPosition + Max + FIntVector(InStep));
+	const FIntVector ArraySize = Bounds.Size() / InStep;
+	checkVoxelSlow(ArraySize.X * ArraySize.Y * ArraySize.Z == FaceSize * FaceSize);
+
+	TStackArray<FVoxelValue, TRANSITION_HALF_LOD_FACE_SIZE * TRANSITION_HALF_LOD_FACE_SIZE> GlobalValues;
+	TVoxelQueryZone<FVoxelValue> QueryZone(Bounds, ArraySize, InLOD, GlobalValues.GetData());
+	MESHER_TIME_VALUES(FaceSize * FaceSize, Data.Get<FVoxelValue>(QueryZone, InLOD));
+
+	// The query zone is in global coordinates
+	for (int32 Y = 0; Y < FaceSize; Y++)
+	{
+		for (int32 X = 0; X < FaceSize; X++)
+		{
+			const FIntVector Position = (Local2DToGlobal<Direction>(X * InStep, Y * InStep, 0) - Min) / InStep;
+			OutValues[X + FaceSize * Y] = GlobalValues[Position.X + ArraySize.X * Position.Y + ArraySize.X * ArraySize.Y * Position.Z];
+		}
+	}
+}
+
 ///////////////////////////////////////////////////////////////////////////////
 ///////////////////////////////////////////////////////////////////////////////
 ///////////////////////////////////////////////////////////////////////////////
@@ -12,17 +12,26 @@
 
 #define EDGE_INDEX_COUNT 4
 
+struct FVoxelMarchingCubeMesherScratch;
+
 class FVoxelMarchingCubeMesher : public FVoxelMesher
 {
 public:
-	using FVoxelMesher::FVoxelMesher;
+	// Must be created & destroyed on the same thread, as it uses the thread scratch buffers
+	FVoxelMarchingCubeMesher(
+		int32 LOD,
+		const FIntVector& ChunkPosition,
+		const FVoxelRendererSettings& Settings);
+	virtual ~FVoxelMarchingCubeMesher() override;
 
 protected:
 	virtual FIntBox GetBoundsToCheckIsEmptyOn() const override final;
 	virtual FIntBox GetBoundsToLock() const override final;
+	virtual FIntBox GetBoundsToPrefetch() const override final;
 
 	virtual TVoxelSharedPtr<FVoxelChunkMesh> CreateFullChunkImpl(FVoxelMesherTimes& Times) override final;
 	virtual void CreateGeometryImpl(FVoxelMesherTimes& Times, TArray<uint32>& Indices, TArray<FVector>& Vertices) override final;
+	virtual TArrayView<const FVoxelValue> GetDistanceFieldValues() const override final;
 
 public:	
 	// For GetGradient template
@@ -36,27 +45,85 @@ public:
 		return CachedValues[(X + 1) + (Y + 1) * CHUNK_SIZE_WITH_NORMALS + (Z + 1) * CHUNK_SIZE_WITH_NORMALS * CHUNK_SIZE_WITH_NORMALS];
 	}
 
-private:
-	// Use LOD0 size as it's bigger
-	using FCachedValues = TStackArray<FVoxelValue, CHUNK_SIZE_WITH_NORMALS * CHUNK_SIZE_WITH_NORMALS * CHUNK_SIZE_WITH_NORMALS>;
-	using FCache = TStackArray<int32, RENDER_CHUNK_SIZE * RENDER_CHUNK_SIZE * EDGE_INDEX_COUNT>;
+	// Central difference gradient of the cached values at a corner of the grid, in local coordinates of this LOD
+	// Returns false if it can't be computed from the cached values
+	FORCEINLINE bool GetCachedGradient(int32 X, int32 Y, int32 Z, FVector& OutGradient) const
+	{
+		checkVoxelSlow(bCachedValuesHaveBorder);
+		if (X < 0 || Y < 0 || Z < 0 || X > RENDER_CHUNK_SIZE || Y > RENDER_CHUNK_SIZE || Z > RENDER_CHUNK_SIZE)
+		{
+			return false;
+		}
+
+		const FVoxelValue* RESTRICT const Value = CachedValues + (X + 1) + (Y + 1) * CHUNK_SIZE_WITH_NORMALS + (Z + 1) * CHUNK_SIZE_WITH_NORMALS * CHUNK_SIZE_WITH_NORMALS;
+		const FVoxelValue MinX = Value[-1];
+		const FVoxelValue MaxX = Value[1];
+		const FVoxelValue MinY = Value[-CHUNK_SIZE_WITH_NORMALS];
+		const FVoxelValue MaxY = Value[CHUNK_SIZE_WITH_NORMALS];
+		const FVoxelValue MinZ = Value[-CHUNK_SIZE_WITH_NORMALS * CHUNK_SIZE_WITH_NORMALS];
+		const FVoxelValue MaxZ = Value[CHUNK_SIZE_WITH_NORMALS * CHUNK_SIZE_WITH_NORMALS];
+
+		// Above LOD 0 the samples are Step voxels apart and are often clamped: the gradient of clamped values is wrong
+		if (LOD > 0 && (
+			MinX.IsTotallyEmpty() || MinX.IsTotallyFull() ||
+			MaxX.IsTotallyEmpty() || MaxX.IsTotallyFull() ||
+			MinY.IsTotallyEmpty() || MinY.IsTotallyFull() ||
+			MaxY.IsTotallyEmpty() || MaxY.IsTotallyFull() ||
+			MinZ.IsTotallyEmpty() || MinZ.IsTotallyFull() ||
+			MaxZ.IsTotallyEmpty() || MaxZ.IsTotallyFull()))
+		{
+			return false;
+		}
+
+		OutGradient = FVector(
+			MaxX.ToFloat() - MinX.ToFloat(),
+			MaxY.ToFloat() - MinY.ToFloat(),
+			MaxZ.ToFloat() - MinZ.ToFloat());
+		return true;
+	}
 
-	TUniquePtr<FCachedValues> CachedValuesStorage = MakeUnique<FCachedValues>();
-	TUniquePtr<FCache> CacheStorageA = MakeUnique<FCache>();
-	TUniquePtr<FCache> CacheStorageB = MakeUnique<FCache>();
+private:
+	// Only set if the thread scratch is already used by another mesher
+	TUniquePtr<FVoxelMarchingCubeMesherScratch> OwnedScratch;
+	FVoxelMarchingCubeMesherScratch& Scratch;
 	
 	TUniquePtr<FVoxelConstDataAccelerator> Accelerator;
+	// Only valid if the world generator is a heightfield and there are no edits nor items in the chunk
+	TUniquePtr<FVoxelHeightfieldColumns> HeightfieldColumns;
 
-	FVoxelValue* RESTRICT const CachedValues = CachedValuesStorage->GetData();
+	FVoxelValue* RESTRICT const CachedValues;
 
 	// Cache to get index of already created vertices
-	int32* RESTRICT CurrentCache = CacheStorageA->GetData();
-	int32* RESTRICT OldCache = CacheStorageB->GetData();
+	int32* RESTRICT CurrentCache;
+	int32* RESTRICT OldCache;
+
+	// Index of the material of each LOD 0 grid point in FVoxelMarchingCubeMaterialsBatch
+	int32* RESTRICT const MaterialsBatchIndices;
+
+	// If true, CachedValues will also be used to build the distance field and must have the normals border at every LOD
+	bool bShareValuesWithDistanceField = false;
+	// Set by CreateGeometryTemplate if CachedValues can be used by GetDistanceFieldValues
+	bool bHasDistanceFieldValues = false;
+	// Set by CreateGeometryTemplate if CachedValues has the normals border, in which case it's CHUNK_SIZE_WITH_NORMALS wide
+	bool bCachedValuesHaveBorder = false;
 
 private:
 	// T: will be created as T(IntersectionPoint, MaterialPosition)
 	template<typename T>
 	bool CreateGeometryTemplate(FVoxelMesherTimes& Times, TArray<uint32>& Indices, TArray<T>& Vertices);
+	// Bounds of CachedValues. bHasBorder: include the normals border
+	FIntBox GetBoundsToQuery(bool bHasBorder) const;
+	// Fill CachedValues from the data, skipping the sub blocks that are entirely inside or outside the surface
+	// Returns true if some blocks were skipped, in which case some values are placeholders with only the right sign
+	// Blocks are never skipped if the values are shared with the distance field
+	bool GetValuesPerBlock(FVoxelMesherTimes& Times, const FIntBox& BoundsToQuery, int32 DataSize);
+	// Fill CachedValues from the world generator heightfield columns. Returns false if the fast path can't be used
+	bool TryGetValuesFromHeightfield(const FIntBox& BoundsToQuery, int32 DataSize);
+	// Reserve the output arrays from the sizes of the previous chunks of this thread
+	template<typename T>
+	void ReserveOutputs(TArray<uint32>& Indices, TArray<T>& Vertices) const;
+	template<typename T>
+	void UpdateOutputsHints(const TArray<uint32>& Indices, const TArray<T>& Vertices) const;
 
 private:
 	static int32 GetCacheIndex(int32 EdgeIndex, int32 LX, int32 LY);
@@ -66,6 +133,8 @@ private:
 
 #define TRANSITION_EDGE_INDEX_COUNT 10
 
+#define TRANSITION_HALF_LOD_FACE_SIZE (2 * RENDER_CHUNK_SIZE + 1)
+
 class FVoxelMarchingCubeTransitionsMesher : public FVoxelTransitionsMesher
 {
 public:
@@ -80,12 +149,19 @@ private:
 	TUniquePtr<FVoxelConstDataAccelerator> Accelerator;
 	TStackArray<int32, RENDER_CHUNK_SIZE * RENDER_CHUNK_SIZE * TRANSITION_EDGE_INDEX_COUNT> Cache2D;
 
+	// Values of the face being polygonized, in local 2D coordinates. Read once per face
+	TStackArray<FVoxelValue, TRANSITION_HALF_LOD_FACE_SIZE * TRANSITION_HALF_LOD_FACE_SIZE> HalfLODFaceValues;
+	TStackArray<FVoxelValue, CHUNK_SIZE_WITH_END_EDGE * CHUNK_SIZE_WITH_END_EDGE> LODFaceValues;
+
 private:
 	// T: will be created as T(IntersectionPoint, MaterialPosition, bNeedToTranslate)
 	template<typename T>
 	bool CreateGeometryTemplate(FVoxelMesherTimes& Times, TArray<uint32>& Indices, TArray<T>& Vertices);
 	template<uint8 Direction, typename T>
 	bool CreateGeometryForDirection(FVoxelMesherTimes& Times, TArray<uint32>& Indices, TArray<T>& Vertices);
+	// Read the values of a face with a single query. OutValues: ((Size >> InLOD) + 1)^2 values
+	template<uint8 Direction>
+	void GetFaceValues(FVoxelMesherTimes& Times, int32 InLOD, FVoxelValue* RESTRICT OutValues) const;
 
 private:
 	static int32 GetCacheIndex(int32 EdgeIndex, int32 LX, int32 LY);
@@ -0,0 +1,561 @@
+// Copyright 2020 Phyronnaz
+
+#include "VoxelRender/Meshers/VoxelMeshSimplifier.h"
+#include "VoxelRender/VoxelChunkMesh.h"
+#include "VoxelGlobals.h"
+
+#include "HAL/IConsoleManager.h"
+#include "HAL/ThreadSafeCounter64.h"
+
+struct FVoxelMeshSimplifierStats
+{
+	static FThreadSafeCounter64 NumMeshes;
+	static FThreadSafeCounter64 NumTrianglesBefore;
+	static FThreadSafeCounter64 NumTrianglesAfter;
+	static FThreadSafeCounter64 Cycles;
+
+	static void Clear()
+	{
+		NumMeshes.Reset();
+		NumTrianglesBefore.Reset();
+		NumTrianglesAfter.Reset();
+		Cycles.Reset();
+	}
+	static void PrintStats()
+	{
+		const int64 Meshes = NumMeshes.GetValue();
+		const int64 Before = NumTrianglesBefore.GetValue();
+		const int64 After = NumTrianglesAfter.GetValue();
+		const double Time = FPlatformTime::ToSeconds64(Cycles.GetValue());
+
+		UE_LOG(LogVoxel, Log, TEXT("############################ Voxel Mesh Simplification ############################"));
+		UE_LOG(LogVoxel, Log, TEXT("Meshes: %lld"), Meshes);
+		UE_LOG(LogVoxel, Log, TEXT("Triangles: %lld -> %lld (%5.2f%% removed)"), Before, After, Before > 0 ? (1 - After / double(Before)) * 100 : 0);
+		UE_LOG(LogVoxel, Log, TEXT("Time: %8.3fs; %8.3fus per mesh"), Time, Meshes > 0 ? Time / Meshes * 1e6 : 0);
+		UE_LOG(LogVoxel, Log, TEXT("####################################################################################"));
+	}
+};
+
+FThreadSafeCounter64 FVoxelMeshSimplifierStats::NumMeshes;
+FThreadSafeCounter64 FVoxelMeshSimplifierStats::NumTrianglesBefore;
+FThreadSafeCounter64 FVoxelMeshSimplifierStats::NumTrianglesAfter;
+FThreadSafeCounter64 FVoxelMeshSimplifierStats::Cycles;
+
+static FAutoConsoleCommand ClearSimplificationStatsCmd(
+	TEXT("voxel.mesher.ClearSimplificationStats"),
+	TEXT("Clear the mesh simplification stats"),
+	FConsoleCommandDelegate::CreateStatic(&FVoxelMeshSimplifierStats::Clear));
+
+static FAutoConsoleCommand PrintSimplificationStatsCmd(
+	TEXT("voxel.mesher.PrintSimplificationStats"),
+	TEXT("Print the number of triangles removed by the mesh simplification and the time spent"),
+	FConsoleCommandDelegate::CreateStatic(&FVoxelMeshSimplifierStats::PrintStats));
+
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+
+// Sum of the squared distances to a set of planes
+struct FVoxelQuadric
+{
+	double XX = 0, XY = 0, XZ = 0, XW = 0;
+	double YY = 0, YZ = 0, YW = 0;
+	double ZZ = 0, ZW = 0;
+	double WW = 0;
+
+	FVoxelQuadric() = default;
+	// Plane: Dot(Normal, P) + W = 0. Normal must be normalized
+	FVoxelQuadric(const FVector& Normal, float W)
+	{
+		const double A = Normal.X;
+		const double B = Normal.Y;
+		const double C = Normal.Z;
+		const double D = W;
+
+		XX = A * A; XY = A * B; XZ = A * C; XW = A * D;
+		YY = B * B; YZ = B * C; YW = B * D;
+		ZZ = C * C; ZW = C * D;
+		WW = D * D;
+	}
+
+	FORCEINLINE FVoxelQuadric& operator+=(const FVoxelQuadric& Other)
+	{
+		XX += Other.XX; XY += Other.XY; XZ += Other.XZ; XW += Other.XW;
+		YY += Other.YY; YZ += Other.YZ; YW += Other.YW;
+		ZZ += Other.ZZ; ZW += Other.ZW;
+		WW += Other.WW;
+		return *this;
+	}
+	FORCEINLINE FVoxelQuadric operator+(const FVoxelQuadric& Other) const
+	{
+		FVoxelQuadric Result = *this;
+		Result += Other;
+		return Result;
+	}
+
+	FORCEINLINE double Evaluate(const FVector& Position) const
+	{
+		const double X = Position.X;
+		const double Y = Position.Y;
+		const double Z = Position.Z;
+		return
+			XX * X * X + 2 * XY * X * Y + 2 * XZ * X * Z + 2 * XW * X +
+			YY * Y * Y + 2 * YZ * Y * Z + 2 * YW * Y +
+			ZZ * Z * Z + 2 * ZW * Z +
+			WW;
+	}
+};
+
+// Triangles around each vertex, stored contiguously
+struct FVoxelVertexTriangles
+{
+	TArray<int32> Offsets;
+	TArray<int32> Triangles;
+
+	void Build(const TArray<uint32>& Indices, int32 NumVertices)
+	{
+		Offsets.Reset();
+		Offsets.SetNumZeroed(NumVertices + 1);
+		for (uint32 Index : Indices)
+		{
+			Offsets[Index + 1]++;
+		}
+		for (int32 Vertex = 0; Vertex < NumVertices; Vertex++)
+		{
+			Offsets[Vertex + 1] += Offsets[Vertex];
+		}
+
+		TArray<int32> Counts;
+		Counts.SetNumZeroed(NumVertices);
+		Triangles.SetNumUninitialized(Indices.Num());
+		for (int32 Index = 0; Index < Indices.Num(); Index++)
+		{
+			const uint32 Vertex = Indices[Index];
+			Triangles[Offsets[Vertex] + Counts[Vertex]++] = Index / 3;
+		}
+	}
+
+	FORCEINLINE TArrayView<const int32> Get(int32 Vertex) const
+	{
+		return TArrayView<const int32>(Triangles.GetData() + Offsets[Vertex], Offsets[Vertex + 1] - Offsets[Vertex]);
+	}
+};
+
+FVoxelMeshSimplifier::FResult FVoxelMeshSimplifier::Simplify(FVoxelChunkMeshBuffers& Buffers, const FBox& InteriorBounds, float MaxError)
+{
+	VOXEL_FUNCTION_COUNTER();
+	check(!Buffers.bPacked);
+
+	const uint64 StartCycles = FPlatformTime::Cycles64();
+
+	TArray<uint32>& Indices = Buffers.Indices;
+	const TArray<FVector>& Positions = Buffers.Positions;
+	const int32 NumVertices = Positions.Num();
+
+	FResult Result;
+	Result.NumTrianglesBefore = Indices.Num() / 3;
+	Result.NumTrianglesAfter = Result.NumTrianglesBefore;
+
+	if (Indices.Num() == 0)
+	{
+		return Result;
+	}
+
+	const auto GetNormal = [&](uint32 A, uint32 B, uint32 C)
+	{
+		return FVector::CrossProduct(Positions[B] - Positions[A], Positions[C] - Positions[A]);
+	};
+
+	TArray<FVoxelQuadric> Quadrics;
+	Quadrics.SetNum(NumVertices);
+	for (int32 Index = 0; Index < Indices.Num(); Index += 3)
+	{
+		const uint32 A = Indices[Index + 0];
+		const uint32 B = Indices[Index + 1];
+		const uint32 C = Indices[Index + 2];
+
+		FVector Normal = GetNormal(A, B, C);
+		if (!Normal.Normalize()) continue;
+
+		const FVoxelQuadric Quadric(Normal, -FVector::DotProduct(Normal, Positions[A]));
+		Quadrics[A] += Quadric;
+		Quadrics[B] += Quadric;
+		Quadrics[C] += Quadric;
+	}
+
+	FVoxelVertexTriangles VertexTriangles;
+	VertexTriangles.Build(Indices, NumVertices);
+
+	TArray<bool> Locked;
+	Locked.SetNumUninitialized(NumVertices);
+	for (int32 Vertex = 0; Vertex < NumVertices; Vertex++)
+	{
+		Locked[Vertex] = !InteriorBounds.IsInsideOrOn(Positions[Vertex]);
+	}
+	// Lock the vertices of open & non manifold edges, ie edges that are not in exactly 2 triangles
+	// Collapses are only done on closed manifold fans, so this doesn't need to be updated between passes
+	for (int32 Index = 0; Index < Indices.Num(); Index += 3)
+	{
+		for (int32 Edge = 0; Edge < 3; Edge++)
+		{
+			const uint32 A = Indices[Index + Edge];
+			const uint32 B = Indices[Index + (Edge + 1) % 3];
+
+			int32 NumEdgeTriangles = 0;
+			for (int32 Triangle : VertexTriangles.Get(A))
+			{
+				NumEdgeTriangles += Indices[3 * Triangle + 0] == B || Indices[3 * Triangle + 1] == B || Indices[3 * Triangle + 2] == B;
+			}
+			if (NumEdgeTriangles != 2)
+			{
+				Locked[A] = true;
+				Locked[B] = true;
+			}
+		}
+	}
+
+	struct FCollapse
+	{
+		int32 Source;
+		int32 Target;
+		double Error;
+	};
+
+	const double MaxQuadricError = FMath::Square(double(MaxError));
+	// Min cosine between the normals of a triangle before & after a collapse
+	constexpr float MinNormalDot = 0.25f;
+	// Each pass does independent collapses only, a few passes are enough to converge
+	constexpr int32 MaxPasses = 16;
+
+	TArray<int32> Remap;
+	Remap.SetNumUninitialized(NumVertices);
+	for (int32 Vertex = 0; Vertex < NumVertices; Vertex++)
+	{
+		Remap[Vertex] = Vertex;
+	}
+
+	TArray<FCollapse> Collapses;
+	TArray<bool> Touched;
+	TArray<uint32, TInlineAllocator<32>> SourceNeighbors;
+
+	const auto CanCollapse = [&](uint32 Source, uint32 Target)
+	{
+		// Link condition: the edge must be shared by exactly 2 triangles after the collapse, else the mesh becomes non manifold
+		SourceNeighbors.Reset();
+		for (int32 Triangle : VertexTriangles.Get(Source))
+		{
+			for (int32 Corner = 0; Corner < 3; Corner++)
+			{
+				const uint32 Vertex = Indices[3 * Triangle + Corner];
+				if (Vertex != Source)
+				{
+					SourceNeighbors.AddUnique(Vertex);
+				}
+			}
+		}
+		int32 NumCommonNeighbors = 0;
+		for (int32 Triangle : VertexTriangles.Get(Target))
+		{
+			for (int32 Corner = 0; Corner < 3; Corner++)
+			{
+				const uint32 Vertex = Indices[3 * Triangle + Corner];
+				if (Vertex != Target && SourceNeighbors.Remove(Vertex) > 0)
+				{
+					NumCommonNeighbors++;
+				}
+			}
+		}
+		if (NumCommonNeighbors != 2)
+		{
+			return false;
+		}
+
+		// Triangles must not flip nor become degenerate
+		for (int32 Triangle : VertexTriangles.Get(Source))
+		{
+			uint32 Corners[3] = { Indices[3 * Triangle + 0], Indices[3 * Triangle + 1], Indices[3 * Triangle + 2] };
+			if (Corners[0] == Target || Corners[1] == Target || Corners[2] == Target)
+			{
+				// Will be removed
+				continue;
+			}
+
+			const FVector OldNormal = GetNormal(Corners[0], Corners[1], Corners[2]).GetSafeNormal();
+			for (uint32& Corner : Corners)
+			{
+				if (Corner == Source)
+				{
+					Corner = Target;
+				}
+			}
+			FVector NewNormal = GetNormal(Corners[0], Corners[1], Corners[2]);
+			if (!NewNormal.Normalize() || FVector::DotProduct(OldNormal, NewNormal) < MinNormalDot)
+			{
+				return false;
+			}
+		}
+		return true;
+	};
+
+	for (int32 Pass = 0; Pass < MaxPasses; Pass++)
+	{
+		Collapses.Reset();
+		for (int32 Index = 0; Index < Indices.Num(); Index += 3)
+		{
+			for (int32 Edge = 0; Edge < 3; Edge++)
+			{
+				const int32 A = Indices[Index + Edge];
+				const int32 B = Indices[Index + (Edge + 1) % 3];
+				// Each edge is in 2 triangles
+				if (A > B || (Locked[A] && Locked[B])) continue;
+
+				const FVoxelQuadric Quadric = Quadrics[A] + Quadrics[B];
+				const double ErrorAToB = Locked[A] ? MAX_dbl : Quadric.Evaluate(Positions[B]);
+				const double ErrorBToA = Locked[B] ? MAX_dbl : Quadric.Evaluate(Positions[A]);
+
+				const FCollapse Collapse = ErrorAToB <= ErrorBToA ? FCollapse{ A, B, ErrorAToB } : FCollapse{ B, A, ErrorBToA };
+				if (Collapse.Error <= MaxQuadricError)
+				{
+					Collapses.Add(Collapse);
+				}
+			}
+		}
+		if (Collapses.Num() == 0)
+		{
+			break;
+		}
+
+		Collapses.Sort([](const FCollapse& A, const FCollapse& B) { return A.Error < B.Error; });
+
+		// Vertices whose triangles were changed by a collapse of this pass: their adjacency is outdated
+		Touched.Reset();
+		Touched.SetNumZeroed(NumVertices);
+
+		int32 NumCollapsed = 0;
+		for (const FCollapse& Collapse : Collapses)
+		{
+			if (Touched[Collapse.Source] || Touched[Collapse.Target]) continue;
+			if (!CanCollapse(Collapse.Source, Collapse.Target)) continue;
+
+			for (int32 Triangle : VertexTriangles.Get(Collapse.Source))
+			{
+				Touched[Indices[3 * Triangle + 0]] = true;
+				Touched[Indices[3 * Triangle + 1]] = true;
+				Touched[Indices[3 * Triangle + 2]] = true;
+			}
+			Remap[Collapse.Source] = Collapse.Target;
+			Quadrics[Collapse.Target] += Quadrics[Collapse.Source];
+			NumCollapsed++;
+		}
+		if (NumCollapsed == 0)
+		{
+			break;
+		}
+
+		// Targets are touched, so they are never collapsed in the same pass: a single remap is enough
+		int32 NumIndices = 0;
+		for (int32 Index = 0; Index < Indices.Num(); Index += 3)
+		{
+			const uint32 A = Remap[Indices[Index + 0]];
+			const uint32 B = Remap[Indices[Index + 1]];
+			const uint32 C = Remap[Indices[Index + 2]];
+			if (A == B || B == C || A == C) continue;
+
+			Indices[NumIndices++] = A;
+			Indices[NumIndices++] = B;
+			Indices[NumIndices++] = C;
+		}
+		Indices.SetNum(NumIndices, false);
+
+		VertexTriangles.Build(Indices, NumVertices);
+	}
+
+	Result.NumTrianglesAfter = Indices.Num() / 3;
+
+	if (Result.NumTrianglesAfter < Result.NumTrianglesBefore)
+	{
+		VOXEL_SCOPE_COUNTER("Remove Unused Vertices");
+
+		TArray<int32> NewVertices;
+		NewVertices.Init(-1, NumVertices);
+		int32 NumNewVertices = 0;
+		for (uint32& Index : Indices)
+		{
+			int32& NewVertex = NewVertices[Index];
+			if (NewVertex == -1)
+			{
+				NewVertex = NumNewVertices++;
+			}
+			Index = NewVertex;
+		}
+
+		const auto Compact = [&](auto& Array)
+		{
+			// Normals etc are not computed when not rendering
+			if (Array.Num() != NumVertices) return;
+
+			typename TRemoveReference<decltype(Array)>::Type NewArray;
+			NewArray.SetNumUninitialized(NumNewVertices);
+			for (int32 Vertex = 0; Vertex < NumVertices; Vertex++)
+			{
+				const int32 NewVertex = NewVertices[Vertex];
+				if (NewVertex != -1)
+				{
+					NewArray[NewVertex] = Array[Vertex];
+				}
+			}
+			Array = MoveTemp(NewArray);
+		};
+		Compact(Buffers.Positions);
+		Compact(Buffers.Normals);
+		Compact(Buffers.Tangents);
+		Compact(Buffers.Colors);
+		for (auto& TextureCoordinates : Buffers.TextureCoordinates)
+		{
+			Compact(TextureCoordinates);
+		}
+	}
+
+	FVoxelMeshSimplifierStats::NumMeshes.Increment();
+	FVoxelMeshSimplifierStats::NumTrianglesBefore.Add(Result.NumTrianglesBefore);
+	FVoxelMeshSimplifierStats::NumTrianglesAfter.Add(Result.NumTrianglesAfter);
+	FVoxelMeshSimplifierStats::Cycles.Add(FPlatformTime::Cycles64() - StartCycles);
+
+	return Result;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+
+static void BenchmarkMeshSimplification(const TArray<FString>& Args)
+{
+	const float MaxError = Args.Num() > 0 ? FMath::Max(0.f, FCString::Atof(*Args[0])) : 0.25f;
+	const int32 NumRuns = Args.Num() > 1 ? FMath::Max(1, FCString::Atoi(*Args[1])) : 100;
+	constexpr int32 Size = RENDER_CHUNK_SIZE;
+
+	const auto CountOpenEdges = [](const TArray<uint32>& Indices)
+	{
+		TMap<uint64, int32> EdgesCount;
+		for (int32 Index = 0; Index < Indices.Num(); Index += 3)
+		{
+			for (int32 Edge = 0; Edge < 3; Edge++)
+			{
+				const uint32 A = Indices[Index + Edge];
+				const uint32 B = Indices[Index + (Edge + 1) % 3];
+				EdgesCount.FindOrAdd(uint64(FMath::Min(A, B)) << 32 | FMath::Max(A, B))++;
+			}
+		}
+		int32 NumOpenEdges = 0;
+		for (auto& It : EdgesCount)
+		{
+			NumOpenEdges += It.Value == 1;
+		}
+		return NumOpenEdges;
+	};
+
+	bool bAllValid = true;
+	const auto Benchmark = [&](const TCHAR* Name, TFunctionRef<float(int32, int32)> GetHeight)
+	{
+		// Heightfield with the density of a LOD 0 marching cubes chunk on a plain: one vertex per column, 2 triangles per cell
+		// Positions are in voxels of the chunk LOD, so the results don't depend on the LOD
+		FVoxelChunkMeshBuffers Mesh;
+		for (int32 Y = 0; Y <= Size; Y++)
+		{
+			for (int32 X = 0; X <= Size; X++)
+			{
+				Mesh.Positions.Add(FVector(X, Y, GetHeight(X, Y)));
+			}
+		}
+		for (int32 Y = 0; Y < Size; Y++)
+		{
+			for (int32 X = 0; X < Size; X++)
+			{
+				const uint32 Index00 = X + (Size + 1) * Y;
+				const uint32 Index10 = Index00 + 1;
+				const uint32 Index01 = Index00 + Size + 1;
+				const uint32 Index11 = Index01 + 1;
+				Mesh.Indices.Append({ Index00, Index10, Index11 });
+				Mesh.Indices.Append({ Index00, Index11, Index01 });
+			}
+		}
+
+		// Same as the mesher with Step = 1
+		const FBox InteriorBounds(FVector(1), FVector(Size - 1));
+
+		FVoxelChunkMeshBuffers Simplified;
+		FVoxelMeshSimplifier::FResult Result;
+		const double StartTime = FPlatformTime::Seconds();
+		for (int32 Run = 0; Run < NumRuns; Run++)
+		{
+			Simplified.Indices = Mesh.Indices;
+			Simplified.Positions = Mesh.Positions;
+			Result = FVoxelMeshSimplifier::Simplify(Simplified, InteriorBounds, MaxError);
+		}
+		const double Time = FPlatformTime::Seconds() - StartTime;
+
+		// Distance from the original vertices to the simplified surface
+		double MaxDistance = 0;
+		double SumDistance = 0;
+		for (const FVector& Position : Mesh.Positions)
+		{
+			double Distance = MAX_dbl;
+			for (int32 Index = 0; Index < Simplified.Indices.Num(); Index += 3)
+			{
+				const FVector ClosestPoint = FMath::ClosestPointOnTriangleToPoint(
+					Position,
+					Simplified.Positions[Simplified.Indices[Index + 0]],
+					Simplified.Positions[Simplified.Indices[Index + 1]],
+					Simplified.Positions[Simplified.Indices[Index + 2]]);
+				Distance = FMath::Min<double>(Distance, FVector::Dist(Position, ClosestPoint));
+			}
+			MaxDistance = FMath::Max(MaxDistance, Distance);
+			SumDistance += Distance;
+		}
+
+		// The border must be unchanged
+		TSet<FVector> SimplifiedPositions(Simplified.Positions);
+		int32 NumMissingBorderVertices = 0;
+		for (const FVector& Position : Mesh.Positions)
+		{
+			if (!InteriorBounds.IsInsideOrOn(Position) && !SimplifiedPositions.Contains(Position))
+			{
+				NumMissingBorderVertices++;
+			}
+		}
+		const int32 NumOpenEdges = CountOpenEdges(Mesh.Indices);
+		const int32 NumSimplifiedOpenEdges = CountOpenEdges(Simplified.Indices);
+
+		const bool bValid = NumMissingBorderVertices == 0 && NumOpenEdges == NumSimplifiedOpenEdges;
+		ensure(bValid);
+		bAllValid &= bValid;
+
+		UE_LOG(LogVoxel, Log, TEXT("%s: %d -> %d triangles (%5.2f%% removed); error: max %.3f, mean %.3f voxels; %.2fus per chunk; border %s"),
+			Name,
+			Result.NumTrianglesBefore,
+			Result.NumTrianglesAfter,
+			(1 - Result.NumTrianglesAfter / double(Result.NumTrianglesBefore)) * 100,
+			MaxDistance,
+			SumDistance / Mesh.Positions.Num(),
+			Time / NumRuns * 1e6,
+			bValid ? TEXT("unchanged") : TEXT("CHANGED"));
+		if (!bValid)
+		{
+			UE_LOG(LogVoxel, Error, TEXT("%s: %d border vertices removed, %d open edges before, %d after"), Name, NumMissingBorderVertices, NumOpenEdges, NumSimplifiedOpenEdges);
+		}
+	};
+
+	UE_LOG(LogVoxel, Log, TEXT("Benchmarking mesh simplification: max error %f voxels, %d runs"), MaxError, NumRuns);
+
+	Benchmark(TEXT("Flat"), [](int32 X, int32 Y) { return 16.3f; });
+	Benchmark(TEXT("Slope"), [](int32 X, int32 Y) { return 4.f + 0.4f * X + 0.25f * Y; });
+	Benchmark(TEXT("Hills"), [](int32 X, int32 Y) { return 16.f + 8.f * FMath::Sin(X * 0.2f) * FMath::Cos(Y * 0.15f); });
+	Benchmark(TEXT("Rough"), [](int32 X, int32 Y) { return 16.f + 4.f * FMath::Sin(X * 0.4f + Y * 0.3f) + 2.f * FMath::Sin(X * 1.3f) * FMath::Cos(Y * 1.7f); });
+
+	UE_LOG(LogVoxel, Log, TEXT("Mesh simplification %s"), bAllValid ? TEXT("passed") : TEXT("FAILED"));
+}
+
+static FAutoConsoleCommand BenchmarkMeshSimplificationCmd(
+	TEXT("voxel.mesher.BenchmarkSimplification"),
+	TEXT("Measure the triangle reduction, the error & the time of the far LODs mesh simplification on reference chunks, and check that their borders are unchanged. Args: MaxError in voxels (default 0.25), NumRuns (default 100)"),
+	FConsoleCommandWithArgsDelegate::CreateStatic(&BenchmarkMeshSimplification));
\ No newline at end of file
@@ -0,0 +1,24 @@
+// Copyright 2020 Phyronnaz
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+struct FVoxelChunkMeshBuffers;
+
+// Quadric error decimation of chunk meshes, used to reduce the triangle count of far LODs
+// Uses half edge collapses: vertices are only removed, never moved, so their normals/colors/UVs stay valid
+namespace FVoxelMeshSimplifier
+{
+	struct FResult
+	{
+		int32 NumTrianglesBefore = 0;
+		int32 NumTrianglesAfter = 0;
+	};
+
+	// Vertices outside InteriorBounds are locked, so that the chunk borders are unchanged and match the neighbors & the transitions
+	// Vertices on open edges are locked too, so that the material sections stay connected
+	// MaxError: max distance between a removed vertex and the planes of the triangles it was merged with
+	// Must be called before packing the buffers
+	FResult Simplify(FVoxelChunkMeshBuffers& Buffers, const FBox& InteriorBounds, float MaxError);
+}
\ No newline at end of file
@@ -1,6 +1,7 @@
 // Copyright 2020 Phyronnaz
 
 #include "VoxelRender/Meshers/VoxelMesher.h"
+#include "VoxelRender/Meshers/VoxelMeshSimplifier.h"
 #include "VoxelRender/VoxelMesherAsyncWork.h"
 #include "VoxelRender/VoxelChunkMesh.h"
 #include "VoxelRender/IVoxelRenderer.h"
@@ -17,6 +18,12 @@ static TAutoConsoleVariable<int32> CVarDoNotSkipEmptyChunks(
 	TEXT("If true, all chunks will be computed"),
 	ECVF_Default);
 
+static TAutoConsoleVariable<int32> CVarCheckDistanceFieldValues(
+	TEXT("voxel.mesher.CheckDistanceFieldValues"),
+	0,
+	TEXT("If true, the values shared by the mesher with the distance field will be checked against the values read from the data. Slow"),
+	ECVF_Default);
+
 ///////////////////////////////////////////////////////////////////////////////
 ///////////////////////////////////////////////////////////////////////////////
 ///////////////////////////////////////////////////////////////////////////////
@@ -73,6 +80,9 @@ struct FVoxelMesherStats
 		double TotalMaterialsTime = 0;
 		uint64 TotalValuesAccesses = 0;
 		uint64 TotalMaterialsAccesses = 0;
+		double TotalNormalsTime = 0;
+		uint64 TotalNormalsVertices = 0;
+		uint64 TotalNormalsFromData = 0;
 		
 		const auto Print = [&](const TArray<FChunkStats>& Stats)
 		{
@@ -90,6 +100,8 @@ struct FVoxelMesherStats
 
 				uint64 ValuesAccesses = 0;
 				uint64 MaterialsAccesses = 0;
+				uint64 NormalsVertices = 0;
+				uint64 NormalsFromData = 0;
 			};
 			TMap<int32, FMean> LODToMeans;
 			double GlobalTotalTime = 0;
@@ -108,13 +120,15 @@ struct FVoxelMesherStats
 
 				Mean.ValuesAccesses += Stat.Times._ValuesAccesses;
 				Mean.MaterialsAccesses += Stat.Times._MaterialsAccesses;
+				Mean.NormalsVertices += Stat.Times._NormalsVertices;
+				Mean.NormalsFromData += Stat.Times._NormalsFromData;
 				
 				GlobalTotalTime += Stat.Time;
 			}
 
 			LODToMeans.KeySort(TLess<int32>());
 
-			UE_LOG(LogVoxel, Log, TEXT("\tLOD; Chunks (%%)     ; Total (%%)         ; Avg       ; Values (%%)        , Per Voxel ; Materials (%%)     , Per Voxel ; Normals (%%)       ; UVs (%%)           ; CreateChunk (%%)   ;"));
+			UE_LOG(LogVoxel, Log, TEXT("\tLOD; Chunks (%%)     ; Total (%%)         ; Avg       ; Values (%%)        , Per Voxel ; Materials (%%)     , Per Voxel ; Normals (%%)       , Per Vertex, From Data; UVs (%%)           ; CreateChunk (%%)   ;"));
 			for (auto& It : LODToMeans)
 			{
 				auto& V = It.Value;
@@ -123,8 +137,11 @@ struct FVoxelMesherStats
 				TotalMaterialsTime += V.MaterialsTime;
 				TotalValuesAccesses += V.ValuesAccesses;
 				TotalMaterialsAccesses += V.MaterialsAccesses;
+				TotalNormalsTime += V.NormalsTime;
+				TotalNormalsVertices += V.NormalsVertices;
+				TotalNormalsFromData += V.NormalsFromData;
 				
-				UE_LOG(LogVoxel, Log, TEXT("\t %2d: %6d (%5.2f%%); %8.3fs (%5.2f%%); %8.3fms; %8.3fs (%5.2f%%), %8.1fns; %8.3fs (%5.2f%%), %8.1fns; %8.3fs (%5.2f%%); %8.3fs (%5.2f%%); %8.3fs (%5.2f%%)"),
+				UE_LOG(LogVoxel, Log, TEXT("\t %2d: %6d (%5.2f%%); %8.3fs (%5.2f%%); %8.3fms; %8.3fs (%5.2f%%), %8.1fns; %8.3fs (%5.2f%%), %8.1fns; %8.3fs (%5.2f%%), %8.1fns, %8.2f%%; %8.3fs (%5.2f%%); %8.3fs (%5.2f%%)"),
 					It.Key,
 					V.Count,
 					V.Count / double(Stats.Num()) * 100,
@@ -142,6 +159,8 @@ struct FVoxelMesherStats
 					
 					V.NormalsTime,
 					V.NormalsTime / V.TotalTime * 100,
+					V.NormalsVertices > 0 ? V.NormalsTime / V.NormalsVertices * 1e9 : 0,
+					V.NormalsVertices > 0 ? V.NormalsFromData / double(V.NormalsVertices) * 100 : 0,
 					
 					V.UVsTime,
 					V.UVsTime / V.TotalTime * 100,
@@ -175,6 +194,7 @@ struct FVoxelMesherStats
 		UE_LOG(LogVoxel, Log, TEXT("Transitions Time: %3.2f%% of Main + Transitions"), 100 * TransitionsTime / (NormalTime + TransitionsTime));
 		UE_LOG(LogVoxel, Log, TEXT("Values: %llu reads in %fs, avg %.1fns/voxel"), TotalValuesAccesses, TotalValuesTime, TotalValuesTime / TotalValuesAccesses * 1e9);
 		UE_LOG(LogVoxel, Log, TEXT("Materials: %llu reads in %fs, avg %.1fns/voxel"), TotalMaterialsAccesses, TotalMaterialsTime, TotalMaterialsTime / TotalMaterialsAccesses * 1e9);
+		UE_LOG(LogVoxel, Log, TEXT("Normals: %llu vertices in %fs, avg %.1fns/vertex, %.2f%% computed from the data"), TotalNormalsVertices, TotalNormalsTime, TotalNormalsTime / TotalNormalsVertices * 1e9, 100. * TotalNormalsFromData / TotalNormalsVertices);
 	}
 };
 
@@ -220,6 +240,13 @@ void FVoxelMesherBase::UnlockData()
 
 void FVoxelMesherBase::LockData()
 {
+	// Disk reads must not block the edits
+	const FIntBox BoundsToPrefetch = GetBoundsToPrefetch();
+	if (BoundsToPrefetch.IsValid())
+	{
+		Data.PrefetchBakedValues(BoundsToPrefetch, LOD);
+	}
+	
 	LockInfo = Data.Lock(EVoxelLockType::Read, GetBoundsToLock(), "Mesher");
 }
 
@@ -258,6 +285,13 @@ TVoxelSharedPtr<FVoxelChunkMesh> FVoxelMesherBase::CreateEmptyChunk() const
 
 void FVoxelMesherBase::FinishCreatingChunk(FVoxelChunkMesh& Chunk) const
 {
+	if (!bIsTransitions && LOD >= Settings.MinSimplificationLOD)
+	{
+		// Lock the vertices that can be translated by the transitions, and the ones on the chunk faces
+		const FBox InteriorBounds(FVector(Step), FVector((RENDER_CHUNK_SIZE - 1) * Step));
+		const float MaxError = Settings.SimplificationMaxError * Step;
+		Chunk.IterateBuffers([&](auto& Buffer) { FVoxelMeshSimplifier::Simplify(Buffer, InteriorBounds, MaxError); });
+	}
 	if (Settings.bOptimizeIndices)
 	{
 		Chunk.IterateBuffers([](auto& Buffer) { Buffer.OptimizeIndices(); });
@@ -266,6 +300,11 @@ void FVoxelMesherBase::FinishCreatingChunk(FVoxelChunkMesh& Chunk) const
 
 	Chunk.ComputeBounds();
 	Chunk.ComputeGuid();
+
+	if (Settings.bPackVertices)
+	{
+		Chunk.IterateBuffers([&](auto& Buffer) { Buffer.Pack(LOD, Settings.bHalfPrecisionCoordinates); });
+	}
 }
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -311,15 +350,68 @@ TVoxelSharedPtr<FVoxelChunkMesh> FVoxelMesher::CreateFullChunk()
 	{
 		FinishCreatingChunk(*Chunk);
 
-		if (LOD <= Settings.MaxDistanceFieldLOD)
+		if (NeedsDistanceField())
 		{
-			Chunk->BuildDistanceField(LOD, ChunkPosition, Data);
+			const TArrayView<const FVoxelValue> DistanceFieldValues = GetDistanceFieldValues();
+			if (DistanceFieldValues.Num() > 0)
+			{
+				if (CVarCheckDistanceFieldValues.GetValueOnAnyThread() != 0)
+				{
+					CheckDistanceFieldValues(DistanceFieldValues);
+				}
+				Chunk->BuildDistanceField(LOD, DistanceFieldValues);
+			}
+			else
+			{
+				Chunk->BuildDistanceField(LOD, ChunkPosition, Data);
+			}
 		}
 	}
 	
 	return Chunk;
 }
 
+bool FVoxelMesher::NeedsDistanceField() const
+{
+	return ENABLE_VOXEL_DISTANCE_FIELDS && LOD <= Settings.MaxDistanceFieldLOD;
+}
+
+void FVoxelMesher::CheckDistanceFieldValues(TArrayView<const FVoxelValue> Values) const
+{
+	VOXEL_FUNCTION_COUNTER();
+
+	// Compare with the values FVoxelChunkMesh::BuildDistanceField would have read itself
+	TArray<FVoxelValue> DataValues;
+	DataValues.SetNumUninitialized(Values.Num());
+	FVoxelChunkMesh::ReadDistanceFieldValues(LOD, ChunkPosition, Data, DataValues);
+
+	int32 NumDifferent = 0;
+	int32 FirstDifferentIndex = -1;
+	for (int32 Index = 0; Index < Values.Num(); Index++)
+	{
+		if (Values[Index] != DataValues[Index])
+		{
+			if (NumDifferent == 0)
+			{
+				FirstDifferentIndex = Index;
+			}
+			NumDifferent++;
+		}
+	}
+
+	if (NumDifferent > 0)
+	{
+		UE_LOG(LogVoxel, Error, TEXT("Distance field values shared by the mesher differ from the data: chunk %s LOD %d: %d values differ, first at index %d: %f instead of %f"),
+			*ChunkPosition.ToString(),
+			LOD,
+			NumDifferent,
+			FirstDifferentIndex,
+			Values[FirstDifferentIndex].ToFloat(),
+			DataValues[FirstDifferentIndex].ToFloat());
+		ensure(false);
+	}
+}
+
 void FVoxelMesher::CreateGeometry(TArray<uint32>& Indices, TArray<FVector>& Vertices)
 {
 	VOXEL_SCOPE_COUNTER_FORMAT("Creating Geometry LOD=%d", LOD);
@@ -5,6 +5,7 @@
 #include "CoreMinimal.h"
 #include "IntBox.h"
 #include "VoxelGlobals.h"
+#include "VoxelValue.h"
 
 struct FVoxelRendererSettings;
 struct FVoxelBlendedMaterialUnsorted;
@@ -40,6 +41,8 @@ struct FVoxelScopedMesherTime
 #define MESHER_TIME_SCOPE_MATERIALS(Count) FVoxelScopedMesherTime LocalScope(Times._Materials); Times._MaterialsAccesses += Count;
 #define MESHER_TIME_MATERIALS(Count, X) { FVoxelScopedMesherTime LocalScope(Times._Materials); Times._MaterialsAccesses += Count; X; }
 #define MESHER_TIME_RETURN_MATERIALS(Count, X) [&]() { FVoxelScopedMesherTime LocalScope(Times._Materials); Times._MaterialsAccesses += Count; return X; }()
+
+#define MESHER_TIME_NORMALS(Count, X) { FVoxelScopedMesherTime LocalScope(Times.Normals); Times._NormalsVertices += Count; X; }
 #else
 #define MESHER_TIME_SCOPE(Time)
 #define MESHER_TIME(Time, X) X
@@ -52,6 +55,8 @@ struct FVoxelScopedMesherTime
 #define MESHER_TIME_SCOPE_MATERIALS(Count)
 #define MESHER_TIME_MATERIALS(Count, X) X
 #define MESHER_TIME_RETURN_MATERIALS(Count, X) X
+
+#define MESHER_TIME_NORMALS(Count, X) X
 #endif
 
 // All times are in cycles
@@ -61,6 +66,9 @@ struct FVoxelMesherTimes
 	uint64 _Materials = 0;
 	uint64 _ValuesAccesses = 0;
 	uint64 _MaterialsAccesses = 0;
+	uint64 _NormalsVertices = 0;
+	// Number of normals computed by querying the data instead of using the cached values
+	uint64 _NormalsFromData = 0;
 
 	uint64 Normals = 0;
 	uint64 UVs = 0;
@@ -92,6 +100,8 @@ public:
 protected:
 	virtual FIntBox GetBoundsToCheckIsEmptyOn() const = 0;
 	virtual FIntBox GetBoundsToLock() const = 0;
+	// Bounds of the main values query, read from the bake cache before locking the data. Invalid if none
+	virtual FIntBox GetBoundsToPrefetch() const { return FIntBox(); }
 
 	void UnlockData();
 	
@@ -123,6 +133,14 @@ protected:
 	virtual TVoxelSharedPtr<FVoxelChunkMesh> CreateFullChunkImpl(FVoxelMesherTimes& Times) = 0;
 	// Need to call UnlockData
 	virtual void CreateGeometryImpl(FVoxelMesherTimes& Times, TArray<uint32>& Indices, TArray<FVector>& Vertices) = 0;
+	
+	// Values already read by the mesher, used to build the distance field without reading the data again
+	// Must be empty or follow the layout of FVoxelChunkMesh::BuildDistanceField
+	virtual TArrayView<const FVoxelValue> GetDistanceFieldValues() const { return {}; }
+	
+	bool NeedsDistanceField() const;
+	// Checks the values returned by GetDistanceFieldValues against the data. See voxel.mesher.CheckDistanceFieldValues
+	void CheckDistanceFieldValues(TArrayView<const FVoxelValue> Values) const;
 };
 
 class FVoxelTransitionsMesher : public FVoxelMesherBase
@@ -3,6 +3,7 @@
 #include "VoxelRender/Meshers/VoxelMesherUtilities.h"
 #include "VoxelRender/IVoxelRenderer.h"
 #include "VoxelRender/VoxelChunkMesh.h"
+#include "HAL/IConsoleManager.h"
 
 struct FDoubleIndex
 {
@@ -176,57 +177,370 @@ struct FVoxelFinalMesherVertex
 	}
 };
 
-TVoxelSharedPtr<FVoxelChunkMesh> FVoxelMesherUtilities::CreateChunkFromVertices(
-	const FVoxelRendererSettings& Settings, 
-	TArray<uint32>&& Indices, 
-	TArray<FVoxelMesherVertex>&& Vertices)
+using FVoxelMaterialCollectionMap = TMap<FVoxelBlendedMaterialSorted, FVoxelBlendedMaterialUnsorted>;
+
+static FVoxelBlendedMaterialUnsorted GetMaterialKeyDouble(const FVoxelMaterialCollectionMap& MaterialCollectionMap, uint8 IndexA, uint8 IndexB)
 {
-	VOXEL_FUNCTION_COUNTER();
+	FVoxelBlendedMaterialSorted Sorted;
+	if (IndexA < IndexB)
+	{
+		Sorted = { IndexA, IndexB };
+	}
+	else
+	{
+		Sorted = { IndexB, IndexA };
+	}
+	auto* Unsorted = MaterialCollectionMap.Find(Sorted);
+	if (!Unsorted)
+	{
+		return FVoxelBlendedMaterialUnsorted(Sorted.Index0, Sorted.Index1);
+	}
+	else
+	{
+		return *Unsorted;
+	}
+}
 
-	auto Chunk = MakeVoxelShared<FVoxelChunkMesh>();
+static FVoxelBlendedMaterialUnsorted GetMaterialKeyTriple(const FVoxelMaterialCollectionMap& MaterialCollectionMap, uint8 IndexA, uint8 IndexB, uint8 IndexC)
+{
+	const int32 Min = FMath::Min3(IndexA, IndexB, IndexC);
+	const int32 Max = FMath::Max3(IndexA, IndexB, IndexC);
+	const int32 Med = IndexA + IndexB + IndexC - Min - Max;
+	const FVoxelBlendedMaterialSorted Sorted(Min, Med, Max);
+	auto* Unsorted = MaterialCollectionMap.Find(Sorted);
+	if (!Unsorted)
+	{
+		return FVoxelBlendedMaterialUnsorted(Sorted.Index0, Sorted.Index1, Sorted.Index2);
+	}
+	else
+	{
+		return *Unsorted;
+	}
+}
+
+// Splits the triangles of a chunk by material in two passes:
+// AddTriangle counts the triangles of each section, then Build scatters them and remaps their vertices
+// Chunks only have a few sections: they are found with a linear search on the triangle material indices, without hashing
+// and with a single material collection lookup per section
+class FVoxelChunkSections
+{
+public:
+	FVoxelChunkSections(int32 NumIndices)
+	{
+		TriangleSections.SetNumUninitialized(NumIndices / 3);
+		Colors.SetNumUninitialized(NumIndices);
+	}
+
+	FORCEINLINE static uint32 MakeKey(FVoxelBlendedMaterialUnsorted::EKind Kind, uint8 IndexA, uint8 IndexB = 0, uint8 IndexC = 0)
+	{
+		return (uint32(Kind) << 24) | (uint32(IndexA) << 16) | (uint32(IndexB) << 8) | uint32(IndexC);
+	}
+
+	// Key: material indices of the triangle, see MakeKey. ResolveMaterial is only called the first time a key is used
+	// Returns the section of the triangle
+	template<typename T>
+	FORCEINLINE int32 AddTriangle(int32 Triangle, uint32 Key, T ResolveMaterial)
+	{
+		if (Key != LastKey)
+		{
+			LastKey = Key;
+			LastSection = -1;
+			for (auto& It : Keys)
+			{
+				if (It.Key == Key)
+				{
+					LastSection = It.Value;
+					break;
+				}
+			}
+			if (LastSection == -1)
+			{
+				// Different keys can map to the same material
+				const FVoxelBlendedMaterialUnsorted Material = ResolveMaterial();
+				LastSection = Materials.IndexOfByKey(Material);
+				if (LastSection == INDEX_NONE)
+				{
+					LastSection = Materials.Add(Material);
+					NumTriangles.Add(0);
+				}
+				Keys.Emplace(Key, LastSection);
+			}
+		}
+		TriangleSections[Triangle] = LastSection;
+		NumTriangles[LastSection]++;
+		return LastSection;
+	}
+	FORCEINLINE const FVoxelBlendedMaterialUnsorted& GetMaterial(int32 Section) const
+	{
+		return Materials[Section];
+	}
+	// Final colors of the triangles vertices, to set after AddTriangle
+	FORCEINLINE FColor& GetColor(int32 Index)
+	{
+		return Colors.GetData()[Index];
+	}
+
+	// bReuseOnlySameColor: if true, a vertex is only shared by the triangles of a section if they gave it the same color
+	void Build(
+		FVoxelChunkMesh& Chunk, 
+		const TArray<uint32>& Indices, 
+		const TArray<FVoxelMesherVertex>& Vertices, 
+		bool bRenderWorld, 
+		bool bReuseOnlySameColor) const
+	{
+		VOXEL_FUNCTION_COUNTER();
+
+		const int32 NumSections = Materials.Num();
+		
+		// Sort the triangles by section, keeping their order
+		TArray<int32, TInlineAllocator<16>> SectionStarts;
+		SectionStarts.SetNumUninitialized(NumSections + 1);
+		SectionStarts[0] = 0;
+		for (int32 Section = 0; Section < NumSections; Section++)
+		{
+			SectionStarts[Section + 1] = SectionStarts[Section] + NumTriangles[Section];
+		}
+		
+		TArray<int32> SortedTriangles;
+		SortedTriangles.SetNumUninitialized(TriangleSections.Num());
+		{
+			TArray<int32, TInlineAllocator<16>> SectionEnds(SectionStarts.GetData(), NumSections);
+			for (int32 Triangle = 0; Triangle < TriangleSections.Num(); Triangle++)
+			{
+				SortedTriangles[SectionEnds[TriangleSections[Triangle]]++] = Triangle;
+			}
+		}
+
+		// Index of the vertices in the buffer of the current section, -1 if not added yet
+		TArray<int32> FinalIndices;
+		FinalIndices.Init(-1, Vertices.Num());
+		TArray<FColor> FinalColors;
+		FinalColors.SetNumUninitialized(Vertices.Num());
+
+		for (int32 Section = 0; Section < NumSections; Section++)
+		{
+			// Sections are created in the order they are first used, same as when adding the triangles one by one
+			FVoxelChunkMeshBuffers& Buffer = Chunk.FindOrAddBuffer(Materials[Section]);
+			Buffer.Indices.Reserve(3 * NumTriangles[Section]);
+			
+			for (int32 SortedIndex = SectionStarts[Section]; SortedIndex < SectionStarts[Section + 1]; SortedIndex++)
+			{
+				const int32 Triangle = SortedTriangles[SortedIndex];
+				for (int32 Index = 3 * Triangle; Index < 3 * Triangle + 3; Index++)
+				{
+					const int32 VertexIndex = Indices[Index];
+					const FColor Color = Colors[Index];
+					int32& FinalIndex = FinalIndices[VertexIndex];
+					if (FinalIndex == -1 || (bReuseOnlySameColor && FinalColors[VertexIndex] != Color))
+					{
+						FVoxelFinalMesherVertex FinalVertex{ Vertices[VertexIndex] };
+						FinalVertex.Color = Color;
+						FinalIndex = Buffer.AddVertex(FinalVertex, bRenderWorld);
+						FinalColors[VertexIndex] = Color;
+					}
+					else
+					{
+						ensureVoxelSlow(bReuseOnlySameColor || FinalColors[VertexIndex] == Color);
+					}
+					Buffer.AddIndex(FinalIndex);
+				}
+			}
+			
+			for (int32 SortedIndex = SectionStarts[Section]; SortedIndex < SectionStarts[Section + 1]; SortedIndex++)
+			{
+				const int32 Triangle = SortedTriangles[SortedIndex];
+				FinalIndices[Indices[3 * Triangle + 0]] = -1;
+				FinalIndices[Indices[3 * Triangle + 1]] = -1;
+				FinalIndices[Indices[3 * Triangle + 2]] = -1;
+			}
+		}
+	}
+
+private:
+	TArray<FVoxelBlendedMaterialUnsorted, TInlineAllocator<16>> Materials;
+	TArray<int32, TInlineAllocator<16>> NumTriangles;
+	TArray<TPair<uint32, int32>, TInlineAllocator<16>> Keys;
+	uint32 LastKey = MAX_uint32;
+	int32 LastSection = -1;
 	
-	Settings.DynamicSettings->DynamicSettingsLock.Lock();
-	const auto MaterialCollectionMap = Settings.DynamicSettings->MaterialCollectionMap; // Copy shared ptr to be safe if the voxel world changes it
-	const bool bGenerateBlendings = Settings.DynamicSettings->bGenerateBlendings;
-	Settings.DynamicSettings->DynamicSettingsLock.Unlock();
+	TArray<int32> TriangleSections;
+	TArray<FColor> Colors;
+};
+
+static void CreateDoubleIndexSections(
+	FVoxelChunkMesh& Chunk,
+	const FVoxelMaterialCollectionMap& MaterialCollectionMap,
+	bool bRenderWorld,
+	const TArray<uint32>& Indices,
+	const TArray<FVoxelMesherVertex>& Vertices)
+{
+	VOXEL_FUNCTION_COUNTER();
 	
-	const auto GetMaterialKeyDouble = [&](uint8 IndexA, uint8 IndexB)
+	FVoxelChunkSections Sections(Indices.Num());
+	for (int32 I = 0; I < Indices.Num(); I += 3)
 	{
-		FVoxelBlendedMaterialSorted Sorted;
-		if (IndexA < IndexB)
+		const FVoxelMesherVertex& VertexA = Vertices[Indices[I + 0]];
+		const FVoxelMesherVertex& VertexB = Vertices[Indices[I + 1]];
+		const FVoxelMesherVertex& VertexC = Vertices[Indices[I + 2]];
+		
+		// Same indices on the whole triangle, only blends change
+		FDoubleIndex DoubleIndex;
+		uint8 BlendA;
+		uint8 BlendB;
+		uint8 BlendC;
 		{
-			Sorted = { IndexA, IndexB };
+			FDoubleIndexBlend MaterialA(VertexA.Material);
+			FDoubleIndexBlend MaterialB(VertexB.Material);
+			FDoubleIndexBlend MaterialC(VertexC.Material);
+			FDoubleIndexBlend MaxBlend = FDoubleIndexBlend::GetBest(MaterialA, MaterialB, MaterialC);
+			DoubleIndex = FDoubleIndex(MaxBlend);
+			BlendA = MaterialA.GetBlendFor(MaxBlend);
+			BlendB = MaterialB.GetBlendFor(MaxBlend);
+			BlendC = MaterialC.GetBlendFor(MaxBlend);
 		}
-		else
+
+		const auto AddSingle = [&](uint8 Index)
 		{
-			Sorted = { IndexB, IndexA };
+			Sections.AddTriangle(I / 3, FVoxelChunkSections::MakeKey(FVoxelBlendedMaterialUnsorted::Single, Index), [&]() { return FVoxelBlendedMaterialUnsorted(Index); });
+		};
+		if (DoubleIndex.IndexA == DoubleIndex.IndexB)
+		{
+			AddSingle(DoubleIndex.IndexA);
+		}
+		else if (BlendA == 0 && BlendB == 0 && BlendC == 0)
+		{
+			AddSingle(DoubleIndex.IndexA);
 		}
-		auto* Unsorted = MaterialCollectionMap->Find(Sorted);
-		if (!Unsorted)
+		else if (BlendA == 255 && BlendB == 255 && BlendC == 255)
 		{
-			return FVoxelBlendedMaterialUnsorted(Sorted.Index0, Sorted.Index1);
+			AddSingle(DoubleIndex.IndexB);
 		}
 		else
 		{
-			return *Unsorted;
+			const int32 Section = Sections.AddTriangle(
+				I / 3,
+				FVoxelChunkSections::MakeKey(FVoxelBlendedMaterialUnsorted::Double, DoubleIndex.IndexA, DoubleIndex.IndexB),
+				[&]() { return GetMaterialKeyDouble(MaterialCollectionMap, DoubleIndex.IndexA, DoubleIndex.IndexB); });
+			if (Sections.GetMaterial(Section).Index0 != DoubleIndex.IndexA)
+			{
+				// They were swapped, change the blends accordingly
+				BlendA = 255 - BlendA;
+				BlendB = 255 - BlendB;
+				BlendC = 255 - BlendC;
+			}
 		}
-	};
-	const auto GetMaterialKeyTriple = [&](uint8 IndexA, uint8 IndexB, uint8 IndexC)
+
+		const auto SetColor = [&](int32 Index, const FVoxelMesherVertex& Vertex, uint8 Blend)
+		{
+			FColor& Color = Sections.GetColor(Index);
+			Color = Vertex.Material.GetColor();
+			// We want to have G being the IndexA, B the IndexB and A the custom data
+			Color.B = Color.G; // Index B
+			Color.G = Color.R; // Index A
+			Color.R = Blend;
+		};
+		SetColor(I + 0, VertexA, BlendA);
+		SetColor(I + 1, VertexB, BlendB);
+		SetColor(I + 2, VertexC, BlendC);
+	}
+
+	// As the blends are per triangle, a vertex can have different colors in the same section
+	Sections.Build(Chunk, Indices, Vertices, bRenderWorld, true);
+}
+
+static void CreateSingleIndexSections(
+	FVoxelChunkMesh& Chunk,
+	const FVoxelMaterialCollectionMap& MaterialCollectionMap,
+	bool bGenerateBlendings,
+	bool bRenderWorld,
+	const TArray<uint32>& Indices,
+	const TArray<FVoxelMesherVertex>& Vertices)
+{
+	VOXEL_FUNCTION_COUNTER();
+	
+	FVoxelChunkSections Sections(Indices.Num());
+	for (int32 I = 0; I < Indices.Num(); I += 3)
 	{
-		const int32 Min = FMath::Min3(IndexA, IndexB, IndexC);
-		const int32 Max = FMath::Max3(IndexA, IndexB, IndexC);
-		const int32 Med = IndexA + IndexB + IndexC - Min - Max;
-		const FVoxelBlendedMaterialSorted Sorted(Min, Med, Max);
-		auto* Unsorted = MaterialCollectionMap->Find(Sorted);
-		if (!Unsorted)
-		{
-			return FVoxelBlendedMaterialUnsorted(Sorted.Index0, Sorted.Index1, Sorted.Index2);
+		const FVoxelMesherVertex& VertexA = Vertices[Indices[I + 0]];
+		const FVoxelMesherVertex& VertexB = Vertices[Indices[I + 1]];
+		const FVoxelMesherVertex& VertexC = Vertices[Indices[I + 2]];
+		const uint8 MaterialIndexA = VertexA.Material.GetSingleIndex_Index();
+		const uint8 MaterialIndexB = VertexB.Material.GetSingleIndex_Index();
+		const uint8 MaterialIndexC = VertexC.Material.GetSingleIndex_Index();
+
+		FColor& ColorA = Sections.GetColor(I + 0);
+		FColor& ColorB = Sections.GetColor(I + 1);
+		FColor& ColorC = Sections.GetColor(I + 2);
+		ColorA = VertexA.Material.GetColor();
+		ColorB = VertexB.Material.GetColor();
+		ColorC = VertexC.Material.GetColor();
+
+		// Send Material.R and Material.G through Vertex.B and Vertex.A, as Material.A is useless (index)
+		const auto FixColor = [](FColor& Color)
+		{
+			Color.B = Color.R;
+			Color.A = Color.G;
+		};
+		FixColor(ColorA);
+		FixColor(ColorB);
+		FixColor(ColorC);
+		
+		if ((MaterialIndexA == MaterialIndexB && MaterialIndexA == MaterialIndexC) || !bGenerateBlendings)
+		{
+			Sections.AddTriangle(
+				I / 3,
+				FVoxelChunkSections::MakeKey(FVoxelBlendedMaterialUnsorted::Single, MaterialIndexA),
+				[&]() { return FVoxelBlendedMaterialUnsorted(MaterialIndexA); });
+		}
+		else if (MaterialIndexA != MaterialIndexB && MaterialIndexA != MaterialIndexC && MaterialIndexB != MaterialIndexC)
+		{
+			const uint8 Min = FMath::Min3(MaterialIndexA, MaterialIndexB, MaterialIndexC);
+			const uint8 Max = FMath::Max3(MaterialIndexA, MaterialIndexB, MaterialIndexC);
+			const uint8 Med = MaterialIndexA + MaterialIndexB + MaterialIndexC - Min - Max;
+			const int32 Section = Sections.AddTriangle(
+				I / 3,
+				FVoxelChunkSections::MakeKey(FVoxelBlendedMaterialUnsorted::Triple, Min, Med, Max),
+				[&]() { return GetMaterialKeyTriple(MaterialCollectionMap, MaterialIndexA, MaterialIndexB, MaterialIndexC); });
+			const FVoxelBlendedMaterialUnsorted& Material = Sections.GetMaterial(Section);
+			ColorA.R = MaterialIndexA == Material.Index0 ? 255 : 0;
+			ColorB.R = MaterialIndexB == Material.Index0 ? 255 : 0;
+			ColorC.R = MaterialIndexC == Material.Index0 ? 255 : 0;
+			ColorA.G = MaterialIndexA == Material.Index1 ? 255 : 0;
+			ColorB.G = MaterialIndexB == Material.Index1 ? 255 : 0;
+			ColorC.G = MaterialIndexC == Material.Index1 ? 255 : 0;
 		}
 		else
 		{
-			return *Unsorted;
+			const uint8 Min = FMath::Min3(MaterialIndexA, MaterialIndexB, MaterialIndexC);
+			const uint8 Max = FMath::Max3(MaterialIndexA, MaterialIndexB, MaterialIndexC);
+			const int32 Section = Sections.AddTriangle(
+				I / 3,
+				FVoxelChunkSections::MakeKey(FVoxelBlendedMaterialUnsorted::Double, Min, Max),
+				[&]() { return GetMaterialKeyDouble(MaterialCollectionMap, Min, Max); });
+			const FVoxelBlendedMaterialUnsorted& Material = Sections.GetMaterial(Section);
+			ColorA.R = MaterialIndexA == Material.Index1 ? 255 : 0;
+			ColorB.R = MaterialIndexB == Material.Index1 ? 255 : 0;
+			ColorC.R = MaterialIndexC == Material.Index1 ? 255 : 0;
 		}
-	};
+	}
+
+	// The vertex colors only depend on the section, no need to check them
+	Sections.Build(Chunk, Indices, Vertices, bRenderWorld, false);
+}
+
+TVoxelSharedPtr<FVoxelChunkMesh> FVoxelMesherUtilities::CreateChunkFromVertices(
+	const FVoxelRendererSettings& Settings, 
+	TArray<uint32>&& Indices, 
+	TArray<FVoxelMesherVertex>&& Vertices)
+{
+	VOXEL_FUNCTION_COUNTER();
+
+	auto Chunk = MakeVoxelShared<FVoxelChunkMesh>();
+	
+	Settings.DynamicSettings->DynamicSettingsLock.Lock();
+	const auto MaterialCollectionMap = Settings.DynamicSettings->MaterialCollectionMap; // Copy shared ptr to be safe if the voxel world changes it
+	const bool bGenerateBlendings = Settings.DynamicSettings->bGenerateBlendings;
+	Settings.DynamicSettings->DynamicSettingsLock.Unlock();
 	
 	if (Settings.MaterialConfig == EVoxelMaterialConfig::RGB)
 	{
@@ -242,6 +556,34 @@ TVoxelSharedPtr<FVoxelChunkMesh> FVoxelMesherUtilities::CreateChunkFromVertices(
 	else if (Settings.MaterialConfig == EVoxelMaterialConfig::DoubleIndex)
 	{
 		Chunk->SetIsSingle(false);
+		CreateDoubleIndexSections(*Chunk, *MaterialCollectionMap, Settings.bRenderWorld, Indices, Vertices);
+	}
+	else
+	{
+		check(Settings.MaterialConfig == EVoxelMaterialConfig::SingleIndex);
+		Chunk->SetIsSingle(false);
+		CreateSingleIndexSections(*Chunk, *MaterialCollectionMap, bGenerateBlendings, Settings.bRenderWorld, Indices, Vertices);
+	}
+
+	return Chunk;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+
+// Previous implementation, adding the triangles one by one with a map of the vertices per section. Used to check the output of the sections
+static void CreateSectionsReference(
+	FVoxelChunkMesh& Chunk,
+	EVoxelMaterialConfig MaterialConfig,
+	const FVoxelMaterialCollectionMap& MaterialCollectionMap,
+	bool bGenerateBlendings,
+	bool bRenderWorld,
+	const TArray<uint32>& Indices,
+	const TArray<FVoxelMesherVertex>& Vertices)
+{
+	if (MaterialConfig == EVoxelMaterialConfig::DoubleIndex)
+	{
 		TMap<FVoxelBlendedMaterialUnsorted, TMap<int32, int32>> IndicesMaps;
 		for (int32 I = 0; I < Indices.Num(); I += 3)
 		{
@@ -283,7 +625,7 @@ TVoxelSharedPtr<FVoxelChunkMesh> FVoxelMesherUtilities::CreateChunkFromVertices(
 			}
 			else
 			{
-				Material = GetMaterialKeyDouble(DoubleIndex.IndexA, DoubleIndex.IndexB);
+				Material = GetMaterialKeyDouble(MaterialCollectionMap, DoubleIndex.IndexA, DoubleIndex.IndexB);
 				if (Material.Index0 != DoubleIndex.IndexA)
 				{
 					// They were swapped, change the blends accordingly
@@ -293,7 +635,7 @@ TVoxelSharedPtr<FVoxelChunkMesh> FVoxelMesherUtilities::CreateChunkFromVertices(
 				}
 			}
 
-			FVoxelChunkMeshBuffers& Buffer = Chunk->FindOrAddBuffer(Material);
+			FVoxelChunkMeshBuffers& Buffer = Chunk.FindOrAddBuffer(Material);
 			TMap<int32, int32>& IndicesMap = IndicesMaps.FindOrAdd(Material);
 			
 			const auto AddVertex = [&](const int32 Index, const uint8 Blend, const FVoxelMesherVertex& Vertex)
@@ -312,7 +654,7 @@ TVoxelSharedPtr<FVoxelChunkMesh> FVoxelMesherUtilities::CreateChunkFromVertices(
 				}
 				else
 				{
-					FinalIndex = Buffer.AddVertex(FinalVertex, Settings.bRenderWorld);
+					FinalIndex = Buffer.AddVertex(FinalVertex, bRenderWorld);
 					IndicesMap.Add(Index, FinalIndex);
 				}
 				Buffer.AddIndex(FinalIndex);
@@ -325,8 +667,7 @@ TVoxelSharedPtr<FVoxelChunkMesh> FVoxelMesherUtilities::CreateChunkFromVertices(
 	}
 	else
 	{
-		check(Settings.MaterialConfig == EVoxelMaterialConfig::SingleIndex);
-		Chunk->SetIsSingle(false);
+		check(MaterialConfig == EVoxelMaterialConfig::SingleIndex);
 		
 		TMap<FVoxelBlendedMaterialUnsorted, TMap<int32, int32>> IndicesMaps;
 		for (int32 I = 0; I < Indices.Num(); I += 3)
@@ -347,17 +688,17 @@ TVoxelSharedPtr<FVoxelChunkMesh> FVoxelMesherUtilities::CreateChunkFromVertices(
 				Color.B = Color.R;
 				Color.A = Color.G;
 			};
-			const auto AddVertex = [&Settings](FVoxelChunkMeshBuffers& Buffer, TMap<int32, int32>& IndicesMap, int32 Index, const FVoxelFinalMesherVertex& Vertex)
+			const auto AddVertex = [bRenderWorld](FVoxelChunkMeshBuffers& Buffer, TMap<int32, int32>& IndicesMap, int32 Index, const FVoxelFinalMesherVertex& Vertex)
 			{
 				int32 FinalIndex;
 				if (int32* FinalIndexPtr = IndicesMap.Find(Index))
 				{
 					FinalIndex = *FinalIndexPtr;
-					ensureVoxelSlow(!Settings.bRenderWorld || Buffer.Colors[FinalIndex] == Vertex.Color);
+					ensureVoxelSlow(!bRenderWorld || Buffer.Colors[FinalIndex] == Vertex.Color);
 				}
 				else
 				{
-					FinalIndex = Buffer.AddVertex(Vertex, Settings.bRenderWorld);
+					FinalIndex = Buffer.AddVertex(Vertex, bRenderWorld);
 					IndicesMap.Add(Index, FinalIndex);
 				}
 				Buffer.AddIndex(FinalIndex);
@@ -366,7 +707,7 @@ TVoxelSharedPtr<FVoxelChunkMesh> FVoxelMesherUtilities::CreateChunkFromVertices(
 			if ((MaterialIndexA == MaterialIndexB && MaterialIndexA == MaterialIndexC) || !bGenerateBlendings)
 			{
 				const FVoxelBlendedMaterialUnsorted Material(MaterialIndexA);
-				auto& Buffer = Chunk->FindOrAddBuffer(Material);
+				auto& Buffer = Chunk.FindOrAddBuffer(Material);
 				auto& IndicesMap = IndicesMaps.FindOrAdd(Material);
 				const auto AddVertexSingle = [&](int32 Index, const FVoxelMesherVertex& Vertex)
 				{
@@ -392,7 +733,7 @@ TVoxelSharedPtr<FVoxelChunkMesh> FVoxelMesherUtilities::CreateChunkFromVertices(
 				FixColor(ColorC);
 				if (MaterialIndexA != MaterialIndexB && MaterialIndexA != MaterialIndexC && MaterialIndexB != MaterialIndexC)
 				{
-					Material = GetMaterialKeyTriple(MaterialIndexA, MaterialIndexB, MaterialIndexC);
+					Material = GetMaterialKeyTriple(MaterialCollectionMap, MaterialIndexA, MaterialIndexB, MaterialIndexC);
 					ColorA.R = MaterialIndexA == Material.Index0 ? 255 : 0;
 					ColorB.R = MaterialIndexB == Material.Index0 ? 255 : 0;
 					ColorC.R = MaterialIndexC == Material.Index0 ? 255 : 0;
@@ -403,13 +744,14 @@ TVoxelSharedPtr<FVoxelChunkMesh> FVoxelMesherUtilities::CreateChunkFromVertices(
 				else
 				{
 					Material = GetMaterialKeyDouble(
+						MaterialCollectionMap,
 						FMath::Min3(MaterialIndexA, MaterialIndexB, MaterialIndexC),
 						FMath::Max3(MaterialIndexA, MaterialIndexB, MaterialIndexC));
 					ColorA.R = MaterialIndexA == Material.Index1 ? 255 : 0;
 					ColorB.R = MaterialIndexB == Material.Index1 ? 255 : 0;
 					ColorC.R = MaterialIndexC == Material.Index1 ? 255 : 0;
 				}
-				FVoxelChunkMeshBuffers& Buffer = Chunk->FindOrAddBuffer(Material);
+				FVoxelChunkMeshBuffers& Buffer = Chunk.FindOrAddBuffer(Material);
 				auto& IndicesMap = IndicesMaps.FindOrAdd(Material);
 				AddVertex(Buffer, IndicesMap, IndexA, NewVertexA);
 				AddVertex(Buffer, IndicesMap, IndexB, NewVertexB);
@@ -418,5 +760,153 @@ TVoxelSharedPtr<FVoxelChunkMesh> FVoxelMesherUtilities::CreateChunkFromVertices(
 		}
 	}
 
-	return Chunk;
-}
\ No newline at end of file
+}
+
+static void BenchmarkChunkSections(const TArray<FString>& Args)
+{
+	const int32 NumRuns = Args.Num() > 0 ? FMath::Max(1, FCString::Atoi(*Args[0])) : 100;
+	const int32 NumMaterials = Args.Num() > 1 ? FMath::Clamp(FCString::Atoi(*Args[1]), 1, 256) : 4;
+
+	// Grid mesh with materials changing smoothly, as a mesher would output
+	constexpr int32 GridSize = 64;
+	TArray<FVoxelMesherVertex> BaseVertices;
+	TArray<uint32> Indices;
+	for (int32 Y = 0; Y <= GridSize; Y++)
+	{
+		for (int32 X = 0; X <= GridSize; X++)
+		{
+			FVoxelMesherVertex Vertex;
+			Vertex.Position = FVector(X, Y, FMath::Sin(X * 0.3f) * FMath::Cos(Y * 0.2f) * 4);
+			Vertex.Normal = FVector(0, 0, 1);
+			Vertex.Tangent = FVoxelProcMeshTangent();
+			Vertex.TextureCoordinate = FVector2D(X, Y);
+			Vertex.Material = FVoxelMaterial::Default();
+			BaseVertices.Add(Vertex);
+		}
+	}
+	for (int32 Y = 0; Y < GridSize; Y++)
+	{
+		for (int32 X = 0; X < GridSize; X++)
+		{
+			const uint32 Index = X + Y * (GridSize + 1);
+			Indices.Append({ Index, Index + 1, Index + GridSize + 1 });
+			Indices.Append({ Index + 1, Index + GridSize + 2, Index + GridSize + 1 });
+		}
+	}
+
+	// Blend some of the materials together, the others use the default blends
+	FVoxelMaterialCollectionMap MaterialCollectionMap;
+	for (int32 IndexA = 0; IndexA < NumMaterials; IndexA++)
+	{
+		for (int32 IndexB = IndexA + 1; IndexB < NumMaterials; IndexB += 2)
+		{
+			MaterialCollectionMap.Add(FVoxelBlendedMaterialSorted(IndexA, IndexB), FVoxelBlendedMaterialUnsorted(IndexB, IndexA));
+		}
+	}
+
+	bool bAllValid = true;
+	const auto Benchmark = [&](const TCHAR* Name, EVoxelMaterialConfig MaterialConfig, bool bGenerateBlendings, bool bRenderWorld)
+	{
+		TArray<FVoxelMesherVertex> Vertices = BaseVertices;
+		FRandomStream Stream(NumMaterials);
+		for (int32 Index = 0; Index < Vertices.Num(); Index++)
+		{
+			const FVector& Position = Vertices[Index].Position;
+			const int32 Region = FMath::Clamp(FMath::FloorToInt((Position.X + Position.Y) / (2 * GridSize + 1) * NumMaterials), 0, NumMaterials - 1);
+			const int32 MaterialIndex = Stream.FRand() < 0.2f ? Stream.RandHelper(NumMaterials) : Region;
+			FVoxelMaterial& Material = Vertices[Index].Material;
+			Material.SetColor(FColor(Stream.RandHelper(256), Stream.RandHelper(256), Stream.RandHelper(256), Stream.RandHelper(256)));
+			if (MaterialConfig == EVoxelMaterialConfig::DoubleIndex)
+			{
+				Material.SetDoubleIndex_IndexA(uint8(MaterialIndex));
+				Material.SetDoubleIndex_IndexB(uint8((MaterialIndex + 1) % NumMaterials));
+				const int32 Blend = Stream.RandHelper(3);
+				Material.SetDoubleIndex_Blend(uint8(Blend == 0 ? 0 : Blend == 1 ? 255 : Stream.RandHelper(256)));
+			}
+			else
+			{
+				Material.SetSingleIndex_Index(uint8(MaterialIndex));
+			}
+		}
+
+		FVoxelChunkMesh NewChunk;
+		FVoxelChunkMesh ReferenceChunk;
+		NewChunk.SetIsSingle(false);
+		ReferenceChunk.SetIsSingle(false);
+		if (MaterialConfig == EVoxelMaterialConfig::DoubleIndex)
+		{
+			CreateDoubleIndexSections(NewChunk, MaterialCollectionMap, bRenderWorld, Indices, Vertices);
+		}
+		else
+		{
+			CreateSingleIndexSections(NewChunk, MaterialCollectionMap, bGenerateBlendings, bRenderWorld, Indices, Vertices);
+		}
+		CreateSectionsReference(ReferenceChunk, MaterialConfig, MaterialCollectionMap, bGenerateBlendings, bRenderWorld, Indices, Vertices);
+
+		// Sections must be the same, in the same order
+		TArray<FVoxelBlendedMaterialUnsorted> NewMaterials;
+		TArray<FVoxelBlendedMaterialUnsorted> ReferenceMaterials;
+		NewChunk.IterateMaterials([&](const FVoxelBlendedMaterialUnsorted& Material) { NewMaterials.Add(Material); });
+		ReferenceChunk.IterateMaterials([&](const FVoxelBlendedMaterialUnsorted& Material) { ReferenceMaterials.Add(Material); });
+		bool bValid = NewMaterials == ReferenceMaterials;
+		for (int32 Section = 0; bValid && Section < NewMaterials.Num(); Section++)
+		{
+			const auto NewBuffer = NewChunk.FindBuffer(NewMaterials[Section]);
+			const auto ReferenceBuffer = ReferenceChunk.FindBuffer(NewMaterials[Section]);
+			bValid &=
+				NewBuffer->Indices == ReferenceBuffer->Indices &&
+				NewBuffer->Positions == ReferenceBuffer->Positions &&
+				NewBuffer->Normals == ReferenceBuffer->Normals &&
+				NewBuffer->Colors == ReferenceBuffer->Colors &&
+				NewBuffer->TextureCoordinates[0] == ReferenceBuffer->TextureCoordinates[0];
+		}
+		bAllValid &= bValid;
+
+		const auto Time = [&](auto Lambda)
+		{
+			const double Start = FPlatformTime::Seconds();
+			for (int32 Run = 0; Run < NumRuns; Run++)
+			{
+				FVoxelChunkMesh Chunk;
+				Chunk.SetIsSingle(false);
+				Lambda(Chunk);
+			}
+			return (FPlatformTime::Seconds() - Start) / NumRuns * 1000;
+		};
+		const double NewTime = Time([&](FVoxelChunkMesh& Chunk)
+		{
+			if (MaterialConfig == EVoxelMaterialConfig::DoubleIndex)
+			{
+				CreateDoubleIndexSections(Chunk, MaterialCollectionMap, bRenderWorld, Indices, Vertices);
+			}
+			else
+			{
+				CreateSingleIndexSections(Chunk, MaterialCollectionMap, bGenerateBlendings, bRenderWorld, Indices, Vertices);
+			}
+		});
+		const double ReferenceTime = Time([&](FVoxelChunkMesh& Chunk)
+		{
+			CreateSectionsReference(Chunk, MaterialConfig, MaterialCollectionMap, bGenerateBlendings, bRenderWorld, Indices, Vertices);
+		});
+
+		UE_LOG(LogVoxel, Log, TEXT("%-24s: %2d sections; %8.3fms with the map, %8.3fms with the sections (%5.2fx); %s"),
+			Name,
+			NewMaterials.Num(),
+			ReferenceTime,
+			NewTime,
+			NewTime > 0 ? ReferenceTime / NewTime : 0,
+			bValid ? TEXT("identical") : TEXT("DIFFERENT"));
+	};
+
+	UE_LOG(LogVoxel, Log, TEXT("Chunk sections: %d triangles, %d materials, %d runs"), Indices.Num() / 3, NumMaterials, NumRuns);
+	Benchmark(TEXT("Double Index"), EVoxelMaterialConfig::DoubleIndex, false, true);
+	Benchmark(TEXT("Single Index"), EVoxelMaterialConfig::SingleIndex, false, true);
+	Benchmark(TEXT("Single Index Blendings"), EVoxelMaterialConfig::SingleIndex, true, true);
+	Benchmark(TEXT("Single Index Collisions"), EVoxelMaterialConfig::SingleIndex, true, false);
+	UE_LOG(LogVoxel, Log, TEXT("%s"), bAllValid ? TEXT("All the sections are identical") : TEXT("ERROR: the sections are different"));
+}
+
+static FAutoConsoleCommand BenchmarkChunkSectionsCmd(
+	TEXT("voxel.mesher.BenchmarkSections"),
+	TEXT("Compare the splitting of chunks by material with the previous map based implementation, and check that their outputs are identical. Args: [NumRuns] [NumMaterials]"),
+	FConsoleCommandWithArgsDelegate::CreateStatic(&BenchmarkChunkSections));
\ No newline at end of file
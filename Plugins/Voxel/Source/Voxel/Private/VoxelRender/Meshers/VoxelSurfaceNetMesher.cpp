@@ -74,6 +74,11 @@ FIntBox FVoxelSurfaceNetMesher::GetBoundsToLock() const
 	return GetBoundsToCheckIsEmptyOn();
 }
 
+FIntBox FVoxelSurfaceNetMesher::GetBoundsToPrefetch() const
+{
+	return GetBoundsToCheckIsEmptyOn();
+}
+
 inline float SampleIsoValue(const float Values[8], const FVector& Offset)
 {
 	// TODO use FVoxelUtilities::TrilinearInterpolation
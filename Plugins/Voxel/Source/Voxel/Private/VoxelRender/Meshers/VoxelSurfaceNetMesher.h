@@ -17,6 +17,7 @@ public:
 protected:
 	virtual FIntBox GetBoundsToCheckIsEmptyOn() const override final;
 	virtual FIntBox GetBoundsToLock() const override final;
+	virtual FIntBox GetBoundsToPrefetch() const override final;
 	virtual TVoxelSharedPtr<FVoxelChunkMesh> CreateFullChunkImpl(FVoxelMesherTimes& Times) override final;
 	virtual void CreateGeometryImpl(FVoxelMesherTimes& Times, TArray<uint32>& Indices, TArray<FVector>& Vertices) override final;
 	
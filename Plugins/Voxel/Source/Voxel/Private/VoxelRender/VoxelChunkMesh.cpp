@@ -6,6 +6,7 @@
 
 #include "Materials/MaterialInstanceDynamic.h"
 #include "DistanceFieldAtlas.h"
+#include "HAL/IConsoleManager.h"
 
 #if ENABLE_TESSELLATION
 #include "ThirdParty/nvtesslib/inc/nvtess.h"
@@ -26,12 +27,10 @@ class FVoxelStaticMeshNvRenderBuffer : public nv::RenderBuffer
 public:
 
 	/** Construct from static mesh render buffers. */
-	FVoxelStaticMeshNvRenderBuffer(
-		const TArray<FVector>& InPositionVertexBuffer,
-		const TArray<uint32>& Indices)
-		: PositionVertexBuffer(InPositionVertexBuffer)
+	FVoxelStaticMeshNvRenderBuffer(const FVoxelChunkMeshBuffers& InBuffers)
+		: Buffers(InBuffers)
 	{
-		mIb = new nv::IndexBuffer((void*)Indices.GetData(), nv::IBT_U32, Indices.Num(), false);
+		mIb = new nv::IndexBuffer((void*)Buffers.Indices.GetData(), nv::IBT_U32, Buffers.Indices.Num(), false);
 	}
 
 	/** Retrieve the position and first texture coordinate of the specified index. */
@@ -39,7 +38,7 @@ public:
 	{
 		nv::Vertex Vertex;
 
-		const FVector& Position = PositionVertexBuffer[Index];
+		const FVector Position = Buffers.GetPosition(Index);
 		Vertex.pos.x = Position.X;
 		Vertex.pos.y = Position.Y;
 		Vertex.pos.z = Position.Z;
@@ -51,8 +50,8 @@ public:
 	}
 
 private:
-	/** The position vertex buffer for the static mesh. */
-	const TArray<FVector>& PositionVertexBuffer;
+	/** The buffers of the chunk. */
+	const FVoxelChunkMeshBuffers& Buffers;
 
 	/** Copying is forbidden. */
 	FVoxelStaticMeshNvRenderBuffer(const FVoxelStaticMeshNvRenderBuffer&) = delete;
@@ -67,7 +66,7 @@ void FVoxelChunkMeshBuffers::BuildAdjacency(TArray<uint32>& OutAdjacencyIndices)
 #if ENABLE_TESSELLATION
 	if (Indices.Num())
 	{
-		FVoxelStaticMeshNvRenderBuffer StaticMeshRenderBuffer(Positions, Indices);
+		FVoxelStaticMeshNvRenderBuffer StaticMeshRenderBuffer(*this);
 		nv::IndexBuffer* PnAENIndexBuffer = nv::tess::buildTessellationBuffer(&StaticMeshRenderBuffer, nv::DBM_PnAenDominantCorner, true);
 		check(PnAENIndexBuffer);
 		const int32 IndexCount = int32(PnAENIndexBuffer->getLength());
@@ -109,6 +108,13 @@ void FVoxelChunkMeshBuffers::Shrink()
 	{
 		TextureCoordinates[Tex].Shrink();
 	}
+	PackedPositions.Shrink();
+	PackedNormals.Shrink();
+	PackedTangents.Shrink();
+	for (uint32 Tex = 0; Tex < NUM_VOXEL_TEXTURE_COORDINATES; Tex++)
+	{
+		HalfTextureCoordinates[Tex].Shrink();
+	}
 
 	UpdateStat();
 }
@@ -116,12 +122,215 @@ void FVoxelChunkMeshBuffers::Shrink()
 void FVoxelChunkMeshBuffers::ComputeBounds()
 {
 	Bounds = FBox(ForceInit);
-	for(auto& Vertex : Positions)
+	const int32 NumVertices = GetNumVertices();
+	for (int32 Index = 0; Index < NumVertices; Index++)
 	{
-		Bounds += Vertex;
+		Bounds += GetPosition(Index);
+	}
+}
+
+void FVoxelChunkMeshBuffers::GetPackedPositionsGrid(int32 LOD, FVector& OutMin, FVector& OutScale)
+{
+	// Power of two scale, so that the grid positions are exact in float
+	static_assert((RENDER_CHUNK_SIZE & (RENDER_CHUNK_SIZE - 1)) == 0, "RENDER_CHUNK_SIZE must be a power of two");
+	
+	const float ChunkSpan = RENDER_CHUNK_SIZE << LOD;
+	OutMin = FVector(-ChunkSpan / 2);
+	OutScale = FVector(ChunkSpan / (1 << 15));
+}
+
+void FVoxelChunkMeshBuffers::Pack(int32 LOD, bool bHalfPrecision)
+{
+	VOXEL_FUNCTION_COUNTER();
+
+	check(!bPacked && !bHalfTextureCoordinates);
+	
+	const int32 NumVertices = Positions.Num();
+	if (NumVertices > 0)
+	{
+		GetPackedPositionsGrid(LOD, PackedPositionsMin, PackedPositionsScale);
+		const FVector InvScale = FVector(1.f) / PackedPositionsScale;
+		const FBox GridBounds(PackedPositionsMin, PackedPositionsMin + PackedPositionsScale * MAX_uint16);
+
+		PackedPositions.SetNumUninitialized(NumVertices);
+		for (int32 Index = 0; Index < NumVertices; Index++)
+		{
+			const FVector& Position = Positions[Index];
+			ensureVoxelSlow(GridBounds.IsInsideOrOn(Position));
+			PackedPositions[Index] = FVoxelPackedPosition(Position, PackedPositionsMin, InvScale);
+		}
+	}
+	
+	PackedNormals.SetNumUninitialized(Normals.Num());
+	for (int32 Index = 0; Index < Normals.Num(); Index++)
+	{
+		PackedNormals[Index] = FVoxelPackedNormal(Normals[Index]);
+	}
+	
+	PackedTangents.SetNumUninitialized(Tangents.Num());
+	for (int32 Index = 0; Index < Tangents.Num(); Index++)
+	{
+		PackedTangents[Index] = FVoxelPackedTangent(Tangents[Index]);
+	}
+
+	Positions.Empty();
+	Normals.Empty();
+	Tangents.Empty();
+	bPacked = true;
+
+	if (bHalfPrecision)
+	{
+		for (uint32 Tex = 0; Tex < NUM_VOXEL_TEXTURE_COORDINATES; Tex++)
+		{
+			HalfTextureCoordinates[Tex].SetNumUninitialized(TextureCoordinates[Tex].Num());
+			for (int32 Index = 0; Index < TextureCoordinates[Tex].Num(); Index++)
+			{
+				HalfTextureCoordinates[Tex][Index] = FVector2DHalf(TextureCoordinates[Tex][Index]);
+			}
+			TextureCoordinates[Tex].Empty();
+		}
+		bHalfTextureCoordinates = true;
+	}
+
+	UpdateStat();
+}
+
+static void TestPackedVertices(const TArray<FString>& Args)
+{
+	const int32 NumVertices = Args.Num() > 0 ? FMath::Max(1, FCString::Atoi(*Args[0])) : 100000;
+
+	constexpr float MaxNormalError = 0.01f; // Degrees
+	constexpr float MaxTangentError = 0.02f; // Degrees, Y has one less bit
+	constexpr float MaxUVError = 1.f / 1024; // Half floats in [0, 1]
+
+	struct FTestVertex
+	{
+		FVector Position;
+		FVector Normal;
+		FVoxelProcMeshTangent Tangent;
+		FColor Color;
+		FVector2D TextureCoordinates[NUM_VOXEL_TEXTURE_COORDINATES];
+	};
+
+	const auto AngleError = [](const FVector& A, const FVector& B)
+	{
+		return FMath::RadiansToDegrees(FMath::Acos(FMath::Clamp(FVector::DotProduct(A, B), -1.f, 1.f)));
+	};
+
+	FRandomStream Stream(NumVertices);
+	bool bSuccess = true;
+	for (int32 LOD = 0; LOD < 8; LOD++)
+	{
+		const float ChunkSize = RENDER_CHUNK_SIZE << LOD;
+
+		// Vertices on the voxel grid of the chunk borders, shared with the neighbors: must be stored exactly to avoid cracks
+		const int32 NumBorderVertices = NumVertices;
+
+		FVoxelChunkMeshBuffers Buffers;
+		Buffers.Reserve(NumVertices + NumBorderVertices, true);
+		for (int32 Index = 0; Index < NumVertices; Index++)
+		{
+			FTestVertex Vertex;
+			// Transvoxel translation can move the vertices slightly outside of the chunk
+			Vertex.Position = FVector(Stream.FRandRange(-1, ChunkSize + 1), Stream.FRandRange(-1, ChunkSize + 1), Stream.FRandRange(-1, ChunkSize + 1));
+			Vertex.Normal = Stream.GetUnitVector();
+			Vertex.Tangent = FVoxelProcMeshTangent(Stream.GetUnitVector(), Stream.FRand() < 0.5f);
+			Vertex.Color = FColor(Stream.RandHelper(256), Stream.RandHelper(256), Stream.RandHelper(256), Stream.RandHelper(256));
+			for (auto& TextureCoordinate : Vertex.TextureCoordinates)
+			{
+				TextureCoordinate = FVector2D(Stream.FRand(), Stream.FRand());
+			}
+			Buffers.AddVertex(Vertex, true);
+		}
+		for (int32 Index = 0; Index < NumBorderVertices; Index++)
+		{
+			FTestVertex Vertex;
+			const int32 Axis = Stream.RandHelper(3);
+			for (int32 Component = 0; Component < 3; Component++)
+			{
+				Vertex.Position[Component] = Component == Axis
+					? (Stream.FRand() < 0.5f ? 0 : ChunkSize)
+					: Stream.RandRange(0, RENDER_CHUNK_SIZE) << LOD;
+			}
+			Vertex.Normal = FVector::UpVector;
+			Vertex.Tangent = FVoxelProcMeshTangent(FVector::ForwardVector, false);
+			Vertex.Color = FColor::White;
+			for (auto& TextureCoordinate : Vertex.TextureCoordinates)
+			{
+				TextureCoordinate = FVector2D::ZeroVector;
+			}
+			Buffers.AddVertex(Vertex, true);
+		}
+		Buffers.ComputeBounds();
+
+		const FVoxelChunkMeshBuffers Reference = Buffers;
+		const int32 UnpackedSize = Buffers.GetAllocatedSize();
+		Buffers.Pack(LOD, true);
+		const int32 PackedSize = Buffers.GetAllocatedSize();
+
+		FVector GridMin;
+		FVector GridScale;
+		FVoxelChunkMeshBuffers::GetPackedPositionsGrid(LOD, GridMin, GridScale);
+		const FVector MaxPositionError = GridScale / 2;
+		FVector PositionError = FVector::ZeroVector;
+		float NormalError = 0;
+		float TangentError = 0;
+		float UVError = 0;
+		bool bFlipsMatch = true;
+		for (int32 Index = 0; Index < NumVertices; Index++)
+		{
+			PositionError = PositionError.ComponentMax((Buffers.GetPosition(Index) - Reference.GetPosition(Index)).GetAbs());
+			NormalError = FMath::Max(NormalError, AngleError(Buffers.GetNormal(Index), Reference.GetNormal(Index)));
+			TangentError = FMath::Max(TangentError, AngleError(Buffers.GetTangent(Index).TangentX, Reference.GetTangent(Index).TangentX));
+			bFlipsMatch &= Buffers.GetTangent(Index).bFlipTangentY == Reference.GetTangent(Index).bFlipTangentY;
+			for (uint32 Tex = 0; Tex < NUM_VOXEL_TEXTURE_COORDINATES; Tex++)
+			{
+				UVError = FMath::Max(UVError, (Buffers.GetTextureCoordinate(Tex, Index) - Reference.GetTextureCoordinate(Tex, Index)).GetAbsMax());
+			}
+		}
+		int32 NumInexactBorderVertices = 0;
+		for (int32 Index = NumVertices; Index < NumVertices + NumBorderVertices; Index++)
+		{
+			if (Buffers.GetPosition(Index) != Reference.GetPosition(Index))
+			{
+				NumInexactBorderVertices++;
+			}
+		}
+
+		// Small margin for the float rounding in the quantization
+		const bool bLODSuccess =
+			PositionError.X <= MaxPositionError.X * 1.01f &&
+			PositionError.Y <= MaxPositionError.Y * 1.01f &&
+			PositionError.Z <= MaxPositionError.Z * 1.01f &&
+			NormalError <= MaxNormalError &&
+			TangentError <= MaxTangentError &&
+			UVError <= MaxUVError &&
+			bFlipsMatch &&
+			NumInexactBorderVertices == 0;
+		bSuccess &= bLODSuccess;
+
+		UE_LOG(LogVoxel, Log, TEXT("LOD %d: %s; position error: %s (max %s); inexact border vertices: %d; normal error: %f deg; tangent error: %f deg; UV error: %f; memory: %d -> %d bytes (%.1f%%)"),
+			LOD,
+			bLODSuccess ? TEXT("OK") : TEXT("FAILED"),
+			*PositionError.ToString(),
+			*MaxPositionError.ToString(),
+			NumInexactBorderVertices,
+			NormalError,
+			TangentError,
+			UVError,
+			UnpackedSize,
+			PackedSize,
+			PackedSize / double(UnpackedSize) * 100);
 	}
+
+	ensureMsgf(bSuccess, TEXT("Packed vertices quantization error is above tolerance"));
 }
 
+static FAutoConsoleCommand TestPackedVerticesCmd(
+	TEXT("voxel.renderer.TestPackedVertices"),
+	TEXT("Check that the quantization error of the packed vertex layout stays within tolerance. Args: NumVertices (default 100000)"),
+	FConsoleCommandWithArgsDelegate::CreateStatic(&TestPackedVertices));
+
 void FVoxelChunkMesh::BuildDistanceField(int32 LOD, const FIntVector& Position, const FVoxelData& Data)
 {
 #if ENABLE_VOXEL_DISTANCE_FIELDS
@@ -132,23 +341,55 @@ void FVoxelChunkMesh::BuildDistanceField(int32 LOD, const FIntVector& Position,
 		return;
 	}
 
-	// One voxel thick layer around the chunk where the distance is > 0 to have a valid distance field
-	// Will be fine in the global one has nearby chunks will have a < 0 distance at these positions
+	constexpr int32 BorderSize = 1;
+	constexpr int32 Size = RENDER_CHUNK_SIZE + 1 + 2 * BorderSize;
+
+	TStackArray<FVoxelValue, Size * Size * Size> Values;
+	ReadDistanceFieldValues(LOD, Position, Data, TArrayView<FVoxelValue>(Values.GetData(), Values.Num()));
+
+	BuildDistanceField(LOD, TArrayView<const FVoxelValue>(Values.GetData(), Values.Num()));
+#endif
+}
+
+void FVoxelChunkMesh::ReadDistanceFieldValues(int32 LOD, const FIntVector& Position, const FVoxelData& Data, TArrayView<FVoxelValue> OutValues)
+{
+	VOXEL_FUNCTION_COUNTER();
 	
 	constexpr int32 BorderSize = 1;
 	constexpr int32 Size = RENDER_CHUNK_SIZE + 1 + 2 * BorderSize;
-	constexpr int32 NumVoxels = Size * Size * Size;
 
 	const int32 Step = 1 << LOD;
 
-	TStackArray<FVoxelValue, NumVoxels> Values;
+	check(OutValues.Num() == Size * Size * Size);
+
+	const FIntBox LockedBounds(Position - BorderSize * Step, Position + (Size - BorderSize) * Step);
+	Data.PrefetchBakedValues(LockedBounds, LOD);
+	FVoxelReadScopeLock Lock(Data, LockedBounds, "Distance Field Build");
+	TVoxelQueryZone<FVoxelValue> QueryZone(LockedBounds, FIntVector(Size), LOD, OutValues.GetData());
+	Data.Get<FVoxelValue>(QueryZone, LOD);
+}
+
+void FVoxelChunkMesh::BuildDistanceField(int32 LOD, TArrayView<const FVoxelValue> Values)
+{
+#if ENABLE_VOXEL_DISTANCE_FIELDS
+	VOXEL_FUNCTION_COUNTER();
+	
+	if (IsEmpty())
 	{
-		const FIntBox LockedBounds(Position - BorderSize * Step, Position + (Size - BorderSize) * Step);
-		FVoxelReadScopeLock Lock(Data, LockedBounds, "Distance Field Build");
-		TVoxelQueryZone<FVoxelValue> QueryZone(LockedBounds, FIntVector(Size), LOD, Values);
-		Data.Get<FVoxelValue>(QueryZone, LOD);
+		return;
 	}
 
+	// One voxel thick layer around the chunk where the distance is > 0 to have a valid distance field
+	// Will be fine in the global one has nearby chunks will have a < 0 distance at these positions
+	
+	constexpr int32 BorderSize = 1;
+	constexpr int32 Size = RENDER_CHUNK_SIZE + 1 + 2 * BorderSize;
+	constexpr int32 NumVoxels = Size * Size * Size;
+
+	const int32 Step = 1 << LOD;
+	
+	check(Values.Num() == NumVoxels);
+
 	TStackArray<float, NumVoxels> DistanceFieldVolume;
 	for (int32 Z = 0; Z < Size; Z++)
 	{
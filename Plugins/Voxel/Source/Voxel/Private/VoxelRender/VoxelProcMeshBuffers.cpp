@@ -8,6 +8,8 @@ DEFINE_STAT(STAT_VoxelProcMeshMemory_Positions);
 DEFINE_STAT(STAT_VoxelProcMeshMemory_Colors);
 DEFINE_STAT(STAT_VoxelProcMeshMemory_Adjacency);
 DEFINE_STAT(STAT_VoxelProcMeshMemory_UVs_Tangents);
+DEFINE_STAT(STAT_VoxelProcMeshUploadSize);
+DEFINE_STAT(STAT_VoxelProcMeshMergeTime);
 
 FVoxelProcMeshBuffers::~FVoxelProcMeshBuffers()
 {
@@ -59,4 +61,12 @@ void FVoxelProcMeshBuffers::UpdateStats()
 	DEC_DWORD_STAT_BY(STAT_VoxelProcMeshMemory_UVs_Tangents, LastAllocatedSize_UVs_Tangents);
 	LastAllocatedSize_UVs_Tangents = VertexBuffers.StaticMeshVertexBuffer.GetResourceSize();
 	INC_DWORD_STAT_BY(STAT_VoxelProcMeshMemory_UVs_Tangents, LastAllocatedSize_UVs_Tangents);
+
+	if (MergeCycles > 0)
+	{
+		// Only report newly merged buffers once
+		INC_DWORD_STAT_BY(STAT_VoxelProcMeshUploadSize, LastAllocatedSize);
+		INC_FLOAT_STAT_BY(STAT_VoxelProcMeshMergeTime, FPlatformTime::ToMilliseconds64(MergeCycles));
+		MergeCycles = 0;
+	}
 }
\ No newline at end of file
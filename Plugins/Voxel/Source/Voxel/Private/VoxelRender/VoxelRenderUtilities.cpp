@@ -179,6 +179,7 @@ TUniquePtr<FVoxelProcMeshBuffers> FVoxelRenderUtilities::MergeSections_AnyThread
 {
 	VOXEL_FUNCTION_COUNTER();
 
+	const uint64 StartCycles = FPlatformTime::Cycles64();
 	const bool bShowMainChunks = CVarShowTransitions.GetValueOnAnyThread() == 0;
 
 	auto ProcMeshBuffersPtr = MakeUnique<FVoxelProcMeshBuffers>();
@@ -255,7 +256,7 @@ TUniquePtr<FVoxelProcMeshBuffers> FVoxelRenderUtilities::MergeSections_AnyThread
 		const int32 ChunkNumVertices = Chunk.GetNumVertices();
 		for (int32 Index = 0; Index < ChunkNumVertices; Index++)
 		{
-			PositionBuffer.VertexPosition(VerticesOffset + Index) = Get(Chunk.Positions, Index) + Offset;
+			PositionBuffer.VertexPosition(VerticesOffset + Index) = Chunk.GetPosition(Index) + Offset;
 		}
 	};
 	const auto CopyColors = [&](auto& Chunk)
@@ -277,9 +278,9 @@ TUniquePtr<FVoxelProcMeshBuffers> FVoxelRenderUtilities::MergeSections_AnyThread
 	{
 		if (!RendererSettings.bRenderWorld)
 		{
-			ensure(Chunk.Tangents.Num() == 0);
-			ensure(Chunk.Normals.Num() == 0);
-			for (uint32 Tex = 0; Tex < NUM_VOXEL_TEXTURE_COORDINATES; Tex++) ensure(Chunk.TextureCoordinates[Tex].Num() == 0);
+			ensure(Chunk.Tangents.Num() == 0 && Chunk.PackedTangents.Num() == 0);
+			ensure(Chunk.Normals.Num() == 0 && Chunk.PackedNormals.Num() == 0);
+			for (uint32 Tex = 0; Tex < NUM_VOXEL_TEXTURE_COORDINATES; Tex++) ensure(Chunk.TextureCoordinates[Tex].Num() == 0 && Chunk.HalfTextureCoordinates[Tex].Num() == 0);
 			return;
 		}
 
@@ -288,14 +289,13 @@ TUniquePtr<FVoxelProcMeshBuffers> FVoxelRenderUtilities::MergeSections_AnyThread
 		for (int32 Index = 0; Index < ChunkNumVertices; Index++)
 		{
 			{
-				auto& Tangent = Get(Chunk.Tangents, Index);
-				auto& Normal = Get(Chunk.Normals, Index);
+				const FVoxelProcMeshTangent Tangent = Chunk.GetTangent(Index);
+				const FVector Normal = Chunk.GetNormal(Index);
 				StaticMeshBuffer.SetVertexTangents(VerticesOffset + Index, Tangent.TangentX, Tangent.GetY(Normal), Normal);
 			}
 			for (uint32 Tex = 0; Tex < NUM_VOXEL_TEXTURE_COORDINATES; Tex++)
 			{
-				auto& TextureCoordinate = Get(Chunk.TextureCoordinates[Tex], Index);
-				StaticMeshBuffer.SetVertexUV(VerticesOffset + Index, Tex, TextureCoordinate);
+				StaticMeshBuffer.SetVertexUV(VerticesOffset + Index, Tex, Chunk.GetTextureCoordinate(Tex, Index));
 			}
 		}
 	};
@@ -341,8 +341,8 @@ TUniquePtr<FVoxelProcMeshBuffers> FVoxelRenderUtilities::MergeSections_AnyThread
 				for (int32 Index = 0; Index < MainChunk.GetNumVertices(); Index++)
 				{
 					PositionBuffer.VertexPosition(VerticesOffset + Index) = FVoxelMesherUtilities::GetTranslatedTransvoxel(
-						Get(MainChunk.Positions, Index),
-						Get(MainChunk.Normals, Index),
+						MainChunk.GetPosition(Index),
+						MainChunk.GetNormal(Index),
 						Chunk.TransitionsMask,
 						Chunk.LOD) + PositionOffset;
 				}
@@ -423,6 +423,7 @@ TUniquePtr<FVoxelProcMeshBuffers> FVoxelRenderUtilities::MergeSections_AnyThread
 	}
 #endif
 
+	ProcMeshBuffers.MergeCycles = FPlatformTime::Cycles64() - StartCycles;
 	ProcMeshBuffers.UpdateStats();
 	
 	CHECK_CANCEL();
@@ -18,6 +18,22 @@ inline auto& GetVoxelTextureCacheMap()
 	return Map;
 }
 
+// The data might already be used by other threads: don't build the mips in place
+template<typename T>
+inline TVoxelSharedRef<typename TVoxelTexture<T>::FTextureData> CopyWithMips(const typename TVoxelTexture<T>::FTextureData& Data)
+{
+	VOXEL_FUNCTION_COUNTER();
+	
+	const auto NewData = MakeVoxelShared<typename TVoxelTexture<T>::FTextureData>();
+	NewData->SizeX = Data.SizeX;
+	NewData->SizeY = Data.SizeY;
+	NewData->TextureData = Data.TextureData;
+	NewData->Min = Data.Min;
+	NewData->Max = Data.Max;
+	NewData->BuildMips();
+	return NewData;
+}
+
 inline void ExtractTextureData(UTexture* Texture, int32& OutSizeX, int32& OutSizeY, TArray<FColor>& OutData)
 {
 	VOXEL_FUNCTION_COUNTER();
@@ -107,7 +123,7 @@ inline void ExtractTextureData(UTexture* Texture, int32& OutSizeX, int32& OutSiz
 	OutData.SetNum(1);
 }
 
-TVoxelTexture<FColor> FVoxelTextureUtilities::CreateFromTexture_Color(UTexture* Texture)
+TVoxelTexture<FColor> FVoxelTextureUtilities::CreateFromTexture_Color(UTexture* Texture, bool bWithMips)
 {
 	VOXEL_FUNCTION_COUNTER();
 
@@ -125,11 +141,15 @@ TVoxelTexture<FColor> FVoxelTextureUtilities::CreateFromTexture_Color(UTexture*
 		ExtractTextureData(Texture, Data->SizeX, Data->SizeY, Data->TextureData);
 		Data->UpdateAllocatedSize();
 	}
+	if (bWithMips && !Data->HasMips())
+	{
+		Data = CopyWithMips<FColor>(*Data);
+	}
 
 	return TVoxelTexture<FColor>(Data.ToSharedRef());
 }
 
-TVoxelTexture<float> FVoxelTextureUtilities::CreateFromTexture_Float(UTexture* Texture, EVoxelRGBA Channel)
+TVoxelTexture<float> FVoxelTextureUtilities::CreateFromTexture_Float(UTexture* Texture, EVoxelRGBA Channel, bool bWithMips)
 {
 	VOXEL_FUNCTION_COUNTER();
 
@@ -182,6 +202,10 @@ TVoxelTexture<float> FVoxelTextureUtilities::CreateFromTexture_Float(UTexture* T
 			Data->Max = FMath::Max(Data->Max, Value);
 		}
 	}
+	if (bWithMips && !Data->HasMips())
+	{
+		Data = CopyWithMips<float>(*Data);
+	}
 	return TVoxelTexture<float>(Data.ToSharedRef());
 }
 
@@ -3,6 +3,8 @@
 #include "VoxelTools/VoxelTextureTools.h"
 #include "VoxelTools/VoxelToolHelpers.h"
 
+#include "HAL/IConsoleManager.h"
+
 enum class EMinMax : uint8
 {
 	Min,
@@ -10,7 +12,14 @@ enum class EMinMax : uint8
 };
 
 template<EMinMax MinMax>
-FVoxelFloatTexture MinMaxImpl(const FVoxelFloatTexture& Texture, const float Radius)
+FORCEINLINE float MinMaxOp(float A, float B)
+{
+	return MinMax == EMinMax::Min ? FMath::Min(A, B) : FMath::Max(A, B);
+}
+
+// Reference implementation, used to check MinMaxImpl
+template<EMinMax MinMax>
+FVoxelFloatTexture MinMaxNaiveImpl(const FVoxelFloatTexture& Texture, const float Radius)
 {
 	VOXEL_TOOL_FUNCTION_COUNTER(Texture.Texture.GetSizeX() * Texture.Texture.GetSizeY());
 	
@@ -36,7 +45,7 @@ FVoxelFloatTexture MinMaxImpl(const FVoxelFloatTexture& Texture, const float Rad
 					if (U * U + V * V <= RadiusSquared)
 					{
 						const float OtherValue = Data.SampleRaw(X + U, Y + V, EVoxelSamplerMode::Clamp);
-						MinMaxValue = MinMax == EMinMax::Min ? FMath::Min(MinMaxValue, OtherValue) : FMath::Max(MinMaxValue, OtherValue);
+						MinMaxValue = MinMaxOp<MinMax>(MinMaxValue, OtherValue);
 					}
 				}
 			}
@@ -47,6 +56,127 @@ FVoxelFloatTexture MinMaxImpl(const FVoxelFloatTexture& Texture, const float Rad
 	return FVoxelFloatTexture{ TVoxelTexture<float>{NewTextureDataPtr} };
 }
 
+// van Herk/Gil-Werman running min/max: Out[X] = MinMax(In[X - HalfWidth], ..., In[X + HalfWidth]), clamping In
+// 3 comparisons per pixel whatever the width
+// Prefix & Suffix must have at least Num + 2 * HalfWidth elements
+template<EMinMax MinMax>
+void MinMax1D(const float* RESTRICT In, float* RESTRICT Out, const int32 Num, const int32 HalfWidth, float* RESTRICT Prefix, float* RESTRICT Suffix)
+{
+	const int32 Window = 2 * HalfWidth + 1;
+	const int32 PaddedNum = Num + 2 * HalfWidth;
+	const auto Padded = [&](int32 Index)
+	{
+		return In[FMath::Clamp(Index - HalfWidth, 0, Num - 1)];
+	};
+
+	// Running min/max from the start of each block, and from the end of each block
+	for (int32 BlockStart = 0; BlockStart < PaddedNum; BlockStart += Window)
+	{
+		const int32 BlockEnd = FMath::Min(BlockStart + Window, PaddedNum);
+		
+		Prefix[BlockStart] = Padded(BlockStart);
+		for (int32 Index = BlockStart + 1; Index < BlockEnd; Index++)
+		{
+			Prefix[Index] = MinMaxOp<MinMax>(Prefix[Index - 1], Padded(Index));
+		}
+		
+		Suffix[BlockEnd - 1] = Padded(BlockEnd - 1);
+		for (int32 Index = BlockEnd - 2; Index >= BlockStart; Index--)
+		{
+			Suffix[Index] = MinMaxOp<MinMax>(Suffix[Index + 1], Padded(Index));
+		}
+	}
+
+	// Any window spans at most two blocks: the end of the first one & the start of the second one
+	for (int32 Index = 0; Index < Num; Index++)
+	{
+		Out[Index] = MinMaxOp<MinMax>(Suffix[Index], Prefix[Index + Window - 1]);
+	}
+}
+
+// The disk is split into rows: each row is a 1D min/max of a given half width, computed once for the whole texture
+// and then combined vertically. O(Radius) per pixel instead of O(Radius^2), with the exact same result as MinMaxNaiveImpl
+template<EMinMax MinMax>
+FVoxelFloatTexture MinMaxImpl(const FVoxelFloatTexture& Texture, const float Radius)
+{
+	VOXEL_TOOL_FUNCTION_COUNTER(Texture.Texture.GetSizeX() * Texture.Texture.GetSizeY());
+	
+	auto& Data = Texture.Texture;
+	const int32 SizeX = Data.GetSizeX();
+	const int32 SizeY = Data.GetSizeY();
+	const float* RESTRICT const Source = Data.GetTextureData().GetData();
+	
+	const auto NewTextureDataPtr = MakeVoxelShared<TVoxelTexture<float>::FTextureData>();
+	auto& NewTextureData = *NewTextureDataPtr;
+	NewTextureData.SetSize(SizeX, SizeY);
+	
+	const int32 CeilRadius = FMath::CeilToInt(Radius);
+	const int32 RadiusSquared = FMath::CeilToInt(FMath::Square(Radius));
+
+	// Half width of the disk for each row offset V, -1 if the row is empty
+	TArray<int32, TInlineAllocator<64>> HalfWidths;
+	TArray<int32, TInlineAllocator<64>> UniqueHalfWidths;
+	for (int32 V = -CeilRadius; V <= CeilRadius; V++)
+	{
+		int32 HalfWidth = -1;
+		while (HalfWidth < CeilRadius && FMath::Square(HalfWidth + 1) + V * V <= RadiusSquared)
+		{
+			HalfWidth++;
+		}
+		HalfWidths.Add(HalfWidth);
+		if (HalfWidth >= 0)
+		{
+			UniqueHalfWidths.AddUnique(HalfWidth);
+		}
+	}
+
+	TArray<float> Accumulator;
+	Accumulator.Init(MinMax == EMinMax::Min ? MAX_flt : -MAX_flt, SizeX * SizeY);
+
+	TArray<float> Horizontal;
+	Horizontal.SetNumUninitialized(SizeX * SizeY);
+	
+	TArray<float> Prefix;
+	TArray<float> Suffix;
+	Prefix.SetNumUninitialized(SizeX + 2 * FMath::Max(CeilRadius, 0));
+	Suffix.SetNumUninitialized(SizeX + 2 * FMath::Max(CeilRadius, 0));
+	
+	for (const int32 HalfWidth : UniqueHalfWidths)
+	{
+		for (int32 Y = 0; Y < SizeY; Y++)
+		{
+			MinMax1D<MinMax>(Source + SizeX * Y, Horizontal.GetData() + SizeX * Y, SizeX, HalfWidth, Prefix.GetData(), Suffix.GetData());
+		}
+		
+		for (int32 V = -CeilRadius; V <= CeilRadius; V++)
+		{
+			if (HalfWidths[V + CeilRadius] != HalfWidth)
+			{
+				continue;
+			}
+			for (int32 Y = 0; Y < SizeY; Y++)
+			{
+				const float* RESTRICT const Row = Horizontal.GetData() + SizeX * FMath::Clamp(Y + V, 0, SizeY - 1);
+				float* RESTRICT const AccumulatorRow = Accumulator.GetData() + SizeX * Y;
+				for (int32 X = 0; X < SizeX; X++)
+				{
+					AccumulatorRow[X] = MinMaxOp<MinMax>(AccumulatorRow[X], Row[X]);
+				}
+			}
+		}
+	}
+
+	for (int32 Y = 0; Y < SizeY; Y++)
+	{
+		for (int32 X = 0; X < SizeX; X++)
+		{
+			NewTextureData.SetValue(X, Y, Accumulator[X + SizeX * Y]);
+		}
+	}
+
+	return FVoxelFloatTexture{ TVoxelTexture<float>{NewTextureDataPtr} };
+}
+
 FVoxelFloatTexture UVoxelTextureTools::Minimum(FVoxelFloatTexture Texture, float Radius)
 {
 	VOXEL_FUNCTION_COUNTER();
@@ -57,4 +187,52 @@ FVoxelFloatTexture UVoxelTextureTools::Maximum(FVoxelFloatTexture Texture, float
 {
 	VOXEL_FUNCTION_COUNTER();
 	return MinMaxImpl<EMinMax::Max>(Texture, Radius);
-}
\ No newline at end of file
+}
+
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+
+static void BenchmarkTextureMinMax(const TArray<FString>& Args)
+{
+	const int32 Size = Args.Num() > 0 ? FMath::Max(1, FCString::Atoi(*Args[0])) : 4096;
+	const float Radius = Args.Num() > 1 ? FMath::Max(0.f, FCString::Atof(*Args[1])) : 8.f;
+	
+	UE_LOG(LogVoxel, Log, TEXT("Benchmarking texture Minimum: %dx%d, radius %f"), Size, Size, Radius);
+
+	const auto DataPtr = MakeVoxelShared<TVoxelTexture<float>::FTextureData>();
+	DataPtr->SetSize(Size, Size);
+	FRandomStream Stream(1337);
+	for (int32 Y = 0; Y < Size; Y++)
+	{
+		for (int32 X = 0; X < Size; X++)
+		{
+			DataPtr->SetValue(X, Y, FMath::Sin(X * 0.01f) * FMath::Cos(Y * 0.013f) + Stream.FRandRange(-0.1f, 0.1f));
+		}
+	}
+	const FVoxelFloatTexture Texture{ TVoxelTexture<float>{DataPtr} };
+
+	const double FastStartTime = FPlatformTime::Seconds();
+	const FVoxelFloatTexture FastResult = MinMaxImpl<EMinMax::Min>(Texture, Radius);
+	const double FastTime = FPlatformTime::Seconds() - FastStartTime;
+
+	const double NaiveStartTime = FPlatformTime::Seconds();
+	const FVoxelFloatTexture NaiveResult = MinMaxNaiveImpl<EMinMax::Min>(Texture, Radius);
+	const double NaiveTime = FPlatformTime::Seconds() - NaiveStartTime;
+
+	int32 NumErrors = 0;
+	for (int32 Index = 0; Index < Size * Size; Index++)
+	{
+		NumErrors += FastResult.Texture.GetTextureData()[Index] != NaiveResult.Texture.GetTextureData()[Index];
+	}
+	ensure(NumErrors == 0);
+
+	UE_LOG(LogVoxel, Log, TEXT("van Herk/Gil-Werman: %fs"), FastTime);
+	UE_LOG(LogVoxel, Log, TEXT("Naive: %fs"), NaiveTime);
+	UE_LOG(LogVoxel, Log, TEXT("Speedup: %fx; %d mismatching pixels"), NaiveTime / FMath::Max(FastTime, SMALL_NUMBER), NumErrors);
+}
+
+static FAutoConsoleCommand BenchmarkTextureMinMaxCmd(
+	TEXT("voxel.texture.BenchmarkMinMax"),
+	TEXT("Benchmark the texture Minimum/Maximum filters against the naive implementation. Args: Size (default 4096), Radius (default 8)"),
+	FConsoleCommandWithArgsDelegate::CreateStatic(&BenchmarkTextureMinMax));
\ No newline at end of file
@@ -2,6 +2,7 @@
 
 #include "VoxelWorldGenerator.h"
 #include "VoxelWorldGeneratorInstance.h"
+#include "VoxelWorldGeneratorInstance.inl"
 #include "VoxelMessages.h"
 
 TMap<FName, int32> UVoxelWorldGenerator::GetDefaultSeeds() const
@@ -38,4 +39,49 @@ TVoxelSharedRef<FVoxelTransformableWorldGeneratorInstance> UVoxelTransformableWo
 TVoxelSharedRef<FVoxelWorldGeneratorInstance> UVoxelTransformableWorldGenerator::GetInstance()
 {
 	return GetTransformableInstance();
+}
+
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+
+void FVoxelWorldGeneratorInstance::GetValues(TArrayView<const FVector> Positions, int32 LOD, const FVoxelItemStack& Items, TArrayView<v_flt> OutValues) const
+{
+	VOXEL_FUNCTION_COUNTER();
+	check(Positions.Num() == OutValues.Num());
+
+	for (int32 Index = 0; Index < Positions.Num(); Index++)
+	{
+		const FVector& Position = Positions[Index];
+		OutValues[Index] = GetValue(Position.X, Position.Y, Position.Z, LOD, Items);
+	}
+}
+
+template<typename T>
+inline void GetCustomOutputsPerPosition(
+	const FVoxelWorldGeneratorInstance& Instance,
+	FVoxelWorldGeneratorInstance::TOutputFunctionPtr<T> Ptr,
+	TArrayView<const FVector> Positions,
+	int32 LOD,
+	const FVoxelItemStack& Items,
+	TArrayView<T> OutValues)
+{
+	VOXEL_FUNCTION_COUNTER();
+	check(Positions.Num() == OutValues.Num());
+
+	for (int32 Index = 0; Index < Positions.Num(); Index++)
+	{
+		const FVector& Position = Positions[Index];
+		OutValues[Index] = (Instance.*Ptr)(Position.X, Position.Y, Position.Z, LOD, Items);
+	}
+}
+
+void FVoxelWorldGeneratorInstance::GetCustomOutputsImpl(TOutputFunctionPtr<v_flt> Ptr, TArrayView<const FVector> Positions, int32 LOD, const FVoxelItemStack& Items, TArrayView<v_flt> OutValues) const
+{
+	GetCustomOutputsPerPosition(*this, Ptr, Positions, LOD, Items, OutValues);
+}
+
+void FVoxelWorldGeneratorInstance::GetCustomOutputsImpl(TOutputFunctionPtr<int32> Ptr, TArrayView<const FVector> Positions, int32 LOD, const FVoxelItemStack& Items, TArrayView<int32> OutValues) const
+{
+	GetCustomOutputsPerPosition(*this, Ptr, Positions, LOD, Items, OutValues);
 }
\ No newline at end of file
@@ -0,0 +1,287 @@
+// Copyright 2020 Phyronnaz
+
+#include "VoxelWorldGeneratorBakeCache.h"
+#include "VoxelWorldGenerator.h"
+#include "VoxelWorldGeneratorInit.h"
+#include "VoxelSerializationUtilities.h"
+#include "VoxelGlobals.h"
+
+#include "HAL/FileManager.h"
+#include "HAL/IConsoleManager.h"
+#include "HAL/PlatformFilemanager.h"
+#include "HAL/PlatformProcess.h"
+#include "HAL/PlatformTLS.h"
+#include "HAL/ThreadSafeCounter64.h"
+#include "Async/Async.h"
+#include "Misc/FileHelper.h"
+#include "Misc/PackageName.h"
+#include "Misc/Paths.h"
+#include "Modules/ModuleManager.h"
+#include "UObject/UnrealType.h"
+
+// Increase to invalidate all the existing caches
+#define VOXEL_BAKE_CACHE_VERSION 2
+
+static TAutoConsoleVariable<int32> CVarBakeCacheMaxSizeMB(
+	TEXT("voxel.generator.BakeCacheMaxSizeMB"),
+	1024,
+	TEXT("Max size of Saved/VoxelBakeCache, shared by all the world generators. The least recently used files are deleted first"),
+	ECVF_Default);
+
+static TAutoConsoleVariable<int32> CVarBakeCacheMaxPendingSaves(
+	TEXT("voxel.generator.BakeCacheMaxPendingSaves"),
+	64,
+	TEXT("Max number of bake cache files waiting to be written. Values computed while the queue is full are not baked"),
+	ECVF_Default);
+
+static int64 GetBakeCacheMaxSize()
+{
+	return int64(FMath::Max(CVarBakeCacheMaxSizeMB.GetValueOnAnyThread(), 0)) << 20;
+}
+
+// Bytes written since the last trim, to trim every time an eighth of the max size is written
+static FThreadSafeCounter64 BytesWrittenSinceTrim;
+static FThreadSafeCounter IsTrimming;
+
+static void ClearBakeCache()
+{
+	const FString RootDirectory = FVoxelWorldGeneratorBakeCache::GetRootDirectory();
+	if (IFileManager::Get().DeleteDirectory(*RootDirectory, false, true))
+	{
+		UE_LOG(LogVoxel, Log, TEXT("Cleared world generator bake cache in %s"), *RootDirectory);
+	}
+	else
+	{
+		UE_LOG(LogVoxel, Warning, TEXT("Failed to clear world generator bake cache in %s"), *RootDirectory);
+	}
+}
+
+static FAutoConsoleCommand ClearBakeCacheCmd(
+	TEXT("voxel.generator.ClearBakeCache"),
+	TEXT("Delete all the baked world generator values. Needed if an asset used by a baked world generator changed"),
+	FConsoleCommandDelegate::CreateStatic(&ClearBakeCache));
+
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+
+// Generated graphs keep the same class & properties when their C++ is regenerated: the binary containing the code is part of the hash
+static FString GetCodeVersion(const UClass* Class)
+{
+	// Blueprints: use the code of their native parent
+	while (Class && !Class->HasAnyClassFlags(CLASS_Native))
+	{
+		Class = Class->GetSuperClass();
+	}
+
+	FString BinaryPath;
+	if (Class)
+	{
+		const FName ModuleName = FPackageName::GetShortFName(Class->GetOutermost()->GetFName());
+		FModuleStatus ModuleStatus;
+		if (FModuleManager::Get().QueryModule(ModuleName, ModuleStatus))
+		{
+			BinaryPath = ModuleStatus.FilePath;
+		}
+	}
+
+	FFileStatData StatData = IFileManager::Get().GetStatData(*BinaryPath);
+	if (!StatData.bIsValid || StatData.bIsDirectory)
+	{
+		// Monolithic builds
+		BinaryPath = FPlatformProcess::ExecutablePath();
+		StatData = IFileManager::Get().GetStatData(*BinaryPath);
+	}
+
+	return FString::Printf(TEXT("%s;%lld;%s"), *FPaths::GetCleanFilename(BinaryPath), StatData.FileSize, *StatData.ModificationTime.ToString());
+}
+
+FVoxelWorldGeneratorBakeCache::FVoxelWorldGeneratorBakeCache(const FString& Directory)
+	: Directory(Directory)
+{
+}
+
+TVoxelSharedRef<FVoxelWorldGeneratorBakeCache> FVoxelWorldGeneratorBakeCache::Create(const UVoxelWorldGenerator& WorldGenerator, const FVoxelWorldGeneratorInit& InitStruct)
+{
+	VOXEL_FUNCTION_COUNTER();
+	
+	// Hash everything that can change the generated values
+	FString HashString = FString::Printf(
+		TEXT("%d;%s;%s;%u;"),
+		VOXEL_BAKE_CACHE_VERSION,
+		*WorldGenerator.GetClass()->GetPathName(),
+		*GetCodeVersion(WorldGenerator.GetClass()),
+		InitStruct.WorldSize);
+
+	TArray<FName> SeedNames;
+	InitStruct.Seeds.GetKeys(SeedNames);
+	SeedNames.Sort([](FName A, FName B) { return A.LexicalLess(B); });
+	for (FName SeedName : SeedNames)
+	{
+		HashString += FString::Printf(TEXT("%s=%d;"), *SeedName.ToString(), InitStruct.Seeds[SeedName]);
+	}
+
+	for (TFieldIterator<UProperty> It(WorldGenerator.GetClass()); It; ++It)
+	{
+		if (It->HasAnyPropertyFlags(CPF_Transient))
+		{
+			continue;
+		}
+		FString Value;
+		It->ExportTextItem(Value, It->ContainerPtrToValuePtr<void>(&WorldGenerator), nullptr, nullptr, PPF_None);
+		HashString += It->GetName() + TEXT("=") + Value + TEXT(";");
+	}
+
+	const uint32 Hash = FCrc::StrCrc32(*HashString);
+	const FString Directory = GetRootDirectory() / FString::Printf(TEXT("%s_%08x"), *WorldGenerator.GetClass()->GetName(), Hash);
+	
+	UE_LOG(LogVoxel, Log, TEXT("World generator bake cache: %s"), *Directory);
+
+	// Previous sessions might have left the cache above its max size
+	AsyncTask(ENamedThreads::AnyBackgroundThreadNormalTask, []() { Trim(); });
+
+	return MakeVoxelShared<FVoxelWorldGeneratorBakeCache>(Directory);
+}
+
+FString FVoxelWorldGeneratorBakeCache::GetRootDirectory()
+{
+	return FPaths::ProjectSavedDir() / TEXT("VoxelBakeCache");
+}
+
+void FVoxelWorldGeneratorBakeCache::Trim()
+{
+	VOXEL_FUNCTION_COUNTER();
+
+	// Concurrent trims would try to delete the same files
+	if (IsTrimming.Set(1) != 0)
+	{
+		return;
+	}
+	BytesWrittenSinceTrim.Reset();
+
+	struct FFile
+	{
+		FString Filename;
+		FDateTime LastUseTime;
+		int64 Size;
+	};
+	TArray<FFile> Files;
+	int64 TotalSize = 0;
+
+	IPlatformFile& PlatformFile = FPlatformFileManager::Get().GetPlatformFile();
+	PlatformFile.IterateDirectoryStatRecursively(*GetRootDirectory(), [&](const TCHAR* Filename, const FFileStatData& StatData)
+	{
+		if (!StatData.bIsDirectory)
+		{
+			Files.Add({ Filename, StatData.ModificationTime, StatData.FileSize });
+			TotalSize += StatData.FileSize;
+		}
+		return true;
+	});
+
+	const int64 MaxSize = GetBakeCacheMaxSize();
+	if (TotalSize > MaxSize)
+	{
+		// LoadValues updates the modification time of the files it reads
+		Files.Sort([](const FFile& A, const FFile& B) { return A.LastUseTime < B.LastUseTime; });
+
+		int32 NumDeleted = 0;
+		for (const FFile& File : Files)
+		{
+			if (TotalSize <= MaxSize)
+			{
+				break;
+			}
+			if (PlatformFile.DeleteFile(*File.Filename))
+			{
+				TotalSize -= File.Size;
+				NumDeleted++;
+			}
+		}
+
+		UE_LOG(LogVoxel, Log, TEXT("Trimmed world generator bake cache: deleted %d files, %lldMB left"), NumDeleted, TotalSize >> 20);
+	}
+
+	IsTrimming.Set(0);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+
+bool FVoxelWorldGeneratorBakeCache::LoadValues(const FIntBox& Bounds, int32 LOD, TArrayView<FVoxelValue> OutValues) const
+{
+	VOXEL_FUNCTION_COUNTER();
+	
+	const FString Filename = GetFilename(Bounds, LOD);
+	
+	TArray<uint8> CompressedData;
+	if (!FFileHelper::LoadFileToArray(CompressedData, *Filename, FILEREAD_Silent))
+	{
+		return false;
+	}
+
+	TArray<uint8> UncompressedData;
+	if (!FVoxelSerializationUtilities::DecompressData(CompressedData, UncompressedData) ||
+		UncompressedData.Num() != OutValues.Num() * sizeof(FVoxelValue))
+	{
+		UE_LOG(LogVoxel, Warning, TEXT("Invalid baked world generator file %s"), *Filename);
+		return false;
+	}
+
+	FMemory::Memcpy(OutValues.GetData(), UncompressedData.GetData(), UncompressedData.Num());
+
+	// Trim deletes the least recently used files first
+	IFileManager::Get().SetTimeStamp(*Filename, FDateTime::UtcNow());
+	
+	return true;
+}
+
+void FVoxelWorldGeneratorBakeCache::SaveValuesAsync(const FIntBox& Bounds, int32 LOD, TArray<FVoxelValue>&& Values) const
+{
+	if (NumPendingSaves.GetValue() >= CVarBakeCacheMaxPendingSaves.GetValueOnAnyThread())
+	{
+		// Will be baked the next time they are computed
+		return;
+	}
+	
+	NumPendingSaves.Increment();
+	AsyncTask(ENamedThreads::AnyBackgroundThreadNormalTask, [This = AsShared(), Bounds, LOD, Values = MoveTemp(Values)]()
+	{
+		This->SaveValues(Bounds, LOD, Values);
+		This->NumPendingSaves.Decrement();
+	});
+}
+
+void FVoxelWorldGeneratorBakeCache::SaveValues(const FIntBox& Bounds, int32 LOD, const TArray<FVoxelValue>& Values) const
+{
+	VOXEL_FUNCTION_COUNTER();
+	
+	TArray<uint8> CompressedData;
+	FVoxelSerializationUtilities::CompressData(reinterpret_cast<const uint8*>(Values.GetData()), Values.Num() * sizeof(FVoxelValue), CompressedData);
+
+	// Write to a temporary file first so that other threads/processes never read a partial file
+	const FString Filename = GetFilename(Bounds, LOD);
+	const FString TempFilename = Filename + FString::Printf(TEXT(".%u.tmp"), FPlatformTLS::GetCurrentThreadId());
+	if (!FFileHelper::SaveArrayToFile(CompressedData, *TempFilename) ||
+		!IFileManager::Get().Move(*Filename, *TempFilename, true, true, false, true))
+	{
+		UE_LOG(LogVoxel, Warning, TEXT("Failed to save baked world generator file %s"), *Filename);
+		IFileManager::Get().Delete(*TempFilename, false, false, true);
+		return;
+	}
+
+	if (BytesWrittenSinceTrim.Add(CompressedData.Num()) + CompressedData.Num() > GetBakeCacheMaxSize() / 8)
+	{
+		Trim();
+	}
+}
+
+FString FVoxelWorldGeneratorBakeCache::GetFilename(const FIntBox& Bounds, int32 LOD) const
+{
+	return Directory / FString::Printf(
+		TEXT("%d_%d_%d_%d_%d_%d_LOD%d.bin"),
+		Bounds.Min.X, Bounds.Min.Y, Bounds.Min.Z,
+		Bounds.Max.X, Bounds.Max.Y, Bounds.Max.Z,
+		LOD);
+}
\ No newline at end of file
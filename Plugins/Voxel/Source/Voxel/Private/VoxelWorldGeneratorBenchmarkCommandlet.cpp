@@ -0,0 +1,209 @@
+// Copyright 2020 Phyronnaz
+
+#include "VoxelWorldGeneratorBenchmarkCommandlet.h"
+#include "VoxelWorldGenerator.h"
+#include "VoxelWorldGeneratorInstance.inl"
+#include "VoxelGlobals.h"
+
+#include "UObject/UObjectIterator.h"
+#include "UObject/Package.h"
+#include "HAL/PlatformMemory.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+
+struct FVoxelWorldGeneratorBenchmark
+{
+	const FString Name;
+	const FVoxelWorldGeneratorInstance& Instance;
+	const int32 Size;
+	const int32 NumRuns;
+	TArray<FString>& Rows;
+
+	static constexpr int32 NumChunks = 8;
+	
+	static FString GetHeader()
+	{
+		return TEXT("Generator,Test,Output,LOD,Size,Count,Seconds,CountPerSecond,MemoryBytes");
+	}
+	void AddRow(const TCHAR* Test, const FString& Output, int32 LOD, int64 Count, double Seconds, int64 MemoryBytes) const
+	{
+		const FString Row = FString::Printf(TEXT("%s,%s,%s,%d,%d,%lld,%f,%f,%lld"),
+			*Name,
+			Test,
+			*Output,
+			LOD,
+			Size,
+			Count,
+			Seconds,
+			Seconds > 0 ? Count / Seconds : 0.,
+			MemoryBytes);
+		UE_LOG(LogVoxel, Display, TEXT("%s"), *Row);
+		Rows.Add(Row);
+	}
+
+	// 2x2x2 chunks around the origin. Run shifts them along X, to avoid hitting the generator caches
+	FIntBox GetChunkBounds(int32 ChunkIndex, int32 LOD, int32 Run) const
+	{
+		const int32 ChunkSize = Size << LOD;
+		const FIntVector Min =
+			FIntVector(-ChunkSize) +
+			FIntVector(
+				bool(ChunkIndex & 0x1) + 2 * Run,
+				bool(ChunkIndex & 0x2),
+				bool(ChunkIndex & 0x4)) * ChunkSize;
+		return FIntBox(Min, Min + FIntVector(ChunkSize));
+	}
+
+	template<typename T>
+	void BenchmarkQueryZones(const TCHAR* Test, int32 LOD) const
+	{
+		TArray<T> Data;
+		Data.SetNumUninitialized(Size * Size * Size);
+
+		const double StartTime = FPlatformTime::Seconds();
+		for (int32 Run = 0; Run < NumRuns; Run++)
+		{
+			for (int32 ChunkIndex = 0; ChunkIndex < NumChunks; ChunkIndex++)
+			{
+				TVoxelQueryZone<T> QueryZone(GetChunkBounds(ChunkIndex, LOD, Run), FIntVector(Size), LOD, Data);
+				Instance.Get<T>(QueryZone, LOD, FVoxelItemStack::Empty);
+			}
+		}
+		const double Time = FPlatformTime::Seconds() - StartTime;
+
+		AddRow(Test, {}, LOD, int64(NumRuns) * NumChunks * Data.Num(), Time, Data.GetAllocatedSize());
+	}
+
+	void BenchmarkValueRange(int32 LOD) const
+	{
+		const double StartTime = FPlatformTime::Seconds();
+		for (int32 Run = 0; Run < NumRuns; Run++)
+		{
+			for (int32 ChunkIndex = 0; ChunkIndex < NumChunks; ChunkIndex++)
+			{
+				Instance.GetValueRange(GetChunkBounds(ChunkIndex, LOD, Run), LOD, FVoxelItemStack::Empty);
+			}
+		}
+		const double Time = FPlatformTime::Seconds() - StartTime;
+
+		AddRow(TEXT("ValueRange"), {}, LOD, NumRuns * NumChunks, Time, 0);
+	}
+
+	void BenchmarkCustomOutputs(int32 LOD) const
+	{
+		TArray<FVector> Positions;
+		Positions.Reserve(Size * Size * Size);
+		TArray<v_flt> Values;
+		Values.SetNumUninitialized(Size * Size * Size);
+
+		for (auto& It : Instance.FloatOutputsPtr)
+		{
+			const auto Handle = Instance.GetCustomOutputHandle<v_flt>(It.Key);
+
+			const double StartTime = FPlatformTime::Seconds();
+			for (int32 Run = 0; Run < NumRuns; Run++)
+			{
+				for (int32 ChunkIndex = 0; ChunkIndex < NumChunks; ChunkIndex++)
+				{
+					const FIntBox Bounds = GetChunkBounds(ChunkIndex, LOD, Run);
+					Positions.Reset();
+					for (int32 X = Bounds.Min.X; X < Bounds.Max.X; X += 1 << LOD)
+					{
+						for (int32 Y = Bounds.Min.Y; Y < Bounds.Max.Y; Y += 1 << LOD)
+						{
+							for (int32 Z = Bounds.Min.Z; Z < Bounds.Max.Z; Z += 1 << LOD)
+							{
+								Positions.Emplace(X, Y, Z);
+							}
+						}
+					}
+					Instance.GetCustomOutputs<v_flt>(Handle, 0, Positions, LOD, FVoxelItemStack::Empty, Values);
+				}
+			}
+			const double Time = FPlatformTime::Seconds() - StartTime;
+
+			AddRow(TEXT("CustomOutput"), It.Key.ToString(), LOD, int64(NumRuns) * NumChunks * Values.Num(), Time, Values.GetAllocatedSize());
+		}
+	}
+};
+
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+
+UVoxelWorldGeneratorBenchmarkCommandlet::UVoxelWorldGeneratorBenchmarkCommandlet()
+{
+	IsClient = false;
+	IsServer = false;
+	IsEditor = true;
+	LogToConsole = true;
+}
+
+int32 UVoxelWorldGeneratorBenchmarkCommandlet::Main(const FString& Params)
+{
+	FString OutputPath = FPaths::ProjectSavedDir() / TEXT("VoxelBenchmark") / TEXT("WorldGenerators.csv");
+	int32 Size = 32;
+	int32 NumRuns = 3;
+	FString Filter;
+	FParse::Value(*Params, TEXT("Output="), OutputPath);
+	FParse::Value(*Params, TEXT("Size="), Size);
+	FParse::Value(*Params, TEXT("NumRuns="), NumRuns);
+	FParse::Value(*Params, TEXT("Filter="), Filter);
+	Size = FMath::Clamp(Size, 1, 256);
+	NumRuns = FMath::Max(NumRuns, 1);
+
+	// Only the generators that can be picked in a voxel world: asset generators (heightmaps, data assets, graphs) are hidden & need their data
+	TArray<UClass*> Classes;
+	for (TObjectIterator<UClass> It; It; ++It)
+	{
+		UClass* Class = *It;
+		if (Class->IsChildOf(UVoxelWorldGenerator::StaticClass()) &&
+			!Class->HasAnyClassFlags(CLASS_Abstract | CLASS_Deprecated | CLASS_NewerVersionExists | CLASS_HideDropDown) &&
+			!Class->GetName().StartsWith(TEXT("SKEL_")) &&
+			!Class->GetName().StartsWith(TEXT("REINST_")) &&
+			(Filter.IsEmpty() || Class->GetName().Contains(Filter)))
+		{
+			Classes.Add(Class);
+		}
+	}
+	// Stable order, to be able to diff the results
+	Classes.Sort([](const UClass& A, const UClass& B) { return A.GetName() < B.GetName(); });
+
+	UE_LOG(LogVoxel, Display, TEXT("Benchmarking %d world generators: Size = %d, NumRuns = %d"), Classes.Num(), Size, NumRuns);
+
+	TArray<FString> Rows;
+	Rows.Add(FVoxelWorldGeneratorBenchmark::GetHeader());
+	
+	for (UClass* Class : Classes)
+	{
+		UVoxelWorldGenerator* Generator = NewObject<UVoxelWorldGenerator>(GetTransientPackage(), Class);
+
+		// Process wide, so only approximate
+		const int64 MemoryBefore = FPlatformMemory::GetStats().UsedPhysical;
+		const double InitStartTime = FPlatformTime::Seconds();
+		const TVoxelSharedRef<FVoxelWorldGeneratorInstance> Instance = Generator->GetInstance();
+		Instance->Init(FVoxelWorldGeneratorInit());
+		const double InitTime = FPlatformTime::Seconds() - InitStartTime;
+		const int64 InstanceMemory = int64(FPlatformMemory::GetStats().UsedPhysical) - MemoryBefore;
+
+		const FVoxelWorldGeneratorBenchmark Benchmark{ Class->GetName(), *Instance, Size, NumRuns, Rows };
+		Benchmark.AddRow(TEXT("Init"), {}, 0, 1, InitTime, InstanceMemory);
+
+		for (int32 LOD : { 0, 2, 4 })
+		{
+			Benchmark.BenchmarkQueryZones<FVoxelValue>(TEXT("Values"), LOD);
+			Benchmark.BenchmarkQueryZones<FVoxelMaterial>(TEXT("Materials"), LOD);
+			Benchmark.BenchmarkValueRange(LOD);
+			Benchmark.BenchmarkCustomOutputs(LOD);
+		}
+	}
+
+	if (!FFileHelper::SaveStringToFile(FString::Join(Rows, TEXT("\n")), *OutputPath))
+	{
+		UE_LOG(LogVoxel, Error, TEXT("Failed to write %s"), *OutputPath);
+		return 1;
+	}
+	UE_LOG(LogVoxel, Display, TEXT("Results written to %s"), *OutputPath);
+
+	return 0;
+}
\ No newline at end of file
@@ -0,0 +1,666 @@
+// Copyright 2020 Phyronnaz
+
+#include "VoxelWorldGeneratorBlender.h"
+#include "VoxelWorldGeneratorInstance.inl"
+#include "VoxelWorldGeneratorHelpers.h"
+#include "VoxelWorldGenerators/VoxelFlatWorldGenerator.h"
+
+#include "HAL/IConsoleManager.h"
+
+TVoxelSharedRef<FVoxelWorldGeneratorInstance> UVoxelWorldGeneratorBlender::GetInstance()
+{
+	TArray<FVoxelWorldGeneratorBlender::FLayer> LayerInstances;
+	for (auto& Layer : Layers)
+	{
+		LayerInstances.Add({ Layer.Generator.GetInstance(false), Layer.WeightName });
+	}
+	return MakeVoxelShared<FVoxelWorldGeneratorBlender>(WeightsGenerator.GetInstance(false), LayerInstances, TileSize);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+
+FVoxelWorldGeneratorBlender::FVoxelWorldGeneratorBlender(const TVoxelSharedRef<FVoxelWorldGeneratorInstance>& WeightsGenerator, const TArray<FLayer>& Layers, int32 TileSize)
+	: FVoxelWorldGeneratorInstance(
+		WeightsGenerator->Class,
+		static_cast<TOutputFunctionPtr<v_flt>>(&FVoxelWorldGeneratorBlender::GetValueImpl),
+		static_cast<TOutputFunctionPtr<FVoxelMaterial>>(&FVoxelWorldGeneratorBlender::GetMaterialImpl),
+		static_cast<TRangeOutputFunctionPtr<v_flt>>(&FVoxelWorldGeneratorBlender::GetValueRangeImpl),
+		{},
+		{},
+		{})
+	, WeightsGenerator(WeightsGenerator)
+	, Layers(Layers)
+	, TileSize(FMath::Max(1, TileSize))
+{
+	for (auto& Layer : Layers)
+	{
+		check(Layer.Generator.IsValid());
+		WeightHandles.Add(WeightsGenerator->GetCustomOutputHandle<v_flt>(Layer.WeightName));
+	}
+}
+
+void FVoxelWorldGeneratorBlender::Init(const FVoxelWorldGeneratorInit& InitStruct)
+{
+	VOXEL_FUNCTION_COUNTER();
+
+	WeightsGenerator->Init(InitStruct);
+	for (auto& Layer : Layers)
+	{
+		Layer.Generator->Init(InitStruct);
+	}
+}
+
+void FVoxelWorldGeneratorBlender::InitArea(const FIntBox& Bounds, int32 LOD)
+{
+	WeightsGenerator->InitArea(Bounds, LOD);
+	for (auto& Layer : Layers)
+	{
+		Layer.Generator->InitArea(Bounds, LOD);
+	}
+}
+
+FVector FVoxelWorldGeneratorBlender::GetUpVector(v_flt X, v_flt Y, v_flt Z) const
+{
+	return WeightsGenerator->GetUpVector(X, Y, Z);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+
+v_flt FVoxelWorldGeneratorBlender::GetValueImpl(v_flt X, v_flt Y, v_flt Z, int32 LOD, const FVoxelItemStack& Items) const
+{
+	v_flt WeightsSum = 0;
+	v_flt Value = 0;
+	for (int32 LayerIndex = 0; LayerIndex < Layers.Num(); LayerIndex++)
+	{
+		const v_flt Weight = FMath::Max<v_flt>(0, WeightsGenerator->GetCustomOutput<v_flt>(WeightHandles[LayerIndex], 0, X, Y, Z, LOD, Items));
+		if (Weight > 0)
+		{
+			WeightsSum += Weight;
+			Value += Weight * Layers[LayerIndex].Generator->GetValue(X, Y, Z, LOD, Items);
+		}
+	}
+	return WeightsSum > 0 ? Value / WeightsSum : FVoxelValue::Empty().ToFloat();
+}
+
+FVoxelMaterial FVoxelWorldGeneratorBlender::GetMaterialImpl(v_flt X, v_flt Y, v_flt Z, int32 LOD, const FVoxelItemStack& Items) const
+{
+	int32 BestLayer = -1;
+	v_flt BestWeight = 0;
+	for (int32 LayerIndex = 0; LayerIndex < Layers.Num(); LayerIndex++)
+	{
+		const v_flt Weight = WeightsGenerator->GetCustomOutput<v_flt>(WeightHandles[LayerIndex], 0, X, Y, Z, LOD, Items);
+		if (Weight > BestWeight)
+		{
+			BestLayer = LayerIndex;
+			BestWeight = Weight;
+		}
+	}
+	return BestLayer == -1 ? FVoxelMaterial::Default() : Layers[BestLayer].Generator->GetMaterial(X, Y, Z, LOD, Items);
+}
+
+TVoxelRange<v_flt> FVoxelWorldGeneratorBlender::GetValueRangeImpl(const FIntBox& Bounds, int32 LOD, const FVoxelItemStack& Items) const
+{
+	FLayerIndices ActiveLayers;
+	bool bCanBeAllZero;
+	GetActiveLayers(Bounds, LOD, Items, ActiveLayers, bCanBeAllZero);
+
+	// The result is a convex combination of the active layers values
+	TOptional<TVoxelRange<v_flt>> Range;
+	if (bCanBeAllZero)
+	{
+		Range = TVoxelRange<v_flt>(FVoxelValue::Empty().ToFloat());
+	}
+	for (const int32 LayerIndex : ActiveLayers)
+	{
+		const TVoxelRange<v_flt> LayerRange = Layers[LayerIndex].Generator->GetValueRange(Bounds, LOD, Items);
+		Range = Range.IsSet() ? TVoxelRange<v_flt>::Union(Range.GetValue(), LayerRange) : LayerRange;
+	}
+	return Range.GetValue();
+}
+
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+
+void FVoxelWorldGeneratorBlender::GetActiveLayers(const FIntBox& Bounds, int32 LOD, const FVoxelItemStack& Items, FLayerIndices& OutLayers, bool& bCanBeAllZero) const
+{
+	bCanBeAllZero = true;
+	for (int32 Index = 0; Index < Layers.Num(); Index++)
+	{
+		if (!WeightHandles[Index].IsValid())
+		{
+			continue;
+		}
+
+		// If the weight has no range analysis, assume it can be anything
+		const TVoxelRange<v_flt> WeightRange = WeightsGenerator->GetCustomOutputRange<v_flt>(TVoxelRange<v_flt>::Infinite(), Layers[Index].WeightName, Bounds, LOD, Items);
+		if (WeightRange.Max > 0)
+		{
+			OutLayers.Add(Index);
+		}
+		if (WeightRange.Min > 0)
+		{
+			bCanBeAllZero = false;
+		}
+	}
+}
+
+void FVoxelWorldGeneratorBlender::GetWeights(FLayerIndices& ActiveLayers, TArrayView<const FVector> Positions, int32 LOD, const FVoxelItemStack& Items, TArray<v_flt>& OutWeights) const
+{
+	VOXEL_FUNCTION_COUNTER();
+
+	const int32 Num = Positions.Num();
+	OutWeights.SetNumUninitialized(ActiveLayers.Num() * Num);
+
+	for (int32 ActiveIndex = 0; ActiveIndex < ActiveLayers.Num();)
+	{
+		const TArrayView<v_flt> LayerWeights(OutWeights.GetData() + ActiveIndex * Num, Num);
+		WeightsGenerator->GetCustomOutputs<v_flt>(WeightHandles[ActiveLayers[ActiveIndex]], 0, Positions, LOD, Items, LayerWeights);
+
+		bool bHasPositiveWeight = false;
+		for (v_flt& Weight : LayerWeights)
+		{
+			Weight = FMath::Max<v_flt>(0, Weight);
+			bHasPositiveWeight |= Weight > 0;
+		}
+
+		if (bHasPositiveWeight)
+		{
+			ActiveIndex++;
+		}
+		else
+		{
+			// Its weights will be overwritten by the next layer ones
+			ActiveLayers.RemoveAt(ActiveIndex);
+		}
+	}
+
+	OutWeights.SetNum(ActiveLayers.Num() * Num, false);
+}
+
+template<typename T, typename TBlend>
+void FVoxelWorldGeneratorBlender::IterateTiles(TVoxelQueryZone<T>& QueryZone, int32 LOD, const FVoxelItemStack& Items, TBlend Blend) const
+{
+	const int32 TileWorldSize = TileSize * int32(QueryZone.Step);
+	const FIntBox& Bounds = QueryZone.Bounds;
+
+	TArray<FVector> Positions;
+
+	for (int32 TileX = Bounds.Min.X; TileX < Bounds.Max.X; TileX += TileWorldSize)
+	{
+		for (int32 TileY = Bounds.Min.Y; TileY < Bounds.Max.Y; TileY += TileWorldSize)
+		{
+			for (int32 TileZ = Bounds.Min.Z; TileZ < Bounds.Max.Z; TileZ += TileWorldSize)
+			{
+				const FIntVector TileMin(TileX, TileY, TileZ);
+				auto TileZone = QueryZone.ShrinkTo(FIntBox(TileMin, TileMin + FIntVector(TileWorldSize)));
+
+				FLayerIndices ActiveLayers;
+				bool bCanBeAllZero;
+				GetActiveLayers(TileZone.Bounds, LOD, Items, ActiveLayers, bCanBeAllZero);
+
+				if (ActiveLayers.Num() == 1 && !bCanBeAllZero)
+				{
+					// Normalized weight is 1 everywhere
+					Layers[ActiveLayers[0]].Generator->Get<T>(TileZone, LOD, Items);
+					continue;
+				}
+
+				// In the tile buffers order: X first
+				Positions.Reset();
+				for (VOXEL_QUERY_ZONE_ITERATE(TileZone, Z))
+				{
+					for (VOXEL_QUERY_ZONE_ITERATE(TileZone, Y))
+					{
+						for (VOXEL_QUERY_ZONE_ITERATE(TileZone, X))
+						{
+							Positions.Emplace(X, Y, Z);
+						}
+					}
+				}
+
+				Blend(TileZone, ActiveLayers, bCanBeAllZero, Positions);
+			}
+		}
+	}
+}
+
+template<typename T>
+inline void FillTile(TVoxelQueryZone<T>& TileZone, TArrayView<const T> Buffer)
+{
+	int32 Index = 0;
+	for (VOXEL_QUERY_ZONE_ITERATE(TileZone, Z))
+	{
+		for (VOXEL_QUERY_ZONE_ITERATE(TileZone, Y))
+		{
+			for (VOXEL_QUERY_ZONE_ITERATE(TileZone, X))
+			{
+				TileZone.Set(X, Y, Z, Buffer[Index++]);
+			}
+		}
+	}
+}
+
+// Query zone on a buffer covering all of TileZone
+template<typename T>
+inline TVoxelQueryZone<T> MakeBufferZone(const TVoxelQueryZone<T>& TileZone, TArray<T>& Buffer)
+{
+	const FIntVector Size = TileZone.Bounds.Size() / int32(TileZone.Step);
+	Buffer.SetNumUninitialized(Size.X * Size.Y * Size.Z);
+	return TVoxelQueryZone<T>(TileZone.Bounds, Size, FMath::FloorLog2(TileZone.Step), Buffer);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+
+void FVoxelWorldGeneratorBlender::GetValues(TVoxelQueryZone<FVoxelValue>& QueryZone, int32 LOD, const FVoxelItemStack& Items) const
+{
+	VOXEL_FUNCTION_COUNTER();
+
+	TArray<TVoxelRange<v_flt>> LayerRanges;
+	LayerRanges.SetNum(Layers.Num());
+	
+	TArray<v_flt> Weights;
+	TArray<FVoxelValue> LayerValues;
+	TArray<v_flt> LayerFloatValues;
+	TArray<FVector> LayerPositions;
+	TArray<int32> LayerIndices;
+	TArray<v_flt> LayerBatchValues;
+	TArray<v_flt> Values;
+	TArray<v_flt> WeightsSums;
+	TArray<FVoxelValue> Result;
+
+	IterateTiles(QueryZone, LOD, Items, [&](TVoxelQueryZone<FVoxelValue>& TileZone, FLayerIndices& ActiveLayers, bool bCanBeAllZero, const TArray<FVector>& Positions)
+	{
+		const int32 Num = Positions.Num();
+		
+		// Values above 1 are stored as empty and below -1 as full: if all the layers are clamped to the same value, so is their blend
+		bool bAllEmpty = true;
+		bool bAllFull = true;
+		for (const int32 LayerIndex : ActiveLayers)
+		{
+			const TVoxelRange<v_flt> Range = Layers[LayerIndex].Generator->GetValueRange(TileZone.Bounds, LOD, Items);
+			LayerRanges[LayerIndex] = Range;
+			bAllEmpty &= Range.Min >= 1;
+			bAllFull &= Range.Max <= -1;
+		}
+		if (bAllEmpty || (bAllFull && !bCanBeAllZero))
+		{
+			Result.Reset();
+			Result.Init(bAllEmpty ? FVoxelValue::Empty() : FVoxelValue::Full(), Num);
+			FillTile<FVoxelValue>(TileZone, Result);
+			return;
+		}
+
+		GetWeights(ActiveLayers, Positions, LOD, Items, Weights);
+
+		Values.Reset();
+		Values.SetNumZeroed(Num);
+		WeightsSums.Reset();
+		WeightsSums.SetNumZeroed(Num);
+
+		for (int32 ActiveIndex = 0; ActiveIndex < ActiveLayers.Num(); ActiveIndex++)
+		{
+			const int32 LayerIndex = ActiveLayers[ActiveIndex];
+			const TVoxelRange<v_flt>& Range = LayerRanges[LayerIndex];
+			const v_flt* RESTRICT const LayerWeights = Weights.GetData() + ActiveIndex * Num;
+
+			LayerFloatValues.SetNumUninitialized(Num);
+			if (-1 <= Range.Min && Range.Max <= 1)
+			{
+				// Not clamped: blending the stored values only adds a rounding error
+				auto LayerZone = MakeBufferZone(TileZone, LayerValues);
+				Layers[LayerIndex].Generator->GetValues(LayerZone, LOD, Items);
+				for (int32 Index = 0; Index < Num; Index++)
+				{
+					LayerFloatValues[Index] = LayerValues[Index].ToFloat();
+				}
+			}
+			else
+			{
+				// The clamped values would change the blend: query the exact values, only where the weight is positive
+				LayerPositions.Reset();
+				LayerIndices.Reset();
+				for (int32 Index = 0; Index < Num; Index++)
+				{
+					if (LayerWeights[Index] > 0)
+					{
+						LayerPositions.Add(Positions[Index]);
+						LayerIndices.Add(Index);
+					}
+				}
+				LayerBatchValues.SetNumUninitialized(LayerPositions.Num());
+				Layers[LayerIndex].Generator->GetValues(LayerPositions, LOD, Items, LayerBatchValues);
+				for (int32 BatchIndex = 0; BatchIndex < LayerIndices.Num(); BatchIndex++)
+				{
+					LayerFloatValues[LayerIndices[BatchIndex]] = LayerBatchValues[BatchIndex];
+				}
+			}
+
+			for (int32 Index = 0; Index < Num; Index++)
+			{
+				const v_flt Weight = LayerWeights[Index];
+				if (Weight > 0)
+				{
+					WeightsSums[Index] += Weight;
+					Values[Index] += Weight * LayerFloatValues[Index];
+				}
+			}
+		}
+
+		Result.SetNumUninitialized(Num);
+		for (int32 Index = 0; Index < Num; Index++)
+		{
+			Result[Index] = WeightsSums[Index] > 0 ? FVoxelValue(Values[Index] / WeightsSums[Index]) : FVoxelValue::Empty();
+		}
+		FillTile<FVoxelValue>(TileZone, Result);
+	});
+}
+
+void FVoxelWorldGeneratorBlender::GetMaterials(TVoxelQueryZone<FVoxelMaterial>& QueryZone, int32 LOD, const FVoxelItemStack& Items) const
+{
+	VOXEL_FUNCTION_COUNTER();
+
+	TArray<v_flt> Weights;
+	TArray<int32> BestLayers;
+	TArray<FVoxelMaterial> LayerMaterials;
+	TArray<FVoxelMaterial> Result;
+
+	IterateTiles(QueryZone, LOD, Items, [&](TVoxelQueryZone<FVoxelMaterial>& TileZone, FLayerIndices& ActiveLayers, bool bCanBeAllZero, const TArray<FVector>& Positions)
+	{
+		const int32 Num = Positions.Num();
+		GetWeights(ActiveLayers, Positions, LOD, Items, Weights);
+		
+		// Index in ActiveLayers of the layer with the highest weight, -1 if all the weights are 0
+		BestLayers.SetNumUninitialized(Num);
+		for (int32 Index = 0; Index < Num; Index++)
+		{
+			int32 BestLayer = -1;
+			v_flt BestWeight = 0;
+			for (int32 ActiveIndex = 0; ActiveIndex < ActiveLayers.Num(); ActiveIndex++)
+			{
+				const v_flt Weight = Weights[ActiveIndex * Num + Index];
+				if (Weight > BestWeight)
+				{
+					BestLayer = ActiveIndex;
+					BestWeight = Weight;
+				}
+			}
+			BestLayers[Index] = BestLayer;
+		}
+
+		Result.Reset();
+		Result.Init(FVoxelMaterial::Default(), Num);
+
+		for (int32 ActiveIndex = 0; ActiveIndex < ActiveLayers.Num(); ActiveIndex++)
+		{
+			if (!BestLayers.Contains(ActiveIndex))
+			{
+				continue;
+			}
+
+			auto LayerZone = MakeBufferZone(TileZone, LayerMaterials);
+			Layers[ActiveLayers[ActiveIndex]].Generator->GetMaterials(LayerZone, LOD, Items);
+
+			for (int32 Index = 0; Index < Num; Index++)
+			{
+				if (BestLayers[Index] == ActiveIndex)
+				{
+					Result[Index] = LayerMaterials[Index];
+				}
+			}
+		}
+		
+		FillTile<FVoxelMaterial>(TileZone, Result);
+	});
+}
+
+void FVoxelWorldGeneratorBlender::GetValues(TArrayView<const FVector> Positions, int32 LOD, const FVoxelItemStack& Items, TArrayView<v_flt> OutValues) const
+{
+	VOXEL_FUNCTION_COUNTER();
+	check(Positions.Num() == OutValues.Num());
+
+	const int32 Num = Positions.Num();
+
+	FLayerIndices ActiveLayers;
+	for (int32 Index = 0; Index < Layers.Num(); Index++)
+	{
+		if (WeightHandles[Index].IsValid())
+		{
+			ActiveLayers.Add(Index);
+		}
+	}
+
+	TArray<v_flt> Weights;
+	GetWeights(ActiveLayers, Positions, LOD, Items, Weights);
+
+	TArray<v_flt> WeightsSums;
+	WeightsSums.SetNumZeroed(Num);
+	for (v_flt& Value : OutValues)
+	{
+		Value = 0;
+	}
+
+	// Only query each layer on the positions where its weight is positive
+	TArray<FVector> LayerPositions;
+	TArray<int32> LayerIndices;
+	TArray<v_flt> LayerValues;
+	for (int32 ActiveIndex = 0; ActiveIndex < ActiveLayers.Num(); ActiveIndex++)
+	{
+		const v_flt* RESTRICT const LayerWeights = Weights.GetData() + ActiveIndex * Num;
+
+		LayerPositions.Reset();
+		LayerIndices.Reset();
+		for (int32 Index = 0; Index < Num; Index++)
+		{
+			if (LayerWeights[Index] > 0)
+			{
+				LayerPositions.Add(Positions[Index]);
+				LayerIndices.Add(Index);
+			}
+		}
+
+		LayerValues.SetNumUninitialized(LayerPositions.Num());
+		Layers[ActiveLayers[ActiveIndex]].Generator->GetValues(LayerPositions, LOD, Items, LayerValues);
+
+		for (int32 LayerIndex = 0; LayerIndex < LayerIndices.Num(); LayerIndex++)
+		{
+			const int32 Index = LayerIndices[LayerIndex];
+			WeightsSums[Index] += LayerWeights[Index];
+			OutValues[Index] += LayerWeights[Index] * LayerValues[LayerIndex];
+		}
+	}
+
+	for (int32 Index = 0; Index < Num; Index++)
+	{
+		OutValues[Index] = WeightsSums[Index] > 0 ? OutValues[Index] / WeightsSums[Index] : FVoxelValue::Empty().ToFloat();
+	}
+}
+
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+
+// Weights: W0 on X < 0, W1 on X > -32, W2 on Y > 0 and W3 on Z > 16
+// Tiles with X >= 0, Y <= 0 and Z <= 16 only have W1
+class FVoxelBlenderTestWeights : public TVoxelWorldGeneratorInstanceHelper<FVoxelBlenderTestWeights, UVoxelFlatWorldGenerator>
+{
+public:
+	using Super = TVoxelWorldGeneratorInstanceHelper<FVoxelBlenderTestWeights, UVoxelFlatWorldGenerator>;
+
+	FVoxelBlenderTestWeights()
+		: Super(
+			{
+				{ "W0", static_cast<TOutputFunctionPtr<v_flt>>(&FVoxelBlenderTestWeights::GetWeight0) },
+				{ "W1", static_cast<TOutputFunctionPtr<v_flt>>(&FVoxelBlenderTestWeights::GetWeight1) },
+				{ "W2", static_cast<TOutputFunctionPtr<v_flt>>(&FVoxelBlenderTestWeights::GetWeight2) },
+				{ "W3", static_cast<TOutputFunctionPtr<v_flt>>(&FVoxelBlenderTestWeights::GetWeight3) }
+			},
+			{},
+			{
+				{ "W0", static_cast<TRangeOutputFunctionPtr<v_flt>>(&FVoxelBlenderTestWeights::GetWeight0Range) },
+				{ "W1", static_cast<TRangeOutputFunctionPtr<v_flt>>(&FVoxelBlenderTestWeights::GetWeight1Range) },
+				{ "W2", static_cast<TRangeOutputFunctionPtr<v_flt>>(&FVoxelBlenderTestWeights::GetWeight2Range) },
+				{ "W3", static_cast<TRangeOutputFunctionPtr<v_flt>>(&FVoxelBlenderTestWeights::GetWeight3Range) }
+			})
+	{
+	}
+
+	static v_flt Weight0(v_flt X) { return FMath::Clamp<v_flt>(-X / 32, 0, 1); }
+	static v_flt Weight1(v_flt X) { return FMath::Clamp<v_flt>(X / 32 + 1, 0, 1); }
+	static v_flt Weight2(v_flt Y) { return FMath::Clamp<v_flt>(Y / 16, 0, 2); }
+	static v_flt Weight3(v_flt Z) { return FMath::Clamp<v_flt>(Z / 8 - 2, 0, 1); }
+
+	v_flt GetWeight0(v_flt X, v_flt Y, v_flt Z, int32 LOD, const FVoxelItemStack& Items) const { return Weight0(X); }
+	v_flt GetWeight1(v_flt X, v_flt Y, v_flt Z, int32 LOD, const FVoxelItemStack& Items) const { return Weight1(X); }
+	v_flt GetWeight2(v_flt X, v_flt Y, v_flt Z, int32 LOD, const FVoxelItemStack& Items) const { return Weight2(Y); }
+	v_flt GetWeight3(v_flt X, v_flt Y, v_flt Z, int32 LOD, const FVoxelItemStack& Items) const { return Weight3(Z); }
+
+	TVoxelRange<v_flt> GetWeight0Range(const FIntBox& Bounds, int32 LOD, const FVoxelItemStack& Items) const { return { Weight0(Bounds.Max.X), Weight0(Bounds.Min.X) }; }
+	TVoxelRange<v_flt> GetWeight1Range(const FIntBox& Bounds, int32 LOD, const FVoxelItemStack& Items) const { return { Weight1(Bounds.Min.X), Weight1(Bounds.Max.X) }; }
+	TVoxelRange<v_flt> GetWeight2Range(const FIntBox& Bounds, int32 LOD, const FVoxelItemStack& Items) const { return { Weight2(Bounds.Min.Y), Weight2(Bounds.Max.Y) }; }
+	TVoxelRange<v_flt> GetWeight3Range(const FIntBox& Bounds, int32 LOD, const FVoxelItemStack& Items) const { return { Weight3(Bounds.Min.Z), Weight3(Bounds.Max.Z) }; }
+
+	//~ Begin FVoxelWorldGeneratorInstance Interface
+	inline v_flt GetValueImpl(v_flt X, v_flt Y, v_flt Z, int32 LOD, const FVoxelItemStack& Items) const { return 0; }
+	inline FVoxelMaterial GetMaterialImpl(v_flt X, v_flt Y, v_flt Z, int32 LOD, const FVoxelItemStack& Items) const { return FVoxelMaterial::Default(); }
+	TVoxelRange<v_flt> GetValueRangeImpl(const FIntBox& Bounds, int32 LOD, const FVoxelItemStack& Items) const { return 0; }
+	FVector GetUpVector(v_flt X, v_flt Y, v_flt Z) const override final { return FVector::UpVector; }
+	//~ End FVoxelWorldGeneratorInstance Interface
+};
+
+class FVoxelBlenderTestLayer : public TVoxelWorldGeneratorInstanceHelper<FVoxelBlenderTestLayer, UVoxelFlatWorldGenerator>
+{
+public:
+	const int32 Layer;
+
+	explicit FVoxelBlenderTestLayer(int32 Layer)
+		: Layer(Layer)
+	{
+	}
+
+	//~ Begin FVoxelWorldGeneratorInstance Interface
+	inline v_flt GetValueImpl(v_flt X, v_flt Y, v_flt Z, int32 LOD, const FVoxelItemStack& Items) const
+	{
+		return (Z - 8 * Layer - 4 * FMath::Sin(X * 0.1f * (Layer + 1)) * FMath::Cos(Y * 0.07f)) / 8;
+	}
+	inline FVoxelMaterial GetMaterialImpl(v_flt X, v_flt Y, v_flt Z, int32 LOD, const FVoxelItemStack& Items) const
+	{
+		return FVoxelMaterial::CreateFromColor(FColor(uint8(50 * Layer), uint8(FMath::FloorToInt(X)), uint8(FMath::FloorToInt(Z)), 255));
+	}
+	TVoxelRange<v_flt> GetValueRangeImpl(const FIntBox& Bounds, int32 LOD, const FVoxelItemStack& Items) const
+	{
+		return { v_flt(Bounds.Min.Z - 8 * Layer - 4) / 8, v_flt(Bounds.Max.Z - 8 * Layer + 4) / 8 };
+	}
+	FVector GetUpVector(v_flt X, v_flt Y, v_flt Z) const override final { return FVector::UpVector; }
+	//~ End FVoxelWorldGeneratorInstance Interface
+};
+
+static void TestBlender(const TArray<FString>& Args)
+{
+	const int32 NumZones = Args.Num() > 0 ? FCString::Atoi(*Args[0]) : 64;
+
+	TArray<FVoxelWorldGeneratorBlender::FLayer> Layers;
+	for (int32 Index = 0; Index < 4; Index++)
+	{
+		Layers.Add({ MakeVoxelShared<FVoxelBlenderTestLayer>(Index), *FString::Printf(TEXT("W%d"), Index) });
+	}
+	// Layer without weight
+	Layers.Add({ MakeVoxelShared<FVoxelBlenderTestLayer>(4), "NoWeight" });
+
+	const auto Weights = MakeVoxelShared<FVoxelBlenderTestWeights>();
+	const FVoxelItemStack& Items = FVoxelItemStack::Empty;
+
+	// The layers values are quantized before being blended in query zones
+	const float MaxValueError = FVoxelValue::Precision().ToFloat();
+
+	FRandomStream Stream(NumZones);
+	int32 NumValueErrors = 0;
+	int32 NumMaterialErrors = 0;
+	int32 NumBatchErrors = 0;
+	int64 NumVoxels = 0;
+	for (int32 ZoneIndex = 0; ZoneIndex < NumZones; ZoneIndex++)
+	{
+		const int32 LOD = Stream.RandRange(0, 2);
+		const int32 Step = 1 << LOD;
+		const FIntVector Min = FIntVector(Stream.RandRange(-48, 32), Stream.RandRange(-32, 32), Stream.RandRange(-16, 32)) * Step;
+		const FIntVector Size = FIntVector(Stream.RandRange(1, 24), Stream.RandRange(1, 24), Stream.RandRange(1, 24));
+		const FIntBox Bounds(Min, Min + Size * Step);
+		const auto Blender = MakeVoxelShared<FVoxelWorldGeneratorBlender>(Weights, Layers, Stream.RandRange(1, 16));
+
+		TArray<FVoxelValue> Values;
+		Values.SetNumUninitialized(Size.X * Size.Y * Size.Z);
+		TVoxelQueryZone<FVoxelValue> ValuesZone(Bounds, Size, LOD, Values);
+		Blender->GetValues(ValuesZone, LOD, Items);
+
+		TArray<FVoxelMaterial> Materials;
+		Materials.SetNumUninitialized(Size.X * Size.Y * Size.Z);
+		TVoxelQueryZone<FVoxelMaterial> MaterialsZone(Bounds, Size, LOD, Materials);
+		Blender->GetMaterials(MaterialsZone, LOD, Items);
+
+		TArray<FVector> Positions;
+		for (VOXEL_QUERY_ZONE_ITERATE(ValuesZone, X))
+		{
+			for (VOXEL_QUERY_ZONE_ITERATE(ValuesZone, Y))
+			{
+				for (VOXEL_QUERY_ZONE_ITERATE(ValuesZone, Z))
+				{
+					const FVoxelValue Value = ValuesZone.Get(X, Y, Z);
+					const FVoxelValue ExpectedValue = FVoxelValue(Blender->GetValue(X, Y, Z, LOD, Items));
+					if (FMath::Abs(Value.ToFloat() - ExpectedValue.ToFloat()) > MaxValueError * 1.01f)
+					{
+						if (NumValueErrors++ < 8)
+						{
+							UE_LOG(LogVoxel, Error, TEXT("Value mismatch at %d %d %d LOD %d: %f, expected %f"), X, Y, Z, LOD, Value.ToFloat(), ExpectedValue.ToFloat());
+						}
+					}
+
+					if (MaterialsZone.Get(X, Y, Z) != Blender->GetMaterial(X, Y, Z, LOD, Items))
+					{
+						if (NumMaterialErrors++ < 8)
+						{
+							UE_LOG(LogVoxel, Error, TEXT("Material mismatch at %d %d %d LOD %d"), X, Y, Z, LOD);
+						}
+					}
+
+					Positions.Add(FVector(X + Stream.FRand(), Y + Stream.FRand(), Z + Stream.FRand()));
+					NumVoxels++;
+				}
+			}
+		}
+
+		TArray<v_flt> BatchValues;
+		BatchValues.SetNumUninitialized(Positions.Num());
+		Blender->GetValues(Positions, LOD, Items, BatchValues);
+		for (int32 Index = 0; Index < Positions.Num(); Index++)
+		{
+			const FVector& Position = Positions[Index];
+			const v_flt ExpectedValue = Blender->GetValue(Position.X, Position.Y, Position.Z, LOD, Items);
+			if (!FMath::IsNearlyEqual(BatchValues[Index], ExpectedValue, v_flt(KINDA_SMALL_NUMBER)))
+			{
+				if (NumBatchErrors++ < 8)
+				{
+					UE_LOG(LogVoxel, Error, TEXT("Batched value mismatch at %s LOD %d: %f, expected %f"), *Position.ToString(), LOD, BatchValues[Index], ExpectedValue);
+				}
+			}
+		}
+	}
+
+	UE_LOG(LogVoxel, Log, TEXT("Blender test: %d zones, %lld voxels: %d value errors, %d material errors, %d batched value errors"),
+		NumZones,
+		NumVoxels,
+		NumValueErrors,
+		NumMaterialErrors,
+		NumBatchErrors);
+	ensureMsgf(NumValueErrors == 0 && NumMaterialErrors == 0 && NumBatchErrors == 0, TEXT("Blended query zones don't match per voxel blending"));
+}
+
+static FAutoConsoleCommand TestBlenderCmd(
+	TEXT("voxel.generator.TestBlender"),
+	TEXT("Check the world generator blender query zones & batched values against per voxel blending on random zones & tile sizes. Args: NumZones (default 64)"),
+	FConsoleCommandWithArgsDelegate::CreateStatic(&TestBlender));
\ No newline at end of file
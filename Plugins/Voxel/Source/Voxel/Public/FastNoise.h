@@ -44,6 +44,8 @@
 //#define FN_USE_DOUBLES
 
 #define FN_CELLULAR_INDEX_MAX 3
+// Max number of cells in a cellular cache. Bigger zones are not cached
+#define FN_CELLULAR_CACHE_MAX_CELLS (1 << 16)
 
 typedef v_flt FN_DECIMAL;
 
@@ -54,6 +56,36 @@ public:
 	
 	//explicit FastNoise(int seed = 1337) { SetSeed(seed); CalculateFractalBounding(); }
 
+	// Cell vectors of the cells covering a zone (eg a query zone), so that adjacent samples don't look them up again
+	// Only valid for the FastNoise that built it, as long as its seed is unchanged
+	// The vectors are stored before being scaled by the jitter, so that the results are bit identical to the uncached ones
+	// See voxel.noise.TestCellularCache
+	struct CellularCache
+	{
+		int minX = 0;
+		int minY = 0;
+		int minZ = 0;
+		int sizeX = 0;
+		int sizeY = 0;
+		int sizeZ = 0;
+		// 2 or 3 per cell, X major
+		TArray<FN_DECIMAL> cellVectors;
+
+		// True if the cell and all its neighbors are cached
+		FORCEINLINE bool Contains_2D(int x, int y) const
+		{
+			return
+				minX < x && x + 1 < minX + sizeX &&
+				minY < y && y + 1 < minY + sizeY;
+		}
+		FORCEINLINE bool Contains_3D(int x, int y, int z) const
+		{
+			return
+				Contains_2D(x, y) &&
+				minZ < z && z + 1 < minZ + sizeZ;
+		}
+	};
+
 	enum NoiseType { Value, ValueFractal, Perlin, PerlinFractal, Simplex, SimplexFractal, Cellular, WhiteNoise, Cubic, CubicFractal };
 	enum Interp { Linear, Hermite, Quintic };
 	enum FractalType { FBM, Billow, RigidMulti };
@@ -192,6 +224,9 @@ public:
 	FN_DECIMAL GetSimplexFractal_2D(FN_DECIMAL x, FN_DECIMAL y, float frequency, int octaves) const;
 
 	FN_DECIMAL GetCellular_2D(FN_DECIMAL x, FN_DECIMAL y, float frequency) const;
+	// Same as above, but reading the cell jitters from the cache when possible
+	FN_DECIMAL GetCellular_2D(const CellularCache& cache, FN_DECIMAL x, FN_DECIMAL y, float frequency) const;
+	void BuildCellularCache_2D(CellularCache& cache, FN_DECIMAL minX, FN_DECIMAL minY, FN_DECIMAL maxX, FN_DECIMAL maxY, float frequency) const;
 	
 	void GetVoronoi_2D(FN_DECIMAL x, FN_DECIMAL y, float m_jitter, FN_DECIMAL& out_x, FN_DECIMAL& out_y) const;
 	void GetVoronoiNeighbors_2D(
@@ -231,6 +266,9 @@ public:
 	FN_DECIMAL GetSimplexFractal_3D(FN_DECIMAL x, FN_DECIMAL y, FN_DECIMAL z, float frequency, int octaves) const;
 
 	FN_DECIMAL GetCellular_3D(FN_DECIMAL x, FN_DECIMAL y, FN_DECIMAL z, float frequency) const;
+	// Same as above, but reading the cell jitters from the cache when possible
+	FN_DECIMAL GetCellular_3D(const CellularCache& cache, FN_DECIMAL x, FN_DECIMAL y, FN_DECIMAL z, float frequency) const;
+	void BuildCellularCache_3D(CellularCache& cache, FN_DECIMAL minX, FN_DECIMAL minY, FN_DECIMAL minZ, FN_DECIMAL maxX, FN_DECIMAL maxY, FN_DECIMAL maxZ, float frequency) const;
 
 	FN_DECIMAL GetWhiteNoise_3D(FN_DECIMAL x, FN_DECIMAL y, FN_DECIMAL z) const;
 	FN_DECIMAL GetWhiteNoiseInt_3D(int x, int y, int z) const;
@@ -308,8 +346,12 @@ private:
 	FN_DECIMAL SingleCubicFractalRigidMulti_2D(FN_DECIMAL x, FN_DECIMAL y, int octaves) const;
 	FN_DECIMAL SingleCubic_2D(unsigned char offset, FN_DECIMAL x, FN_DECIMAL y) const;
 
-	FN_DECIMAL SingleCellular_2D(FN_DECIMAL x, FN_DECIMAL y) const;
-	FN_DECIMAL SingleCellular2Edge_2D(FN_DECIMAL x, FN_DECIMAL y) const;
+	template<bool bCached>
+	FN_DECIMAL SingleCellular_2D(const CellularCache* cache, FN_DECIMAL x, FN_DECIMAL y) const;
+	template<bool bCached>
+	FN_DECIMAL SingleCellular2Edge_2D(const CellularCache* cache, FN_DECIMAL x, FN_DECIMAL y) const;
+	template<bool bCached>
+	void GetCellVector_2D(const CellularCache* cache, int x, int y, FN_DECIMAL& outX, FN_DECIMAL& outY) const;
 
 	void SingleGradientPerturb_2D(unsigned char offset, FN_DECIMAL warpAmp, FN_DECIMAL frequency, FN_DECIMAL& x, FN_DECIMAL& y) const;
 
@@ -342,8 +384,12 @@ private:
 	FN_DECIMAL SingleCubicFractalRigidMulti_3D(FN_DECIMAL x, FN_DECIMAL y, FN_DECIMAL z, int octaves) const;
 	FN_DECIMAL SingleCubic_3D(unsigned char offset, FN_DECIMAL x, FN_DECIMAL y, FN_DECIMAL z) const;
 
-	FN_DECIMAL SingleCellular_3D(FN_DECIMAL x, FN_DECIMAL y, FN_DECIMAL z) const;
-	FN_DECIMAL SingleCellular2Edge_3D(FN_DECIMAL x, FN_DECIMAL y, FN_DECIMAL z) const;
+	template<bool bCached>
+	FN_DECIMAL SingleCellular_3D(const CellularCache* cache, FN_DECIMAL x, FN_DECIMAL y, FN_DECIMAL z) const;
+	template<bool bCached>
+	FN_DECIMAL SingleCellular2Edge_3D(const CellularCache* cache, FN_DECIMAL x, FN_DECIMAL y, FN_DECIMAL z) const;
+	template<bool bCached>
+	void GetCellVector_3D(const CellularCache* cache, int x, int y, int z, FN_DECIMAL& outX, FN_DECIMAL& outY, FN_DECIMAL& outZ) const;
 
 	void SingleGradientPerturb_3D(unsigned char offset, FN_DECIMAL warpAmp, FN_DECIMAL frequency, FN_DECIMAL& x, FN_DECIMAL& y, FN_DECIMAL& z) const;
 
@@ -15,6 +15,171 @@ class UTexture2D;
 
 DECLARE_MEMORY_STAT_EXTERN(TEXT("Voxel Data Assets Memory"), STAT_VoxelDataAssetMemory, STATGROUP_VoxelMemory, VOXEL_API);
 
+// Voxels stored in 16^3 bricks. Uniform bricks only store a single value
+template<typename T>
+class TVoxelDataAssetBricks
+{
+public:
+	static constexpr int32 BrickSizeLog2 = 4;
+	static constexpr int32 BrickSize = 1 << BrickSizeLog2;
+	static constexpr int32 BrickNumVoxels = BrickSize * BrickSize * BrickSize;
+
+	struct FBrick
+	{
+		// -1 if uniform
+		int32 Offset = -1;
+		T UniformValue;
+	};
+
+public:
+	inline void Init(const FIntVector& Size, T Value)
+	{
+		NumBricks = FVoxelUtilities::DivideCeil(Size, BrickSize);
+		Bricks.Reset();
+		Bricks.SetNum(NumBricks.X * NumBricks.Y * NumBricks.Z);
+		for (auto& Brick : Bricks)
+		{
+			Brick.UniformValue = Value;
+		}
+		Data.Empty();
+	}
+	inline void Empty()
+	{
+		NumBricks = FIntVector::ZeroValue;
+		Bricks.Empty();
+		Data.Empty();
+	}
+	
+	FORCEINLINE bool IsEmpty() const
+	{
+		return Bricks.Num() == 0;
+	}
+	FORCEINLINE int32 GetAllocatedSize() const
+	{
+		return Bricks.GetAllocatedSize() + Data.GetAllocatedSize();
+	}
+	FORCEINLINE FIntVector GetNumBricks() const
+	{
+		return NumBricks;
+	}
+	FORCEINLINE const FBrick& GetBrick(int32 BrickX, int32 BrickY, int32 BrickZ) const
+	{
+		return Bricks.GetData()[GetBrickIndex(BrickX, BrickY, BrickZ)];
+	}
+	FORCEINLINE int32 GetNumUniformBricks() const
+	{
+		return Bricks.Num() - Data.Num() / BrickNumVoxels;
+	}
+
+public:
+	FORCEINLINE T Get(int32 X, int32 Y, int32 Z) const
+	{
+		const FBrick& Brick = Bricks.GetData()[GetBrickIndex(X >> BrickSizeLog2, Y >> BrickSizeLog2, Z >> BrickSizeLog2)];
+		if (Brick.Offset < 0)
+		{
+			return Brick.UniformValue;
+		}
+		checkVoxelSlow(Data.IsValidIndex(Brick.Offset + GetIndexInBrick(X, Y, Z)));
+		return Data.GetData()[Brick.Offset + GetIndexInBrick(X, Y, Z)];
+	}
+	FORCEINLINE T GetInBrick(const FBrick& Brick, int32 X, int32 Y, int32 Z) const
+	{
+		return Brick.Offset < 0 ? Brick.UniformValue : Data.GetData()[Brick.Offset + GetIndexInBrick(X, Y, Z)];
+	}
+	FORCEINLINE void Set(int32 X, int32 Y, int32 Z, T Value)
+	{
+		FBrick& Brick = Bricks.GetData()[GetBrickIndex(X >> BrickSizeLog2, Y >> BrickSizeLog2, Z >> BrickSizeLog2)];
+		if (Brick.Offset < 0)
+		{
+			if (IsSame(Brick.UniformValue, Value))
+			{
+				return;
+			}
+			// Allocate the brick
+			Brick.Offset = Data.AddUninitialized(BrickNumVoxels);
+			for (int32 Index = 0; Index < BrickNumVoxels; Index++)
+			{
+				Data.GetData()[Brick.Offset + Index] = Brick.UniformValue;
+			}
+		}
+		checkVoxelSlow(Data.IsValidIndex(Brick.Offset + GetIndexInBrick(X, Y, Z)));
+		Data.GetData()[Brick.Offset + GetIndexInBrick(X, Y, Z)] = Value;
+	}
+
+	// Collapse the bricks that became uniform and shrink the storage
+	// Size is used to ignore the voxels outside of the asset in the border bricks
+	void Compact(const FIntVector& Size)
+	{
+		TArray<T> NewData;
+		for (int32 BrickZ = 0; BrickZ < NumBricks.Z; BrickZ++)
+		{
+			for (int32 BrickY = 0; BrickY < NumBricks.Y; BrickY++)
+			{
+				for (int32 BrickX = 0; BrickX < NumBricks.X; BrickX++)
+				{
+					FBrick& Brick = Bricks[GetBrickIndex(BrickX, BrickY, BrickZ)];
+					if (Brick.Offset < 0)
+					{
+						continue;
+					}
+
+					const FIntVector Min = FIntVector(BrickX, BrickY, BrickZ) * BrickSize;
+					const FIntVector Max = FVoxelUtilities::ComponentMin(Min + FIntVector(BrickSize), Size);
+					const T FirstValue = Data[Brick.Offset + GetIndexInBrick(Min.X, Min.Y, Min.Z)];
+
+					bool bIsUniform = true;
+					for (int32 Z = Min.Z; Z < Max.Z && bIsUniform; Z++)
+					{
+						for (int32 Y = Min.Y; Y < Max.Y && bIsUniform; Y++)
+						{
+							for (int32 X = Min.X; X < Max.X && bIsUniform; X++)
+							{
+								bIsUniform = IsSame(FirstValue, Data[Brick.Offset + GetIndexInBrick(X, Y, Z)]);
+							}
+						}
+					}
+
+					if (bIsUniform)
+					{
+						Brick.Offset = -1;
+						Brick.UniformValue = FirstValue;
+					}
+					else
+					{
+						const int32 NewOffset = NewData.AddUninitialized(BrickNumVoxels);
+						FMemory::Memcpy(&NewData[NewOffset], &Data[Brick.Offset], BrickNumVoxels * sizeof(T));
+						Brick.Offset = NewOffset;
+					}
+				}
+			}
+		}
+		Data = MoveTemp(NewData);
+	}
+
+private:
+	FIntVector NumBricks = FIntVector::ZeroValue;
+	TArray<FBrick> Bricks;
+	TArray<T> Data;
+
+	FORCEINLINE int32 GetBrickIndex(int32 BrickX, int32 BrickY, int32 BrickZ) const
+	{
+		checkVoxelSlow(0 <= BrickX && BrickX < NumBricks.X);
+		checkVoxelSlow(0 <= BrickY && BrickY < NumBricks.Y);
+		checkVoxelSlow(0 <= BrickZ && BrickZ < NumBricks.Z);
+		return BrickX + NumBricks.X * BrickY + NumBricks.X * NumBricks.Y * BrickZ;
+	}
+	FORCEINLINE static int32 GetIndexInBrick(int32 X, int32 Y, int32 Z)
+	{
+		constexpr int32 Mask = BrickSize - 1;
+		return (X & Mask) + BrickSize * (Y & Mask) + BrickSize * BrickSize * (Z & Mask);
+	}
+	FORCEINLINE static bool IsSame(const T& A, const T& B)
+	{
+		// Bitwise comparison, to not merge materials that only compare equal
+		return FMemory::Memcmp(&A, &B, sizeof(T)) == 0;
+	}
+};
+
 struct FVoxelDataAssetData
 {
 	TWeakObjectPtr<UVoxelDataAsset> const Owner;
@@ -22,6 +187,8 @@ struct FVoxelDataAssetData
 	explicit FVoxelDataAssetData(UVoxelDataAsset* Owner)
 		: Owner(Owner)
 	{
+		Values.Init(Size, FVoxelValue::Empty());
+		Materials.Init(Size, FVoxelMaterial::Default());
 		INC_DWORD_STAT_BY(STAT_VoxelDataAssetMemory, GetAllocatedSize());
 	}
 	~FVoxelDataAssetData()
@@ -39,9 +206,18 @@ public:
 		DEC_DWORD_STAT_BY(STAT_VoxelDataAssetMemory, GetAllocatedSize());
 
 		// Somewhat thread safe
-		Values.SetNumUninitialized(NewSize.X * NewSize.Y * NewSize.Z);
-		Materials.SetNumUninitialized(bCreateMaterials ? NewSize.X * NewSize.Y * NewSize.Z : 0);
+		Values.Init(NewSize, FVoxelValue::Empty());
+		if (bCreateMaterials)
+		{
+			Materials.Init(NewSize, FVoxelMaterial::Default());
+		}
+		else
+		{
+			Materials.Empty();
+		}
 		Size = NewSize;
+		Mips.Empty();
+		bMipsDirty = true;
 
 		ensure(Size.GetMin() > 0);
 		ensure(Size.GetMax() > 1); // Else it'll be considered empty
@@ -50,15 +226,20 @@ public:
 	}
 	FORCEINLINE bool HasMaterials() const
 	{
-		return Materials.Num() > 0;
+		return !Materials.IsEmpty();
 	}
 	FORCEINLINE bool IsEmpty() const
 	{
-		return Values.Num() <= 1 && Materials.Num() <= 1;
+		return Size.GetMax() <= 1;
 	}
 	FORCEINLINE int32 GetAllocatedSize() const
 	{
-		return Values.GetAllocatedSize() + Materials.GetAllocatedSize();
+		int32 AllocatedSize = Values.GetAllocatedSize() + Materials.GetAllocatedSize() + Mips.GetAllocatedSize();
+		for (auto& Mip : Mips)
+		{
+			AllocatedSize += Mip.Min.GetAllocatedSize() + Mip.Max.GetAllocatedSize();
+		}
+		return AllocatedSize;
 	}
 	
 public:
@@ -82,28 +263,29 @@ public:
 
 	FORCEINLINE void SetValue(int32 X, int32 Y, int32 Z, const FVoxelValue& NewValue)
 	{
-		checkVoxelSlow(Values.IsValidIndex(GetIndex(X, Y, Z)));
-		Values.GetData()[GetIndex(X, Y, Z)] = NewValue;
+		checkVoxelSlow(IsValidIndex(X, Y, Z));
+		Values.Set(X, Y, Z, NewValue);
+		bMipsDirty = true;
 	}
 	FORCEINLINE void SetMaterial(int32 X, int32 Y, int32 Z, const FVoxelMaterial& NewMaterial)
 	{
-		checkVoxelSlow(Materials.IsValidIndex(GetIndex(X, Y, Z)));
-		Materials.GetData()[GetIndex(X, Y, Z)] = NewMaterial;
+		checkVoxelSlow(IsValidIndex(X, Y, Z) && HasMaterials());
+		Materials.Set(X, Y, Z, NewMaterial);
 	}
 
 	template<typename T>
 	FORCEINLINE FVoxelValue GetValueUnsafe(T X, T Y, T Z) const
 	{
 		static_assert(TIsSame<T, int32>::Value, "should be int32");
-		checkVoxelSlow(Values.IsValidIndex(GetIndex(X, Y, Z)));
-		return Values.GetData()[GetIndex(X, Y, Z)];
+		checkVoxelSlow(IsValidIndex(X, Y, Z));
+		return Values.Get(X, Y, Z);
 	}
 	template<typename T>
 	FORCEINLINE FVoxelMaterial GetMaterialUnsafe(T X, T Y, T Z) const
 	{
 		static_assert(TIsSame<T, int32>::Value, "should be int32");
-		checkVoxelSlow(Materials.IsValidIndex(GetIndex(X, Y, Z)));
-		return Materials.GetData()[GetIndex(X, Y, Z)];
+		checkVoxelSlow(IsValidIndex(X, Y, Z) && HasMaterials());
+		return Materials.Get(X, Y, Z);
 	}
 
 public:
@@ -170,8 +352,6 @@ public:
 		Y = FMath::Clamp<float>(Y, 0, Size.Y - 1);
 		Z = FMath::Clamp<float>(Z, 0, Size.Z - 1);
 		
-		auto* RESTRICT const ValuesPtr = Values.GetData();
-		auto* RESTRICT const MaterialsPtr = Materials.GetData();
 		const int32 MinX = FMath::FloorToInt(X);
 		const int32 MinY = FMath::FloorToInt(Y);
 		const int32 MinZ = FMath::FloorToInt(Z);
@@ -185,34 +365,31 @@ public:
 				for (int32 ItZ = MinZ; ItZ <= MaxZ; ItZ++)
 				{
 					checkVoxelSlow(IsValidIndex(ItX, ItY, ItZ));
-					const int32 Index = GetIndex(ItX, ItY, ItZ);
-					checkVoxelSlow(Values.IsValidIndex(Index));
-					checkVoxelSlow(Materials.IsValidIndex(Index));
-					if (ValuesPtr[Index].IsEmpty()) continue;
-					return MaterialsPtr[Index];
+					if (Values.Get(ItX, ItY, ItZ).IsEmpty()) continue;
+					return Materials.Get(ItX, ItY, ItZ);
 				}
 			}
 		}
-		return MaterialsPtr[GetIndex(MinX, MinY, MinZ)];
+		return Materials.Get(MinX, MinY, MinZ);
 	}
 
+public:
+	// Range of the values in Bounds, in asset voxel coordinates. Bounds.Max is inclusive to account for interpolation
+	// DefaultValue is the value outside of the asset
+	VOXEL_API TVoxelRange<v_flt> GetValueRange(const FIntBox& Bounds, FVoxelValue DefaultValue) const;
+	
+	// Collapse uniform bricks and build the bricks min/max pyramid. Called when serializing, need to be called manually after SetValue
+	VOXEL_API void Compact();
+
 public:
 	VOXEL_API void Serialize(FArchive& Ar, uint32 ValueConfigFlag, uint32 MaterialConfigFlag, int32 VoxelCustomVersion);
 
 public:
-	inline TArray<FVoxelValue>& GetRawValues()
-	{
-		return Values;
-	}
-	inline TArray<FVoxelMaterial>& GetRawMaterials()
-	{
-		return Materials;
-	}
-	inline const TArray<FVoxelValue>& GetRawValues() const
+	inline const TVoxelDataAssetBricks<FVoxelValue>& GetValueBricks() const
 	{
 		return Values;
 	}
-	inline const TArray<FVoxelMaterial>& GetRawMaterials() const
+	inline const TVoxelDataAssetBricks<FVoxelMaterial>& GetMaterialBricks() const
 	{
 		return Materials;
 	}
@@ -220,8 +397,19 @@ public:
 private:
 	// Not 0 to avoid crashes if empty
 	FIntVector Size = FIntVector(1, 1, 1);
-	TArray<FVoxelValue> Values = { FVoxelValue::Empty() };
-	TArray<FVoxelMaterial> Materials = { FVoxelMaterial::Default() };
+	TVoxelDataAssetBricks<FVoxelValue> Values;
+	TVoxelDataAssetBricks<FVoxelMaterial> Materials;
+
+	struct FMinMaxMip
+	{
+		FIntVector Size;
+		TArray<FVoxelValue> Min;
+		TArray<FVoxelValue> Max;
+	};
+	// Min/max of the values of each brick. Mips[0] has one cell per brick, the last one is 1x1x1
+	TArray<FMinMaxMip> Mips;
+	// If true, GetValueRange will return the full range
+	bool bMipsDirty = true;
 };
 
 UENUM()
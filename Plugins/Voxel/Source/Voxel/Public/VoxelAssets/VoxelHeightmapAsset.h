@@ -58,6 +58,8 @@ public:
 		Height = NewHeight;
 		MinHeight = TNumericLimits<T>::Max();
 		MaxHeight = TNumericLimits<T>::Min();
+		Mips.Empty();
+		bMipsDirty = true;
 
 		INC_DWORD_STAT_BY(STAT_VoxelHeightmapAssetMemory, GetAllocatedSize());
 	}
@@ -72,7 +74,12 @@ public:
 	}
 	inline int32 GetAllocatedSize() const
 	{
-		return Heights.GetAllocatedSize() + Materials.GetAllocatedSize();
+		int32 Size = Heights.GetAllocatedSize() + Materials.GetAllocatedSize() + Mips.GetAllocatedSize();
+		for (auto& Mip : Mips)
+		{
+			Size += Mip.Min.GetAllocatedSize() + Mip.Max.GetAllocatedSize();
+		}
+		return Size;
 	}
 
 public:
@@ -98,6 +105,7 @@ public:
 		MaxHeight = FMath::Max(MaxHeight, NewHeight);
 		MinHeight = FMath::Min(MinHeight, NewHeight);
 		Heights[Index] = NewHeight;
+		bMipsDirty = true;
 	}
 	inline void SetMaterial(int32 Index, const FVoxelMaterial& NewMaterial)
 	{
@@ -197,6 +205,57 @@ public:
 		}
 	}
 
+public:
+	// Build the min/max pyramid used by GetHeightRange. Called when serializing, need to be called manually after SetHeight
+	void BuildMinMaxPyramid();
+	
+	// Min & max of the heights in the rectangle, bounds inclusive. Coordinates are clamped
+	// O(log n): will look at at most 4x4 cells of the right mip
+	inline void GetHeightRange(int32 MinX, int32 MinY, int32 MaxX, int32 MaxY, T& OutMin, T& OutMax) const
+	{
+		if (bMipsDirty)
+		{
+			OutMin = MinHeight;
+			OutMax = MaxHeight;
+			return;
+		}
+
+		MinX = FMath::Clamp(MinX, 0, Width - 1);
+		MinY = FMath::Clamp(MinY, 0, Height - 1);
+		MaxX = FMath::Clamp(MaxX, MinX, Width - 1);
+		MaxY = FMath::Clamp(MaxY, MinY, Height - 1);
+
+		// Find the finest level where the rectangle is at most 4 cells wide
+		const int32 Size = FMath::Max(MaxX - MinX, MaxY - MinY) + 1;
+		int32 Level = 0;
+		while (Level < Mips.Num() && (Size >> Level) > 2)
+		{
+			Level++;
+		}
+
+		OutMin = TNumericLimits<T>::Max();
+		OutMax = TNumericLimits<T>::Lowest();
+		for (int32 Y = MinY >> Level; Y <= MaxY >> Level; Y++)
+		{
+			for (int32 X = MinX >> Level; X <= MaxX >> Level; X++)
+			{
+				if (Level == 0)
+				{
+					const T Value = Heights[GetIndex(X, Y)];
+					OutMin = FMath::Min(OutMin, Value);
+					OutMax = FMath::Max(OutMax, Value);
+				}
+				else
+				{
+					const FMinMaxMip& Mip = Mips[Level - 1];
+					const int32 Index = X + Mip.SizeX * Y;
+					OutMin = FMath::Min(OutMin, Mip.Min[Index]);
+					OutMax = FMath::Max(OutMax, Mip.Max[Index]);
+				}
+			}
+		}
+	}
+
 public:
 	void SerializeAsset(FArchive& Ar, uint32 MaterialConfigFlag, int32 VoxelCustomVersion);
 	
@@ -207,6 +266,18 @@ private:
 	int32 Height = 2;
 	T MinHeight = 0;
 	T MaxHeight = 0;
+
+	struct FMinMaxMip
+	{
+		int32 SizeX = 0;
+		int32 SizeY = 0;
+		TArray<T> Min;
+		TArray<T> Max;
+	};
+	// Mips[0] is half the heightmap resolution, the last one is 1x1
+	TArray<FMinMaxMip> Mips;
+	// If true, GetHeightRange will return the global min/max
+	bool bMipsDirty = true;
 };
 
 template<typename T>
@@ -235,6 +306,21 @@ struct VOXEL_API TVoxelHeightmapAssetSamplerWrapper
 	{
 		return HeightOffset + HeightScale * Data->GetMaxHeight();
 	}
+	// Range of the heights GetHeight can return in this rectangle
+	inline TVoxelRange<v_flt> GetHeightRange(v_flt MinX, v_flt MinY, v_flt MaxX, v_flt MaxY) const
+	{
+		T Min;
+		T Max;
+		// Floor & ceil to account for the bilinear interpolation
+		Data->GetHeightRange(
+			FMath::FloorToInt(MinX / Scale),
+			FMath::FloorToInt(MinY / Scale),
+			FMath::CeilToInt(MaxX / Scale),
+			FMath::CeilToInt(MaxY / Scale),
+			Min,
+			Max);
+		return TVoxelRange<v_flt>::FromList(HeightOffset + HeightScale * v_flt(Min), HeightOffset + HeightScale * v_flt(Max));
+	}
 	inline float GetWidth() const
 	{
 		return Scale * Data->GetWidth();
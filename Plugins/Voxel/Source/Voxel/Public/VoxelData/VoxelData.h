@@ -21,6 +21,7 @@ class FVoxelData;
 class AVoxelWorld;
 class FVoxelWorldGeneratorInstance;
 class FVoxelPlaceableItem;
+class FVoxelWorldGeneratorBakeCache;
 
 DECLARE_DWORD_COUNTER_STAT(TEXT("Edited Voxels"), STAT_EditedVoxels, STATGROUP_Voxel);
 
@@ -52,6 +53,8 @@ struct FVoxelDataSettings
 	const TVoxelSharedRef<FVoxelWorldGeneratorInstance> WorldGenerator;
 	const bool bEnableMultiplayer;
 	const bool bEnableUndoRedo;
+	// Optional
+	const TVoxelSharedPtr<const FVoxelWorldGeneratorBakeCache> BakeCache;
 
 	FVoxelDataSettings(const AVoxelWorld* World, EVoxelPlayType PlayType);
 	FVoxelDataSettings(
@@ -83,6 +86,8 @@ public:
 	const bool bEnableUndoRedo;
 
 	TVoxelSharedRef<FVoxelWorldGeneratorInstance> const WorldGenerator;
+	// On-disk cache of the world generator values, can be null. See PrefetchBakedValues
+	TVoxelSharedPtr<const FVoxelWorldGeneratorBakeCache> const BakeCache;
 
 private:
 	TUniquePtr<FVoxelDataOctreeParent> Octree;
@@ -149,6 +154,12 @@ public:
 	// Get the data in zone. Requires read lock
 	template<typename T>
 	void Get(TVoxelQueryZone<T>& QueryZone, int32 LOD) const;
+
+	// Read the world generator values of Bounds baked by a previous session, if there is a bake cache
+	// Must be called without any lock, as it's reading the disk
+	// The next Get of this thread with the exact same bounds & LOD will use them if the data there is still generator only,
+	// or will bake the values it computes if there were none
+	void PrefetchBakedValues(const FIntBox& Bounds, int32 LOD) const;
 	
 	template<typename T>
 	TArray<T> Get(const FIntBox& Bounds) const
@@ -178,6 +189,10 @@ public:
 		return Range.Min.IsEmpty() == Range.Max.IsEmpty();
 	}
 
+	// True if there are no edits nor items in Bounds, ie if the data there is the world generator one
+	// Requires read lock
+	bool IsGeneratorOnly(const FIntBox& Bounds) const;
+
 	template<typename T>
 	FORCEINLINE T GetCustomOutput(T DefaultValue, FName Name, v_flt X, v_flt Y, v_flt Z, int32 LOD) const
 	{
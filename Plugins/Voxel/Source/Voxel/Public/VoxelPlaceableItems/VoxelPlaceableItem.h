@@ -17,12 +17,15 @@ public:
 	const uint8 ItemId; // Item class id
 	const FIntBox Bounds;
 	const int32 Priority;
+	// Unique for the lifetime of the process, unlike the item address: use it to identify items in caches
+	const uint64 SerialNumber;
 	int32 ItemIndex = -1; // Index in the VoxelData array
 
 	FVoxelPlaceableItem(uint8 ItemId, const FIntBox& InBounds, int32 Priority)
 		: ItemId(ItemId)
 		, Bounds(InBounds)
 		, Priority(Priority)
+		, SerialNumber(NewSerialNumber())
 	{
 	}
 	virtual ~FVoxelPlaceableItem() = default;
@@ -42,6 +45,9 @@ public:
 	virtual FString GetDescription() const = 0;
 	virtual void Save(FArchive& Ar) const = 0;
 	virtual bool ShouldBeSaved() const { return true; }
+
+private:
+	static uint64 NewSerialNumber();
 };
 
 struct VOXEL_API FVoxelPlaceableItemLoader
@@ -51,6 +51,28 @@ public:
 	}
 
 	FORCEINLINE void Set(int32 X, int32 Y, int32 Z, T Value)
+	{
+		Data[GetIndex(X, Y, Z)] = Value;
+	}
+	FORCEINLINE T Get(int32 X, int32 Y, int32 Z) const
+	{
+		return Data[GetIndex(X, Y, Z)];
+	}
+	
+	TVoxelQueryZone<T> ShrinkTo(const FIntBox& InBounds) const
+	{
+		FIntBox LocalBounds = Bounds.Overlap(InBounds);
+		LocalBounds = LocalBounds.MakeMultipleOfRoundUp(Step);
+		return TVoxelQueryZone<T>(LocalBounds, Offset, ArraySize, LOD, Data);
+	}
+
+private:
+	T* RESTRICT Data;
+	const FIntVector Offset;
+	const FIntVector ArraySize;
+	const uint32 LOD;
+	
+	FORCEINLINE int32 GetIndex(int32 X, int32 Y, int32 Z) const
 	{
 		checkVoxelSlow(Bounds.Contains(X, Y, Z));
 		
@@ -70,23 +92,9 @@ public:
 		checkVoxelSlow(0 <= LocalY && LocalY < ArraySize.Y);
 		checkVoxelSlow(0 <= LocalZ && LocalZ < ArraySize.Z);
 
-		const int32 Index = LocalX + ArraySize.X * LocalY + ArraySize.X * ArraySize.Y * LocalZ;
-		Data[Index] = Value;
+		return LocalX + ArraySize.X * LocalY + ArraySize.X * ArraySize.Y * LocalZ;
 	}
 	
-	TVoxelQueryZone<T> ShrinkTo(const FIntBox& InBounds) const
-	{
-		FIntBox LocalBounds = Bounds.Overlap(InBounds);
-		LocalBounds = LocalBounds.MakeMultipleOfRoundUp(Step);
-		return TVoxelQueryZone<T>(LocalBounds, Offset, ArraySize, LOD, Data);
-	}
-
-private:
-	T* RESTRICT Data;
-	const FIntVector Offset;
-	const FIntVector ArraySize;
-	const uint32 LOD;
-	
 	TVoxelQueryZone(const FIntBox& Bounds, const FIntVector& Offset, const FIntVector& ArraySize, int32 LOD, T* Data)
 		: Step(1 << LOD)
 		, Bounds(Bounds)
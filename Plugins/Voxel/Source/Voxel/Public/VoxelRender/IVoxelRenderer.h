@@ -72,10 +72,14 @@ struct FVoxelRendererSettingsBase
 	const bool bCleanCollisionMeshes;
 
 	const EVoxelRenderType RenderType;
+	const bool bGreedyCubicMeshing;
 	const bool bCreateMaterialInstances;
 	const bool bDitherChunks;
 	const float ChunksDitheringDuration;
 	const bool bOptimizeIndices;
+	const bool bPackVertices;
+	const int32 MinSimplificationLOD;
+	const float SimplificationMaxError;
 	const int32 MaxDistanceFieldLOD;
 	const bool bOneMaterialPerCubeSide;
 	const bool bHalfPrecisionCoordinates;
@@ -4,7 +4,10 @@
 
 #include "CoreMinimal.h"
 #include "VoxelGlobals.h"
+#include "VoxelValue.h"
 #include "VoxelRender/VoxelProcMeshTangent.h"
+#include "VoxelRender/VoxelPackedVertex.h"
+#include "Math/Vector2DHalf.h"
 #include "VoxelRender/VoxelBlendedMaterial.h"
 
 class FDistanceFieldVolumeData;
@@ -23,6 +26,16 @@ struct VOXEL_API FVoxelChunkMeshBuffers
 	FBox Bounds;
 	FGuid Guid; // Use to avoid rebuilding collisions when the mesh didn't change
 
+	// Compact layout, set by Pack. Use the getters below to read the vertices of both layouts
+	bool bPacked = false;
+	bool bHalfTextureCoordinates = false;
+	TArray<FVoxelPackedPosition> PackedPositions;
+	TArray<FVoxelPackedNormal> PackedNormals;
+	TArray<FVoxelPackedTangent> PackedTangents;
+	TArray<FVector2DHalf> HalfTextureCoordinates[NUM_VOXEL_TEXTURE_COORDINATES];
+	FVector PackedPositionsMin = FVector::ZeroVector;
+	FVector PackedPositionsScale = FVector::ZeroVector;
+
 	~FVoxelChunkMeshBuffers()
 	{
 		DEC_DWORD_STAT_BY(STAT_VoxelChunkMeshMemory, LastAllocatedSize);
@@ -52,6 +65,7 @@ struct VOXEL_API FVoxelChunkMeshBuffers
 	template<typename TVertex>
 	FORCEINLINE uint32 AddVertex(const TVertex& Vertex, bool bRenderWorld)
 	{
+		checkVoxelSlow(!bPacked);
 		const int32 Index = Positions.Emplace(Vertex.Position);
 		if (bRenderWorld)
 		{
@@ -72,7 +86,28 @@ struct VOXEL_API FVoxelChunkMeshBuffers
 
 	inline int32 GetNumVertices() const
 	{
-		return Positions.Num();
+		return bPacked ? PackedPositions.Num() : Positions.Num();
+	}
+
+	FORCEINLINE FVector GetPosition(int32 Index) const
+	{
+		return bPacked
+			? PackedPositions.GetData()[Index].Unpack(PackedPositionsMin, PackedPositionsScale)
+			: Positions.GetData()[Index];
+	}
+	FORCEINLINE FVector GetNormal(int32 Index) const
+	{
+		return bPacked ? PackedNormals.GetData()[Index].Unpack() : Normals.GetData()[Index];
+	}
+	FORCEINLINE FVoxelProcMeshTangent GetTangent(int32 Index) const
+	{
+		return bPacked ? PackedTangents.GetData()[Index].Unpack() : Tangents.GetData()[Index];
+	}
+	FORCEINLINE FVector2D GetTextureCoordinate(uint32 Tex, int32 Index) const
+	{
+		return bHalfTextureCoordinates
+			? FVector2D(HalfTextureCoordinates[Tex].GetData()[Index])
+			: TextureCoordinates[Tex].GetData()[Index];
 	}
 
 	inline int32 GetAllocatedSize() const
@@ -82,13 +117,26 @@ struct VOXEL_API FVoxelChunkMeshBuffers
 			+ Normals.GetAllocatedSize()
 			+ Tangents.GetAllocatedSize()
 			+ Colors.GetAllocatedSize()
-			+ [&]() { uint32 Count = 0; for (auto& T : TextureCoordinates) Count += T.GetAllocatedSize(); return Count; }();
+			+ [&]() { uint32 Count = 0; for (auto& T : TextureCoordinates) Count += T.GetAllocatedSize(); return Count; }()
+			+ PackedPositions.GetAllocatedSize()
+			+ PackedNormals.GetAllocatedSize()
+			+ PackedTangents.GetAllocatedSize()
+			+ [&]() { uint32 Count = 0; for (auto& T : HalfTextureCoordinates) Count += T.GetAllocatedSize(); return Count; }();
 	}
 
 	void BuildAdjacency(TArray<uint32>& OutAdjacencyIndices) const;
 	void OptimizeIndices();
 	void Shrink();
 	void ComputeBounds();
+	// Convert the vertices to the compact layout. Must be called once all the vertices are added
+	// Positions are quantized to 16 bits on the grid given by GetPackedPositionsGrid, normals & tangents are octahedral encoded on 32 bits
+	// If bHalfPrecision, the texture coordinates are also stored as 16 bits floats
+	void Pack(int32 LOD, bool bHalfPrecision);
+
+	// Fixed quantization grid of the chunk positions, the same for all the chunks of a LOD
+	// Chunk origin is 0, and RENDER_CHUNK_SIZE * Step is mapped to 2^15 grid steps: positions on the voxel grid, eg the chunk borders, are stored exactly
+	// The grid starts half a chunk before the origin to leave room for the vertices translated by the transitions
+	static void GetPackedPositionsGrid(int32 LOD, FVector& OutMin, FVector& OutScale);
 
 private:
 	int32 LastAllocatedSize = 0;
@@ -159,6 +207,11 @@ public:
 	
 public:
 	void BuildDistanceField(int32 LOD, const FIntVector& Position, const FVoxelData& Data);
+	// Values: (RENDER_CHUNK_SIZE + 3)^3 values spaced by 1 << LOD, from Position - Step to Position + (RENDER_CHUNK_SIZE + 1) * Step included
+	// Use to share the values already read by the mesher
+	void BuildDistanceField(int32 LOD, TArrayView<const FVoxelValue> Values);
+	// Reads the values used by BuildDistanceField from Data. Takes a read lock
+	static void ReadDistanceFieldValues(int32 LOD, const FIntVector& Position, const FVoxelData& Data, TArrayView<FVoxelValue> OutValues);
 	void ComputeBounds();
 	void ComputeGuid();
 	
@@ -0,0 +1,113 @@
+// Copyright 2020 Phyronnaz
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "VoxelRender/VoxelProcMeshTangent.h"
+
+namespace FVoxelPackedVertexUtilities
+{
+	// Octahedral encoding: maps the unit sphere to [-1, 1]^2
+	FORCEINLINE FVector2D OctahedronEncode(const FVector& Vector)
+	{
+		const float L1Norm = FMath::Abs(Vector.X) + FMath::Abs(Vector.Y) + FMath::Abs(Vector.Z);
+		if (L1Norm <= 0)
+		{
+			return FVector2D(0, 0);
+		}
+		FVector2D Result(Vector.X / L1Norm, Vector.Y / L1Norm);
+		if (Vector.Z < 0)
+		{
+			Result = FVector2D(
+				(1 - FMath::Abs(Result.Y)) * (Result.X >= 0 ? 1 : -1),
+				(1 - FMath::Abs(Result.X)) * (Result.Y >= 0 ? 1 : -1));
+		}
+		return Result;
+	}
+	FORCEINLINE FVector OctahedronDecode(const FVector2D& Encoded)
+	{
+		FVector Result(Encoded.X, Encoded.Y, 1 - FMath::Abs(Encoded.X) - FMath::Abs(Encoded.Y));
+		if (Result.Z < 0)
+		{
+			Result.X = (1 - FMath::Abs(Encoded.Y)) * (Encoded.X >= 0 ? 1 : -1);
+			Result.Y = (1 - FMath::Abs(Encoded.X)) * (Encoded.Y >= 0 ? 1 : -1);
+		}
+		return Result.GetSafeNormal();
+	}
+
+	FORCEINLINE int16 QuantizeSNorm(float Value)
+	{
+		return int16(FMath::Clamp(FMath::RoundToInt(Value * MAX_int16), -MAX_int16, int32(MAX_int16)));
+	}
+	FORCEINLINE float DequantizeSNorm(int16 Value)
+	{
+		return FMath::Max(Value / float(MAX_int16), -1.f);
+	}
+}
+
+// Unit vector, octahedral encoded on 2 x 16 bits
+struct FVoxelPackedNormal
+{
+	int16 X = 0;
+	int16 Y = 0;
+
+	FVoxelPackedNormal() = default;
+	FORCEINLINE explicit FVoxelPackedNormal(const FVector& Normal)
+	{
+		const FVector2D Encoded = FVoxelPackedVertexUtilities::OctahedronEncode(Normal);
+		X = FVoxelPackedVertexUtilities::QuantizeSNorm(Encoded.X);
+		Y = FVoxelPackedVertexUtilities::QuantizeSNorm(Encoded.Y);
+	}
+
+	FORCEINLINE FVector Unpack() const
+	{
+		return FVoxelPackedVertexUtilities::OctahedronDecode(FVector2D(
+			FVoxelPackedVertexUtilities::DequantizeSNorm(X),
+			FVoxelPackedVertexUtilities::DequantizeSNorm(Y)));
+	}
+};
+
+// Same as FVoxelPackedNormal, with bFlipTangentY stored in the lowest bit of Y
+struct FVoxelPackedTangent
+{
+	int16 X = 0;
+	int16 Y = 0;
+
+	FVoxelPackedTangent() = default;
+	FORCEINLINE explicit FVoxelPackedTangent(const FVoxelProcMeshTangent& Tangent)
+	{
+		const FVector2D Encoded = FVoxelPackedVertexUtilities::OctahedronEncode(Tangent.TangentX);
+		X = FVoxelPackedVertexUtilities::QuantizeSNorm(Encoded.X);
+		Y = int16((FVoxelPackedVertexUtilities::QuantizeSNorm(Encoded.Y) & ~1) | int32(Tangent.bFlipTangentY));
+	}
+
+	FORCEINLINE FVoxelProcMeshTangent Unpack() const
+	{
+		const FVector TangentX = FVoxelPackedVertexUtilities::OctahedronDecode(FVector2D(
+			FVoxelPackedVertexUtilities::DequantizeSNorm(X),
+			FVoxelPackedVertexUtilities::DequantizeSNorm(int16(Y & ~1))));
+		return FVoxelProcMeshTangent(TangentX, bool(Y & 1));
+	}
+};
+
+// Position quantized on 16 bits per component, see FVoxelChunkMeshBuffers::GetPackedPositionsGrid
+struct FVoxelPackedPosition
+{
+	uint16 X = 0;
+	uint16 Y = 0;
+	uint16 Z = 0;
+
+	FVoxelPackedPosition() = default;
+	FORCEINLINE FVoxelPackedPosition(const FVector& Position, const FVector& Min, const FVector& InvScale)
+	{
+		const FVector Quantized = (Position - Min) * InvScale;
+		X = uint16(FMath::Clamp(FMath::RoundToInt(Quantized.X), 0, int32(MAX_uint16)));
+		Y = uint16(FMath::Clamp(FMath::RoundToInt(Quantized.Y), 0, int32(MAX_uint16)));
+		Z = uint16(FMath::Clamp(FMath::RoundToInt(Quantized.Z), 0, int32(MAX_uint16)));
+	}
+
+	FORCEINLINE FVector Unpack(const FVector& Min, const FVector& Scale) const
+	{
+		return Min + FVector(X, Y, Z) * Scale;
+	}
+};
\ No newline at end of file
@@ -16,6 +16,8 @@ DECLARE_MEMORY_STAT_EXTERN(TEXT("Positions"), STAT_VoxelProcMeshMemory_Positions
 DECLARE_MEMORY_STAT_EXTERN(TEXT("Colors"), STAT_VoxelProcMeshMemory_Colors, STATGROUP_VoxelProcMeshMemory, VOXEL_API);
 DECLARE_MEMORY_STAT_EXTERN(TEXT("Adjacency"), STAT_VoxelProcMeshMemory_Adjacency, STATGROUP_VoxelProcMeshMemory, VOXEL_API);
 DECLARE_MEMORY_STAT_EXTERN(TEXT("UVs & Tangents"), STAT_VoxelProcMeshMemory_UVs_Tangents, STATGROUP_VoxelProcMeshMemory, VOXEL_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Merged Buffers Upload Size"), STAT_VoxelProcMeshUploadSize, STATGROUP_VoxelProcMeshMemory, VOXEL_API);
+DECLARE_FLOAT_COUNTER_STAT_EXTERN(TEXT("Merge Time (ms)"), STAT_VoxelProcMeshMergeTime, STATGROUP_VoxelProcMeshMemory, VOXEL_API);
 
 struct VOXEL_API FVoxelProcMeshBuffers
 {
@@ -33,6 +35,8 @@ struct VOXEL_API FVoxelProcMeshBuffers
 	FVoxelRawStaticIndexBuffer AdjacencyIndexBuffer{ bNeedsCPUAccess };
 	/** Local bounds of this section */
 	FBox LocalBounds = FBox(ForceInit);
+	// Time spent merging the chunks into these buffers. Reported & reset by UpdateStats
+	uint64 MergeCycles = 0;
 
 	inline int32 GetNumVertices() const
 	{
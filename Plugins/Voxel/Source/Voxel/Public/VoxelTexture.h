@@ -78,6 +78,82 @@ struct TVoxelTexture
 	}
 
 public:
+	// Mip 0 is the texture itself. Only 1 unless the texture was created with mips, see FVoxelTextureUtilities::CreateFromTexture_Color
+	inline int32 GetNumMips() const
+	{
+		return DataPtr->Mips.Num() + 1;
+	}
+	inline T SampleRawMip(int32 X, int32 Y, int32 Mip, EVoxelSamplerMode Mode) const
+	{
+		checkVoxelSlow(0 <= Mip && Mip < GetNumMips());
+		if (Mip == 0)
+		{
+			return SampleRaw(X, Y, Mode);
+		}
+		
+		const auto& MipData = DataPtr->Mips[Mip - 1];
+		if (Mode == EVoxelSamplerMode::Clamp)
+		{
+			X = FMath::Clamp(X, 0, MipData.SizeX - 1);
+			Y = FMath::Clamp(Y, 0, MipData.SizeY - 1);
+		}
+		else
+		{
+			X = FVoxelUtilities::PositiveMod(X, MipData.SizeX);
+			Y = FVoxelUtilities::PositiveMod(Y, MipData.SizeY);
+		}
+		return MipData.Data[X + MipData.SizeX * Y];
+	}
+	// Bilinear sampling of a mip. X and Y are in full resolution texels
+	template<typename U>
+	inline U SampleMip(v_flt X, v_flt Y, int32 Mip, EVoxelSamplerMode Mode) const
+	{
+		Mip = FMath::Clamp(Mip, 0, GetNumMips() - 1);
+		if (Mip == 0)
+		{
+			return Sample<U>(X, Y, Mode);
+		}
+
+		// Mip texel (0, 0) is centered on the full resolution texels (0, 0) to (2^Mip - 1, 2^Mip - 1)
+		const v_flt Scale = v_flt(1) / (1 << Mip);
+		const v_flt MipX = (X + v_flt(0.5)) * Scale - v_flt(0.5);
+		const v_flt MipY = (Y + v_flt(0.5)) * Scale - v_flt(0.5);
+		
+		const int32 MinX = FMath::FloorToInt(MipX);
+		const int32 MinY = FMath::FloorToInt(MipY);
+
+		const int32 MaxX = FMath::CeilToInt(MipX);
+		const int32 MaxY = FMath::CeilToInt(MipY);
+
+		const v_flt AlphaX = MipX - MinX;
+		const v_flt AlphaY = MipY - MinY;
+
+		return FVoxelUtilities::BilinearInterpolation<U>(
+			U(SampleRawMip(MinX, MinY, Mip, Mode)),
+			U(SampleRawMip(MaxX, MinY, Mip, Mode)),
+			U(SampleRawMip(MinX, MaxY, Mip, Mode)),
+			U(SampleRawMip(MaxX, MaxY, Mip, Mode)),
+			AlphaX,
+			AlphaY);
+	}
+	// Samples the mip matching the distance between two samples, in full resolution texels
+	// Use it when sampling sparsely, eg at high LODs: the full resolution texture would alias and thrash the cache
+	// Same as Sample if the texture has no mips
+	template<typename U>
+	inline U SampleLOD(v_flt X, v_flt Y, v_flt TexelsPerSample, EVoxelSamplerMode Mode) const
+	{
+		const int32 Mip = TexelsPerSample >= 2 ? FMath::FloorLog2(uint32(FMath::Min<v_flt>(TexelsPerSample, MAX_int32))) : 0;
+		return SampleMip<U>(X, Y, Mip, Mode);
+	}
+
+public:
+	struct FMip
+	{
+		int32 SizeX = 1;
+		int32 SizeY = 1;
+		TArray<T> Data;
+	};
+	
 	struct FTextureData
 	{
 		int32 SizeX = 1;
@@ -85,6 +161,13 @@ public:
 		TArray<T> TextureData = { T{} };
 		T Min{};
 		T Max{};
+		// Box filtered, each half the size of the previous one. Empty unless BuildMips is called
+		TArray<FMip> Mips;
+
+		inline bool HasMips() const
+		{
+			return Mips.Num() > 0 || (SizeX == 1 && SizeY == 1);
+		}
 
 		FTextureData() = default;
 		~FTextureData()
@@ -98,6 +181,7 @@ public:
 			SizeY = NewSizeY;
 			TextureData.SetNumUninitialized(SizeX * SizeY);
 			TextureData.Shrink();
+			Mips.Empty();
 			UpdateAllocatedSize();
 
 			Min = TNumericLimits<T>::Max();
@@ -114,11 +198,73 @@ public:
 		inline void UpdateAllocatedSize()
 		{
 			DEC_MEMORY_STAT_BY(STAT_VoxelTextureMemory, AllocatedSize);
-			AllocatedSize = TextureData.GetAllocatedSize();
+			AllocatedSize = TextureData.GetAllocatedSize() + Mips.GetAllocatedSize();
+			for (auto& Mip : Mips)
+			{
+				AllocatedSize += Mip.Data.GetAllocatedSize();
+			}
 			INC_MEMORY_STAT_BY(STAT_VoxelTextureMemory, AllocatedSize);
 		}
+		// Must be called again if the texture data is changed
+		void BuildMips()
+		{
+			VOXEL_FUNCTION_COUNTER();
+			
+			Mips.Reset();
+
+			int32 PreviousSizeX = SizeX;
+			int32 PreviousSizeY = SizeY;
+			const TArray<T>* PreviousData = &TextureData;
+			while (PreviousSizeX > 1 || PreviousSizeY > 1)
+			{
+				// Mips might be reallocated, so don't keep references to them
+				FMip NewMip;
+				NewMip.SizeX = (PreviousSizeX + 1) / 2;
+				NewMip.SizeY = (PreviousSizeY + 1) / 2;
+				NewMip.Data.SetNumUninitialized(NewMip.SizeX * NewMip.SizeY);
+
+				const T* RESTRICT Source = PreviousData->GetData();
+				for (int32 Y = 0; Y < NewMip.SizeY; Y++)
+				{
+					// Odd sizes: the last texel is duplicated
+					const int32 Y0 = 2 * Y;
+					const int32 Y1 = FMath::Min(2 * Y + 1, PreviousSizeY - 1);
+					for (int32 X = 0; X < NewMip.SizeX; X++)
+					{
+						const int32 X0 = 2 * X;
+						const int32 X1 = FMath::Min(2 * X + 1, PreviousSizeX - 1);
+						NewMip.Data[X + NewMip.SizeX * Y] = Average(
+							Source[X0 + PreviousSizeX * Y0],
+							Source[X1 + PreviousSizeX * Y0],
+							Source[X0 + PreviousSizeX * Y1],
+							Source[X1 + PreviousSizeX * Y1]);
+					}
+				}
+
+				PreviousSizeX = NewMip.SizeX;
+				PreviousSizeY = NewMip.SizeY;
+				Mips.Add(MoveTemp(NewMip));
+				PreviousData = &Mips.Last().Data;
+			}
+
+			UpdateAllocatedSize();
+		}
+		
 	private:
 		int32 AllocatedSize = 0;
+
+		static FORCEINLINE float Average(float A, float B, float C, float D)
+		{
+			return (A + B + C + D) / 4;
+		}
+		static FORCEINLINE FColor Average(const FColor& A, const FColor& B, const FColor& C, const FColor& D)
+		{
+			return FColor(
+				(A.R + B.R + C.R + D.R + 2) / 4,
+				(A.G + B.G + C.G + D.G + 2) / 4,
+				(A.B + B.B + C.B + D.B + 2) / 4,
+				(A.A + B.A + C.A + D.A + 2) / 4);
+		}
 	};
 	
 	TVoxelTexture()
@@ -139,8 +285,10 @@ private:
 
 namespace FVoxelTextureUtilities
 {
-	VOXEL_API TVoxelTexture<FColor> CreateFromTexture_Color(UTexture* Texture);
-	VOXEL_API TVoxelTexture<float> CreateFromTexture_Float(UTexture* Texture, EVoxelRGBA Channel);
+	// bWithMips: also build the mips used by TVoxelTexture::SampleLOD. They use a third more memory
+	// The graph texture sampler nodes never request mips: they are only for C++ world generators
+	VOXEL_API TVoxelTexture<FColor> CreateFromTexture_Color(UTexture* Texture, bool bWithMips = false);
+	VOXEL_API TVoxelTexture<float> CreateFromTexture_Float(UTexture* Texture, EVoxelRGBA Channel, bool bWithMips = false);
 	VOXEL_API bool CanCreateFromTexture(UTexture* Texture, FString& OutError);
 	VOXEL_API void FixTexture(UTexture* Texture);
 	VOXEL_API void ClearCache();
@@ -118,6 +118,11 @@ public:
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, AdvancedDisplay, Category = "Voxel - General", meta = (DisplayName = "Use camera if no invokers found"))
 	bool bUseCameraIfNoInvokersFound = false;
 	
+	// If true, the values generated on unedited chunks will be saved to Saved/VoxelBakeCache and reused by the next sessions
+	// The cache is invalidated when the world generator properties, its code or the seeds change. Its size is limited by voxel.generator.BakeCacheMaxSizeMB
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, AdvancedDisplay, Category = "Voxel - General", meta = (Recreate))
+	bool bEnableWorldGeneratorBakeCache = false;
+	
 	// Keep all the changes in memory to enable undo/redo. Can be expensive
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, AdvancedDisplay, Category = "Voxel - General", meta = (Recreate))
 	bool bEnableUndoRedo = false;
@@ -269,6 +274,11 @@ public:
 
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Voxel - Rendering", meta = (RecreateRender))
 	EVoxelRenderType RenderType = EVoxelRenderType::MarchingCubes;
+
+	// Only for Cubic mode. If true, coplanar faces with the same material will be merged into bigger quads, reducing a lot the triangle count of flat areas
+	// Per voxel UVs are tiled across the merged faces. Merged faces create T-junctions, which can cause small cracks with some materials
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, AdvancedDisplay, Category = "Voxel - Rendering", meta = (RecreateRender))
+	bool bGreedyCubicMeshing = false;
 	
 	// If true, a dynamic instance will be created for each chunk. Else, the material will be used directly
 	// Disable this if you want to use dynamic material instances as voxel world materials
@@ -311,6 +321,24 @@ public:
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, AdvancedDisplay, Category = "Voxel - Rendering", meta = (RecreateRender))
 	bool bOptimizeIndices = false;
 
+	// If true, the chunk meshes kept in memory will use a compact vertex layout: 16 bits positions, 32 bits normals & tangents,
+	// and 16 bits texture coordinates if bHalfPrecisionCoordinates is true. Reduces the mesh memory, but lower precision
+	// Only the CPU copies are packed: the vertices are unpacked when merged into the GPU buffers, so GPU memory & upload size are unchanged
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, AdvancedDisplay, Category = "Voxel - Rendering", meta = (RecreateRender))
+	bool bPackVertices = false;
+
+	// Only for Marching Cubes mode. If true, the chunks with LOD >= MinSimplificationLOD will be decimated on the async thread
+	// Reduces the triangle count of distant terrain, especially on flat areas. Chunk borders are kept so there are no cracks with the neighbors
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, AdvancedDisplay, Category = "Voxel - Rendering", meta = (RecreateRender))
+	bool bSimplifyFarChunks = false;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, AdvancedDisplay, Category = "Voxel - Rendering", meta = (RecreateRender, ClampMin = 0, ClampMax = 25, UIMin = 0, UIMax = 25, EditCondition = "bSimplifyFarChunks"))
+	int32 MinSimplificationLOD = 4;
+
+	// Max distance between the simplified mesh and the removed vertices, in voxels of the chunk LOD
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, AdvancedDisplay, Category = "Voxel - Rendering", meta = (RecreateRender, ClampMin = 0, UIMin = 0, UIMax = 2, EditCondition = "bSimplifyFarChunks"))
+	float SimplificationMaxError = 0.25f;
+
 	// Will generate distance fields on LOD 0 chunks
 	// Has a cost of around 1 ms per chunk (on async thread)
 	// Doesn't work with chunks merging or single/double index material config with different materials per chunk
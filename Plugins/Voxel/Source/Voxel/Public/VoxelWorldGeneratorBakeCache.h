@@ -0,0 +1,47 @@
+// Copyright 2020 Phyronnaz
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "HAL/ThreadSafeCounter.h"
+#include "IntBox.h"
+#include "VoxelValue.h"
+#include "VoxelSharedPtr.h"
+
+class UVoxelWorldGenerator;
+struct FVoxelWorldGeneratorInit;
+
+/**
+ * Opt-in on-disk cache of world generator values, stored in Saved/VoxelBakeCache. Used by FVoxelData, see FVoxelData::PrefetchBakedValues
+ * One file per bounds & LOD, in a directory named after the hash of the generator properties, of the seeds and of the binary containing the generator code
+ * The total size is limited by voxel.generator.BakeCacheMaxSizeMB: the least recently used files are deleted first
+ * Only the generator properties are hashed: if an asset referenced by the generator changes, use voxel.generator.ClearBakeCache
+ */
+class VOXEL_API FVoxelWorldGeneratorBakeCache : public TVoxelSharedFromThis<FVoxelWorldGeneratorBakeCache>
+{
+public:
+	const FString Directory;
+
+	explicit FVoxelWorldGeneratorBakeCache(const FString& Directory);
+
+	static TVoxelSharedRef<FVoxelWorldGeneratorBakeCache> Create(const UVoxelWorldGenerator& WorldGenerator, const FVoxelWorldGeneratorInit& InitStruct);
+	static FString GetRootDirectory();
+	// Delete the least recently used files until the cache is below its max size
+	// Needs to be thread safe!
+	static void Trim();
+
+public:
+	// Values are X + SizeX * Y + SizeX * SizeY * Z, spaced by 1 << LOD
+	// Blocking disk read: must not be called while holding a data lock
+	// Needs to be thread safe!
+	bool LoadValues(const FIntBox& Bounds, int32 LOD, TArrayView<FVoxelValue> OutValues) const;
+	// Compress & write the values in a background task. Values are dropped if too many saves are pending
+	// Needs to be thread safe!
+	void SaveValuesAsync(const FIntBox& Bounds, int32 LOD, TArray<FVoxelValue>&& Values) const;
+
+private:
+	mutable FThreadSafeCounter NumPendingSaves;
+
+	void SaveValues(const FIntBox& Bounds, int32 LOD, const TArray<FVoxelValue>& Values) const;
+	FString GetFilename(const FIntBox& Bounds, int32 LOD) const;
+};
\ No newline at end of file
@@ -0,0 +1,26 @@
+// Copyright 2020 Phyronnaz
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Commandlets/Commandlet.h"
+#include "VoxelWorldGeneratorBenchmarkCommandlet.generated.h"
+
+/**
+ * Headless world generator benchmark, to track generator throughput across builds
+ * Runs every generator that can be picked in a voxel world over fixed query zones, LODs & custom outputs, and writes the results as CSV
+ *
+ * Usage: UE4Editor-Cmd.exe Project.uproject -run=VoxelWorldGeneratorBenchmark [-Output=Path.csv] [-Size=32] [-NumRuns=3] [-Filter=Name]
+ */
+UCLASS()
+class VOXEL_API UVoxelWorldGeneratorBenchmarkCommandlet : public UCommandlet
+{
+	GENERATED_BODY()
+
+public:
+	UVoxelWorldGeneratorBenchmarkCommandlet();
+
+	//~ Begin UCommandlet Interface
+	virtual int32 Main(const FString& Params) override;
+	//~ End UCommandlet Interface
+};
\ No newline at end of file
@@ -0,0 +1,106 @@
+// Copyright 2020 Phyronnaz
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "VoxelWorldGenerator.h"
+#include "VoxelWorldGeneratorPicker.h"
+#include "VoxelWorldGeneratorInstance.h"
+#include "VoxelWorldGeneratorBlender.generated.h"
+
+/**
+ * World generator instance blending several world generators by weights, eg to merge biomes
+ * Created by UVoxelWorldGeneratorBlender, or directly by a C++ world generator. Its class is the weights generator one
+ * The weights are float custom outputs of WeightsGenerator. Negative weights are treated as 0
+ * Value = Sum(Weight * Value) / Sum(Weight), or empty if all the weights are 0. Material = material of the layer with the highest weight
+ *
+ * Query zones are split in tiles of TileSize voxels whose weights & values are range analyzed first:
+ * tiles with a single contributing layer directly use its query zone, and tiles where all the layers are clamped to empty or full are filled
+ * In the other tiles, the weights are queried in batch, and the layers whose weight is strictly positive somewhere are queried on the whole tile
+ * before being blended. Layers whose values might be clamped by FVoxelValue are queried in batch where their weight is positive instead
+ * Use voxel.generator.TestBlender to check the query zones against per voxel blending
+ */
+class VOXEL_API FVoxelWorldGeneratorBlender : public FVoxelWorldGeneratorInstance
+{
+public:
+	struct FLayer
+	{
+		TVoxelSharedPtr<FVoxelWorldGeneratorInstance> Generator;
+		// Name of the float custom output of WeightsGenerator. Weight is always 0 if there is no such output
+		FName WeightName;
+	};
+
+	FVoxelWorldGeneratorBlender(const TVoxelSharedRef<FVoxelWorldGeneratorInstance>& WeightsGenerator, const TArray<FLayer>& Layers, int32 TileSize = 8);
+
+	//~ Begin FVoxelWorldGeneratorInstance Interface
+	// Inits the weights generator & all the layers
+	virtual void Init(const FVoxelWorldGeneratorInit& InitStruct) override;
+	virtual void InitArea(const FIntBox& Bounds, int32 LOD) override;
+
+	virtual void GetValues   (TVoxelQueryZone<FVoxelValue   >& QueryZone, int32 LOD, const FVoxelItemStack& Items) const override;
+	virtual void GetMaterials(TVoxelQueryZone<FVoxelMaterial>& QueryZone, int32 LOD, const FVoxelItemStack& Items) const override;
+	virtual void GetValues(TArrayView<const FVector> Positions, int32 LOD, const FVoxelItemStack& Items, TArrayView<v_flt> OutValues) const override;
+
+	virtual FVector GetUpVector(v_flt X, v_flt Y, v_flt Z) const override;
+	//~ End FVoxelWorldGeneratorInstance Interface
+
+private:
+	const TVoxelSharedRef<FVoxelWorldGeneratorInstance> WeightsGenerator;
+	const TArray<FLayer> Layers;
+	const int32 TileSize;
+	TArray<TCustomOutputHandle<v_flt>> WeightHandles;
+
+	using FLayerIndices = TArray<int32, TInlineAllocator<16>>;
+
+	// Single voxel queries: blend all the layers
+	v_flt GetValueImpl(v_flt X, v_flt Y, v_flt Z, int32 LOD, const FVoxelItemStack& Items) const;
+	FVoxelMaterial GetMaterialImpl(v_flt X, v_flt Y, v_flt Z, int32 LOD, const FVoxelItemStack& Items) const;
+	TVoxelRange<v_flt> GetValueRangeImpl(const FIntBox& Bounds, int32 LOD, const FVoxelItemStack& Items) const;
+
+	// Layers whose weight can be strictly positive in Bounds
+	// bCanBeAllZero: true if there might be a position in Bounds where all the weights are 0
+	void GetActiveLayers(const FIntBox& Bounds, int32 LOD, const FVoxelItemStack& Items, FLayerIndices& OutLayers, bool& bCanBeAllZero) const;
+	// OutWeights: Positions.Num() weights per layer, in the ActiveLayers order. Layers whose weights are all 0 are removed from ActiveLayers
+	void GetWeights(FLayerIndices& ActiveLayers, TArrayView<const FVector> Positions, int32 LOD, const FVoxelItemStack& Items, TArray<v_flt>& OutWeights) const;
+
+	template<typename T, typename TBlend>
+	void IterateTiles(TVoxelQueryZone<T>& QueryZone, int32 LOD, const FVoxelItemStack& Items, TBlend Blend) const;
+};
+
+USTRUCT(BlueprintType)
+struct VOXEL_API FVoxelWorldGeneratorBlenderLayer
+{
+	GENERATED_BODY()
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Voxel")
+	FVoxelWorldGeneratorPicker Generator;
+
+	// Name of the float custom output of the weights generator giving the weight of this layer
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Voxel")
+	FName WeightName;
+};
+
+/**
+ * Blends several world generators by weights, eg to merge biomes. See FVoxelWorldGeneratorBlender
+ */
+UCLASS(Blueprintable)
+class VOXEL_API UVoxelWorldGeneratorBlender : public UVoxelWorldGenerator
+{
+	GENERATED_BODY()
+
+public:
+	// Generator whose float custom outputs are the layers weights. Negative weights are treated as 0
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Blender")
+	FVoxelWorldGeneratorPicker WeightsGenerator;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Blender")
+	TArray<FVoxelWorldGeneratorBlenderLayer> Layers;
+
+	// Size in voxels of the tiles whose weights are range analyzed. Smaller tiles skip more layers, but do more range analysis
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, AdvancedDisplay, Category = "Blender", meta = (ClampMin = 1, UIMin = 1, UIMax = 64))
+	int32 TileSize = 8;
+
+	//~ Begin UVoxelWorldGenerator Interface
+	virtual TVoxelSharedRef<FVoxelWorldGeneratorInstance> GetInstance() override;
+	//~ End UVoxelWorldGenerator Interface
+};
\ No newline at end of file
@@ -82,6 +82,17 @@ public:
 			}
 		}
 	}
+
+	virtual void GetValues(TArrayView<const FVector> Positions, int32 LOD, const FVoxelItemStack& Items, TArrayView<v_flt> OutValues) const override
+	{
+		check(Positions.Num() == OutValues.Num());
+		// No function pointer call: GetValueImpl can be inlined, and simple generators vectorized
+		for (int32 Index = 0; Index < Positions.Num(); Index++)
+		{
+			const FVector& Position = Positions[Index];
+			OutValues[Index] = This().GetValueImpl(Position.X, Position.Y, Position.Z, LOD, Items);
+		}
+	}
 	
 private:
 	inline const TWorldInstance& This() const
@@ -231,6 +242,16 @@ public:
 	{
 		return This().template GetValueRangeImpl<true>(LocalToWorld, WorldBounds, LOD, Items);
 	}
+
+	virtual void GetValues(TArrayView<const FVector> Positions, int32 LOD, const FVoxelItemStack& Items, TArrayView<v_flt> OutValues) const override
+	{
+		check(Positions.Num() == OutValues.Num());
+		for (int32 Index = 0; Index < Positions.Num(); Index++)
+		{
+			const FVector& Position = Positions[Index];
+			OutValues[Index] = This().GetValueNoTransformImpl(Position.X, Position.Y, Position.Z, LOD, Items);
+		}
+	}
 	
 private:
 	inline const TWorldInstance& This() const
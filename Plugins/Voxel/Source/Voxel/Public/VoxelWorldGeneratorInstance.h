@@ -15,6 +15,50 @@
 
 class UMaterialInstanceDynamic;
 
+/**
+ * Columns returned by heightfield world generators
+ * In these columns, Value(X, Y, Z) = (Z - Height(X, Y)) / Precision and Material(X, Y, Z) = Material(X, Y)
+ */
+struct FVoxelHeightfieldColumns
+{
+	FIntPoint Min;
+	FIntPoint Size;
+	int32 Step = 1;
+	float Precision = 1;
+	
+	// Use TNumericLimits<float>::Lowest() for columns that are entirely empty
+	TArray<float> Heights;
+	// Can be left empty, the materials will then be queried per voxel
+	TArray<FVoxelMaterial> Materials;
+
+	FORCEINLINE int32 GetIndex(int32 LocalX, int32 LocalY) const
+	{
+		checkVoxelSlow(0 <= LocalX && LocalX < Size.X);
+		checkVoxelSlow(0 <= LocalY && LocalY < Size.Y);
+		return LocalX + Size.X * LocalY;
+	}
+	FORCEINLINE FVoxelValue GetValue(int32 LocalX, int32 LocalY, int32 Z) const
+	{
+		return FVoxelValue((Z - Heights.GetData()[GetIndex(LocalX, LocalY)]) / Precision);
+	}
+	// Global coordinates. Returns false if not on a column
+	FORCEINLINE bool GetMaterial(int32 X, int32 Y, FVoxelMaterial& OutMaterial) const
+	{
+		if (Materials.Num() == 0 || (X - Min.X) % Step != 0 || (Y - Min.Y) % Step != 0)
+		{
+			return false;
+		}
+		const int32 LocalX = (X - Min.X) / Step;
+		const int32 LocalY = (Y - Min.Y) / Step;
+		if (LocalX < 0 || LocalX >= Size.X || LocalY < 0 || LocalY >= Size.Y)
+		{
+			return false;
+		}
+		OutMaterial = Materials.GetData()[GetIndex(LocalX, LocalY)];
+		return true;
+	}
+};
+
 /**
  * A FVoxelWorldGeneratorInstance is a constant object created by a UVoxelWorldGenerator
  */
@@ -26,6 +70,9 @@ public:
 	
 	template<typename T>
 	using TRangeOutputFunctionPtr = TVoxelRange<T>(FVoxelWorldGeneratorInstance::*)(const FIntBox& Bounds, int32 LOD, const FVoxelItemStack& Items) const;
+	
+	template<typename T>
+	using TBatchOutputFunctionPtr = void(FVoxelWorldGeneratorInstance::*)(TArrayView<const FVector> Positions, int32 LOD, const FVoxelItemStack& Items, TArrayView<T> OutValues) const;
 
 public:
 	FVoxelWorldGeneratorInstance(
@@ -70,6 +117,14 @@ public:
 	const TMap<FName, TOutputFunctionPtr<T>>& GetOutputsPtrMap() const;
 	template<typename T>
 	const TMap<FName, TRangeOutputFunctionPtr<T>>& GetOutputsRangesPtrMap() const;
+	template<typename T>
+	const TMap<FName, TBatchOutputFunctionPtr<T>>& GetBatchOutputsPtrMap() const;
+
+protected:
+	// Optional batched versions of the custom outputs, stored in the handles by GetCustomOutputHandle
+	// Filled by the child constructor. Outputs without one use GetCustomOutputsImpl
+	TMap<FName, TBatchOutputFunctionPtr<v_flt>> FloatBatchOutputsPtr;
+	TMap<FName, TBatchOutputFunctionPtr<int32>> Int32BatchOutputsPtr;
 
 public:
 	//~ Begin FVoxelWorldGeneratorInstance Interface
@@ -88,9 +143,25 @@ public:
 	virtual void GetValues   (TVoxelQueryZone<FVoxelValue   >& QueryZone, int32 LOD, const FVoxelItemStack& Items) const = 0;
 	// This function is only called when a chunk material is edited for the first time. Fine to leave as default
 	virtual void GetMaterials(TVoxelQueryZone<FVoxelMaterial>& QueryZone, int32 LOD, const FVoxelItemStack& Items) const = 0;
+	
+	// Batched GetValue for scattered positions, eg for spawners or projections. Positions and OutValues must have the same size
+	// Default implementation calls GetValue on every position; override it if setup can be shared between positions
+	// Needs to be thread safe!
+	virtual void GetValues(TArrayView<const FVector> Positions, int32 LOD, const FVoxelItemStack& Items, TArrayView<v_flt> OutValues) const;
+	// Batched custom outputs, called by GetCustomOutputs with the pointer of a valid handle that has no BatchPtr. Positions and OutValues have the same size
+	// Default implementation calls Ptr on every position; override it if setup can be shared between positions
+	// Needs to be thread safe!
+	virtual void GetCustomOutputsImpl(TOutputFunctionPtr<v_flt> Ptr, TArrayView<const FVector> Positions, int32 LOD, const FVoxelItemStack& Items, TArrayView<v_flt> OutValues) const;
+	virtual void GetCustomOutputsImpl(TOutputFunctionPtr<int32> Ptr, TArrayView<const FVector> Positions, int32 LOD, const FVoxelItemStack& Items, TArrayView<int32> OutValues) const;
 
 	// World up vector at position (must be normalized). Used for spawners
 	virtual FVector GetUpVector(v_flt X, v_flt Y, v_flt Z) const = 0;
+
+	// Heightfield fast path: if true, the meshers will try to use GetHeightfieldColumns instead of computing every voxel
+	virtual bool IsHeightfield() const { return false; }
+	// Fill the columns of Bounds, spaced by 1 << LOD. Return false if Bounds cannot be represented as columns
+	// Needs to be thread safe!
+	virtual bool GetHeightfieldColumns(const FIntBox& Bounds, int32 LOD, FVoxelHeightfieldColumns& OutColumns) const { return false; }
 	//~ End FVoxelWorldGeneratorInstance Interface
 	
 public:
@@ -114,6 +185,31 @@ public:
 	T GetCustomOutput(T DefaultValue, FName Name, const U& P, int32 LOD, const FVoxelItemStack& Items) const;
 	template<typename T>
 	TVoxelRange<T> GetCustomOutputRange(TVoxelRange<T> DefaultValue, FName Name, const FIntBox& Bounds, int32 LOD, const FVoxelItemStack& Items) const;
+
+public:
+	// Custom output resolved once, to avoid looking up the name on every call
+	// Only valid for the instance that created it
+	template<typename T>
+	struct TCustomOutputHandle
+	{
+		TOutputFunctionPtr<T> Ptr = nullptr;
+		// Batched version of Ptr, if the instance has one
+		TBatchOutputFunctionPtr<T> BatchPtr = nullptr;
+
+		inline bool IsValid() const
+		{
+			return Ptr != nullptr;
+		}
+	};
+
+	// Returns an invalid handle if there is no output named Name
+	template<typename T>
+	TCustomOutputHandle<T> GetCustomOutputHandle(FName Name) const;
+	
+	template<typename T>
+	T GetCustomOutput(const TCustomOutputHandle<T>& Handle, T DefaultValue, v_flt X, v_flt Y, v_flt Z, int32 LOD, const FVoxelItemStack& Items) const;
+	template<typename T>
+	void GetCustomOutputs(const TCustomOutputHandle<T>& Handle, T DefaultValue, TArrayView<const FVector> Positions, int32 LOD, const FVoxelItemStack& Items, TArrayView<T> OutValues) const;
 };
 
 class VOXEL_API FVoxelTransformableWorldGeneratorInstance : public FVoxelWorldGeneratorInstance
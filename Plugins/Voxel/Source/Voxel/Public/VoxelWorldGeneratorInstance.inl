@@ -47,6 +47,58 @@ FORCEINLINE TVoxelRange<T> FVoxelWorldGeneratorInstance::GetCustomOutputRange(TV
 
 ///////////////////////////////////////////////////////////////////////////////
 
+template<typename T>
+FORCEINLINE FVoxelWorldGeneratorInstance::TCustomOutputHandle<T> FVoxelWorldGeneratorInstance::GetCustomOutputHandle(FName Name) const
+{
+	TCustomOutputHandle<T> Handle;
+	Handle.Ptr = GetOutputsPtrMap<T>().FindRef(Name);
+	Handle.BatchPtr = GetBatchOutputsPtrMap<T>().FindRef(Name);
+	checkVoxelSlow(Handle.Ptr || !Handle.BatchPtr);
+	return Handle;
+}
+
+template<typename T>
+FORCEINLINE T FVoxelWorldGeneratorInstance::GetCustomOutput(const TCustomOutputHandle<T>& Handle, T DefaultValue, v_flt X, v_flt Y, v_flt Z, int32 LOD, const FVoxelItemStack& Items) const
+{
+	checkVoxelSlow(!Handle.IsValid() || GetOutputsPtrMap<T>().FindKey(Handle.Ptr));
+	if (Handle.IsValid())
+	{
+		return (this->*Handle.Ptr)(X, Y, Z, LOD, Items);
+	}
+	else
+	{
+		return DefaultValue;
+	}
+}
+
+template<typename T>
+void FVoxelWorldGeneratorInstance::GetCustomOutputs(const TCustomOutputHandle<T>& Handle, T DefaultValue, TArrayView<const FVector> Positions, int32 LOD, const FVoxelItemStack& Items, TArrayView<T> OutValues) const
+{
+	check(Positions.Num() == OutValues.Num());
+	checkVoxelSlow(!Handle.IsValid() || GetOutputsPtrMap<T>().FindKey(Handle.Ptr));
+	
+	if (!Handle.IsValid())
+	{
+		for (T& Value : OutValues)
+		{
+			Value = DefaultValue;
+		}
+		return;
+	}
+
+	if (Handle.BatchPtr)
+	{
+		checkVoxelSlow(GetBatchOutputsPtrMap<T>().FindKey(Handle.BatchPtr));
+		(this->*Handle.BatchPtr)(Positions, LOD, Items, OutValues);
+	}
+	else
+	{
+		GetCustomOutputsImpl(Handle.Ptr, Positions, LOD, Items, OutValues);
+	}
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
 template<typename T>
 FORCEINLINE T FVoxelTransformableWorldGeneratorInstance::GetCustomOutput_Transform(const FTransform& LocalToWorld, T DefaultValue, FName Name, v_flt X, v_flt Y, v_flt Z, int32 LOD, const FVoxelItemStack& Items) const
 {
@@ -220,6 +272,18 @@ FORCEINLINE const TMap<FName, FVoxelWorldGeneratorInstance::TRangeOutputFunction
 	return FloatOutputsRangesPtr;
 }
 
+template<>
+FORCEINLINE const TMap<FName, FVoxelWorldGeneratorInstance::TBatchOutputFunctionPtr<v_flt>>& FVoxelWorldGeneratorInstance::GetBatchOutputsPtrMap<v_flt>() const
+{
+	return FloatBatchOutputsPtr;
+}
+
+template<>
+FORCEINLINE const TMap<FName, FVoxelWorldGeneratorInstance::TBatchOutputFunctionPtr<int32>>& FVoxelWorldGeneratorInstance::GetBatchOutputsPtrMap<int32>() const
+{
+	return Int32BatchOutputsPtr;
+}
+
 ///////////////////////////////////////////////////////////////////////////////
 
 template<>
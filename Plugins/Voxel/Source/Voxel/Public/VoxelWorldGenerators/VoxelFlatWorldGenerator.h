@@ -30,6 +30,20 @@ public:
 	{
 		return FVector::UpVector;
 	}
+	virtual bool IsHeightfield() const override final
+	{
+		return true;
+	}
+	virtual bool GetHeightfieldColumns(const FIntBox& Bounds, int32 LOD, FVoxelHeightfieldColumns& OutColumns) const override final
+	{
+		OutColumns.Min = FIntPoint(Bounds.Min.X, Bounds.Min.Y);
+		OutColumns.Step = 1 << LOD;
+		OutColumns.Size = FIntPoint(Bounds.Size().X / OutColumns.Step, Bounds.Size().Y / OutColumns.Step);
+		OutColumns.Precision = 1;
+		OutColumns.Heights.Init(-0.001f, OutColumns.Size.X * OutColumns.Size.Y);
+		OutColumns.Materials.Init(FVoxelMaterial::Default(), OutColumns.Size.X * OutColumns.Size.Y);
+		return true;
+	}
 	//~ End FVoxelWorldGeneratorInstance Interface
 };
 
@@ -0,0 +1,151 @@
+// Copyright 2020 Phyronnaz
+
+#include "VoxelGraphBufferCache.h"
+#include "VoxelItemStack.h"
+
+#include "HAL/IConsoleManager.h"
+
+static TAutoConsoleVariable<int32> CVarBufferCacheSize(
+	TEXT("voxel.graph.BufferCacheSize"),
+	256,
+	TEXT("Max number of XY rects whose X & XY buffers are cached per graph instance. 0 to disable the cache"),
+	ECVF_Default);
+
+bool FVoxelGraphBufferCache::IsEnabled()
+{
+	return CVarBufferCacheSize.GetValueOnAnyThread() > 0;
+}
+
+FVoxelGraphBufferCache::FKey FVoxelGraphBufferCache::MakeKey(uint32 OutputIndex, const FIntBox& Bounds, int32 Step, int32 LOD, const FVoxelItemStack& Items, const FTransform* LocalToWorld)
+{
+	FKey Key;
+	Key.Min = FIntPoint(Bounds.Min.X, Bounds.Min.Y);
+	Key.Max = FIntPoint(Bounds.Max.X, Bounds.Max.Y);
+	Key.Step = Step;
+	Key.LOD = LOD;
+	Key.OutputIndex = OutputIndex;
+	
+	// The buffers are shared by the whole column: use the items affecting any part of it
+	const FIntBox ColumnBounds(
+		FIntVector(Bounds.Min.X, Bounds.Min.Y, FIntBox::Infinite.Min.Z),
+		FIntVector(Bounds.Max.X, Bounds.Max.Y, FIntBox::Infinite.Max.Z));
+	Key.Stack = FVoxelGraphStackIdentity::Make(ColumnBounds, Items, LocalToWorld);
+
+	return Key;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+
+TVoxelSharedPtr<const FVoxelGraphBufferCache::FEntry> FVoxelGraphBufferCache::Find(const FKey& Key, bool& bOutShouldAdd)
+{
+	bOutShouldAdd = false;
+	
+	auto& Shard = GetShard(Key);
+	FScopeLock Lock(&Shard.Section);
+	
+	if (auto* Entry = Shard.Map.Find(Key))
+	{
+		return *Entry;
+	}
+
+	if (Shard.MissedKeys.Contains(Key))
+	{
+		// Stays in the missed keys until evicted: Add ignores keys that are already in the map
+		bOutShouldAdd = true;
+	}
+	else
+	{
+		Shard.AddMissedKeyNoLock(Key);
+	}
+	return nullptr;
+}
+
+void FVoxelGraphBufferCache::Add(const FKey& Key, const TVoxelSharedRef<const FEntry>& Entry)
+{
+	if (!IsEnabled())
+	{
+		return;
+	}
+	const int32 MaxSize = FMath::Max(1, CVarBufferCacheSize.GetValueOnAnyThread() / NumShards);
+
+	auto& Shard = GetShard(Key);
+	FScopeLock Lock(&Shard.Section);
+	
+	if (Shard.Map.Contains(Key))
+	{
+		// Another thread computed it at the same time
+		return;
+	}
+
+	if (Shard.Keys.Num() > MaxSize)
+	{
+		// Cache size was reduced
+		Shard.Empty();
+	}
+
+	if (Shard.Keys.Num() < MaxSize)
+	{
+		Shard.Keys.Add(Key);
+	}
+	else
+	{
+		// Evict the oldest entry. Threads still using it hold a reference to it
+		Shard.NextKeyIndex %= MaxSize;
+		Shard.Map.Remove(Shard.Keys[Shard.NextKeyIndex]);
+		Shard.Keys[Shard.NextKeyIndex] = Key;
+		Shard.NextKeyIndex++;
+	}
+	Shard.Map.Add(Key, Entry);
+}
+
+void FVoxelGraphBufferCache::Clear()
+{
+	for (auto& Shard : Shards)
+	{
+		FScopeLock Lock(&Shard.Section);
+		Shard.Empty();
+	}
+}
+
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+
+void FVoxelGraphBufferCache::FShard::AddMissedKeyNoLock(const FKey& Key)
+{
+	// Keys are small: remember more missed keys than entries
+	const int32 MaxSize = 4 * FMath::Max(1, CVarBufferCacheSize.GetValueOnAnyThread() / NumShards);
+	if (MissedKeysRing.Num() > MaxSize)
+	{
+		// Cache size was reduced
+		MissedKeys.Empty();
+		MissedKeysRing.Empty();
+		NextMissedKeyIndex = 0;
+	}
+
+	if (MissedKeysRing.Num() < MaxSize)
+	{
+		MissedKeysRing.Add(Key);
+	}
+	else
+	{
+		NextMissedKeyIndex %= MaxSize;
+		MissedKeys.Remove(MissedKeysRing[NextMissedKeyIndex]);
+		MissedKeysRing[NextMissedKeyIndex] = Key;
+		NextMissedKeyIndex++;
+	}
+	MissedKeys.Add(Key);
+}
+
+void FVoxelGraphBufferCache::FShard::Empty()
+{
+	Map.Empty();
+	Keys.Empty();
+	NextKeyIndex = 0;
+	
+	MissedKeys.Empty();
+	MissedKeysRing.Empty();
+	NextMissedKeyIndex = 0;
+}
\ No newline at end of file
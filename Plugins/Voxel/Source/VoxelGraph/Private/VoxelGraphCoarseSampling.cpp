@@ -0,0 +1,334 @@
+// Copyright 2020 Phyronnaz
+
+#include "VoxelGraphCoarseSampling.h"
+#include "VoxelGraphGeneratorHelpers.h"
+#include "VoxelWorldGeneratorInit.h"
+#include "VoxelItemStack.h"
+
+#include "HAL/IConsoleManager.h"
+#include "UObject/UObjectIterator.h"
+#include "UObject/Package.h"
+
+static TAutoConsoleVariable<int32> CVarCoarseSampling(
+	TEXT("voxel.graph.CoarseSampling"),
+	0,
+	TEXT("If 1, the value output of the graphs query zones will be computed on a coarse grid and trilinearly interpolated where the error is small enough. Only applies to new graph instances"),
+	ECVF_Default);
+
+static TAutoConsoleVariable<int32> CVarCoarseSamplingCellSize(
+	TEXT("voxel.graph.CoarseSamplingCellSize"),
+	16,
+	TEXT("Size of the coarse sampling cells in voxels, rounded up to a power of 2. The same grid is used by all the LODs: LODs whose step is the cell size or more are exact"),
+	ECVF_Default);
+
+static TAutoConsoleVariable<float> CVarCoarseSamplingMaxValueError(
+	TEXT("voxel.graph.CoarseSamplingMaxValueError"),
+	0.1f,
+	TEXT("Max error allowed on the value output, checked at the center & at the faces centers of every coarse cell. Cells with a bigger error are computed at full resolution"),
+	ECVF_Default);
+
+FVoxelGraphCoarseSampling FVoxelGraphCoarseSampling::GetSettings()
+{
+	FVoxelGraphCoarseSampling Settings;
+	Settings.bEnable = CVarCoarseSampling.GetValueOnAnyThread() != 0;
+	Settings.CellSize = FMath::Clamp<int32>(FMath::RoundUpToPowerOfTwo(FMath::Max(2, CVarCoarseSamplingCellSize.GetValueOnAnyThread())), 2, 1024);
+	Settings.MaxValueError = FMath::Max(0.f, CVarCoarseSamplingMaxValueError.GetValueOnAnyThread());
+	return Settings;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+
+const FIntVector FVoxelGraphCoarseSampling::CheckPoints[NumCheckPoints] =
+{
+	FIntVector(1, 1, 1),
+	FIntVector(0, 1, 1),
+	FIntVector(2, 1, 1),
+	FIntVector(1, 0, 1),
+	FIntVector(1, 2, 1),
+	FIntVector(1, 1, 0),
+	FIntVector(1, 1, 2)
+};
+
+bool FVoxelGraphCoarseSampling::IsSmooth(const v_flt Corners[8], const v_flt CheckValues[NumCheckPoints]) const
+{
+	for (int32 Index = 0; Index < NumCheckPoints; Index++)
+	{
+		const FIntVector& Point = CheckPoints[Index];
+		const v_flt Interpolated = FVoxelUtilities::TrilinearInterpolation<v_flt>(
+			Corners[0],
+			Corners[1],
+			Corners[2],
+			Corners[3],
+			Corners[4],
+			Corners[5],
+			Corners[6],
+			Corners[7],
+			Point.X * v_flt(0.5),
+			Point.Y * v_flt(0.5),
+			Point.Z * v_flt(0.5));
+		if (!(FMath::Abs(CheckValues[Index] - Interpolated) <= MaxValueError))
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+bool FVoxelGraphCoarseSampling::IsOnCorners(const FIntBox& Bounds, int32 Step) const
+{
+	return
+		Step % CellSize == 0 &&
+		Bounds.Min.X % CellSize == 0 &&
+		Bounds.Min.Y % CellSize == 0 &&
+		Bounds.Min.Z % CellSize == 0;
+}
+
+FIntBox FVoxelGraphCoarseSampling::GetCellsBounds(const FIntBox& Bounds) const
+{
+	const FIntVector Min = FVoxelUtilities::DivideFloor(Bounds.Min, CellSize) * CellSize;
+	// Max is exclusive: the last point is Bounds.Max - 1, and its cell upper corners must be included
+	const FIntVector Max = (FVoxelUtilities::DivideFloor(Bounds.Max - FIntVector(1), CellSize) + FIntVector(1)) * CellSize + FIntVector(1);
+	return FIntBox(Min, Max);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+
+// Compare coarse sampling with full evaluation on render chunks with the normals border, using the current coarse sampling settings
+// Reports the query zones cost, the value error, how far the surface moves along the grid edges, whether the chunks of two
+// consecutive LODs agree on their shared voxels and how far the exact single point queries are from the coarse query zones
+static void BenchmarkCoarseSampling(const TArray<FString>& Args)
+{
+	const FString Filter = Args.Num() > 0 ? Args[0] : FString();
+	constexpr int32 Size = RENDER_CHUNK_SIZE + 2;
+	// Points of the same bounds at the next LOD
+	constexpr int32 ParentSize = (Size + 1) / 2;
+	constexpr int32 NumChunks = 8;
+	constexpr int32 NumRuns = 3;
+	constexpr int32 NumSinglePoints = 1000;
+
+	TArray<UClass*> Classes;
+	for (TObjectIterator<UClass> It; It; ++It)
+	{
+		UClass* Class = *It;
+		if (Class->IsChildOf(UVoxelGraphGeneratorHelper::StaticClass()) &&
+			!Class->HasAnyClassFlags(CLASS_Abstract | CLASS_Deprecated | CLASS_NewerVersionExists) &&
+			(Filter.IsEmpty() || Class->GetName().Contains(Filter)))
+		{
+			Classes.Add(Class);
+		}
+	}
+	Classes.Sort([](const UClass& A, const UClass& B) { return A.GetName() < B.GetName(); });
+
+	const FVoxelGraphCoarseSampling Settings = FVoxelGraphCoarseSampling::GetSettings();
+	UE_LOG(LogVoxel, Log, TEXT("Benchmarking coarse sampling on %d graphs: CellSize = %d, MaxValueError = %f"), Classes.Num(), Settings.CellSize, Settings.MaxValueError);
+
+	// The settings are read when creating the instances
+	const auto CreateInstance = [](UVoxelWorldGenerator& Generator, bool bCoarse)
+	{
+		const int32 OldValue = CVarCoarseSampling.GetValueOnGameThread();
+		CVarCoarseSampling->Set(bCoarse ? 1 : 0, ECVF_SetByConsole);
+		const auto Instance = Generator.GetInstance();
+		CVarCoarseSampling->Set(OldValue, ECVF_SetByConsole);
+		Instance->Init(FVoxelWorldGeneratorInit());
+		return Instance;
+	};
+
+	for (UClass* Class : Classes)
+	{
+		UVoxelGraphGeneratorHelper* Generator = NewObject<UVoxelGraphGeneratorHelper>(GetTransientPackage(), Class);
+		const auto FullInstance = CreateInstance(*Generator, false);
+		const auto CoarseInstance = CreateInstance(*Generator, true);
+
+		UE_LOG(LogVoxel, Log, TEXT("%s:"), *Class->GetName());
+
+		for (int32 LOD = 0; LOD <= 4; LOD++)
+		{
+			const int32 Step = 1 << LOD;
+
+			// 2x2x2 render chunks around the origin, shifted along X by Run to not hit the graph buffer caches
+			const auto GetChunkBounds = [&](int32 ChunkIndex, int32 Run, int32 ChunkLOD, int32 ChunkSize)
+			{
+				const int32 ChunkWorldSize = RENDER_CHUNK_SIZE << LOD;
+				const FIntVector Min =
+					FIntVector(-ChunkWorldSize - Step) +
+					FIntVector(
+						bool(ChunkIndex & 0x1) + 2 * Run,
+						bool(ChunkIndex & 0x2),
+						bool(ChunkIndex & 0x4)) * ChunkWorldSize;
+				return FIntBox(Min, Min + FIntVector(ChunkSize << ChunkLOD));
+			};
+			const auto Query = [&](const FVoxelWorldGeneratorInstance& Instance, int32 QueryLOD, int32 QuerySize, int32 Run, TArray<FVoxelValue>& Values)
+			{
+				Values.SetNumUninitialized(NumChunks * QuerySize * QuerySize * QuerySize);
+				for (int32 ChunkIndex = 0; ChunkIndex < NumChunks; ChunkIndex++)
+				{
+					TVoxelQueryZone<FVoxelValue> QueryZone(GetChunkBounds(ChunkIndex, Run, QueryLOD, QuerySize), FIntVector(QuerySize), QueryLOD, Values.GetData() + ChunkIndex * QuerySize * QuerySize * QuerySize);
+					Instance.Get<FVoxelValue>(QueryZone, QueryLOD, FVoxelItemStack::Empty);
+				}
+			};
+
+			TArray<FVoxelValue> FullValues;
+			TArray<FVoxelValue> CoarseValues;
+			const auto Benchmark = [&](const FVoxelWorldGeneratorInstance& Instance, TArray<FVoxelValue>& Values)
+			{
+				const double StartTime = FPlatformTime::Seconds();
+				for (int32 Run = 0; Run < NumRuns; Run++)
+				{
+					// Only the last run values are kept
+					Query(Instance, LOD, Size, Run, Values);
+				}
+				return FPlatformTime::Seconds() - StartTime;
+			};
+			const double FullTime = Benchmark(*FullInstance, FullValues);
+			const double CoarseTime = Benchmark(*CoarseInstance, CoarseValues);
+
+			double MaxError = 0;
+			double SumError = 0;
+			int64 NumSignChanges = 0;
+			for (int32 Index = 0; Index < FullValues.Num(); Index++)
+			{
+				const double Error = FMath::Abs(FullValues[Index].ToFloat() - CoarseValues[Index].ToFloat());
+				MaxError = FMath::Max(MaxError, Error);
+				SumError += Error;
+				NumSignChanges += FullValues[Index].IsEmpty() != CoarseValues[Index].IsEmpty();
+			}
+
+			// Surface position along the grid edges, as the mesher would compute it without refining
+			double MaxDeviation = 0;
+			double SumDeviation = 0;
+			int64 NumSurfaceEdges = 0;
+			int64 NumTopologyChanges = 0;
+			for (int32 ChunkIndex = 0; ChunkIndex < NumChunks; ChunkIndex++)
+			{
+				const int32 ChunkOffset = ChunkIndex * Size * Size * Size;
+				for (int32 Z = 0; Z < Size; Z++)
+				{
+					for (int32 Y = 0; Y < Size; Y++)
+					{
+						for (int32 X = 0; X < Size; X++)
+						{
+							const int32 IndexA = ChunkOffset + X + Size * Y + Size * Size * Z;
+							for (int32 Direction = 0; Direction < 3; Direction++)
+							{
+								if ((Direction == 0 && X + 1 == Size) ||
+									(Direction == 1 && Y + 1 == Size) ||
+									(Direction == 2 && Z + 1 == Size))
+								{
+									continue;
+								}
+								const int32 IndexB = IndexA + (Direction == 0 ? 1 : Direction == 1 ? Size : Size * Size);
+
+								const bool bFullSurface = FullValues[IndexA].IsEmpty() != FullValues[IndexB].IsEmpty();
+								const bool bCoarseSurface = CoarseValues[IndexA].IsEmpty() != CoarseValues[IndexB].IsEmpty();
+								if (bFullSurface != bCoarseSurface)
+								{
+									NumTopologyChanges++;
+								}
+								else if (bFullSurface)
+								{
+									const auto GetAlpha = [&](const TArray<FVoxelValue>& Values)
+									{
+										const float A = Values[IndexA].ToFloat();
+										const float B = Values[IndexB].ToFloat();
+										return A / (A - B);
+									};
+									const double Deviation = FMath::Abs(GetAlpha(FullValues) - GetAlpha(CoarseValues)) * Step;
+									MaxDeviation = FMath::Max(MaxDeviation, Deviation);
+									SumDeviation += Deviation;
+									NumSurfaceEdges++;
+								}
+							}
+						}
+					}
+				}
+			}
+
+			// Seams: the same chunks at the next LOD must have the same values on the voxels they share with this LOD, else the LOD transitions would crack
+			// Voxels where the full values already differ between the two LODs are skipped, as the graph itself depends on the LOD there
+			int64 NumSharedVoxels = 0;
+			int64 NumSeamMismatches = 0;
+			{
+				TArray<FVoxelValue> FullParentValues;
+				TArray<FVoxelValue> CoarseParentValues;
+				Query(*FullInstance, LOD + 1, ParentSize, NumRuns - 1, FullParentValues);
+				Query(*CoarseInstance, LOD + 1, ParentSize, NumRuns - 1, CoarseParentValues);
+
+				for (int32 ChunkIndex = 0; ChunkIndex < NumChunks; ChunkIndex++)
+				{
+					for (int32 Z = 0; Z < ParentSize; Z++)
+					{
+						for (int32 Y = 0; Y < ParentSize; Y++)
+						{
+							for (int32 X = 0; X < ParentSize; X++)
+							{
+								const int32 Index = ChunkIndex * Size * Size * Size + 2 * X + Size * 2 * Y + Size * Size * 2 * Z;
+								const int32 ParentIndex = ChunkIndex * ParentSize * ParentSize * ParentSize + X + ParentSize * Y + ParentSize * ParentSize * Z;
+								if (FullValues[Index] != FullParentValues[ParentIndex])
+								{
+									continue;
+								}
+								NumSharedVoxels++;
+								NumSeamMismatches += CoarseValues[Index] != CoarseParentValues[ParentIndex];
+							}
+						}
+					}
+				}
+			}
+
+			// Single point queries are exact: compare them with the coarse query zones
+			FRandomStream Stream(1337);
+			double MaxSinglePointError = 0;
+			int32 NumSinglePointSignChanges = 0;
+			double FullSingleTime = 0;
+			double CoarseSingleTime = 0;
+			for (int32 PointIndex = 0; PointIndex < NumSinglePoints; PointIndex++)
+			{
+				const int32 ChunkIndex = Stream.RandHelper(NumChunks);
+				const FIntVector Local(Stream.RandHelper(Size), Stream.RandHelper(Size), Stream.RandHelper(Size));
+				const FIntVector Position = GetChunkBounds(ChunkIndex, NumRuns - 1, LOD, Size).Min + Local * Step;
+
+				const double FullStartTime = FPlatformTime::Seconds();
+				FullInstance->GetValue(Position.X, Position.Y, Position.Z, LOD, FVoxelItemStack::Empty);
+				FullSingleTime += FPlatformTime::Seconds() - FullStartTime;
+
+				const double CoarseStartTime = FPlatformTime::Seconds();
+				const FVoxelValue Value(CoarseInstance->GetValue(Position.X, Position.Y, Position.Z, LOD, FVoxelItemStack::Empty));
+				CoarseSingleTime += FPlatformTime::Seconds() - CoarseStartTime;
+
+				const FVoxelValue& CoarseValue = CoarseValues[ChunkIndex * Size * Size * Size + Local.X + Size * Local.Y + Size * Size * Local.Z];
+				MaxSinglePointError = FMath::Max<double>(MaxSinglePointError, FMath::Abs(Value.ToFloat() - CoarseValue.ToFloat()));
+				NumSinglePointSignChanges += Value.IsEmpty() != CoarseValue.IsEmpty();
+			}
+
+			UE_LOG(LogVoxel, Log, TEXT("\tLOD %d: query zones: full %8.3fms, coarse %8.3fms (%5.2fx); single points: full %6.3fus, coarse %6.3fus"),
+				LOD,
+				FullTime * 1000,
+				CoarseTime * 1000,
+				CoarseTime > 0 ? FullTime / CoarseTime : 0.,
+				FullSingleTime * 1e6 / NumSinglePoints,
+				CoarseSingleTime * 1e6 / NumSinglePoints);
+			UE_LOG(LogVoxel, Log, TEXT("\t\tValue error: max %f, mean %f; sign changes: %lld of %d"),
+				MaxError,
+				SumError / FullValues.Num(),
+				NumSignChanges,
+				FullValues.Num());
+			UE_LOG(LogVoxel, Log, TEXT("\t\tSurface deviation along the edges: max %f voxels, mean %f voxels on %lld edges; %lld edges gained or lost the surface"),
+				MaxDeviation,
+				NumSurfaceEdges > 0 ? SumDeviation / NumSurfaceEdges : 0.,
+				NumSurfaceEdges,
+				NumTopologyChanges);
+			UE_LOG(LogVoxel, Log, TEXT("\t\tVoxels shared with LOD %d that differ: %lld of %lld"), LOD + 1, NumSeamMismatches, NumSharedVoxels);
+			UE_LOG(LogVoxel, Log, TEXT("\t\tExact single points vs coarse query zones: max error %f, sign changes: %d of %d"), MaxSinglePointError, NumSinglePointSignChanges, NumSinglePoints);
+			ensure(NumSeamMismatches == 0);
+		}
+	}
+}
+
+static FAutoConsoleCommand BenchmarkCoarseSamplingCmd(
+	TEXT("voxel.graph.BenchmarkCoarseSampling"),
+	TEXT("Compare graph coarse sampling with full evaluation: cost, error, surface deviation & seams between LODs. Uses the voxel.graph.CoarseSampling* settings. Args: [ClassFilter]"),
+	FConsoleCommandWithArgsDelegate::CreateStatic(&BenchmarkCoarseSampling));
\ No newline at end of file
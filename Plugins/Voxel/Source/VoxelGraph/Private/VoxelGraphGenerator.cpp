@@ -203,6 +203,9 @@ TMap<FName, int32> UVoxelGraphGenerator::GetDefaultSeeds() const
 
 TVoxelSharedRef<FVoxelTransformableWorldGeneratorInstance> UVoxelGraphGenerator::GetTransformableInstance()
 {
+	// Graphs can only be evaluated through their C++ translation here:
+	// the graph compiler (FVoxelCompilationNode/FVoxelComputeNode) and the node compute implementations are not part of this build,
+	// so there is nothing a runtime interpreter could be built on
 	FVoxelMessages::ShowVoxelPluginProError("Voxel Graphs require Voxel Plugin Pro");
 	return MakeVoxelShared<FVoxelTransformableEmptyWorldGeneratorInstance>();
 }
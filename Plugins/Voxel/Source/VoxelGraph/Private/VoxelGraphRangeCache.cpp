@@ -0,0 +1,261 @@
+// Copyright 2020 Phyronnaz
+
+#include "VoxelGraphRangeCache.h"
+#include "VoxelPlaceableItems/VoxelPlaceableItem.h"
+#include "VoxelItemStack.h"
+#include "VoxelGlobals.h"
+
+#include "HAL/IConsoleManager.h"
+#include "HAL/ThreadSafeCounter64.h"
+
+static TAutoConsoleVariable<int32> CVarRangeCacheSize(
+	TEXT("voxel.graph.RangeCacheSize"),
+	4096,
+	TEXT("Max number of range analysis results cached per graph instance. 0 to disable the cache"),
+	ECVF_Default);
+
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+
+struct FVoxelGraphRangeCacheStats
+{
+	static FThreadSafeCounter64 Hits;
+	static FThreadSafeCounter64 ChildrenHits;
+	static FThreadSafeCounter64 Misses;
+	static FThreadSafeCounter64 MissesCycles;
+
+	static void Clear()
+	{
+		Hits.Reset();
+		ChildrenHits.Reset();
+		Misses.Reset();
+		MissesCycles.Reset();
+	}
+	static void PrintStats()
+	{
+		const int64 NumHits = Hits.GetValue();
+		const int64 NumChildrenHits = ChildrenHits.GetValue();
+		const int64 NumMisses = Misses.GetValue();
+		const int64 NumQueries = NumHits + NumChildrenHits + NumMisses;
+
+		const double MissesTime = FPlatformTime::ToSeconds64(MissesCycles.GetValue());
+		const double AverageMissTime = NumMisses > 0 ? MissesTime / NumMisses : 0;
+		// Assume a hit would have cost an average miss
+		const double SavedTime = (NumHits + NumChildrenHits) * AverageMissTime;
+
+		UE_LOG(LogVoxel, Log, TEXT("############################ Voxel Graph Range Cache ############################"));
+		UE_LOG(LogVoxel, Log, TEXT("Queries: %lld"), NumQueries);
+		UE_LOG(LogVoxel, Log, TEXT("Hits: %lld (%5.2f%%)"), NumHits, NumQueries > 0 ? NumHits / double(NumQueries) * 100 : 0);
+		UE_LOG(LogVoxel, Log, TEXT("Children Hits: %lld (%5.2f%%)"), NumChildrenHits, NumQueries > 0 ? NumChildrenHits / double(NumQueries) * 100 : 0);
+		UE_LOG(LogVoxel, Log, TEXT("Misses: %lld (%5.2f%%); %8.3fs; %8.3fus per miss"), NumMisses, NumQueries > 0 ? NumMisses / double(NumQueries) * 100 : 0, MissesTime, AverageMissTime * 1e6);
+		UE_LOG(LogVoxel, Log, TEXT("Estimated time saved: %8.3fs"), SavedTime);
+		UE_LOG(LogVoxel, Log, TEXT("##################################################################################"));
+	}
+};
+
+FThreadSafeCounter64 FVoxelGraphRangeCacheStats::Hits;
+FThreadSafeCounter64 FVoxelGraphRangeCacheStats::ChildrenHits;
+FThreadSafeCounter64 FVoxelGraphRangeCacheStats::Misses;
+FThreadSafeCounter64 FVoxelGraphRangeCacheStats::MissesCycles;
+
+static FAutoConsoleCommand ClearRangeCacheStatsCmd(
+	TEXT("voxel.graph.ClearRangeCacheStats"),
+	TEXT("Clear the graphs range cache stats"),
+	FConsoleCommandDelegate::CreateStatic(&FVoxelGraphRangeCacheStats::Clear));
+
+static FAutoConsoleCommand PrintRangeCacheStatsCmd(
+	TEXT("voxel.graph.PrintRangeCacheStats"),
+	TEXT("Print the graphs range cache hit rate and the estimated time saved"),
+	FConsoleCommandDelegate::CreateStatic(&FVoxelGraphRangeCacheStats::PrintStats));
+
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+
+FVoxelGraphStackIdentity FVoxelGraphStackIdentity::Make(const FIntBox& Bounds, const FVoxelItemStack& Items, const FTransform* LocalToWorld)
+{
+	FVoxelGraphStackIdentity Identity;
+	Identity.WorldGenerator = Items.WorldGenerator;
+	Identity.CustomData = Items.CustomData;
+	Identity.Depth = Items.Depth;
+	
+	uint32 Hash = GetTypeHash(Items.Depth);
+	Hash = HashCombine(Hash, PointerHash(Items.WorldGenerator));
+	Hash = HashCombine(Hash, PointerHash(Items.CustomData));
+	if (!Items.IsEmpty())
+	{
+		for (auto& ItemArray : Items.ItemHolder.GetAllItems())
+		{
+			for (auto* Item : ItemArray)
+			{
+				if (Item->Bounds.Intersect(Bounds))
+				{
+					Identity.Items.Add(Item->SerialNumber);
+					Hash = HashCombine(Hash, GetTypeHash(Item->SerialNumber));
+				}
+			}
+		}
+	}
+	if (LocalToWorld)
+	{
+		Identity.bHasTransform = true;
+		Identity.Translation = LocalToWorld->GetTranslation();
+		Identity.Rotation = LocalToWorld->GetRotation();
+		Identity.Scale = LocalToWorld->GetScale3D();
+		Hash = FCrc::MemCrc32(&Identity.Translation, sizeof(FVector), Hash);
+		Hash = FCrc::MemCrc32(&Identity.Rotation, sizeof(FQuat), Hash);
+		Hash = FCrc::MemCrc32(&Identity.Scale, sizeof(FVector), Hash);
+	}
+	Identity.Hash = Hash;
+	
+	return Identity;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+
+FVoxelGraphRangeCache::FKey FVoxelGraphRangeCache::MakeKey(uint32 OutputIndex, const FIntBox& Bounds, int32 LOD, const FVoxelItemStack& Items, const FTransform* LocalToWorld)
+{
+	FKey Key;
+	Key.Bounds = Bounds;
+	Key.LOD = LOD;
+	Key.OutputIndex = OutputIndex;
+	Key.Stack = FVoxelGraphStackIdentity::Make(Bounds, Items, LocalToWorld);
+
+	return Key;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+
+bool FVoxelGraphRangeCache::Find(const FKey& Key, TVoxelRange<v_flt>& OutRange)
+{
+	if (CVarRangeCacheSize.GetValueOnAnyThread() <= 0)
+	{
+		return false;
+	}
+
+	if (FindInShard(Key, OutRange))
+	{
+		FVoxelGraphRangeCacheStats::Hits.Increment();
+		return true;
+	}
+
+	// Try to reuse the children results: the union of their ranges is a valid (and usually tighter) range for the parent
+	// Only if no item intersects the parent: else the children identities would only contain a subset of its items
+	const FIntVector Size = Key.Bounds.Size();
+	if (Key.Stack.Items.Num() == 0 && Size.X % 2 == 0 && Size.Y % 2 == 0 && Size.Z % 2 == 0)
+	{
+		const FIntVector HalfSize = Size / 2;
+
+		TOptional<TVoxelRange<v_flt>> Union;
+		for (int32 Index = 0; Index < 8; Index++)
+		{
+			FKey ChildKey = Key;
+			ChildKey.Bounds.Min = Key.Bounds.Min + FIntVector(
+				bool(Index & 0x1) * HalfSize.X,
+				bool(Index & 0x2) * HalfSize.Y,
+				bool(Index & 0x4) * HalfSize.Z);
+			ChildKey.Bounds.Max = ChildKey.Bounds.Min + HalfSize;
+
+			TVoxelRange<v_flt> ChildRange;
+			if (!FindInShard(ChildKey, ChildRange))
+			{
+				FVoxelGraphRangeCacheStats::Misses.Increment();
+				return false;
+			}
+			Union = Union.IsSet() ? TVoxelRange<v_flt>::Union(Union.GetValue(), ChildRange) : ChildRange;
+		}
+
+		FVoxelGraphRangeCacheStats::ChildrenHits.Increment();
+		OutRange = Union.GetValue();
+
+		auto& Shard = GetShard(Key);
+		FScopeLock Lock(&Shard.Section);
+		Shard.AddNoLock(Key, OutRange);
+		return true;
+	}
+
+	FVoxelGraphRangeCacheStats::Misses.Increment();
+	return false;
+}
+
+void FVoxelGraphRangeCache::Add(const FKey& Key, const TVoxelRange<v_flt>& Range, uint64 ComputeCycles)
+{
+	FVoxelGraphRangeCacheStats::MissesCycles.Add(ComputeCycles);
+
+	if (CVarRangeCacheSize.GetValueOnAnyThread() <= 0)
+	{
+		return;
+	}
+
+	auto& Shard = GetShard(Key);
+	FScopeLock Lock(&Shard.Section);
+	Shard.AddNoLock(Key, Range);
+}
+
+void FVoxelGraphRangeCache::Clear()
+{
+	for (auto& Shard : Shards)
+	{
+		FScopeLock Lock(&Shard.Section);
+		Shard.Empty();
+	}
+}
+
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+
+bool FVoxelGraphRangeCache::FindInShard(const FKey& Key, TVoxelRange<v_flt>& OutRange)
+{
+	auto& Shard = GetShard(Key);
+	FScopeLock Lock(&Shard.Section);
+	
+	if (auto* Range = Shard.Map.Find(Key))
+	{
+		OutRange = *Range;
+		return true;
+	}
+	return false;
+}
+
+void FVoxelGraphRangeCache::FShard::AddNoLock(const FKey& Key, const TVoxelRange<v_flt>& Range)
+{
+	if (Map.Contains(Key))
+	{
+		// Another thread computed it at the same time
+		return;
+	}
+
+	const int32 MaxSize = FMath::Max(1, CVarRangeCacheSize.GetValueOnAnyThread() / NumShards);
+	if (Keys.Num() > MaxSize)
+	{
+		// Cache size was reduced
+		Empty();
+	}
+
+	if (Keys.Num() < MaxSize)
+	{
+		Keys.Add(Key);
+	}
+	else
+	{
+		// Evict the oldest entry
+		NextKeyIndex %= MaxSize;
+		Map.Remove(Keys[NextKeyIndex]);
+		Keys[NextKeyIndex] = Key;
+		NextKeyIndex++;
+	}
+	Map.Add(Key, Range);
+}
+
+void FVoxelGraphRangeCache::FShard::Empty()
+{
+	Map.Empty();
+	Keys.Empty();
+	NextKeyIndex = 0;
+}
\ No newline at end of file
@@ -0,0 +1,96 @@
+// Copyright 2020 Phyronnaz
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "HAL/CriticalSection.h"
+#include "IntBox.h"
+#include "VoxelSharedPtr.h"
+#include "VoxelGraphRangeCache.h"
+
+struct FVoxelItemStack;
+
+// Bounded cache of the X & XY buffers of a graph instance
+// Chunks stacked vertically query the same XY rect: that way the 2D part of the graph (heightmaps, 2D noises...) is only computed once per column
+class VOXELGRAPH_API FVoxelGraphBufferCache
+{
+public:
+	struct FKey
+	{
+		FIntPoint Min;
+		FIntPoint Max;
+		int32 Step = 1;
+		int32 LOD = 0;
+		uint32 OutputIndex = 0;
+		// Items & transform affecting the whole column
+		FVoxelGraphStackIdentity Stack;
+
+		inline bool operator==(const FKey& Other) const
+		{
+			return
+				Min == Other.Min &&
+				Max == Other.Max &&
+				Step == Other.Step &&
+				LOD == Other.LOD &&
+				OutputIndex == Other.OutputIndex &&
+				Stack == Other.Stack;
+		}
+		inline friend uint32 GetTypeHash(const FKey& Key)
+		{
+			return HashCombine(
+				HashCombine(GetTypeHash(Key.Min), GetTypeHash(Key.Max)),
+				HashCombine(HashCombine(GetTypeHash(Key.Step), GetTypeHash(Key.LOD)), HashCombine(GetTypeHash(Key.OutputIndex), Key.Stack.Hash)));
+		}
+	};
+
+	struct FEntry
+	{
+		virtual ~FEntry() = default;
+	};
+	// The output index determines the graph target, and thus the buffer types
+	template<typename TBufferX, typename TBufferXY>
+	struct TEntry : FEntry
+	{
+		TArray<TBufferX> BuffersX;
+		// In iteration order: X major
+		TArray<TBufferXY> BuffersXY;
+	};
+
+	static bool IsEnabled();
+	// Bounds: query bounds. Only their XY rect is used
+	static FKey MakeKey(uint32 OutputIndex, const FIntBox& Bounds, int32 Step, int32 LOD, const FVoxelItemStack& Items, const FTransform* LocalToWorld);
+
+public:
+	// bOutShouldAdd: set on the second miss of a key. Rects queried only once (eg, single chunks) are not worth storing
+	TVoxelSharedPtr<const FEntry> Find(const FKey& Key, bool& bOutShouldAdd);
+	void Add(const FKey& Key, const TVoxelSharedRef<const FEntry>& Entry);
+	void Clear();
+
+private:
+	// The cache is queried by all the generator threads: split it so that they rarely wait on each other
+	static constexpr int32 NumShards = 16;
+
+	struct FShard
+	{
+		FCriticalSection Section;
+		TMap<FKey, TVoxelSharedPtr<const FEntry>> Map;
+		// Ring buffer used to evict the oldest entries
+		TArray<FKey> Keys;
+		int32 NextKeyIndex = 0;
+
+		// Keys that missed once
+		TSet<FKey> MissedKeys;
+		// Ring buffer used to evict the oldest missed keys
+		TArray<FKey> MissedKeysRing;
+		int32 NextMissedKeyIndex = 0;
+
+		void AddMissedKeyNoLock(const FKey& Key);
+		void Empty();
+	};
+	FShard Shards[NumShards];
+
+	FORCEINLINE FShard& GetShard(const FKey& Key)
+	{
+		return Shards[GetTypeHash(Key) % NumShards];
+	}
+};
\ No newline at end of file
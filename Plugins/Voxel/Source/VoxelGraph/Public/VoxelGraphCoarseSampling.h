@@ -0,0 +1,59 @@
+// Copyright 2020 Phyronnaz
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "IntBox.h"
+#include "VoxelGlobals.h"
+#include "VoxelBaseUtilities.h"
+#include "VoxelIntVectorUtilities.h"
+
+// Coarse sampling of the value output of the graph query zones, enabled with voxel.graph.CoarseSampling
+// The world is split in cells of CellSize voxels aligned on the world grid. This grid is the same for all the LODs: the value of a voxel only depends on its position,
+// so neighbouring chunks of different LODs always agree on their shared voxels
+// The output is computed at the cells corners, and trilinearly interpolated inside the cells whose error is small enough. The error of a cell is checked at its center
+// and at the center of its 6 faces, so that a feature between two neighbouring cells is caught by both of them. Cells with a bigger error are computed at full resolution
+// Single point & scattered positions queries are always exact: a single point would need its whole cell, ie 15 evaluations
+struct VOXELGRAPH_API FVoxelGraphCoarseSampling
+{
+	bool bEnable = false;
+	// Power of 2
+	int32 CellSize = 16;
+	v_flt MaxValueError = 0.1f;
+
+	// Settings of the console variables. Instances keep the settings they were created with
+	static FVoxelGraphCoarseSampling GetSettings();
+
+public:
+	static constexpr int32 NumCheckPoints = 7;
+	// Offsets of the error check points in a cell, in half cell sizes: the center, then the -X, +X, -Y, +Y, -Z & +Z faces centers
+	static const FIntVector CheckPoints[NumCheckPoints];
+
+	FORCEINLINE FIntVector GetCell(int32 X, int32 Y, int32 Z) const
+	{
+		return FVoxelUtilities::DivideFloor(FIntVector(X, Y, Z), CellSize);
+	}
+	// Corners: in FVoxelUtilities::TrilinearInterpolation order, ie corner N is at the cell min + (N & 1, N & 2, N & 4) * cell size
+	FORCEINLINE v_flt Interpolate(const v_flt Corners[8], const FIntVector& Cell, int32 X, int32 Y, int32 Z) const
+	{
+		return FVoxelUtilities::TrilinearInterpolation<v_flt>(
+			Corners[0],
+			Corners[1],
+			Corners[2],
+			Corners[3],
+			Corners[4],
+			Corners[5],
+			Corners[6],
+			Corners[7],
+			v_flt(X - Cell.X * CellSize) / CellSize,
+			v_flt(Y - Cell.Y * CellSize) / CellSize,
+			v_flt(Z - Cell.Z * CellSize) / CellSize);
+	}
+	// CheckValues: exact values at CheckPoints
+	bool IsSmooth(const v_flt Corners[8], const v_flt CheckValues[NumCheckPoints]) const;
+	// True if all the points of the query are cells corners. Their coarse values are then the exact ones, and the cells don't need to be computed
+	bool IsOnCorners(const FIntBox& Bounds, int32 Step) const;
+	// Bounds containing all the points used to compute the coarse values in Bounds
+	// As the interpolated values are between the corners ones, the range of the exact values on them is a valid range for both the coarse & exact values in Bounds
+	FIntBox GetCellsBounds(const FIntBox& Bounds) const;
+};
\ No newline at end of file
@@ -7,6 +7,9 @@
 #include "VoxelGlobals.h"
 #include "VoxelContext.h"
 #include "VoxelGraphConstants.h"
+#include "VoxelGraphRangeCache.h"
+#include "VoxelGraphBufferCache.h"
+#include "VoxelGraphCoarseSampling.h"
 #include "VoxelWorldGeneratorHelpers.h"
 #include "VoxelWorldGeneratorInstance.inl"
 #include "VoxelGraphGeneratorHelpers.generated.h"
@@ -24,15 +27,24 @@ class TVoxelGraphGeneratorInstanceHelper : public TVoxelTransformableWorldGenera
 public:
 	using FVoxelWorldGeneratorInstance::TOutputFunctionPtr;
 	using FVoxelWorldGeneratorInstance::TRangeOutputFunctionPtr;
+	using FVoxelWorldGeneratorInstance::TBatchOutputFunctionPtr;
 	using FVoxelTransformableWorldGeneratorInstance::TOutputFunctionPtr_Transform;
 	using FVoxelTransformableWorldGeneratorInstance::TRangeOutputFunctionPtr_Transform;
 
+	// Single point custom output & its batched version, given by NoTransformAccessor
+	template<typename T>
+	struct TNoTransformOutputPtrs
+	{
+		TOutputFunctionPtr<T> Ptr;
+		TBatchOutputFunctionPtr<T> BatchPtr;
+	};
+
 	TVoxelGraphGeneratorInstanceHelper(
 		const TMap<FName, uint32>& FloatOutputs,
 		const TMap<FName, uint32>& Int32Outputs,
 
-		const TMap<FName, TOutputFunctionPtr<v_flt>>& FloatOutputsPtr,
-		const TMap<FName, TOutputFunctionPtr<int32>>& Int32OutputsPtr,
+		const TMap<FName, TNoTransformOutputPtrs<v_flt>>& FloatOutputsPtr,
+		const TMap<FName, TNoTransformOutputPtrs<int32>>& Int32OutputsPtr,
 		const TMap<FName, TRangeOutputFunctionPtr<v_flt>>& FloatOutputsRangesPtr,
 
 		const TMap<FName, TOutputFunctionPtr_Transform<v_flt>>& FloatOutputsPtr_Transform,
@@ -41,13 +53,14 @@ public:
 
 		bool bEnableRangeAnalysis)
 		: TVoxelTransformableWorldGeneratorInstanceHelper<TChild, UWorldObject>(
-			FloatOutputsPtr,
-			Int32OutputsPtr,
+			GetOutputsPtr(FloatOutputsPtr),
+			GetOutputsPtr(Int32OutputsPtr),
 			FloatOutputsRangesPtr,
 			FloatOutputsPtr_Transform,
 			Int32OutputsPtr_Transform,
 			FloatOutputsRangesPtr_Transform)
 		, bEnableRangeAnalysis(bEnableRangeAnalysis)
+		, CoarseSampling(FVoxelGraphCoarseSampling::GetSettings())
 		, CustomOutputsNames(FName())
 	{
 		auto& Array = const_cast<TStaticArray<FName, MAX_VOXELGRAPH_OUTPUTS>&>(CustomOutputsNames);
@@ -61,11 +74,27 @@ public:
 			ensure(Array[It.Value] == FName());
 			Array[It.Value] = It.Key;
 		}
+
+		for (auto& It : FloatOutputsPtr)
+		{
+			this->FloatBatchOutputsPtr.Add(It.Key, It.Value.BatchPtr);
+		}
+		for (auto& It : Int32OutputsPtr)
+		{
+			this->Int32BatchOutputsPtr.Add(It.Key, It.Value.BatchPtr);
+		}
 	}
 
 public:
 	template<bool bCustomTransform, typename T, uint32 Index, typename F>
 	inline T GetOutput(const FTransform& LocalToWorld, T DefaultValue, v_flt X, v_flt Y, v_flt Z, int32 LOD, const FVoxelItemStack& Items, F CallNextGenerator) const
+	{
+		// Single points are never coarse sampled, see FVoxelGraphCoarseSampling
+		return ComputeOutput<bCustomTransform, T, Index>(LocalToWorld, DefaultValue, X, Y, Z, LOD, Items);
+	}
+
+	template<bool bCustomTransform, typename T, uint32 Index>
+	inline T ComputeOutput(const FTransform& LocalToWorld, T DefaultValue, v_flt X, v_flt Y, v_flt Z, int32 LOD, const FVoxelItemStack& Items) const
 	{
 		auto&& Target = This().template GetTarget<Index>();
 		auto Outputs = Target.GetOutputs();
@@ -78,6 +107,50 @@ public:
 		return Outputs.template GetRef<T, Index>();
 	}
 
+	// Batched GetOutput, used by the scattered positions queries
+	template<typename T, uint32 Index>
+	void GetOutputs(T DefaultValue, TArrayView<const FVector> Positions, int32 LOD, const FVoxelItemStack& Items, TArrayView<T> OutValues) const
+	{
+		VOXEL_FUNCTION_COUNTER();
+		check(Positions.Num() == OutValues.Num());
+
+		auto&& Target = This().template GetTarget<Index>();
+		FVoxelContext Context(LOD, Items, FTransform(), false);
+		
+		auto BufferX = Target.GetBufferX();
+		auto BufferXY = Target.GetBufferXY();
+		bool bHasBufferX = false;
+		bool bHasBufferXY = false;
+		
+		// Reuse the X & XY buffers while consecutive positions share their X/Y coordinates, eg when querying columns
+		for (int32 PositionIndex = 0; PositionIndex < Positions.Num(); PositionIndex++)
+		{
+			const FVector& Position = Positions[PositionIndex];
+			
+			if (!bHasBufferX || Context.GetWorldX() != Position.X)
+			{
+				Context.SetWorldX(Position.X);
+				BufferX = Target.GetBufferX();
+				Target.ComputeX(Context, BufferX);
+				bHasBufferX = true;
+				bHasBufferXY = false;
+			}
+			if (!bHasBufferXY || Context.GetWorldY() != Position.Y)
+			{
+				Context.SetWorldY(Position.Y);
+				BufferXY = Target.GetBufferXY();
+				Target.ComputeXYWithCache(Context, BufferX, BufferXY);
+				bHasBufferXY = true;
+			}
+			Context.SetWorldZ(Position.Z);
+
+			auto Outputs = Target.GetOutputs();
+			Outputs.template GetRef<T, Index>() = DefaultValue;
+			Target.ComputeXYZWithCache(Context, (const decltype(BufferX)&)BufferX, (const decltype(BufferXY)&)BufferXY, Outputs);
+			OutValues[PositionIndex] = Outputs.template GetRef<T, Index>();
+		}
+	}
+
 	template<bool bCustomTransform, typename T, uint32 Index>
 	inline TVoxelRange<T> GetOutputRange(const FTransform& LocalToWorld, TVoxelRange<T> DefaultValue, const FIntBox& WorldBounds, int32 LOD, const FVoxelItemStack& Items) const
 	{
@@ -86,6 +159,29 @@ public:
 			return TVoxelRange<T>::Infinite();
 		}
 
+		// The range must also be valid for the query zones, whose values are interpolated between the cells corners
+		const FIntBox Bounds = UseCoarseSampling<bCustomTransform, Index>(LocalToWorld)
+			? CoarseSampling.GetCellsBounds(WorldBounds)
+			: WorldBounds;
+		
+		const auto Key = FVoxelGraphRangeCache::MakeKey(Index, Bounds, LOD, Items, bCustomTransform ? &LocalToWorld : nullptr);
+		
+		TVoxelRange<v_flt> CachedRange;
+		if (RangeCache.Find(Key, CachedRange))
+		{
+			return TVoxelRange<T>(CachedRange);
+		}
+
+		const uint64 StartCycles = FPlatformTime::Cycles64();
+		const TVoxelRange<T> Range = ComputeOutputRange<bCustomTransform, T, Index>(LocalToWorld, DefaultValue, Bounds, LOD, Items);
+		RangeCache.Add(Key, TVoxelRange<v_flt>(Range), FPlatformTime::Cycles64() - StartCycles);
+
+		return Range;
+	}
+
+	template<bool bCustomTransform, typename T, uint32 Index>
+	inline TVoxelRange<T> ComputeOutputRange(const FTransform& LocalToWorld, TVoxelRange<T> DefaultValue, const FIntBox& WorldBounds, int32 LOD, const FVoxelItemStack& Items) const
+	{
 		auto&& Target = This().template GetRangeTarget<FVoxelGraphOutputsIndices::RangeAnalysisIndex, Index>();
 		auto Outputs = Target.GetOutputs();
 
@@ -123,19 +219,46 @@ public:
 		FVoxelContext Context(LOD, Items, LocalToWorld, bCustomTransform);
 		if (!bCustomTransform || LocalToWorld.GetRotation() == FQuat::Identity)
 		{
+			if (UseCoarseSampling<bCustomTransform, Index>(LocalToWorld) && !CoarseSampling.IsOnCorners(QueryZone.Bounds, int32(QueryZone.Step)))
+			{
+				GetCoarseOutput<bCustomTransform, T, QueryZoneType, Index>(LocalToWorld, DefaultValue, QueryZone, LOD, Items);
+				return;
+			}
+
+			// Null if the XY rect isn't worth caching
+			const auto CachedBuffers = GetCachedBuffers<bCustomTransform, Index>(Target, LocalToWorld, QueryZone, LOD, Items);
+			int32 IndexX = 0;
+			int32 IndexXY = 0;
+
 			// We can only use the dependencies analysis if we don't have a transform, or if it's only translation + scale
 			// (and thus not changing the axis)
 			for (VOXEL_QUERY_ZONE_ITERATE(QueryZone, X))
 			{
 				Context.SetWorldX(X);
 				auto BufferX = Target.GetBufferX();
-				Target.ComputeX(Context, BufferX);
+				const auto* BufferXPtr = &BufferX;
+				if (CachedBuffers.IsValid())
+				{
+					BufferXPtr = &CachedBuffers->BuffersX[IndexX++];
+				}
+				else
+				{
+					Target.ComputeX(Context, BufferX);
+				}
 
 				for (VOXEL_QUERY_ZONE_ITERATE(QueryZone, Y))
 				{
 					Context.SetWorldY(Y);
 					auto BufferXY = Target.GetBufferXY();
-					Target.ComputeXYWithCache(Context, BufferX, BufferXY);
+					const auto* BufferXYPtr = &BufferXY;
+					if (CachedBuffers.IsValid())
+					{
+						BufferXYPtr = &CachedBuffers->BuffersXY[IndexXY++];
+					}
+					else
+					{
+						Target.ComputeXYWithCache(Context, BufferX, BufferXY);
+					}
 
 					for (VOXEL_QUERY_ZONE_ITERATE(QueryZone, Z))
 					{
@@ -143,7 +266,7 @@ public:
 
 						auto Outputs = Target.GetOutputs();
 						Outputs.template GetRef<T, Index>() = DefaultValue;
-						Target.ComputeXYZWithCache(Context, (const decltype(BufferX)&)BufferX, (const decltype(BufferXY)&)BufferXY, Outputs);
+						Target.ComputeXYZWithCache(Context, *BufferXPtr, *BufferXYPtr, Outputs);
 						QueryZone.Set(X, Y, Z, QueryZoneType(Outputs.template GetRef<T, Index>()));
 					}
 				}
@@ -172,6 +295,231 @@ public:
 		}
 	}
 
+	// X & XY buffers of the XY rect of QueryZone. Shared by all the query zones in the same column
+	// Null if the cache is disabled, or if the rect wasn't missed before: the caller then computes the buffers inline
+	template<bool bCustomTransform, uint32 Index, typename TTarget, typename QueryZoneType>
+	auto GetCachedBuffers(const TTarget& Target, const FTransform& LocalToWorld, const TVoxelQueryZone<QueryZoneType>& QueryZone, int32 LOD, const FVoxelItemStack& Items) const
+		-> TVoxelSharedPtr<const FVoxelGraphBufferCache::TEntry<decltype(Target.GetBufferX()), decltype(Target.GetBufferXY())>>
+	{
+		using FBuffers = FVoxelGraphBufferCache::TEntry<decltype(Target.GetBufferX()), decltype(Target.GetBufferXY())>;
+
+		if (!FVoxelGraphBufferCache::IsEnabled())
+		{
+			return nullptr;
+		}
+
+		const auto Key = FVoxelGraphBufferCache::MakeKey(Index, QueryZone.Bounds, QueryZone.Step, LOD, Items, bCustomTransform ? &LocalToWorld : nullptr);
+		bool bShouldAdd = false;
+		if (const auto CachedBuffers = BufferCache.Find(Key, bShouldAdd))
+		{
+			return StaticCastVoxelSharedPtr<const FBuffers>(CachedBuffers);
+		}
+		if (!bShouldAdd)
+		{
+			return nullptr;
+		}
+
+		VOXEL_FUNCTION_COUNTER();
+		
+		const auto Buffers = MakeVoxelShared<FBuffers>();
+		FVoxelContext Context(LOD, Items, LocalToWorld, bCustomTransform);
+		for (VOXEL_QUERY_ZONE_ITERATE(QueryZone, X))
+		{
+			Context.SetWorldX(X);
+			auto& BufferX = Buffers->BuffersX.Add_GetRef(Target.GetBufferX());
+			Target.ComputeX(Context, BufferX);
+
+			for (VOXEL_QUERY_ZONE_ITERATE(QueryZone, Y))
+			{
+				Context.SetWorldY(Y);
+				auto& BufferXY = Buffers->BuffersXY.Add_GetRef(Target.GetBufferXY());
+				Target.ComputeXYWithCache(Context, BufferX, BufferXY);
+			}
+		}
+		BufferCache.Add(Key, Buffers);
+		
+		return Buffers;
+	}
+
+	// Only the value output is coarse sampled: materials can't be interpolated, and custom outputs are queried at exact positions
+	// Not used with rotations, as the query zones of rotated instances are computed point by point
+	// Does not depend on the LOD, so that all the LODs use the same values
+	template<bool bCustomTransform, uint32 Index>
+	FORCEINLINE bool UseCoarseSampling(const FTransform& LocalToWorld) const
+	{
+		return
+			Index == FVoxelGraphOutputsIndices::ValueIndex &&
+			CoarseSampling.bEnable &&
+			(!bCustomTransform || LocalToWorld.GetRotation() == FQuat::Identity);
+	}
+
+	// See FVoxelGraphCoarseSampling
+	// The corners & the check points of all the cells intersecting the query zone are computed on grids, using the X & XY buffers
+	template<bool bCustomTransform, typename T, typename QueryZoneType, uint32 Index>
+	typename TEnableIf<TIsSame<T, v_flt>::Value>::Type GetCoarseOutput(const FTransform& LocalToWorld, T DefaultValue, TVoxelQueryZone<QueryZoneType>& QueryZone, int32 LOD, const FVoxelItemStack& Items) const
+	{
+		VOXEL_FUNCTION_COUNTER();
+
+		const int32 CellSize = CoarseSampling.CellSize;
+		const int32 HalfCellSize = CellSize / 2;
+		
+		const FIntVector Min = QueryZone.Bounds.Min;
+		const FIntVector Last = QueryZone.Bounds.Max - FIntVector(QueryZone.Step);
+		const FIntVector CellsMin = CoarseSampling.GetCell(Min.X, Min.Y, Min.Z);
+		const FIntVector CellsMax = CoarseSampling.GetCell(Last.X, Last.Y, Last.Z);
+		const FIntVector NumCells = CellsMax - CellsMin + FIntVector(1);
+		const FIntVector CellsStart = CellsMin * CellSize;
+
+		auto&& Target = This().template GetTarget<Index>();
+		FVoxelContext Context(LOD, Items, LocalToWorld, bCustomTransform);
+
+		struct FGrid
+		{
+			FIntVector Size;
+			TArray<T> Values;
+
+			FORCEINLINE T Get(int32 X, int32 Y, int32 Z) const
+			{
+				checkVoxelSlow(0 <= X && X < Size.X);
+				checkVoxelSlow(0 <= Y && Y < Size.Y);
+				checkVoxelSlow(0 <= Z && Z < Size.Z);
+				return Values.GetData()[X + Size.X * Y + Size.X * Size.Y * Z];
+			}
+		};
+		const auto ComputeGrid = [&](const FIntVector& Offset, const FIntVector& GridSize)
+		{
+			FGrid Grid;
+			Grid.Size = GridSize;
+			Grid.Values.SetNumUninitialized(GridSize.X * GridSize.Y * GridSize.Z);
+			for (int32 IndexX = 0; IndexX < GridSize.X; IndexX++)
+			{
+				Context.SetWorldX(CellsStart.X + Offset.X + IndexX * CellSize);
+				auto BufferX = Target.GetBufferX();
+				Target.ComputeX(Context, BufferX);
+
+				for (int32 IndexY = 0; IndexY < GridSize.Y; IndexY++)
+				{
+					Context.SetWorldY(CellsStart.Y + Offset.Y + IndexY * CellSize);
+					auto BufferXY = Target.GetBufferXY();
+					Target.ComputeXYWithCache(Context, BufferX, BufferXY);
+
+					for (int32 IndexZ = 0; IndexZ < GridSize.Z; IndexZ++)
+					{
+						Context.SetWorldZ(CellsStart.Z + Offset.Z + IndexZ * CellSize);
+
+						auto Outputs = Target.GetOutputs();
+						Outputs.template GetRef<T, Index>() = DefaultValue;
+						Target.ComputeXYZWithCache(Context, (const decltype(BufferX)&)BufferX, (const decltype(BufferXY)&)BufferXY, Outputs);
+						Grid.Values[IndexX + GridSize.X * IndexY + GridSize.X * GridSize.Y * IndexZ] = Outputs.template GetRef<T, Index>();
+					}
+				}
+			}
+			return Grid;
+		};
+
+		const FGrid Corners = ComputeGrid(FIntVector(0), NumCells + FIntVector(1));
+		const FGrid Centers = ComputeGrid(FIntVector(HalfCellSize), NumCells);
+		const FGrid FacesX = ComputeGrid(FIntVector(0, HalfCellSize, HalfCellSize), NumCells + FIntVector(1, 0, 0));
+		const FGrid FacesY = ComputeGrid(FIntVector(HalfCellSize, 0, HalfCellSize), NumCells + FIntVector(0, 1, 0));
+		const FGrid FacesZ = ComputeGrid(FIntVector(HalfCellSize, HalfCellSize, 0), NumCells + FIntVector(0, 0, 1));
+
+		const auto GetCorners = [&](const FIntVector& Cell, T OutCorners[8])
+		{
+			for (int32 CornerIndex = 0; CornerIndex < 8; CornerIndex++)
+			{
+				OutCorners[CornerIndex] = Corners.Get(
+					Cell.X + bool(CornerIndex & 0x1),
+					Cell.Y + bool(CornerIndex & 0x2),
+					Cell.Z + bool(CornerIndex & 0x4));
+			}
+		};
+		
+		TArray<bool> SmoothCells;
+		SmoothCells.SetNumUninitialized(NumCells.X * NumCells.Y * NumCells.Z);
+		for (int32 Z = 0; Z < NumCells.Z; Z++)
+		{
+			for (int32 Y = 0; Y < NumCells.Y; Y++)
+			{
+				for (int32 X = 0; X < NumCells.X; X++)
+				{
+					T CellCorners[8];
+					GetCorners(FIntVector(X, Y, Z), CellCorners);
+
+					// Same order as FVoxelGraphCoarseSampling::CheckPoints
+					const T CheckValues[FVoxelGraphCoarseSampling::NumCheckPoints] =
+					{
+						Centers.Get(X, Y, Z),
+						FacesX.Get(X, Y, Z),
+						FacesX.Get(X + 1, Y, Z),
+						FacesY.Get(X, Y, Z),
+						FacesY.Get(X, Y + 1, Z),
+						FacesZ.Get(X, Y, Z),
+						FacesZ.Get(X, Y, Z + 1)
+					};
+					SmoothCells[X + NumCells.X * Y + NumCells.X * NumCells.Y * Z] = CoarseSampling.IsSmooth(CellCorners, CheckValues);
+				}
+			}
+		}
+
+		for (VOXEL_QUERY_ZONE_ITERATE(QueryZone, X))
+		{
+			for (VOXEL_QUERY_ZONE_ITERATE(QueryZone, Y))
+			{
+				for (VOXEL_QUERY_ZONE_ITERATE(QueryZone, Z))
+				{
+					const FIntVector Cell = CoarseSampling.GetCell(X, Y, Z);
+					const FIntVector LocalCell = Cell - CellsMin;
+					
+					T Value;
+					if (SmoothCells[LocalCell.X + NumCells.X * LocalCell.Y + NumCells.X * NumCells.Y * LocalCell.Z])
+					{
+						T CellCorners[8];
+						GetCorners(LocalCell, CellCorners);
+						Value = CoarseSampling.Interpolate(CellCorners, Cell, X, Y, Z);
+					}
+					else
+					{
+						// Full resolution: reuse the values we already have
+						const FIntVector Offset = FIntVector(X, Y, Z) - Cell * CellSize;
+						const bool bHalfX = Offset.X == HalfCellSize;
+						const bool bHalfY = Offset.Y == HalfCellSize;
+						const bool bHalfZ = Offset.Z == HalfCellSize;
+						const bool bOnCheckPoints =
+							(Offset.X == 0 || bHalfX) &&
+							(Offset.Y == 0 || bHalfY) &&
+							(Offset.Z == 0 || bHalfZ);
+						const int32 NumHalf = bHalfX + bHalfY + bHalfZ;
+
+						if (bOnCheckPoints && NumHalf == 0)
+						{
+							Value = Corners.Get(LocalCell.X, LocalCell.Y, LocalCell.Z);
+						}
+						else if (bOnCheckPoints && NumHalf == 3)
+						{
+							Value = Centers.Get(LocalCell.X, LocalCell.Y, LocalCell.Z);
+						}
+						else if (bOnCheckPoints && NumHalf == 2)
+						{
+							const FGrid& Faces = !bHalfX ? FacesX : !bHalfY ? FacesY : FacesZ;
+							Value = Faces.Get(LocalCell.X, LocalCell.Y, LocalCell.Z);
+						}
+						else
+						{
+							Value = ComputeOutput<bCustomTransform, T, Index>(LocalToWorld, DefaultValue, X, Y, Z, LOD, Items);
+						}
+					}
+					QueryZone.Set(X, Y, Z, QueryZoneType(Value));
+				}
+			}
+		}
+	}
+	template<bool bCustomTransform, typename T, typename QueryZoneType, uint32 Index>
+	typename TEnableIf<!TIsSame<T, v_flt>::Value>::Type GetCoarseOutput(const FTransform& LocalToWorld, T DefaultValue, TVoxelQueryZone<QueryZoneType>& QueryZone, int32 LOD, const FVoxelItemStack& Items) const
+	{
+		// Can't interpolate materials
+		check(false);
+	}
+
 	template<bool bCustomTransform, typename T, uint32 Index>
 	inline T GetDataImpl(const FTransform& LocalToWorld, T DefaultValue, v_flt X, v_flt Y, v_flt Z, int32 LOD, const FVoxelItemStack& Items) const
 	{
@@ -255,6 +603,11 @@ public:
 		GetData<false, FVoxelMaterial, FVoxelMaterial, FVoxelGraphOutputsIndices::MaterialIndex>(FTransform(), FVoxelMaterial::Default(), QueryZone, LOD, Items);
 	}
 
+	virtual void GetValues(TArrayView<const FVector> Positions, int32 LOD, const FVoxelItemStack& Items, TArrayView<v_flt> OutValues) const override final
+	{
+		GetOutputs<v_flt, FVoxelGraphOutputsIndices::ValueIndex>(1, Positions, LOD, Items, OutValues);
+	}
+
 	virtual void GetValues_Transform(const FTransform& LocalToWorld, TVoxelQueryZone<FVoxelValue>& QueryZone, int32 LOD, const FVoxelItemStack& Items) const override final
 	{
 		GetData<true, v_flt, FVoxelValue, FVoxelGraphOutputsIndices::ValueIndex>(LocalToWorld, 1, QueryZone, LOD, Items);
@@ -294,9 +647,13 @@ protected:
 	struct NoTransformAccessor
 	{
 		template<uint32 Index, typename ReturnType>
-		inline static ReturnType Get()
+		inline static TNoTransformOutputPtrs<T> Get()
 		{
-			return static_cast<ReturnType>(&TChild::template GetCustomOutputNoTransform<T, Index>);
+			static_assert(TIsSame<ReturnType, TOutputFunctionPtr<T>>::Value, "");
+			TNoTransformOutputPtrs<T> Ptrs;
+			Ptrs.Ptr = static_cast<ReturnType>(&TChild::template GetCustomOutputNoTransform<T, Index>);
+			Ptrs.BatchPtr = static_cast<TBatchOutputFunctionPtr<T>>(&TVoxelGraphGeneratorInstanceHelper::template GetCustomOutputsBatch<T, Index>);
+			return Ptrs;
 		}
 	};
 	template<typename T>
@@ -327,9 +684,32 @@ protected:
 		}
 	};
 
+private:
+	template<typename T>
+	static TMap<FName, TOutputFunctionPtr<T>> GetOutputsPtr(const TMap<FName, TNoTransformOutputPtrs<T>>& OutputsPtr)
+	{
+		TMap<FName, TOutputFunctionPtr<T>> Result;
+		for (auto& It : OutputsPtr)
+		{
+			Result.Add(It.Key, It.Value.Ptr);
+		}
+		return Result;
+	}
+
+	// Stored in FloatBatchOutputsPtr/Int32BatchOutputsPtr, and called through the custom output handles
+	template<typename T, uint32 Index>
+	void GetCustomOutputsBatch(TArrayView<const FVector> Positions, int32 LOD, const FVoxelItemStack& Items, TArrayView<T> OutValues) const
+	{
+		// Same default value as GetCustomOutputImpl
+		GetOutputs<T, Index>(0, Positions, LOD, Items, OutValues);
+	}
+
 private:
 	const bool bEnableRangeAnalysis;
+	const FVoxelGraphCoarseSampling CoarseSampling;
 	const TStaticArray<FName, MAX_VOXELGRAPH_OUTPUTS> CustomOutputsNames;
+	mutable FVoxelGraphRangeCache RangeCache;
+	mutable FVoxelGraphBufferCache BufferCache;
 
 	inline const TChild& This() const
 	{
@@ -0,0 +1,105 @@
+// Copyright 2020 Phyronnaz
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "HAL/CriticalSection.h"
+#include "IntBox.h"
+#include "VoxelRange.h"
+
+struct FVoxelItemStack;
+
+// Identity of an item stack & of a transform, as seen by a graph query on some bounds
+// Compared exactly: the hash is only used for bucketing
+struct VOXELGRAPH_API FVoxelGraphStackIdentity
+{
+	const void* WorldGenerator = nullptr;
+	const void* CustomData = nullptr;
+	int32 Depth = -1;
+	// Serial numbers of the items that can affect the bounds, in the item holder order
+	TArray<uint64, TInlineAllocator<4>> Items;
+
+	bool bHasTransform = false;
+	FVector Translation = FVector::ZeroVector;
+	FQuat Rotation = FQuat::Identity;
+	FVector Scale = FVector::OneVector;
+
+	uint32 Hash = 0;
+
+	// The graph might sample the items below it: only the ones intersecting Bounds are part of the identity
+	static FVoxelGraphStackIdentity Make(const FIntBox& Bounds, const FVoxelItemStack& Items, const FTransform* LocalToWorld);
+
+	inline bool operator==(const FVoxelGraphStackIdentity& Other) const
+	{
+		return
+			Hash == Other.Hash &&
+			WorldGenerator == Other.WorldGenerator &&
+			CustomData == Other.CustomData &&
+			Depth == Other.Depth &&
+			Items == Other.Items &&
+			bHasTransform == Other.bHasTransform &&
+			(!bHasTransform || (
+				Translation == Other.Translation &&
+				Rotation == Other.Rotation &&
+				Scale == Other.Scale));
+	}
+};
+
+// Bounded cache of the range analysis results of a graph instance
+// The render octree & the meshers query ranges on heavily overlapping boxes, and the range analysis goes through every node each time
+class VOXELGRAPH_API FVoxelGraphRangeCache
+{
+public:
+	struct FKey
+	{
+		FIntBox Bounds;
+		int32 LOD = 0;
+		uint32 OutputIndex = 0;
+		FVoxelGraphStackIdentity Stack;
+
+		inline bool operator==(const FKey& Other) const
+		{
+			return
+				Bounds == Other.Bounds &&
+				LOD == Other.LOD &&
+				OutputIndex == Other.OutputIndex &&
+				Stack == Other.Stack;
+		}
+		inline friend uint32 GetTypeHash(const FKey& Key)
+		{
+			return HashCombine(HashCombine(GetTypeHash(Key.Bounds), Key.Stack.Hash), HashCombine(GetTypeHash(Key.LOD), GetTypeHash(Key.OutputIndex)));
+		}
+	};
+
+	static FKey MakeKey(uint32 OutputIndex, const FIntBox& Bounds, int32 LOD, const FVoxelItemStack& Items, const FTransform* LocalToWorld);
+
+public:
+	// Will also try to build the result from the 8 children of Key.Bounds if they are all cached
+	bool Find(const FKey& Key, TVoxelRange<v_flt>& OutRange);
+	// ComputeCycles: time spent computing the range, used to estimate the time saved by the cache
+	void Add(const FKey& Key, const TVoxelRange<v_flt>& Range, uint64 ComputeCycles);
+	void Clear();
+
+private:
+	// The cache is queried by all the generator threads: split it so that they rarely wait on each other
+	static constexpr int32 NumShards = 16;
+
+	struct FShard
+	{
+		FCriticalSection Section;
+		TMap<FKey, TVoxelRange<v_flt>> Map;
+		// Ring buffer used to evict the oldest entries
+		TArray<FKey> Keys;
+		int32 NextKeyIndex = 0;
+
+		void AddNoLock(const FKey& Key, const TVoxelRange<v_flt>& Range);
+		void Empty();
+	};
+	FShard Shards[NumShards];
+
+	FORCEINLINE FShard& GetShard(const FKey& Key)
+	{
+		return Shards[GetTypeHash(Key) % NumShards];
+	}
+	bool FindInShard(const FKey& Key, TVoxelRange<v_flt>& OutRange);
+};
\ No newline at end of file
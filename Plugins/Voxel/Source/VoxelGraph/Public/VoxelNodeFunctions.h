@@ -772,6 +772,154 @@ namespace FVoxelNodeFunctions
 		}
 	}
 
+	// LOD aware versions: sample the texture mip matching the distance between two voxels at this LOD, assuming one texel per voxel at LOD 0
+	// Same as the versions above if the texture was created without mips
+	// Not used by the texture sampler nodes: for C++ world generators sampling a texture created with mips, see FVoxelTextureUtilities::CreateFromTexture_Color
+	inline v_flt GetTexelsPerSample(int32 LOD)
+	{
+		return v_flt(1 << FMath::Clamp(LOD, 0, 30));
+	}
+	inline void ReadColorTextureDataFloat(
+		const TVoxelTexture<FColor>& Texture,
+		const EVoxelSamplerMode Mode,
+		v_flt U,
+		v_flt V,
+		int32 LOD,
+		v_flt& OutR,
+		v_flt& OutG,
+		v_flt& OutB,
+		v_flt& OutA)
+	{
+		const FLinearColor Color = Texture.SampleLOD<FLinearColor>(U, V, GetTexelsPerSample(LOD), Mode);
+		OutR = Color.R;
+		OutG = Color.G;
+		OutB = Color.B;
+		OutA = Color.A;
+	}
+	inline void ReadColorTextureDataFloat(
+		const TVoxelTexture<FColor>& Texture,
+		const EVoxelSamplerMode Mode,
+		const TVoxelRange<v_flt>& U,
+		const TVoxelRange<v_flt>& V,
+		int32 LOD,
+		TVoxelRange<v_flt>& OutR,
+		TVoxelRange<v_flt>& OutG,
+		TVoxelRange<v_flt>& OutB,
+		TVoxelRange<v_flt>& OutA)
+	{
+		if (U.IsSingleValue() && V.IsSingleValue())
+		{
+			v_flt R, G, B, A;
+			ReadColorTextureDataFloat(Texture, Mode, U.GetSingleValue(), V.GetSingleValue(), LOD, R, G, B, A);
+			OutR = R;
+			OutG = G;
+			OutB = B;
+			OutA = A;
+		}
+		else
+		{
+			OutR = { 0, 1 };
+			OutG = { 0, 1 };
+			OutB = { 0, 1 };
+			OutA = { 0, 1 };
+		}
+	}
+	inline void ReadColorTextureDataInt(
+		const TVoxelTexture<FColor>& Texture,
+		const EVoxelSamplerMode Mode,
+		int32 U,
+		int32 V,
+		int32 LOD,
+		v_flt& OutR,
+		v_flt& OutG,
+		v_flt& OutB,
+		v_flt& OutA)
+	{
+		ReadColorTextureDataFloat(Texture, Mode, v_flt(U), v_flt(V), LOD, OutR, OutG, OutB, OutA);
+	}
+	inline void ReadColorTextureDataInt(
+		const TVoxelTexture<FColor>& Texture,
+		const EVoxelSamplerMode Mode,
+		const TVoxelRange<int32>& U,
+		const TVoxelRange<int32>& V,
+		int32 LOD,
+		TVoxelRange<v_flt>& OutR,
+		TVoxelRange<v_flt>& OutG,
+		TVoxelRange<v_flt>& OutB,
+		TVoxelRange<v_flt>& OutA)
+	{
+		if (U.IsSingleValue() && V.IsSingleValue())
+		{
+			v_flt R, G, B, A;
+			ReadColorTextureDataInt(Texture, Mode, U.GetSingleValue(), V.GetSingleValue(), LOD, R, G, B, A);
+			OutR = R;
+			OutG = G;
+			OutB = B;
+			OutA = A;
+		}
+		else
+		{
+			OutR = { 0, 1 };
+			OutG = { 0, 1 };
+			OutB = { 0, 1 };
+			OutA = { 0, 1 };
+		}
+	}
+	
+	inline v_flt ReadFloatTextureDataFloat(
+		const TVoxelTexture<float>& Texture,
+		const EVoxelSamplerMode Mode,
+		v_flt U,
+		v_flt V,
+		int32 LOD)
+	{
+		return Texture.SampleLOD<float>(U, V, GetTexelsPerSample(LOD), Mode);
+	}
+	inline TVoxelRange<v_flt> ReadFloatTextureDataFloat(
+		const TVoxelTexture<float>& Texture,
+		const EVoxelSamplerMode Mode,
+		const TVoxelRange<v_flt>& U,
+		const TVoxelRange<v_flt>& V,
+		int32 LOD)
+	{
+		if (U.IsSingleValue() && V.IsSingleValue())
+		{
+			return ReadFloatTextureDataFloat(Texture, Mode, U.GetSingleValue(), V.GetSingleValue(), LOD);
+		}
+		else
+		{
+			// The mips are averages of the texture values: they are in the same range
+			ensure(Texture.GetMin() <= Texture.GetMax());
+			return { Texture.GetMin(), Texture.GetMax() };
+		}
+	}
+	inline v_flt ReadFloatTextureDataInt(
+		const TVoxelTexture<float>& Texture,
+		const EVoxelSamplerMode Mode,
+		int32 U,
+		int32 V,
+		int32 LOD)
+	{
+		return ReadFloatTextureDataFloat(Texture, Mode, v_flt(U), v_flt(V), LOD);
+	}
+	inline TVoxelRange<v_flt> ReadFloatTextureDataInt(
+		const TVoxelTexture<float>& Texture,
+		const EVoxelSamplerMode Mode,
+		const TVoxelRange<int32>& U,
+		const TVoxelRange<int32>& V,
+		int32 LOD)
+	{
+		if (U.IsSingleValue() && V.IsSingleValue())
+		{
+			return ReadFloatTextureDataInt(Texture, Mode, U.GetSingleValue(), V.GetSingleValue(), LOD);
+		}
+		else
+		{
+			ensure(Texture.GetMin() <= Texture.GetMax());
+			return { Texture.GetMin(), Texture.GetMax() };
+		}
+	}
+
 	inline void FindColorsAlphas(
 		const int Threshold,
 		const TArray<FColor>& Colors,